@@ -25,6 +25,8 @@ import array
 import gcode
 import os
 import re
+import hashlib
+import marshal
 
 def minmax(*args):
     return min(*args), max(*args)
@@ -76,6 +78,19 @@ limiticon = array.array('B',
          255, 255,  176, 0,  152, 0,  140, 0,  134, 0,  128, 0,    0,   0,
            0,   0,    0, 0])
 
+class CachedLineCode(object):
+    """The state of the last line of a program read from the preview cache,
+    standing in for the gcode.linecode that next_line() was last given."""
+    attrs = ('sequence_number', 'feed_rate', 'speed', 'motion_mode',
+        'block', 'plane', 'cutter_side', 'units', 'distance_mode',
+        'feed_mode', 'origin', 'tool_length_offset', 'retract_mode',
+        'path_mode', 'stopping', 'spindle', 'toolchange', 'mist', 'flood',
+        'overrides', 'gcodes', 'mcodes')
+
+    def __init__(self, values):
+        for a in self.attrs:
+            setattr(self, a, values[a])
+
 class GLCanon(Translated, ArcsToSegmentsMixin):
     lineno = -1
     def __init__(self, colors, geometry, is_foam=0):
@@ -126,6 +141,8 @@ class GLCanon(Translated, ArcsToSegmentsMixin):
         self.notify = 0
         self.notify_message = ""
         self.highlight_line = None
+        # messages and notifications given while the program was read
+        self.outputs = 0
 
     def comment(self, arg):
         if arg.startswith("AXIS,"):
@@ -151,6 +168,7 @@ class GLCanon(Translated, ArcsToSegmentsMixin):
                     except:
                         self.foam_w = 30.0
             if command == "notify":
+                self.outputs += 1
                 self.notify = self.notify + 1
                 self.notify_message = "(AXIS,notify):" + str(self.notify)
                 if len(parts) > 2:
@@ -268,6 +286,42 @@ class GLCanon(Translated, ArcsToSegmentsMixin):
         self.lo = l
     straight_probe = straight_feed
 
+    def moves(self, lines, types, positions, arcs):
+        # straight_traverse, straight_feed and arc_feed calls batched up by
+        # gcode.parse, see gcodemodule.cc for the layout
+        if self.suppress > 0: return
+        l = array.array('i'); l.fromstring(lines)
+        t = array.array('b'); t.fromstring(types)
+        p = array.array('d'); p.fromstring(positions)
+        r = array.array('d'); r.fromstring(arcs)
+        rotate_and_translate = self.rotate_and_translate
+        traverse_append = self.traverse_append
+        feed_append = self.feed_append
+        lo = self.lo
+        j = k = 0
+        for i in range(len(l)):
+            lineno = l[i]
+            typ = t[i]
+            if typ == 2:
+                self.lo = lo
+                self.lineno = lineno
+                x1, y1, z1, a, b, c, u, v, w = p[j:j+9]
+                cx, cy, rot = r[k:k+3]
+                self.arc_feed(x1, y1, cx, cy, int(rot), z1, a, b, c, u, v, w)
+                lo = self.lo
+                k += 3
+            else:
+                n = rotate_and_translate(*p[j:j+9])
+                if typ == 1:
+                    self.first_move = False
+                    feed_append((lineno, lo, n, self.feedrate, [self.xo, self.yo, self.zo]))
+                elif not self.first_move:
+                    traverse_append((lineno, lo, n, [self.xo, self.yo, self.zo]))
+                lo = n
+            j += 9
+        self.lo = lo
+        self.lineno = lineno
+
     def user_defined_function(self, i, p, q):
         if self.suppress > 0: return
         color = self.colors['m1xx']
@@ -426,9 +480,13 @@ class GlCanonDraw:
         self.dro_mm = "% 9.3f"
         self.show_overlay = True
         self.cone_basesize = .5
+        self.preview_cache = None
         try:
             if os.environ["INI_FILE_NAME"]:
                 self.inifile = linuxcnc.ini(os.environ["INI_FILE_NAME"])
+                cache = self.inifile.find("DISPLAY", "PREVIEW_CACHE")
+                if cache:
+                    self.preview_cache = os.path.expanduser(cache)
                 if self.inifile.find("DISPLAY", "DRO_FORMAT_IN"):
                     temp = self.inifile.find("DISPLAY", "DRO_FORMAT_IN")
                     try:
@@ -1821,18 +1879,183 @@ class GlCanonDraw:
         if self.canon: self.canon.draw(0, False)
         glEndList()
 
+    # what a preview is made of, and what it was made from besides the
+    # program text, the arguments to parse and the INI file
+    preview_cache_version = 2
+    preview_cache_entries = 16
+    preview_cache_attrs = ('traverse', 'feed', 'arcfeed', 'dwells',
+        'dwell_time', 'foam_z', 'foam_w', 'lineno')
+    preview_cache_inputs = ('arcdivision', 'is_foam', 'geometry')
+    # callbacks whose effect is more than what the preview is made of; a
+    # program that calls them is read through the interpreter every time
+    preview_cache_outputs = ('message',)
+
+    def preview_cache_key(self, f, canon, args):
+        def add_dir(d, suffix):
+            try:
+                names = sorted(os.listdir(d))
+            except OSError:
+                return
+            for n in names:
+                if not n.endswith(suffix): continue
+                try:
+                    st = os.stat(os.path.join(d, n))
+                except OSError:
+                    continue
+                h.update(repr((d, n, st.st_size, st.st_mtime)))
+
+        def add_file(name):
+            try:
+                fd = open(name, "rb")
+            except (IOError, TypeError):
+                h.update("-")
+                return
+            size = 0
+            try:
+                while True:
+                    block = fd.read(1 << 20)
+                    if not block: break
+                    h.update(block)
+                    size += len(block)
+            finally:
+                fd.close()
+            h.update("\0%d" % size)
+
+        h = hashlib.sha1()
+        h.update(repr((self.preview_cache_version, args,
+            [getattr(canon, a, None) for a in self.preview_cache_inputs],
+            canon.colors['dwell'], canon.colors['m1xx'])))
+        add_file(f)
+        add_file(getattr(canon, 'parameter_file', None))
+        inifile = os.environ.get("INI_FILE_NAME")
+        add_file(inifile)
+        if inifile:
+            inidir = os.path.dirname(os.path.abspath(inifile))
+        else:
+            inidir = os.getcwd()
+        tooltable = self.inifile.find("EMCIO", "TOOL_TABLE")
+        if tooltable:
+            add_file(os.path.join(inidir, tooltable))
+        # subroutines the program may call, looked for where the
+        # interpreter looks for them
+        dirs = [self.inifile.find("DISPLAY", "PROGRAM_PREFIX") or ""]
+        dirs += (self.inifile.find("RS274NGC", "SUBROUTINE_PATH") or "").split(":")
+        for d in dirs:
+            if not d: continue
+            add_dir(os.path.join(inidir, os.path.expanduser(d)), ".ngc")
+        # Python remap code: the toplevel module and what it can import
+        toplevel = self.inifile.find("PYTHON", "TOPLEVEL")
+        if toplevel:
+            toplevel = os.path.join(inidir, os.path.expanduser(toplevel))
+            add_file(toplevel)
+            add_dir(os.path.dirname(toplevel), ".py")
+        dirs = (self.inifile.findall("PYTHON", "PATH_PREPEND") +
+            self.inifile.findall("PYTHON", "PATH_APPEND"))
+        for d in dirs:
+            add_dir(os.path.join(inidir, os.path.expanduser(d)), ".py")
+        return h.hexdigest()
+
+    def load_cached_preview(self, name, canon):
+        try:
+            fd = open(name, "rb")
+        except IOError:
+            return None
+        try:
+            try:
+                data = marshal.load(fd)
+                result, seq, extents, attrs, state = data
+                extents = [list(e) for e in extents]
+                (min_extents, max_extents,
+                    min_extents_notool, max_extents_notool) = extents
+                if len(attrs) != len(self.preview_cache_attrs):
+                    return None
+            except (EOFError, ValueError, TypeError):
+                return None
+        finally:
+            fd.close()
+        for a, v in zip(self.preview_cache_attrs, attrs):
+            setattr(canon, a, v)
+        (canon.min_extents, canon.max_extents,
+            canon.min_extents_notool, canon.max_extents_notool) = extents
+        if state is not None:
+            canon.state = CachedLineCode(state)
+        try:
+            os.utime(name, None)
+        except OSError:
+            pass
+        return result, seq
+
+    def save_cached_preview(self, name, canon, result, seq):
+        state = getattr(canon, 'state', None)
+        if state is not None:
+            state = dict((a, getattr(state, a))
+                for a in CachedLineCode.attrs)
+        data = (result, seq,
+            (canon.min_extents, canon.max_extents,
+                canon.min_extents_notool, canon.max_extents_notool),
+            [getattr(canon, a, None) for a in self.preview_cache_attrs],
+            state)
+        d = self.preview_cache
+        try:
+            if not os.path.isdir(d): os.makedirs(d)
+            tmp = name + ".%d" % os.getpid()
+            fd = open(tmp, "wb")
+            try:
+                marshal.dump(data, fd)
+            finally:
+                fd.close()
+            os.rename(tmp, name)
+            # forget the least recently loaded previews
+            names = [os.path.join(d, n) for n in os.listdir(d)
+                        if n.endswith(".preview")]
+            names.sort(key=os.path.getmtime)
+            for n in names[:-self.preview_cache_entries]:
+                os.unlink(n)
+        except (OSError, IOError, ValueError):
+            try:
+                os.unlink(tmp)
+            except (OSError, NameError):
+                pass
+
     def load_preview(self, f, canon, *args):
         self.set_canon(canon)
-        result, seq = gcode.parse(f, canon, *args)
+        name = cached = None
+        if self.preview_cache:
+            name = os.path.join(self.preview_cache,
+                        self.preview_cache_key(f, canon, args) + ".preview")
+            cached = self.load_cached_preview(name, canon)
+        if cached:
+            result, seq = cached
+        elif name:
+            # note what can't be played back from the cache
+            outputs = canon.outputs
+            def counted(method):
+                def call(*args):
+                    canon.outputs += 1
+                    return method(*args)
+                return call
+            for m in self.preview_cache_outputs:
+                setattr(canon, m, counted(getattr(canon, m)))
+            try:
+                result, seq = gcode.parse(f, canon, *args)
+            finally:
+                for m in self.preview_cache_outputs:
+                    delattr(canon, m)
+            if canon.outputs != outputs:
+                name = None
+        else:
+            result, seq = gcode.parse(f, canon, *args)
 
         if result <= gcode.MIN_ERROR:
             self.canon.progress.nextphase(1)
-            canon.calc_extents()
+            if not cached: canon.calc_extents()
             self.stale_dlist('program_rapids')
             self.stale_dlist('program_norapids')
             self.stale_dlist('select_rapids')
             self.stale_dlist('select_norapids')
 
+        if name and not cached:
+            self.save_cached_preview(name, canon, result, seq)
         return result, seq
 
     def from_internal_units(self, pos, unit=None):
@@ -50,6 +50,7 @@ extern value_inihal_data old_inihal_data;
   HOME_USE_INDEX <bool>        use index pulse when homing
   HOME_IGNORE_LIMITS <bool>    ignore limit switches when homing
   COMP_FILE <filename>         file of joint compensation points
+  COMP_GRID_FILE <filename>    file of a volumetric compensation grid
 
   calls:
 
@@ -68,6 +69,7 @@ extern value_inihal_data old_inihal_data;
   emcJointSetMaxVelocity(int joint, double vel);
   emcJointSetMaxAcceleration(int joint, double acc);
   emcJointLoadComp(int joint, const char * file, int comp_file_type);
+  emcJointLoadCompGrid(int joint, const char * file);
   */
 
 static int loadJoint(int joint, EmcIniFile *jointIniFile)
@@ -231,6 +233,11 @@ static int loadJoint(int joint, EmcIniFile *jointIniFile)
                 return -1;
             }
         }
+        if (NULL != (inistring = jointIniFile->Find("COMP_GRID_FILE", jointString))) {
+            if (0 != emcJointLoadCompGrid(joint, inistring)) {
+                return -1;
+            }
+        }
     }
 
     catch (EmcIniFile::Exception &e) {
@@ -24,6 +24,7 @@
 #include "initraj.hh"		// these decls
 #include "emcglb.h"		/*! \todo TRAVERSE_RATE (FIXME) */
 #include "inihal.hh"
+#include "tp_types.h"		// TP_PLANNER_SCURVE
 
 extern value_inihal_data old_inihal_data;
 
@@ -230,6 +231,22 @@ static int loadTraj(EmcIniFile *trajInifile)
         old_inihal_data.traj_arc_blend_tangent_kink_ratio = arcBlendTangentKinkRatio;
         //TODO update inihal
 
+        int plannerType = TP_PLANNER_TRAPEZOIDAL;
+        double maxJerk = 0.0;
+        trajInifile->Find(&plannerType, "PLANNER_TYPE", "TRAJ");
+        trajInifile->Find(&maxJerk, "MAX_LINEAR_JERK", "TRAJ");
+        if (plannerType == TP_PLANNER_SCURVE && maxJerk <= 0.0) {
+            rcs_print("[TRAJ]PLANNER_TYPE = 1 needs a positive MAX_LINEAR_JERK, using trapezoidal profiles\n");
+            plannerType = TP_PLANNER_TRAPEZOIDAL;
+        }
+
+        if (0 != emcSetPlannerType(plannerType, maxJerk)) {
+            if (emc_debug & EMC_DEBUG_CONFIG) {
+                rcs_print("bad return value from emcSetPlannerType\n");
+            }
+            return -1;
+        }
+
         double maxFeedScale = 1.0;
         trajInifile->Find(&maxFeedScale, "MAX_FEED_OVERRIDE", "DISPLAY");
 
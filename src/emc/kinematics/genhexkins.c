@@ -103,6 +103,21 @@
   genhexkins.max-iterations - maximum number of iterations spent for
                     a converged solution during current session.
 
+  genhexkins.quasi-newton - when set, each iteration
+                    reuses the inverse Jacobian of the previous one,
+                    corrected by a Broyden update, instead of computing
+                    and inverting the Jacobian again.  The inverse is
+                    kept from one call to the next, and when a call
+                    starts from the pose the previous call returned, as
+                    on the servo thread, the starting point is moved on
+                    by the change between the last two solutions.  A
+                    solution then usually takes two iterations and no
+                    matrix inversion at all.  The Jacobian is computed
+                    and inverted afresh (by LU decomposition) only when
+                    an iteration does not at least halve the error, or
+                    when the geometry changes.  Cleared by default,
+                    which uses plain Newton-Raphson.
+
  ----------------------------------------------------------------------------*/
 
 #include "rtapi_math.h"
@@ -110,6 +125,7 @@
 #include "genhexkins.h"
 #include "kinematics.h"             /* these decls, KINEMATICS_FORWARD_FLAGS */
 #include "hal.h"
+#include "rtapi_string.h"
 
 struct haldata {
     hal_float_t basex[NUM_STRUTS];
@@ -128,6 +144,7 @@ struct haldata {
     hal_float_t screw_lead;
     hal_u32_t *last_iter;
     hal_u32_t *max_iter;
+    hal_bit_t quasi_newton;
     hal_u32_t iter_limit;
     hal_float_t max_error;
     hal_float_t conv_criterion;
@@ -237,6 +254,72 @@ static void MatMult(double J[][6], const double x[], double Ans[])
   }
 }
 
+/******************************** MatInvertLU() *****************************/
+
+/*---------------------------------------------------------------------------
+  This function inverts a 6x6 matrix by LU decomposition with partial
+  pivoting.  Returns -1, leaving InvJ alone, if the matrix is singular.
+  ---------------------------------------------------------------------------*/
+
+static int MatInvertLU(double J[][NUM_STRUTS], double InvJ[][NUM_STRUTS])
+{
+  double LU[NUM_STRUTS][NUM_STRUTS], x[NUM_STRUTS], m, temp;
+  int piv[NUM_STRUTS];
+  int i, j, k, p;
+
+  for (j = 0; j < NUM_STRUTS; j++) {
+    for (k = 0; k < NUM_STRUTS; k++) {
+      LU[j][k] = J[j][k];
+    }
+    piv[j] = j;
+  }
+
+  /* factor: LU = P J */
+  for (k = 0; k < NUM_STRUTS; k++) {
+    p = k;
+    for (j = k + 1; j < NUM_STRUTS; j++) {
+      if (fabs(LU[j][k]) > fabs(LU[p][k])) {
+        p = j;
+      }
+    }
+    if (fabs(LU[p][k]) < 1e-12) {
+      return -1;
+    }
+    if (p != k) {
+      for (i = 0; i < NUM_STRUTS; i++) {
+        temp = LU[k][i]; LU[k][i] = LU[p][i]; LU[p][i] = temp;
+      }
+      i = piv[k]; piv[k] = piv[p]; piv[p] = i;
+    }
+    for (j = k + 1; j < NUM_STRUTS; j++) {
+      m = LU[j][k] /= LU[k][k];
+      for (i = k + 1; i < NUM_STRUTS; i++) {
+        LU[j][i] -= m * LU[k][i];
+      }
+    }
+  }
+
+  /* solve for each column of the inverse */
+  for (i = 0; i < NUM_STRUTS; i++) {
+    for (j = 0; j < NUM_STRUTS; j++) {
+      x[j] = piv[j] == i ? 1.0 : 0.0;
+      for (k = 0; k < j; k++) {
+        x[j] -= LU[j][k] * x[k];
+      }
+    }
+    for (j = NUM_STRUTS - 1; j >= 0; j--) {
+      for (k = j + 1; k < NUM_STRUTS; k++) {
+        x[j] -= LU[j][k] * x[k];
+      }
+      x[j] /= LU[j][j];
+    }
+    for (j = 0; j < NUM_STRUTS; j++) {
+      InvJ[j][i] = x[j];
+    }
+  }
+  return 0;
+}
+
 /* declare arrays for base and platform coordinates */
 static PmCartesian b[NUM_STRUTS];
 static PmCartesian a[NUM_STRUTS];
@@ -300,6 +383,115 @@ int StrutLengthCorrection(const PmCartesian * StrutVectUnit,
 }
 
 
+/***************************StrutLengthDiffs********************************/
+
+/* Runs the inverse kinematics on a pose estimate, giving the differences
+   between the strut lengths for the estimate and the actual joints, and
+   the inverse Jacobian at the estimate. */
+
+static int StrutLengthDiffs(const double * joints,
+                            const PmCartesian * q_trans,
+                            const PmRpy * q_RPY,
+                            double StrutLengthDiff[],
+                            double InverseJacobian[][NUM_STRUTS])
+{
+  PmCartesian aw;
+  PmCartesian InvKinStrutVect,InvKinStrutVectUnit;
+  PmCartesian RMatrix_a, RMatrix_a_cross_Strut;
+  PmRotationMatrix RMatrix;
+  double InvKinStrutLength, corr;
+  int i;
+
+  /* Convert q_RPY to Rotation Matrix */
+  pmRpyMatConvert(q_RPY, &RMatrix);
+
+  for (i = 0; i < NUM_STRUTS; i++) {
+    pmMatCartMult(&RMatrix, &a[i], &RMatrix_a);
+    pmCartCartAdd(q_trans, &RMatrix_a, &aw);
+    pmCartCartSub(&aw, &b[i], &InvKinStrutVect);
+    if (0 != pmCartUnit(&InvKinStrutVect, &InvKinStrutVectUnit)) {
+      return -1;
+    }
+    pmCartMag(&InvKinStrutVect, &InvKinStrutLength);
+
+    if (haldata->screw_lead != 0.0) {
+      /* enable strut length correction */
+      StrutLengthCorrection(&InvKinStrutVectUnit, &RMatrix, i, &corr);
+      /* define corrected joint lengths */
+      InvKinStrutLength += corr;
+    }
+
+    StrutLengthDiff[i] = InvKinStrutLength - joints[i];
+
+    /* Determine RMatrix_a_cross_strut */
+    pmCartCartCross(&RMatrix_a, &InvKinStrutVectUnit, &RMatrix_a_cross_Strut);
+
+    /* Build Inverse Jacobian Matrix */
+    InverseJacobian[i][0] = InvKinStrutVectUnit.x;
+    InverseJacobian[i][1] = InvKinStrutVectUnit.y;
+    InverseJacobian[i][2] = InvKinStrutVectUnit.z;
+    InverseJacobian[i][3] = RMatrix_a_cross_Strut.x;
+    InverseJacobian[i][4] = RMatrix_a_cross_Strut.y;
+    InverseJacobian[i][5] = RMatrix_a_cross_Strut.z;
+  }
+  return 0;
+}
+
+/* Turns the last three columns of an inverse Jacobian from derivatives by
+   angular velocity into derivatives by the roll, pitch and yaw angles the
+   iteration actually steps, using the rates of R = Rz(y) Ry(p) Rx(r). */
+
+static void RpyInverseJacobian(const PmRpy * q_RPY,
+                               double InverseJacobian[][NUM_STRUTS])
+{
+  double sy = sin(q_RPY->y), cy = cos(q_RPY->y);
+  double sp = sin(q_RPY->p), cp = cos(q_RPY->p);
+  double wx, wy, wz;
+  int i;
+
+  for (i = 0; i < NUM_STRUTS; i++) {
+    wx = InverseJacobian[i][3];
+    wy = InverseJacobian[i][4];
+    wz = InverseJacobian[i][5];
+    InverseJacobian[i][3] = wx * cy * cp + wy * sy * cp - wz * sp;
+    InverseJacobian[i][4] = -wx * sy + wy * cy;
+    InverseJacobian[i][5] = wz;
+  }
+}
+
+/* The Jacobian kept by the quasi-Newton iteration from one call to the
+   next, and the geometry it belongs to. */
+static double QNJacobian[NUM_STRUTS][NUM_STRUTS];
+static int QNJacobianValid;
+static PmCartesian QNa[NUM_STRUTS], QNb[NUM_STRUTS];
+static PmCartesian QNna0[NUM_STRUTS], QNnb1[NUM_STRUTS];
+static double QNScrewLead;
+
+/* The last two solutions.  Only a call that starts from the pose the last
+   one returned, as it does on the servo thread, is a warm start: its
+   starting point is moved on by the difference between them, and it
+   steps with the kept Jacobian and Broyden updates.  Any other call is
+   solved by Newton-Raphson with a Jacobian computed on every iteration,
+   as is a warm start that fails to converge. */
+static EmcPose QNLastPose, QNPrevPose;
+static int QNPoses;
+
+static int QNGeometryChanged(void)
+{
+  int changed = memcmp(QNa, a, sizeof(a)) || memcmp(QNb, b, sizeof(b)) ||
+                memcmp(QNna0, na0, sizeof(na0)) ||
+                memcmp(QNnb1, nb1, sizeof(nb1)) ||
+                QNScrewLead != haldata->screw_lead;
+  if (changed) {
+    memcpy(QNa, a, sizeof(a));
+    memcpy(QNb, b, sizeof(b));
+    memcpy(QNna0, na0, sizeof(na0));
+    memcpy(QNnb1, nb1, sizeof(nb1));
+    QNScrewLead = haldata->screw_lead;
+  }
+  return changed;
+}
+
 /**************************** kinematicsForward() ***************************/
 
 int kinematicsForward(const double * joints,
@@ -308,23 +500,23 @@ int kinematicsForward(const double * joints,
                       KINEMATICS_INVERSE_FLAGS * iflags)
 {
 
-  PmCartesian aw;
-  PmCartesian InvKinStrutVect,InvKinStrutVectUnit;
-  PmCartesian q_trans, RMatrix_a, RMatrix_a_cross_Strut;
+  PmCartesian q_trans;
+  EmcPose start;
 
   double Jacobian[NUM_STRUTS][NUM_STRUTS];
   double InverseJacobian[NUM_STRUTS][NUM_STRUTS];
-  double InvKinStrutLength, StrutLengthDiff[NUM_STRUTS];
-  double delta[NUM_STRUTS];
+  double StrutLengthDiff[NUM_STRUTS], LastStrutLengthDiff[NUM_STRUTS];
+  double delta[NUM_STRUTS], y[NUM_STRUTS], Jy[NUM_STRUTS], dJ[NUM_STRUTS];
   double conv_err = 1.0;
-  double corr;
+  double last_err, d;
 
-  PmRotationMatrix RMatrix;
   PmRpy q_RPY;
 
-  int iterate = 1;
-  int i;
-  int iteration = 0;
+  int quasi_newton = haldata->quasi_newton;
+  int broyden;
+  int iterate;
+  int i, j;
+  int iteration, iterations = 0;
 
   genhexkins_read_hal_pins();
 
@@ -340,15 +532,38 @@ int kinematicsForward(const double * joints,
     return -1;
   }
 
+  if (QNGeometryChanged()) {
+    QNJacobianValid = 0;
+  }
+
+  if (!quasi_newton || memcmp(pos, &QNLastPose, sizeof(EmcPose))) {
+    QNPoses = 0;
+  }
+  broyden = QNPoses > 0 && QNJacobianValid;
+  start = *pos;
+  if (QNPoses == 2) {
+    start.tran.x += QNLastPose.tran.x - QNPrevPose.tran.x;
+    start.tran.y += QNLastPose.tran.y - QNPrevPose.tran.y;
+    start.tran.z += QNLastPose.tran.z - QNPrevPose.tran.z;
+    start.a += QNLastPose.a - QNPrevPose.a;
+    start.b += QNLastPose.b - QNPrevPose.b;
+    start.c += QNLastPose.c - QNPrevPose.c;
+  }
+
+restart:
+  conv_err = 1.0;
+  iterate = 1;
+  iteration = 0;
+
   /* assign a,b,c to roll, pitch, yaw angles */
-  q_RPY.r = pos->a * PM_PI / 180.0;
-  q_RPY.p = pos->b * PM_PI / 180.0;
-  q_RPY.y = pos->c * PM_PI / 180.0;
+  q_RPY.r = start.a * PM_PI / 180.0;
+  q_RPY.p = start.b * PM_PI / 180.0;
+  q_RPY.y = start.c * PM_PI / 180.0;
 
   /* Assign translation values in pos to q_trans */
-  q_trans.x = pos->tran.x;
-  q_trans.y = pos->tran.y;
-  q_trans.z = pos->tran.z;
+  q_trans.x = start.tran.x;
+  q_trans.y = start.tran.y;
+  q_trans.z = start.tran.z;
 
   /* Enter Newton-Raphson iterative method   */
   while (iterate) {
@@ -356,59 +571,93 @@ int kinematicsForward(const double * joints,
     if ((conv_err > +(haldata->max_error)) ||
     (conv_err < -(haldata->max_error))) {
       /* we can't converge */
+      QNJacobianValid = 0;
+      if (broyden) {
+        goto newton;
+      }
       return -2;
     };
 
     iteration++;
+    iterations++;
 
     /* check iteration to see if the kinematics can reach the
        convergence criterion and return error flag if it can't */
     if (iteration > haldata->iter_limit) {
       /* we can't converge */
+      QNJacobianValid = 0;
+      if (broyden) {
+        goto newton;
+      }
       return -5;
     }
 
-    /* Convert q_RPY to Rotation Matrix */
-    pmRpyMatConvert(&q_RPY, &RMatrix);
-
     /* compute StrutLengthDiff[] by running inverse kins on Cartesian
      estimate to get joint estimate, subtract joints to get joint deltas,
      and compute inv J while we're at it */
-    for (i = 0; i < NUM_STRUTS; i++) {
-      pmMatCartMult(&RMatrix, &a[i], &RMatrix_a);
-      pmCartCartAdd(&q_trans, &RMatrix_a, &aw);
-      pmCartCartSub(&aw, &b[i], &InvKinStrutVect);
-      if (0 != pmCartUnit(&InvKinStrutVect, &InvKinStrutVectUnit)) {
-        return -1;
+    if (0 != StrutLengthDiffs(joints, &q_trans, &q_RPY,
+                              StrutLengthDiff, InverseJacobian)) {
+      QNJacobianValid = 0;
+      if (broyden) {
+        goto newton;
       }
-      pmCartMag(&InvKinStrutVect, &InvKinStrutLength);
-
-      if (haldata->screw_lead != 0.0) {
-        /* enable strut length correction */
-        StrutLengthCorrection(&InvKinStrutVectUnit, &RMatrix, i, &corr);
-        /* define corrected joint lengths */
-        InvKinStrutLength += corr;
-      }
-
-      StrutLengthDiff[i] = InvKinStrutLength - joints[i];
-
-      /* Determine RMatrix_a_cross_strut */
-      pmCartCartCross(&RMatrix_a, &InvKinStrutVectUnit, &RMatrix_a_cross_Strut);
-
-      /* Build Inverse Jacobian Matrix */
-      InverseJacobian[i][0] = InvKinStrutVectUnit.x;
-      InverseJacobian[i][1] = InvKinStrutVectUnit.y;
-      InverseJacobian[i][2] = InvKinStrutVectUnit.z;
-      InverseJacobian[i][3] = RMatrix_a_cross_Strut.x;
-      InverseJacobian[i][4] = RMatrix_a_cross_Strut.y;
-      InverseJacobian[i][5] = RMatrix_a_cross_Strut.z;
+      return -1;
     }
 
-    /* invert Inverse Jacobian */
-    MatInvert(InverseJacobian, Jacobian);
+    last_err = conv_err;
+    /* determine value of conv_error (used to determine if no convergence) */
+    conv_err = 0.0;
+    for (i = 0; i < NUM_STRUTS; i++) {
+      conv_err += fabs(StrutLengthDiff[i]);
+    }
 
-    /* multiply Jacobian by LegLengthDiff */
-    MatMult(Jacobian, StrutLengthDiff, delta);
+    if (!quasi_newton) {
+      /* invert Inverse Jacobian */
+      MatInvert(InverseJacobian, Jacobian);
+
+      /* multiply Jacobian by LegLengthDiff */
+      MatMult(Jacobian, StrutLengthDiff, delta);
+    } else {
+      d = 0.0;
+      if (broyden && iteration > 1 && conv_err <= 0.5 * last_err) {
+        /* Broyden update of the Jacobian for the step just taken:
+           J += (s - J y) s^T J / (s^T J y), with step s = -delta and
+           y the change in StrutLengthDiff */
+        for (i = 0; i < NUM_STRUTS; i++) {
+          y[i] = StrutLengthDiff[i] - LastStrutLengthDiff[i];
+        }
+        MatMult(QNJacobian, y, Jy);
+        for (i = 0; i < NUM_STRUTS; i++) {
+          d -= delta[i] * Jy[i];
+        }
+      }
+      if (fabs(d) > 1e-30) {
+        for (j = 0; j < NUM_STRUTS; j++) {
+          dJ[j] = 0.0;
+          for (i = 0; i < NUM_STRUTS; i++) {
+            dJ[j] -= delta[i] * QNJacobian[i][j];
+          }
+        }
+        for (i = 0; i < NUM_STRUTS; i++) {
+          for (j = 0; j < NUM_STRUTS; j++) {
+            QNJacobian[i][j] += (-delta[i] - Jy[i]) * dJ[j] / d;
+          }
+        }
+      } else if (!broyden || iteration > 1) {
+        /* Newton-Raphson, or the last step didn't do well enough:
+           start again from the real thing */
+        RpyInverseJacobian(&q_RPY, InverseJacobian);
+        if (0 != MatInvertLU(InverseJacobian, QNJacobian)) {
+          QNJacobianValid = 0;
+          return -1;
+        }
+        QNJacobianValid = 1;
+      }
+      for (i = 0; i < NUM_STRUTS; i++) {
+        LastStrutLengthDiff[i] = StrutLengthDiff[i];
+      }
+      MatMult(QNJacobian, StrutLengthDiff, delta);
+    }
 
     /* subtract delta from last iterations pos values */
     q_trans.x -= delta[0];
@@ -418,12 +667,6 @@ int kinematicsForward(const double * joints,
     q_RPY.p   -= delta[4];
     q_RPY.y   -= delta[5];
 
-    /* determine value of conv_error (used to determine if no convergence) */
-    conv_err = 0.0;
-    for (i = 0; i < NUM_STRUTS; i++) {
-      conv_err += fabs(StrutLengthDiff[i]);
-    }
-
     /* enter loop to determine if a strut needs another iteration */
     iterate = 0;            /*assume iteration is done */
     for (i = 0; i < NUM_STRUTS; i++) {
@@ -443,12 +686,25 @@ int kinematicsForward(const double * joints,
   pos->tran.y = q_trans.y;
   pos->tran.z = q_trans.z;
 
-  *haldata->last_iter = iteration;
+  QNPrevPose = QNLastPose;
+  QNLastPose = *pos;
+  if (QNPoses < 2) {
+    QNPoses++;
+  }
+
+  *haldata->last_iter = iterations;
 
-  if (iteration > *haldata->max_iter){
-    *haldata->max_iter = iteration;
+  if (iterations > *haldata->max_iter){
+    *haldata->max_iter = iterations;
   }
   return 0;
+
+newton:
+  /* the warm start failed: solve again from the pose we were given */
+  broyden = 0;
+  QNPoses = 0;
+  start = *pos;
+  goto restart;
 }
 
 
@@ -606,6 +862,11 @@ int rtapi_app_main(void)
     goto error;
     *haldata->max_iter = 0;
 
+    if ((res = hal_param_bit_newf(HAL_RW, &haldata->quasi_newton, comp_id,
+        "genhexkins.quasi-newton")) < 0)
+    goto error;
+    haldata->quasi_newton = 0;
+
     if ((res = hal_param_float_newf(HAL_RW, &haldata->max_error, comp_id,
         "genhexkins.max-error")) < 0)
     goto error;
@@ -64,17 +64,15 @@ int num_axes = EMCMOT_MAX_AXIS;
 emcmot_axis_t *axes = 0;
 
 void emcmot_config_change(void) {
-    if (emcmotConfig->head == emcmotConfig->tail) {
-        emcmotConfig->head++;
-        emcmotConfig->config_num++;
-        emcmotStatus->config_num = emcmotConfig->config_num;
-        emcmotConfig->tail = emcmotConfig->head;
-    }
+    emcmot_seq_write_begin(&emcmotConfig->seq);
+    emcmotConfig->config_num++;
+    emcmotStatus->config_num = emcmotConfig->config_num;
+    emcmot_seq_write_end(&emcmotConfig->seq);
 }
 
 
 static int init_comm_buffers(void) {
-    int joint_num, axis_num, n;
+    int joint_num, axis_num;
     emcmot_joint_t *joint;
     emcmot_axis_t *axis;
     int retval;
@@ -107,7 +105,7 @@ static int init_comm_buffers(void) {
     memset(emcmotStruct, 0, sizeof(emcmot_struct_t));
 
     /* we'll reference emcmotStruct directly */
-    c = &emcmotStruct->command;
+    c = &emcmotStruct->command.slot[0];
     emcmotStatus = &emcmotStruct->status;
     emcmotConfig = &emcmotStruct->config;
     emcmotDebug = &emcmotStruct->debug;
@@ -150,22 +148,14 @@ static int init_comm_buffers(void) {
 	joint->min_ferror = 0.01;
 	joint->max_ferror = 1.0;
 
-	joint->comp.entry = &(joint->comp.array[0]);
-	/* the compensation code has -DBL_MAX at one end of the table
-	   and +DBL_MAX at the other so _all_ commanded positions are
-	   guaranteed to be covered by the table */
-	joint->comp.array[0].nominal = -DBL_MAX;
-	joint->comp.array[0].fwd_trim = 0.0;
-	joint->comp.array[0].rev_trim = 0.0;
-	joint->comp.array[0].fwd_slope = 0.0;
-	joint->comp.array[0].rev_slope = 0.0;
-	for ( n = 1 ; n < EMCMOT_COMP_SIZE+2 ; n++ ) {
-	    joint->comp.array[n].nominal = DBL_MAX;
-	    joint->comp.array[n].fwd_trim = 0.0;
-	    joint->comp.array[n].rev_trim = 0.0;
-	    joint->comp.array[n].fwd_slope = 0.0;
-	    joint->comp.array[n].rev_slope = 0.0;
-	}
+	/* comp commands are only logged, so there are no tables */
+	joint->comp.entries = 0;
+	joint->comp.max_entries = 0;
+	joint->comp.index = 0;
+	joint->comp_grid.axes = 0;
+	joint->comp_grid.points = 0;
+	joint->comp_grid.loaded = 0;
+	joint->screw_corr = 0.0;
 
 	/* init status info */
 	joint->ferror_limit = joint->min_ferror;
@@ -307,22 +297,20 @@ int main(int argc, char* argv[]) {
     init_comm_buffers();
 
     while (1) {
-        if (c->commandNum != c->tail) {
-            // "split read"
-            continue;
-        }
-        if (c->commandNum == emcmotStatus->commandNumEcho) {
+        emcmot_command_ring_t *ring = &emcmotStruct->command;
+        if (ring->tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
             // nothing new
             maybe_reopen_logfile();
             usleep(10 * 1000);
             continue;
         }
+        c = &ring->slot[ring->tail % EMCMOT_COMMAND_RING_SIZE];
 
         //
         // new incoming command!
         //
 
-        emcmotStatus->head++;
+        emcmot_seq_write_begin(&emcmotStatus->seq);
 
         switch (c->command) {
             case EMCMOT_ABORT:
@@ -666,6 +654,15 @@ int main(int argc, char* argv[]) {
                 log_print("SET_JOINT_COMP\n");
                 break;
 
+            case EMCMOT_SET_JOINT_COMP_GRID:
+                log_print("SET_JOINT_COMP_GRID joint=%d, axes=%d\n", c->joint, c->comp_grid_axes);
+                break;
+
+            case EMCMOT_SET_JOINT_COMP_GRID_VALUES:
+                log_print("SET_JOINT_COMP_GRID_VALUES joint=%d, first=%d, count=%d\n",
+                    c->joint, c->comp_grid_first, c->comp_grid_count);
+                break;
+
             case EMCMOT_SET_OFFSET:
                 log_print(
                     "SET_OFFSET x=%.6f, y=%.6f, z=%.6f, a=%.6f, b=%.6f, c=%.6f u=%.6f, v=%.6f, w=%.6f\n",
@@ -683,6 +680,10 @@ int main(int argc, char* argv[]) {
                 log_print("SETUP_ARC_BLENDS\n");
                 break;
 
+            case EMCMOT_SET_PLANNER_TYPE:
+                log_print("SET_PLANNER_TYPE %d %.6f\n", c->plannerType, c->maxJerk);
+                break;
+
             case EMCMOT_SET_PROBE_ERR_INHIBIT:
                 log_print("SETUP_SET_PROBE_ERR_INHIBIT %d %d\n",
                           c->probe_jog_err_inhibit,
@@ -700,7 +701,8 @@ int main(int argc, char* argv[]) {
         emcmotStatus->commandEcho = c->command;
         emcmotStatus->commandNumEcho = c->commandNum;
         emcmotStatus->commandStatus = EMCMOT_COMMAND_OK;
-        emcmotStatus->tail = emcmotStatus->head;
+        emcmot_seq_write_end(&emcmotStatus->seq);
+        __atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
     }
 
     return 0;
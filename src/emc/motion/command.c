@@ -77,6 +77,10 @@ extern int motion_num_spindles;
 
 static int rehomeAll;
 
+/* set when a queued move fails; the moves task queued behind it are
+   dropped until it sends EMCMOT_ABORT */
+static int drop_queued_moves;
+
 /* loops through the active joints and checks if any are not homed */
 bool checkAllHomed(void)
 {
@@ -401,10 +405,9 @@ STATIC int is_feed_type(int motion_type)
 }
 
 /*
-  emcmotCommandHandler() is called each main cycle to read the
-  shared memory buffer
+  handle_command() carries out the command in *emcmotCommand
   */
-void emcmotCommandHandler(void *arg, long period)
+static void handle_command(void)
 {
     int joint_num, axis_num, spindle_num;
     int n;
@@ -412,19 +415,18 @@ void emcmotCommandHandler(void *arg, long period)
     emcmot_axis_t *axis;
     double tmp1;
     emcmot_comp_entry_t *comp_entry;
+    emcmot_comp_grid_t *comp_grid;
     char issue_atspeed = 0;
     int abort = 0;
     char* emsg = "";
 
-    /* check for split read */
-    if (emcmotCommand->head != emcmotCommand->tail) {
-	emcmotDebug->split++;
-	return;			/* not really an error */
+    if (drop_queued_moves && EMCMOT_QUEUED_COMMAND(emcmotCommand->command)) {
+	return;
     }
     if (emcmotCommand->commandNum != emcmotStatus->commandNumEcho) {
-	/* increment head count-- we'll be modifying emcmotStatus */
-	emcmotStatus->head++;
-	emcmotDebug->head++;
+	/* bump the sequence counts-- we'll be modifying emcmotStatus */
+	emcmot_seq_write_begin(&emcmotStatus->seq);
+	emcmot_seq_write_begin(&emcmotDebug->seq);
 
 	/* got a new command-- echo command and number... */
 	emcmotStatus->commandEcho = emcmotCommand->command;
@@ -1883,24 +1885,26 @@ void emcmotCommandHandler(void *arg, long period)
 	    if (joint == 0) {
 		break;
 	    }
-	    if (joint->comp.entries >= EMCMOT_COMP_SIZE) {
-		reportError(_("joint %d: too many compensation entries"), joint_num);
+	    if (joint->comp.entries >= joint->comp.max_entries) {
+		reportError(_("joint %d: too many compensation entries, motmod comp_size is %d"),
+			    joint_num, joint->comp.max_entries);
 		break;
 	    }
 	    /* point to last entry */
-	    comp_entry = &(joint->comp.array[joint->comp.entries]);
-	    if (emcmotCommand->comp_nominal <= comp_entry[0].nominal) {
+	    n = joint->comp.entries;
+	    comp_entry = &(joint->comp.entry[n]);
+	    if (emcmotCommand->comp_nominal <= joint->comp.nominal[n]) {
 		reportError(_("joint %d: compensation values must increase"), joint_num);
 		break;
 	    }
 	    /* store data to new entry */
-	    comp_entry[1].nominal = emcmotCommand->comp_nominal;
+	    joint->comp.nominal[n+1] = emcmotCommand->comp_nominal;
 	    comp_entry[1].fwd_trim = emcmotCommand->comp_forward;
 	    comp_entry[1].rev_trim = emcmotCommand->comp_reverse;
 	    /* calculate slopes from previous entry to the new one */
-	    if ( comp_entry[0].nominal != -DBL_MAX ) {
+	    if ( joint->comp.nominal[n] != -DBL_MAX ) {
 		/* but only if the previous entry is "real" */
-		tmp1 = comp_entry[1].nominal - comp_entry[0].nominal;
+		tmp1 = joint->comp.nominal[n+1] - joint->comp.nominal[n];
 		comp_entry[0].fwd_slope =
 		    (comp_entry[1].fwd_trim - comp_entry[0].fwd_trim) / tmp1;
 		comp_entry[0].rev_slope =
@@ -1913,6 +1917,72 @@ void emcmotCommandHandler(void *arg, long period)
 	    joint->comp.entries++;
 	    break;
 
+	case EMCMOT_SET_JOINT_COMP_GRID:
+	    rtapi_print_msg(RTAPI_MSG_DBG, "SET_JOINT_COMP_GRID for joint %d", joint_num);
+	    if (joint == 0) {
+		break;
+	    }
+	    comp_grid = &(joint->comp_grid);
+	    /* stop using the old grid; the new one is used once it is complete */
+	    comp_grid->points = 0;
+	    comp_grid->loaded = 0;
+	    comp_grid->axes = emcmotCommand->comp_grid_axes;
+	    if (comp_grid->axes < 1 || comp_grid->axes > EMCMOT_COMP_GRID_AXES) {
+		reportError(_("joint %d: compensation grid must have 1 to %d axes"),
+			    joint_num, EMCMOT_COMP_GRID_AXES);
+		comp_grid->axes = 0;
+		break;
+	    }
+	    tmp1 = 1;
+	    for (n = 0; n < comp_grid->axes; n++) {
+		comp_grid->joint[n] = emcmotCommand->comp_grid_joint[n];
+		comp_grid->size[n] = emcmotCommand->comp_grid_size[n];
+		comp_grid->start[n] = emcmotCommand->comp_grid_start[n];
+		if (comp_grid->joint[n] < 0 || comp_grid->joint[n] >= ALL_JOINTS) {
+		    reportError(_("joint %d: compensation grid axis %d is not a joint"),
+				joint_num, n);
+		    break;
+		}
+		if (comp_grid->size[n] < 2 || !(emcmotCommand->comp_grid_step[n] > 0.0)) {
+		    reportError(_("joint %d: compensation grid axis %d needs two or more increasing points"),
+				joint_num, n);
+		    break;
+		}
+		comp_grid->inv_step[n] = 1.0 / emcmotCommand->comp_grid_step[n];
+		tmp1 *= comp_grid->size[n];
+	    }
+	    if (n < comp_grid->axes) {
+		comp_grid->axes = 0;
+		break;
+	    }
+	    if (tmp1 > comp_grid->max_points) {
+		reportError(_("joint %d: too many compensation grid points, motmod comp_grid_size is %d"),
+			    joint_num, comp_grid->max_points);
+		comp_grid->axes = 0;
+		break;
+	    }
+	    comp_grid->points = tmp1;
+	    break;
+
+	case EMCMOT_SET_JOINT_COMP_GRID_VALUES:
+	    rtapi_print_msg(RTAPI_MSG_DBG, "SET_JOINT_COMP_GRID_VALUES for joint %d", joint_num);
+	    if (joint == 0) {
+		break;
+	    }
+	    comp_grid = &(joint->comp_grid);
+	    if (emcmotCommand->comp_grid_first != comp_grid->loaded ||
+		emcmotCommand->comp_grid_count < 1 ||
+		emcmotCommand->comp_grid_count > EMCMOT_COMP_GRID_BATCH ||
+		emcmotCommand->comp_grid_count > comp_grid->points - comp_grid->loaded) {
+		reportError(_("joint %d: compensation grid values out of order"), joint_num);
+		break;
+	    }
+	    for (n = 0; n < emcmotCommand->comp_grid_count; n++) {
+		comp_grid->value[comp_grid->loaded + n] = emcmotCommand->comp_grid_value[n];
+	    }
+	    comp_grid->loaded += emcmotCommand->comp_grid_count;
+	    break;
+
         case EMCMOT_SET_OFFSET:
             emcmotStatus->tool_offset = emcmotCommand->tool_offset;
             break;
@@ -1982,6 +2052,10 @@ void emcmotCommandHandler(void *arg, long period)
             emcmotConfig->arcBlendRampFreq = emcmotCommand->arcBlendRampFreq;
             emcmotConfig->arcBlendTangentKinkRatio = emcmotCommand->arcBlendTangentKinkRatio;
             break;
+        case EMCMOT_SET_PLANNER_TYPE:
+            emcmotConfig->plannerType = emcmotCommand->plannerType;
+            emcmotConfig->maxJerk = emcmotCommand->maxJerk;
+            break;
         case EMCMOT_SET_PROBE_ERR_INHIBIT:
             emcmotConfig->inhibit_probe_jog_error = emcmotCommand->probe_jog_err_inhibit;
             emcmotConfig->inhibit_probe_home_error = emcmotCommand->probe_home_err_inhibit;
@@ -1993,13 +2067,57 @@ void emcmotCommandHandler(void *arg, long period)
 		emcmotStatus->commandStatus);
 	}
 	rtapi_print_msg(RTAPI_MSG_DBG, "\n");
-	/* synch tail count */
-	emcmotStatus->tail = emcmotStatus->head;
-	emcmotConfig->tail = emcmotConfig->head;
-	emcmotDebug->tail = emcmotDebug->head;
+	if (EMCMOT_QUEUED_COMMAND(emcmotCommand->command)) {
+	    /* task counts moves it has queued but we haven't echoed yet
+	       as pending, so the depth has to be current along with it */
+	    emcmotStatus->depth = tpQueueDepth(&emcmotDebug->coord_tp);
+	    emcmotStatus->queueFull = tcqFull(&emcmotDebug->coord_tp.queue);
+	    /* task didn't wait to hear about this one */
+	    if (emcmotStatus->commandStatus != EMCMOT_COMMAND_OK) {
+		emcmotStatus->queuedFailNum = emcmotCommand->commandNum;
+		drop_queued_moves = 1;
+	    }
+	} else if (emcmotCommand->command == EMCMOT_ABORT) {
+	    drop_queued_moves = 0;
+	}
+	/* done; config is only open if emcmot_config_change() was called */
+	emcmot_seq_write_end(&emcmotStatus->seq);
+	if (emcmotConfig->seq & 1) {
+	    emcmot_seq_write_end(&emcmotConfig->seq);
+	}
+	emcmot_seq_write_end(&emcmotDebug->seq);
 
     }
     /* end of: if-new-command */
 
     return;
 }
+
+/*
+  emcmotCommandHandler() is called each main cycle to handle the
+  commands task has put in the shared memory ring
+  */
+void emcmotCommandHandler(void *arg, long period)
+{
+    emcmot_command_ring_t *ring = &emcmotStruct->command;
+    unsigned int head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    unsigned int tail = ring->tail;
+    int queued = 0;
+
+    if (head - tail > EMCMOT_COMMAND_RING_SIZE) {
+	/* can't happen unless task wrote garbage */
+	emcmotDebug->split++;
+	return;
+    }
+    /* only what is there now, and only a few moves, so task can't hold
+       up the cycle; commands stay in order behind the moves left over */
+    while (tail != head) {
+	emcmotCommand = &ring->slot[tail % EMCMOT_COMMAND_RING_SIZE];
+	if (EMCMOT_QUEUED_COMMAND(emcmotCommand->command)
+	    && ++queued > EMCMOT_QUEUED_PER_CYCLE) {
+	    break;
+	}
+	handle_command();
+	__atomic_store_n(&ring->tail, ++tail, __ATOMIC_RELEASE);
+    }
+}
@@ -26,6 +26,7 @@
 #include "config.h"
 #include "motion_types.h"
 #include "homing.h"
+#include "jointcomp.h"
 
 // Mark strings for translation, but defer translation to userspace
 #define _(s) (s)
@@ -156,6 +157,9 @@ static void get_pos_cmds(long period);
    value is in backlash_corr, however has makes step changes when
    the direction reverses.  backlash_filt is a ramped version, and
    that is the one that is later added/subtracted from the position.
+   A volumetric compensation grid, if the joint has one, adds to
+   backlash_corr a correction that depends on the commanded positions
+   of the joints indexing the grid.
 */
 static void compute_screw_comp(void);
 
@@ -236,8 +240,8 @@ void emcmotController(void *arg, long period)
     /* calculate servo frequency for calcs like vel = Dpos / period */
     /* it's faster to do vel = Dpos * freq */
     servo_freq = 1.0 / servo_period;
-    /* increment head count to indicate work in progress */
-    emcmotStatus->head++;
+    /* make the sequence count odd to indicate work in progress */
+    emcmot_seq_write_begin(&emcmotStatus->seq);
     /* here begins the core of the controller */
 
     read_homing_in_pins(ALL_JOINTS);
@@ -258,8 +262,12 @@ void emcmotController(void *arg, long period)
     update_status();
     /* here ends the core of the controller */
     emcmotStatus->heartbeat++;
-    /* set tail to head, to indicate work complete */
-    emcmotStatus->tail = emcmotStatus->head;
+    /* make it even again, to indicate work complete */
+    emcmot_seq_write_end(&emcmotStatus->seq);
+    /* emcmotSetCycleTime() above may have changed config */
+    if (emcmotConfig->seq & 1) {
+	emcmot_seq_write_end(&emcmotConfig->seq);
+    }
 /* end of controller function */
 }
 
@@ -1632,6 +1640,7 @@ static void compute_screw_comp(void)
     int joint_num;
     emcmot_joint_t *joint;
     emcmot_comp_t *comp;
+    emcmot_comp_entry_t *entry;
     double dpos;
     double a_max, v_max, v, s_to_go, ds_stop, ds_vel, ds_acc, dv_acc;
 
@@ -1649,22 +1658,16 @@ static void compute_screw_comp(void)
 	if ( comp->entries > 0 ) {
 	    /* there is data in the comp table, use it */
 	    /* first make sure we're in the right spot in the table */
-	    while ( joint->pos_cmd < comp->entry->nominal ) {
-		comp->entry--;
-	    }
-	    while ( joint->pos_cmd >= (comp->entry+1)->nominal ) {
-		comp->entry++;
-	    }
+	    comp->index = find_comp_entry(comp, joint->pos_cmd);
+	    entry = &(comp->entry[comp->index]);
 	    /* now interpolate */
-	    dpos = joint->pos_cmd - comp->entry->nominal;
+	    dpos = joint->pos_cmd - comp->nominal[comp->index];
 	    if (joint->vel_cmd > 0.0) {
 	        /* moving "up". apply forward screw comp */
-		joint->backlash_corr = comp->entry->fwd_trim + 
-					comp->entry->fwd_slope * dpos;
+		joint->screw_corr = entry->fwd_trim + entry->fwd_slope * dpos;
 	    } else if (joint->vel_cmd < 0.0) {
 	        /* moving "down". apply reverse screw comp */
-		joint->backlash_corr = comp->entry->rev_trim +
-					comp->entry->rev_slope * dpos;
+		joint->screw_corr = entry->rev_trim + entry->rev_slope * dpos;
 	    } else {
 		/* not moving, use whatever was there before */
 	    }
@@ -1678,14 +1681,20 @@ static void compute_screw_comp(void)
 	    /* determine which way the compensation should be applied */
 	    if (joint->vel_cmd > 0.0) {
 	        /* moving "up". apply positive backlash comp */
-		joint->backlash_corr = 0.5 * joint->backlash;
+		joint->screw_corr = 0.5 * joint->backlash;
 	    } else if (joint->vel_cmd < 0.0) {
 	        /* moving "down". apply negative backlash comp */
-		joint->backlash_corr = -0.5 * joint->backlash;
+		joint->screw_corr = -0.5 * joint->backlash;
 	    } else {
 		/* not moving, use whatever was there before */
 	    }
 	}
+	joint->backlash_corr = joint->screw_corr;
+	/* add volumetric comp, which doesn't depend on direction */
+	if (joint->comp_grid.points > 0 &&
+	    joint->comp_grid.loaded == joint->comp_grid.points) {
+	    joint->backlash_corr += comp_grid_value(&(joint->comp_grid), joints);
+	}
 	/* at this point, the correction has been computed, but
 	   the value may make abrupt jumps on direction reversal */
     /*
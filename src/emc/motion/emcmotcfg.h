@@ -38,6 +38,12 @@
 #error A 64 bit bitmask is used in the planner.  Don't increase these until that's fixed.
 #endif
 
+/* volumetric compensation grids: joints indexing a grid, most points
+   in a grid, and points sent to motion per command */
+#define EMCMOT_COMP_GRID_AXES 3
+#define EMCMOT_COMP_GRID_SIZE 4096
+#define EMCMOT_COMP_GRID_BATCH 32
+
 #define EMCMOT_ERROR_NUM 32	/* how many errors we can queue */
 #define EMCMOT_ERROR_LEN 1024	/* how long error string can be */
 
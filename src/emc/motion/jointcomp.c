@@ -0,0 +1,98 @@
+/********************************************************************
+* Description: jointcomp.c
+*   Leadscrew compensation table lookup and volumetric compensation
+*   grid interpolation, used by compute_screw_comp() in control.c.
+*   Kept apart from control.c so that they can be unit tested.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+
+#include "motion.h"
+#include "jointcomp.h"
+
+/* Find the comp table entry whose interval holds pos.  From one cycle
+   to the next the position stays in the same interval or moves to a
+   neighbour, so those are tried before searching the table. */
+int find_comp_entry(const emcmot_comp_t *comp, double pos)
+{
+    const double *nominal = comp->nominal;
+    int n = comp->index;
+    int lo, hi, mid;
+
+    if (pos >= nominal[n]) {
+	if (n == comp->entries || pos < nominal[n+1]) {
+	    return n;
+	}
+	if (n + 1 == comp->entries || pos < nominal[n+2]) {
+	    return n + 1;
+	}
+	lo = n + 2;
+	hi = comp->entries;
+    } else {
+	if (n == 0 || pos >= nominal[n-1]) {
+	    return n > 0 ? n - 1 : 0;
+	}
+	lo = 0;
+	hi = n - 2;
+    }
+    /* nominal[lo] <= pos; find the last entry that still is */
+    while (lo < hi) {
+	mid = lo + (hi - lo + 1) / 2;
+	if (nominal[mid] <= pos) {
+	    lo = mid;
+	} else {
+	    hi = mid - 1;
+	}
+    }
+    return lo;
+}
+
+/* Interpolate a joint's compensation grid at the commanded positions
+   of the joints indexing it. */
+double comp_grid_value(const emcmot_comp_grid_t *grid,
+		       const emcmot_joint_t *joints)
+{
+    int offset[EMCMOT_COMP_GRID_AXES];
+    double frac[EMCMOT_COMP_GRID_AXES];
+    int n, i, base, stride, corner, index;
+    double u, w, value;
+
+    /* find the grid cell, holding the edge value outside the grid */
+    base = 0;
+    stride = 1;
+    for (n = 0; n < grid->axes; n++) {
+	u = (joints[grid->joint[n]].pos_cmd - grid->start[n]) * grid->inv_step[n];
+	if (!(u > 0.0)) {
+	    u = 0.0;
+	} else if (u > grid->size[n] - 1) {
+	    u = grid->size[n] - 1;
+	}
+	i = (int) u;
+	if (i > grid->size[n] - 2) {
+	    i = grid->size[n] - 2;
+	}
+	frac[n] = u - i;
+	base += i * stride;
+	offset[n] = stride;
+	stride *= grid->size[n];
+    }
+    /* blend the points at its corners */
+    value = 0.0;
+    for (corner = 0; corner < (1 << grid->axes); corner++) {
+	w = 1.0;
+	index = base;
+	for (n = 0; n < grid->axes; n++) {
+	    if (corner & (1 << n)) {
+		w *= frac[n];
+		index += offset[n];
+	    } else {
+		w *= 1.0 - frac[n];
+	    }
+	}
+	value += w * grid->value[index];
+    }
+    return value;
+}
@@ -0,0 +1,14 @@
+#ifndef JOINTCOMP_H
+#define JOINTCOMP_H
+
+#include "motion.h"
+
+/* index of the entry of 'comp' whose interval holds 'pos', starting
+   from comp->index, the entry used last cycle */
+extern int find_comp_entry(const emcmot_comp_t *comp, double pos);
+
+/* correction from 'grid' at the commanded positions of 'joints' */
+extern double comp_grid_value(const emcmot_comp_grid_t *grid,
+			      const emcmot_joint_t *joints);
+
+#endif /* JOINTCOMP_H */
@@ -13,6 +13,7 @@
 #include "rtapi.h"		/* RTAPI realtime OS API */
 #include "rtapi_app.h"		/* RTAPI realtime module decls */
 #include "rtapi_string.h"       /* memset */
+#include "rtapi_slab.h"		/* rtapi_kzalloc */
 #include "hal.h"		/* decls for HAL implementation */
 #include "motion.h"
 #include "motion_debug.h"
@@ -45,6 +46,15 @@ int base_thread_fp = 0;	/* default is no floating point in base thread */
 RTAPI_MP_INT(base_thread_fp, "floating point in base thread?");
 static long servo_period_nsec = 1000000;	/* servo thread period */
 RTAPI_MP_LONG(servo_period_nsec, "servo thread period (nsecs)");
+static int base_thread_cpu = RTAPI_DEFAULT_CPU;	/* cpu for base thread */
+RTAPI_MP_INT(base_thread_cpu, "cpu for base thread (-1 for default)");
+static int servo_thread_cpu = RTAPI_DEFAULT_CPU;	/* cpu for servo thread */
+RTAPI_MP_INT(servo_thread_cpu, "cpu for servo thread (-1 for default)");
+#define MAX_SERVO_WORKERS 8
+static int servo_thread_workers[MAX_SERVO_WORKERS] =
+    { [0 ... MAX_SERVO_WORKERS-1] = -1 };	/* no workers */
+RTAPI_MP_ARRAY_INT(servo_thread_workers, MAX_SERVO_WORKERS,
+    "cpus for servo thread parallel group workers");
 static long traj_period_nsec = 0;	/* trajectory planner period */
 RTAPI_MP_LONG(traj_period_nsec, "trajectory planner period (nsecs)");
 static int num_spindles = 1; /* default number of spindles is 1 */
@@ -61,6 +71,10 @@ RTAPI_MP_INT(num_aio, "number of analog inputs/outputs");
 
 static int unlock_joints_mask = 0;/* mask to select joints for unlock pins */
 RTAPI_MP_INT(unlock_joints_mask, "mask to select joints for unlock pins");
+static int comp_size = EMCMOT_COMP_SIZE;	/* comp table entries per joint */
+RTAPI_MP_INT(comp_size, "compensation table entries per joint");
+static int comp_grid_size = 0;	/* compensation grid points per joint */
+RTAPI_MP_INT(comp_grid_size, "compensation grid points per joint");
 /***********************************************************************
 *                  GLOBAL VARIABLE DEFINITIONS                         *
 ************************************************************************/
@@ -81,6 +95,9 @@ emcmot_joint_t joint_array[EMCMOT_MAX_JOINTS];
 emcmot_axis_t axis_array[EMCMOT_MAX_AXIS];
 #endif
 
+/* the compensation tables and grids of all joints */
+static void *comp_mem = 0;
+
 /*
   Principles of communication:
 
@@ -89,7 +106,7 @@ emcmot_axis_t axis_array[EMCMOT_MAX_AXIS];
 
   emcmotStruct is ptr to this memory.
 
-  emcmotCommand points to emcmotStruct->command,
+  emcmotCommand points to the slot of emcmotStruct->command being handled,
   emcmotStatus points to emcmotStruct->status,
   emcmotError points to emcmotStruct->error, and
  */
@@ -176,10 +193,11 @@ void switch_to_teleop_mode(void) {
 
 void emcmot_config_change(void)
 {
-    if (emcmotConfig->head == emcmotConfig->tail) {
+    /* the writer that changed config closes the update when it is done */
+    if (!(emcmotConfig->seq & 1)) {
+	emcmot_seq_write_begin(&emcmotConfig->seq);
 	emcmotConfig->config_num++;
 	emcmotStatus->config_num = emcmotConfig->config_num;
-	emcmotConfig->head++;
     }
 }
 
@@ -264,6 +282,20 @@ int rtapi_app_main(void)
 	return -1;
     }
 
+    if (( comp_size < 1 ) || ( comp_size > EMCMOT_COMP_MAX_SIZE )) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    _("MOTION: comp_size is %d, must be between 1 and %d\n"), comp_size, EMCMOT_COMP_MAX_SIZE);
+	hal_exit(mot_comp_id);
+	return -1;
+    }
+
+    if (( comp_grid_size < 0 ) || ( comp_grid_size > EMCMOT_COMP_GRID_SIZE )) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    _("MOTION: comp_grid_size is %d, must be between 0 and %d\n"), comp_grid_size, EMCMOT_COMP_GRID_SIZE);
+	hal_exit(mot_comp_id);
+	return -1;
+    }
+
     /* initialize/export HAL pins and parameters */
     retval = init_hal_io();
     if (retval != 0) {
@@ -316,6 +348,7 @@ void rtapi_app_exit(void)
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    _("MOTION: rtapi_shmem_delete() failed, returned %d\n"), retval);
     }
+    rtapi_kfree(comp_mem);
     /* disconnect from HAL and RTAPI */
     retval = hal_exit(mot_comp_id);
     if (retval < 0) {
@@ -697,6 +730,9 @@ static int init_comm_buffers(void)
 {
     int joint_num, axis_num, spindle_num, n;
     emcmot_joint_t *joint;
+    double *comp_nominal;
+    emcmot_comp_entry_t *comp_entry;
+    float *comp_value;
     int retval;
 
     rtapi_print_msg(RTAPI_MSG_INFO, "MOTION: init_comm_buffers() starting...\n");
@@ -725,7 +761,7 @@ static int init_comm_buffers(void)
     memset(emcmotStruct, 0, sizeof(emcmot_struct_t));
 
     /* we'll reference emcmotStruct directly */
-    emcmotCommand = &emcmotStruct->command;
+    emcmotCommand = &emcmotStruct->command.slot[0];
     emcmotStatus = &emcmotStruct->status;
     emcmotConfig = &emcmotStruct->config;
     emcmotDebug = &emcmotStruct->debug;
@@ -734,21 +770,20 @@ static int init_comm_buffers(void)
     /* init error struct */
     emcmotErrorInit(emcmotError);
 
-    /* init command struct */
-    emcmotCommand->head = 0;
-    emcmotCommand->command = 0;
-    emcmotCommand->commandNum = 0;
-    emcmotCommand->tail = 0;
+    /* init command ring */
+    emcmotStruct->command.head = 0;
+    emcmotStruct->command.tail = 0;
 
     /* init status struct */
-    emcmotStatus->head = 0;
+    emcmotStatus->seq = 0;
     emcmotStatus->commandEcho = 0;
     emcmotStatus->commandNumEcho = 0;
     emcmotStatus->commandStatus = 0;
+    emcmotStatus->queuedFailNum = 0;
 
     /* init more stuff */
-    emcmotDebug->head = 0;
-    emcmotConfig->head = 0;
+    emcmotDebug->seq = 0;
+    emcmotConfig->seq = 0;
 
     emcmotStatus->motionFlag = 0;
     SET_MOTION_ERROR_FLAG(0);
@@ -807,6 +842,21 @@ static int init_comm_buffers(void)
       axis = &axes[axis_num];
       axis->locking_joint = -1;
    }
+
+    /* allocate the compensation tables and grids, only as large as
+       motmod was asked to make them, and only for the joints in use */
+    comp_mem = rtapi_kzalloc(ALL_JOINTS * ((comp_size + 2) *
+	    (sizeof(double) + sizeof(emcmot_comp_entry_t)) +
+	    comp_grid_size * sizeof(float)), RTAPI_GFP_KERNEL);
+    if (comp_mem == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    _("MOTION: compensation table allocation failed\n"));
+	return -1;
+    }
+    /* all the nominal positions first, to keep the doubles aligned */
+    comp_nominal = comp_mem;
+    comp_entry = (emcmot_comp_entry_t *) (comp_nominal + ALL_JOINTS * (comp_size + 2));
+    comp_value = (float *) (comp_entry + ALL_JOINTS * (comp_size + 2));
     /* init per-joint stuff */
     for (joint_num = 0; joint_num < ALL_JOINTS; joint_num++) {
 	/* point to structure for this joint */
@@ -823,22 +873,23 @@ static int init_comm_buffers(void)
 	joint->backlash = 0.0;
 
 	joint->comp.entries = 0;
-	joint->comp.entry = &(joint->comp.array[0]);
+	joint->comp.max_entries = comp_size;
+	joint->comp.index = 0;
+	joint->comp.nominal = comp_nominal + joint_num * (comp_size + 2);
+	joint->comp.entry = comp_entry + joint_num * (comp_size + 2);
 	/* the compensation code has -DBL_MAX at one end of the table
 	   and +DBL_MAX at the other so _all_ commanded positions are
 	   guaranteed to be covered by the table */
-	joint->comp.array[0].nominal = -DBL_MAX;
-	joint->comp.array[0].fwd_trim = 0.0;
-	joint->comp.array[0].rev_trim = 0.0;
-	joint->comp.array[0].fwd_slope = 0.0;
-	joint->comp.array[0].rev_slope = 0.0;
-	for ( n = 1 ; n < EMCMOT_COMP_SIZE+2 ; n++ ) {
-	    joint->comp.array[n].nominal = DBL_MAX;
-	    joint->comp.array[n].fwd_trim = 0.0;
-	    joint->comp.array[n].rev_trim = 0.0;
-	    joint->comp.array[n].fwd_slope = 0.0;
-	    joint->comp.array[n].rev_slope = 0.0;
+	joint->comp.nominal[0] = -DBL_MAX;
+	for ( n = 1 ; n < comp_size+2 ; n++ ) {
+	    joint->comp.nominal[n] = DBL_MAX;
 	}
+	joint->comp_grid.axes = 0;
+	joint->comp_grid.points = 0;
+	joint->comp_grid.loaded = 0;
+	joint->comp_grid.max_points = comp_grid_size;
+	joint->comp_grid.value = comp_value + joint_num * comp_grid_size;
+	joint->screw_corr = 0.0;
 
 	/* init joint flags */
 	joint->flag = 0;
@@ -884,7 +935,9 @@ static int init_comm_buffers(void)
     tpSetVmax(&emcmotDebug->coord_tp, emcmotStatus->vel, emcmotStatus->vel);
     tpSetAmax(&emcmotDebug->coord_tp, emcmotStatus->acc);
 
-    emcmotStatus->tail = 0;
+    if (emcmotConfig->seq & 1) {
+	emcmot_seq_write_end(&emcmotConfig->seq);
+    }
 
     rtapi_print_msg(RTAPI_MSG_INFO, "MOTION: init_comm_buffers() complete\n");
     return 0;
@@ -897,7 +950,7 @@ static int init_threads(void)
 {
     double base_period_sec, servo_period_sec;
     int servo_base_ratio;
-    int retval;
+    int retval, n;
 
     rtapi_print_msg(RTAPI_MSG_INFO, "MOTION: init_threads() starting...\n");
 
@@ -924,7 +977,8 @@ static int init_threads(void)
     /* create HAL threads for each period */
     /* only create base thread if it is faster than servo thread */
     if (servo_base_ratio > 1) {
-	retval = hal_create_thread("base-thread", base_period_nsec, base_thread_fp);
+	retval = hal_create_thread_cpu("base-thread", base_period_nsec,
+	    base_thread_fp, base_thread_cpu);
 	if (retval < 0) {
 	    rtapi_print_msg(RTAPI_MSG_ERR,
 		"MOTION: failed to create %ld nsec base thread\n",
@@ -932,13 +986,23 @@ static int init_threads(void)
 	    return -1;
 	}
     }
-    retval = hal_create_thread("servo-thread", servo_period_nsec, 1);
+    retval = hal_create_thread_cpu("servo-thread", servo_period_nsec, 1,
+	servo_thread_cpu);
     if (retval < 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "MOTION: failed to create %ld nsec servo thread\n",
 	    servo_period_nsec);
 	return -1;
     }
+    for (n = 0; n < MAX_SERVO_WORKERS && servo_thread_workers[n] >= 0; n++) {
+	retval = hal_thread_add_worker("servo-thread", servo_thread_workers[n]);
+	if (retval < 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"MOTION: failed to add servo thread worker on cpu %d\n",
+		servo_thread_workers[n]);
+	    return -1;
+	}
+    }
     /* export realtime functions that do the real work */
     retval = hal_export_funct("motion-controller", emcmotController, 0	/* arg 
 	 */ , 1 /* uses_fp */ , 0 /* reentrant */ , mot_comp_id);
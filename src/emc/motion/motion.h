@@ -157,6 +157,7 @@ extern "C" {
         EMCMOT_SET_OFFSET, /* set tool offsets */
         EMCMOT_SET_MAX_FEED_OVERRIDE,
         EMCMOT_SETUP_ARC_BLENDS,
+        EMCMOT_SET_PLANNER_TYPE,
 
 	EMCMOT_SET_PROBE_ERR_INHIBIT,
 	EMCMOT_ENABLE_WATCHDOG,         /* enable watchdog sound, parport */
@@ -182,6 +183,8 @@ extern "C" {
 	EMCMOT_UPDATE_JOINT_HOMING_PARAMS, /* updates some joint homing parameters */
 	EMCMOT_SET_JOINT_MOTOR_OFFSET,  /* set the offset between joint and motor */
 	EMCMOT_SET_JOINT_COMP,          /* set a compensation triplet for a joint (nominal, forw., rev.) */
+	EMCMOT_SET_JOINT_COMP_GRID,     /* set the shape of a joint's compensation grid */
+	EMCMOT_SET_JOINT_COMP_GRID_VALUES, /* set a run of points of a compensation grid */
 
         EMCMOT_SET_AXIS_POSITION_LIMITS, /* set the axis position +/- limits */
         EMCMOT_SET_AXIS_VEL_LIMIT,      /* set the max axis vel */
@@ -209,11 +212,10 @@ extern "C" {
        COMMAND STRUCTURE
 *********************************/
 
-/* This is the command structure.  There is one of these in shared
-   memory, and all commands from higher level code come thru it.
+/* This is the command structure.  All commands from higher level code
+   come thru a ring of these in shared memory, see below.
 */
     typedef struct emcmot_command_t {
-	unsigned char head;	/* flag count for mutex detect */
 	cmd_code_t command;	/* command code (enum) */
 	int commandNum;		/* increment this for new command */
 	double motor_offset;    /* offset from joint to motor position */
@@ -253,6 +255,14 @@ extern "C" {
 	unsigned char now, out, start, end;	/* these are related to synched AOUT/DOUT. now=wether now or synched, out = which gets set, start=start value, end=end value */
 	unsigned char mode;	/* used for turning overrides etc. on/off */
 	double comp_nominal, comp_forward, comp_reverse; /* compensation triplet, nominal, forward, reverse */
+	int comp_grid_axes;	/* number of joints indexing the grid */
+	int comp_grid_joint[EMCMOT_COMP_GRID_AXES]; /* the joints indexing it */
+	int comp_grid_size[EMCMOT_COMP_GRID_AXES];  /* points along each */
+	double comp_grid_start[EMCMOT_COMP_GRID_AXES]; /* position of the first point */
+	double comp_grid_step[EMCMOT_COMP_GRID_AXES];  /* spacing of the points */
+	int comp_grid_first;	/* index of comp_grid_value[0] in the grid */
+	int comp_grid_count;	/* number of values in comp_grid_value */
+	float comp_grid_value[EMCMOT_COMP_GRID_BATCH];
         unsigned char probe_type; /* ~1 = error if probe operation is unsuccessful (ngc default)
                                      |1 = suppress error, report in # instead
                                      ~2 = move until probe trips (ngc default)
@@ -264,7 +274,6 @@ extern "C" {
 	char    direction;      /* CANON_DIRECTION flag for spindle orient */
 	double  timeout;        /* of wait for spindle orient to complete */
 	unsigned char wait_for_spindle_at_speed; // EMCMOT_SPINDLE_ON now carries this, for next feed move
-	unsigned char tail;	/* flag count for mutex detect */
         int arcBlendOptDepth;
         int arcBlendEnable;
         int arcBlendFallbackEnable;
@@ -272,10 +281,55 @@ extern "C" {
         double arcBlendRampFreq;
         double arcBlendTangentKinkRatio;
         double maxFeedScale;
+        int plannerType;
+        double maxJerk;
 	double ext_offset_vel;	/* velocity for an external axis offset */
 	double ext_offset_acc;	/* acceleration for an external axis offset */
     } emcmot_command_t;
 
+/* Commands are passed from task to motion through a single producer,
+   single consumer ring, so that task can queue a burst of moves without
+   waiting a servo cycle for each one.  'head' counts the commands task
+   has written and 'tail' the ones motion has taken; both run freely and
+   index 'slot' modulo the ring size.  Task only waits for an echo of
+   commands other than EMCMOT_SET_LINE and EMCMOT_SET_CIRCLE.
+
+   The ring is kept well inside the TC queue margin (see tcqFull()) so
+   the moves in flight always fit in the queue once task has seen
+   motion report it not full. */
+#define EMCMOT_COMMAND_RING_SIZE 32
+
+/* Adding a move to the TP can take tens of microseconds, so a full ring
+   of moves would not fit in a servo cycle.  Motion takes at most this
+   many queued moves per cycle and leaves the rest for the next one. */
+#define EMCMOT_QUEUED_PER_CYCLE 4
+
+    typedef struct emcmot_command_ring_t {
+	unsigned int head;	/* written by task only */
+	unsigned int tail;	/* written by motion only */
+	emcmot_command_t slot[EMCMOT_COMMAND_RING_SIZE];
+    } emcmot_command_ring_t;
+
+#define EMCMOT_QUEUED_COMMAND(cmd) \
+    ((cmd) == EMCMOT_SET_LINE || (cmd) == EMCMOT_SET_CIRCLE)
+
+/* The status, config and debug structures are published with a sequence
+   lock: motion makes 'seq' odd before it starts changing a structure and
+   even again when it is done, and a reader that sees the same even value
+   before and after copying the structure has a consistent copy.  Only
+   motion writes these structures, so the writer side needs no atomic
+   read-modify-write. */
+    static inline void emcmot_seq_write_begin(unsigned int *seq)
+    {
+	__atomic_store_n(seq, *seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+
+    static inline void emcmot_seq_write_end(unsigned int *seq)
+    {
+	__atomic_store_n(seq, *seq + 1, __ATOMIC_RELEASE);
+    }
+
 /*! \todo FIXME - these packed bits might be replaced with chars
    memory is cheap, and being able to access them without those
    damn macros would be nice
@@ -389,7 +443,6 @@ Suggestion: Split this in to an Error and a Status flag register..
 
 /* compensation structures */
     typedef struct {
-	double nominal;		/* nominal (command) position */
 	float fwd_trim;		/* correction for forward movement */
 	float rev_trim;		/* correction for reverse movement */
 	float fwd_slope;	/* slopes between here and next pt */
@@ -397,14 +450,47 @@ Suggestion: Split this in to an Error and a Status flag register..
     } emcmot_comp_entry_t; 
 
 
+/* The nominal positions are kept apart from the corrections, so that
+   searching the table only touches the positions.  The entry used last
+   cycle is tried first, then its neighbours; anything further away is
+   found with a binary search, so a long rapid costs O(log n).
+
+   The arrays are allocated when motmod is loaded, with room for the
+   number of entries given by its comp_size parameter, by default
+   EMCMOT_COMP_SIZE and at most EMCMOT_COMP_MAX_SIZE. */
 #define EMCMOT_COMP_SIZE 256
+#define EMCMOT_COMP_MAX_SIZE 65536
     typedef struct {
 	int entries;		/* number of entries in the array */
-	emcmot_comp_entry_t *entry;  /* current entry in array */
-	emcmot_comp_entry_t array[EMCMOT_COMP_SIZE+2];
-	/* +2 because array has -HUGE_VAL and +HUGE_VAL entries at the ends */
+	int max_entries;	/* entries there is room for */
+	int index;		/* entry used last cycle */
+	/* max_entries+2 long, because the arrays have -DBL_MAX and
+	   +DBL_MAX entries at the ends */
+	double *nominal;	/* nominal (command) positions */
+	emcmot_comp_entry_t *entry;
     } emcmot_comp_t;
 
+/* A compensation grid adds a correction to a joint that depends on the
+   commanded positions of up to three joints (possibly including itself),
+   for volumetric compensation.  The points are evenly spaced along each
+   of the indexing joints, the first index varying fastest, and the
+   correction is interpolated linearly between them.  Outside the grid
+   the nearest edge is used.  The grid only takes effect once all of
+   its points have been loaded.  Like the comp table, the values are
+   allocated when motmod is loaded, for as many points as its
+   comp_grid_size parameter asks for. */
+    typedef struct {
+	int axes;		/* number of joints indexing the grid, 0 if none */
+	int joint[EMCMOT_COMP_GRID_AXES];	/* the joints indexing it */
+	int size[EMCMOT_COMP_GRID_AXES];	/* points along each */
+	double start[EMCMOT_COMP_GRID_AXES];	/* position of the first point */
+	double inv_step[EMCMOT_COMP_GRID_AXES];	/* 1 / spacing of the points */
+	int points;		/* points in the grid */
+	int loaded;		/* points loaded so far */
+	int max_points;		/* points there is room for */
+	float *value;
+    } emcmot_comp_grid_t;
+
 /* motion controller states */
 
     typedef enum {
@@ -463,6 +549,9 @@ Suggestion: Split this in to an Error and a Status flag register..
 	double max_ferror;	/* max speed following error limit */
 	double backlash;	/* amount of backlash */
 	emcmot_comp_t comp;	/* leadscrew correction data */
+	emcmot_comp_grid_t comp_grid;	/* volumetric correction data */
+	double screw_corr;	/* part of backlash_corr from backlash and comp,
+				   held while the joint is stopped */
 
 	/* status info - changes regularly */
 	/* many of these need to be made available to higher levels */
@@ -598,11 +687,15 @@ Suggestion: Split this in to an Error and a Status flag register..
 */
 
     typedef struct emcmot_status_t {
-	unsigned char head;	/* flag count for mutex detect */
+	unsigned int seq;	/* odd while being written, see
+				   emcmot_seq_write_begin() */
 	/* these three are updated only when a new command is handled */
 	cmd_code_t commandEcho;	/* echo of input command */
 	int commandNumEcho;	/* echo of input command number */
 	cmd_status_t commandStatus;	/* result of most recent command */
+	int queuedFailNum;	/* commandNum of the last queued move that
+				   failed; later ones are dropped until an
+				   EMCMOT_ABORT */
 	/* these are config info, updated when a command changes them */
 	double feed_scale;	/* velocity scale factor for all motion but rapids */
 	double rapid_scale;	/* velocity scale factor for rapids */
@@ -672,7 +765,6 @@ Suggestion: Split this in to an Error and a Status flag register..
 	unsigned int tcqlen;
 	EmcPose tool_offset;
 	int atspeed_next_feed;  /* at next feed move, wait for spindle to be at speed  */
-	unsigned char tail;	/* flag count for mutex detect */
 	int external_offsets_applied;
 	EmcPose eoffset_pose;
 	int numExtraJoints;
@@ -702,7 +794,8 @@ Suggestion: Split this in to an Error and a Status flag register..
    evaluated - either they move up, or they go away.
 */
     typedef struct emcmot_config_t {
-	unsigned char head;	/* flag count for mutex detect */
+	unsigned int seq;	/* odd while being written, see
+				   emcmot_seq_write_begin() */
 
 	int config_num;		/* Incremented everytime configuration
 				   changed, should match status.config_num */
@@ -734,7 +827,6 @@ Suggestion: Split this in to an Error and a Status flag register..
 
 	double limitVel;	/* scalar upper limit on vel */
 	int debug;		/* copy of DEBUG, from .ini file */
-	unsigned char tail;	/* flag count for mutex detect */
         int arcBlendOptDepth;
         int arcBlendEnable;
         int arcBlendFallbackEnable;
@@ -742,6 +834,8 @@ Suggestion: Split this in to an Error and a Status flag register..
         double arcBlendRampFreq;
         double arcBlendTangentKinkRatio;
         double maxFeedScale;
+        int plannerType;        /* trapezoidal or S-curve velocity profiles */
+        double maxJerk;         /* tangential jerk limit for S-curve profiles */
         int inhibit_probe_jog_error;
         int inhibit_probe_home_error;
     } emcmot_config_t;
@@ -42,7 +42,8 @@
 /*! \todo FIXME - this has become a dumping ground for all kinds of stuff */
 
 typedef struct emcmot_debug_t {
-	unsigned char head;	/* flag count for mutex detect */
+	unsigned int seq;	/* odd while being written, see
+				   emcmot_seq_write_begin() */
 
 /*! \todo FIXME - all structure members beyond this point are in limbo */
 
@@ -73,7 +74,6 @@ typedef struct emcmot_debug_t {
 	double running_time;
 	double cur_time;
 	double last_time;
-	unsigned char tail;	/* flag count for mutex detect */
     } emcmot_debug_t;
 
 #endif // MOTION_DEBUG_H
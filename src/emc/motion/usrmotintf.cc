@@ -38,8 +38,8 @@
 #include "stashf.h"
 
 static int inited = 0;		/* flag if inited */
+static int commandNum = 0;	/* number of the last command written */
 
-static emcmot_command_t *emcmotCommand = 0;
 static emcmot_status_t *emcmotStatus = 0;
 static emcmot_config_t *emcmotConfig = 0;
 static emcmot_debug_t *emcmotDebug = 0;
@@ -75,34 +75,65 @@ int usrmotIniLoad(const char *filename)
 int usrmotWriteEmcmotCommand(emcmot_command_t * c)
 {
     emcmot_status_t s;
-    static int commandNum = 0;
-    static unsigned char headCount = 0;
+    emcmot_command_ring_t *ring;
+    static int queuedFailNum = 0;
+    unsigned int head;
     double end;
 
     if (!MOTION_ID_VALID(c->id)) {
         rcs_print("USRMOT: ERROR: invalid motion id: %d\n",c->id);
 	return EMCMOT_COMM_INVALID_MOTION_ID;
     }
-    c->head = ++headCount;
-    c->tail = c->head;
-    c->commandNum = ++commandNum;
 
     /* check for mapped mem still around */
-    if (0 == emcmotCommand) {
+    if (0 == emcmotStruct) {
         rcs_print("USRMOT: ERROR: can't connect to shared memory\n");
 	return EMCMOT_COMM_ERROR_CONNECT;
     }
-    /* copy entire command structure to shared memory */
-    *emcmotCommand = *c;
-    /* poll for receipt of command */
+    ring = &emcmotStruct->command;
+
+    /* a move queued earlier failed, and motion is dropping the ones
+       after it until we abort; fail this one so task notices */
+    if (EMCMOT_QUEUED_COMMAND(c->command) &&
+        emcmotStatus->queuedFailNum != queuedFailNum) {
+	queuedFailNum = emcmotStatus->queuedFailNum;
+        rcs_print("USRMOT: ERROR: queued move failed\n");
+	return EMCMOT_COMM_ERROR_COMMAND;
+    }
+
+    c->commandNum = ++commandNum;
+
     /* set timeout for comm failure, now + timeout */
     end = etime() + EMCMOT_COMM_TIMEOUT;
-    /* now check to see if it got it */
+    /* wait for a free slot */
+    head = ring->head;
+    while (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)
+           >= EMCMOT_COMMAND_RING_SIZE) {
+	if (etime() >= end) {
+	    rcs_print("USRMOT: ERROR: command timeout\n");
+	    return EMCMOT_COMM_ERROR_TIMEOUT;
+	}
+	esleep(25e-6);
+    }
+    /* copy entire command structure to shared memory, then publish it */
+    ring->slot[head % EMCMOT_COMMAND_RING_SIZE] = *c;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    /* moves go into the TC queue anyway; errors come back later */
+    if (EMCMOT_QUEUED_COMMAND(c->command)) {
+	return EMCMOT_COMM_OK;
+    }
+
+    /* poll for receipt of command */
     while (etime() < end) {
 	/* update status */
 	if (( usrmotReadEmcmotStatus(&s) == 0 ) && ( s.commandNumEcho == commandNum )) {
 	    /* now check emcmot status flag */
 	    if (s.commandStatus == EMCMOT_COMMAND_OK) {
+		/* all queued moves are done with, failed or not */
+		if (c->command == EMCMOT_ABORT) {
+		    queuedFailNum = s.queuedFailNum;
+		}
 		return EMCMOT_COMM_OK;
 	    } else {
                 rcs_print("USRMOT: ERROR: invalid command\n");
@@ -115,75 +146,79 @@ int usrmotWriteEmcmotCommand(emcmot_command_t * c)
     return EMCMOT_COMM_ERROR_TIMEOUT;
 }
 
+/* number of commands written that motion hadn't handled as of status s */
+int usrmotPendingCommands(const emcmot_status_t * s)
+{
+    return commandNum - s->commandNumEcho;
+}
+
+/* Copy a structure published with emcmot_seq_write_begin/end().  If
+   motion is in the middle of updating it, sleep briefly rather than
+   copying something that is about to be thrown away. */
+static int read_seqlocked(void *dst, const void *src, size_t size,
+			  const unsigned int *seq)
+{
+    int split_read_count;
+    unsigned int before;
+
+    for (split_read_count = 0; split_read_count < 10; split_read_count++) {
+	before = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+	if (before & 1) {
+	    esleep(10e-6);
+	    continue;
+	}
+	memcpy(dst, src, size);
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (__atomic_load_n(seq, __ATOMIC_RELAXED) == before) {
+	    return EMCMOT_COMM_OK;
+	}
+    }
+    return EMCMOT_COMM_SPLIT_READ_TIMEOUT;
+}
+
 /* copies status to s */
 int usrmotReadEmcmotStatus(emcmot_status_t * s)
 {
-    int split_read_count;
-    
     /* check for shmem still around */
     if (0 == emcmotStatus) {
 	return EMCMOT_COMM_ERROR_CONNECT;
     }
-    split_read_count = 0;
-    do {
-	/* copy status struct from shmem to local memory */
-	memcpy(s, emcmotStatus, sizeof(emcmot_status_t));
-	/* got it, now check head-tail matche */
-	if (s->head == s->tail) {
-	    /* head and tail match, done */
-	    return EMCMOT_COMM_OK;
-	}
-	/* inc counter and try again, max three times */
-    } while ( ++split_read_count < 3 );
-    return EMCMOT_COMM_SPLIT_READ_TIMEOUT;
+    return read_seqlocked(s, emcmotStatus, sizeof(emcmot_status_t),
+			  &emcmotStatus->seq);
 }
 
 /* copies config to s */
 int usrmotReadEmcmotConfig(emcmot_config_t * s)
 {
-    int split_read_count;
-    
+    int retval;
+
     /* check for shmem still around */
     if (0 == emcmotConfig) {
 	return EMCMOT_COMM_ERROR_CONNECT;
     }
-    split_read_count = 0;
-    do {
-	/* copy config struct from shmem to local memory */
-	memcpy(s, emcmotConfig, sizeof(emcmot_config_t));
-	/* got it, now check head-tail matches */
-	if (s->head == s->tail) {
-	    /* head and tail match, done */
-	    return EMCMOT_COMM_OK;
-	}
-	/* inc counter and try again, max three times */
-    } while ( ++split_read_count < 3 );
+    retval = read_seqlocked(s, emcmotConfig, sizeof(emcmot_config_t),
+			    &emcmotConfig->seq);
+    if (retval == EMCMOT_COMM_SPLIT_READ_TIMEOUT) {
 printf("ReadEmcmotConfig COMM_SPLIT_READ_TIMEOUT\n" );
-    return EMCMOT_COMM_SPLIT_READ_TIMEOUT;
+    }
+    return retval;
 }
 
 /* copies debug to s */
 int usrmotReadEmcmotDebug(emcmot_debug_t * s)
 {
-    int split_read_count;
-    
+    int retval;
+
     /* check for shmem still around */
     if (0 == emcmotDebug) {
 	return EMCMOT_COMM_ERROR_CONNECT;
     }
-    split_read_count = 0;
-    do {
-	/* copy debug struct from shmem to local memory */
-	memcpy(s, emcmotDebug, sizeof(emcmot_debug_t));
-	/* got it, now check head-tail matches */
-	if (s->head == s->tail) {
-	    /* head and tail match, done */
-	    return EMCMOT_COMM_OK;
-	}
-	/* inc counter and try again, max three times */
-    } while ( ++split_read_count < 3 );
+    retval = read_seqlocked(s, emcmotDebug, sizeof(emcmot_debug_t),
+			    &emcmotDebug->seq);
+    if (retval == EMCMOT_COMM_SPLIT_READ_TIMEOUT) {
 printf("ReadEmcmotDebug COMM_SPLIT_READ_TIMEOUT\n" );
-    return EMCMOT_COMM_SPLIT_READ_TIMEOUT;
+    }
+    return retval;
 }
 
 /* copies error to s */
@@ -663,7 +698,6 @@ int usrmotInit(const char *modname)
 	return -1;
     }
     /* got it */
-    emcmotCommand = &(emcmotStruct->command);
     emcmotStatus = &(emcmotStruct->status);
     emcmotDebug = &(emcmotStruct->debug);
     emcmotConfig = &(emcmotStruct->config);
@@ -682,7 +716,6 @@ int usrmotExit(void)
     }
 
     emcmotStruct = 0;
-    emcmotCommand = 0;
     emcmotStatus = 0;
     emcmotError = 0;
 /*! \todo Another #if 0 */
@@ -755,6 +788,156 @@ int usrmotLoadComp(int joint, const char *file, int type)
     return ret;
 }
 
+/* Loads a volumetric compensation grid.  '#' starts a comment.  The
+   header gives, for each of one to three joints indexing the grid,
+   the joint number, the position of the first point, the spacing of
+   the points and how many there are along that joint:
+	JOINTS 0 1
+	START -100 -50
+	STEP 10 10
+	SIZE 21 11
+   and is followed by the corrections for all the points, the first
+   joint's index varying fastest.
+*/
+int usrmotLoadCompGrid(int joint, const char *file)
+{
+    static float value[EMCMOT_COMP_GRID_SIZE];
+    FILE *fp;
+    char buffer[LINELEN];
+    char *word, *end;
+    int axes[4] = { 0, 0, 0, 0 };
+    int points, loaded, line, n, k;
+    double d;
+    int ret = 0;
+    emcmot_command_t emcmotCommand;
+
+    /* check joint range */
+    if (joint < 0 || joint >= EMCMOT_MAX_JOINTS) {
+	fprintf(stderr, "joint out of range for compensation grid\n");
+	return -1;
+    }
+
+    /* open input comp file */
+    if (NULL == (fp = fopen(file, "r"))) {
+	fprintf(stderr, "can't open compensation grid file %s\n", file);
+	return -1;
+    }
+
+    memset(&emcmotCommand, 0, sizeof(emcmotCommand));
+    loaded = 0;
+    for (line = 1; NULL != fgets(buffer, LINELEN, fp); line++) {
+	if (NULL != (end = strchr(buffer, '#'))) {
+	    *end = 0;
+	}
+	word = strtok(buffer, " \t\r\n");
+	if (word == NULL) {
+	    continue;
+	}
+	k = -1;
+	if (0 == strcasecmp(word, "JOINTS")) {
+	    k = 0;
+	} else if (0 == strcasecmp(word, "START")) {
+	    k = 1;
+	} else if (0 == strcasecmp(word, "STEP")) {
+	    k = 2;
+	} else if (0 == strcasecmp(word, "SIZE")) {
+	    k = 3;
+	}
+	if (k >= 0) {
+	    if (loaded > 0) {
+		fprintf(stderr, "%s:%d: %s after the grid values\n", file, line, word);
+		ret = -1;
+		break;
+	    }
+	    word = strtok(NULL, " \t\r\n");
+	}
+	for (n = 0; word != NULL; n++, word = strtok(NULL, " \t\r\n")) {
+	    d = strtod(word, &end);
+	    if (end == word || *end != 0) {
+		fprintf(stderr, "%s:%d: bad number '%s'\n", file, line, word);
+		ret = -1;
+		break;
+	    }
+	    if (k < 0) {
+		if (loaded >= EMCMOT_COMP_GRID_SIZE) {
+		    fprintf(stderr, "%s:%d: more than %d grid values\n",
+			    file, line, EMCMOT_COMP_GRID_SIZE);
+		    ret = -1;
+		    break;
+		}
+		value[loaded++] = d;
+		continue;
+	    }
+	    if (n >= EMCMOT_COMP_GRID_AXES) {
+		fprintf(stderr, "%s:%d: more than %d grid axes\n",
+			file, line, EMCMOT_COMP_GRID_AXES);
+		ret = -1;
+		break;
+	    }
+	    switch (k) {
+	    case 0:
+		emcmotCommand.comp_grid_joint[n] = (int) d;
+		break;
+	    case 1:
+		emcmotCommand.comp_grid_start[n] = d;
+		break;
+	    case 2:
+		emcmotCommand.comp_grid_step[n] = d;
+		break;
+	    case 3:
+		emcmotCommand.comp_grid_size[n] = (int) d;
+		break;
+	    }
+	}
+	if (ret != 0) {
+	    break;
+	}
+	if (k >= 0) {
+	    axes[k] = n;
+	}
+    }
+    fclose(fp);
+    if (ret != 0) {
+	return ret;
+    }
+
+    points = 1;
+    for (k = 0; k < 4; k++) {
+	if (axes[k] != axes[0] || axes[k] == 0) {
+	    fprintf(stderr, "%s: JOINTS, START, STEP and SIZE must all be given, "
+		    "with the same number of values\n", file);
+	    return -1;
+	}
+    }
+    for (n = 0; n < axes[0]; n++) {
+	points *= emcmotCommand.comp_grid_size[n];
+    }
+    if (points != loaded) {
+	fprintf(stderr, "%s: %d grid values for a grid of %d points\n",
+		file, loaded, points);
+	return -1;
+    }
+
+    emcmotCommand.command = EMCMOT_SET_JOINT_COMP_GRID;
+    emcmotCommand.joint = joint;
+    emcmotCommand.comp_grid_axes = axes[0];
+    ret |= usrmotWriteEmcmotCommand(&emcmotCommand);
+
+    emcmotCommand.command = EMCMOT_SET_JOINT_COMP_GRID_VALUES;
+    for (n = 0; n < loaded && ret == 0; n += EMCMOT_COMP_GRID_BATCH) {
+	emcmotCommand.comp_grid_first = n;
+	emcmotCommand.comp_grid_count = loaded - n;
+	if (emcmotCommand.comp_grid_count > EMCMOT_COMP_GRID_BATCH) {
+	    emcmotCommand.comp_grid_count = EMCMOT_COMP_GRID_BATCH;
+	}
+	memcpy(emcmotCommand.comp_grid_value, &value[n],
+	       emcmotCommand.comp_grid_count * sizeof(float));
+	ret |= usrmotWriteEmcmotCommand(&emcmotCommand);
+    }
+
+    return ret;
+}
+
 
 int usrmotPrintComp(int joint)
 {
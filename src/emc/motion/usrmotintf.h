@@ -67,9 +67,15 @@ extern "C" {
 #define EMCMOT_COMM_INVALID_MOTION_ID -5 /* do not queue a motion id MOTION_INVALID_ID */
 
 /* usrmotWriteEmcmotCommand() writes the command to the emcmot process.
+   Queued moves (EMCMOT_SET_LINE, EMCMOT_SET_CIRCLE) return as soon as
+   they are written; a failure is reported on the next queued move.
    Return values are as per the #defines above */
     extern int usrmotWriteEmcmotCommand(emcmot_command_t * c);
 
+/* usrmotPendingCommands() returns how many of the commands written
+   the emcmot controller had not yet handled as of status s */
+    extern int usrmotPendingCommands(const emcmot_status_t * s);
+
 /* usrmotInit() initializes communication with the emcmot process */
     extern int usrmotInit(const char *name);
 
@@ -79,6 +85,9 @@ extern "C" {
 /* usrmotLoadComp() loads the compensation data in file into the joint */
     extern int usrmotLoadComp(int joint, const char *file, int type);
 
+/* usrmotLoadCompGrid() loads the volumetric compensation grid in file into the joint */
+    extern int usrmotLoadCompGrid(int joint, const char *file);
+
 /* usrmotPrintComp() prints the joint compensation data for the specified joint */
     extern int usrmotPrintComp(int joint);
 
@@ -1299,6 +1299,12 @@ void EMC_STAT::update(CMS * cms)
     motion.update(cms);
     io.update(cms);
     cms->update(debug);
+    cms->update(generation);
+    cms->update(task_generation);
+    cms->update(motion_generation);
+    cms->update(joint_generation, EMCMOT_MAX_JOINTS);
+    cms->update(io_generation);
+    cms->update(tool_table_generation);
 
 }
 
@@ -376,6 +376,7 @@ extern int emcJointActivate(int joint);
 extern int emcJointDeactivate(int joint);
 extern int emcJointOverrideLimits(int joint);
 extern int emcJointLoadComp(int joint, const char *file, int type);
+extern int emcJointLoadCompGrid(int joint, const char *file);
 extern int emcJogStop(int nr, int jjogmode);
 extern int emcJogCont(int nr, double vel, int jjogmode);
 extern int emcJogIncr(int nr, double incr, double vel, int jjogmode);
@@ -535,6 +536,7 @@ int emcSetupArcBlends(int arcBlendEnable,
         int arcBlendGapCycles,
         double arcBlendRampFreq,
         double arcBlendTangentKinkRatio);
+int emcSetPlannerType(int plannerType, double maxJerk);
 int emcSetProbeErrorInhibit(int j_inhibit, int h_inhibit);
 int emcGetExternalOffsetApplied(void);
 EmcPose emcGetExternalOffsets(void);
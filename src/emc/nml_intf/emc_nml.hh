@@ -2204,6 +2204,15 @@ class EMC_STAT:public EMC_STAT_MSG {
     EMC_IO_STAT io;
 
     int debug;			// copy of EMC_DEBUG global
+
+    // change counters, bumped by task when a section differs from the
+    // last status it wrote; the heartbeats don't count as changes
+    uint32_t generation;	// any section
+    uint32_t task_generation;
+    uint32_t motion_generation;	// motion, except joint[]
+    uint32_t joint_generation[EMCMOT_MAX_JOINTS];
+    uint32_t io_generation;	// io, except tool.toolTable[]
+    uint32_t tool_table_generation;
 };
 
 /*
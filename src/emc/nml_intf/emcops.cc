@@ -227,4 +227,8 @@ EMC_TOOL_STAT EMC_TOOL_STAT::operator =(EMC_TOOL_STAT s)
 
 EMC_STAT::EMC_STAT():EMC_STAT_MSG(EMC_STAT_TYPE, sizeof(EMC_STAT))
 {
+    generation = task_generation = 0;
+    motion_generation = io_generation = tool_table_generation = 0;
+    for (int j = 0; j < EMCMOT_MAX_JOINTS; j++)
+	joint_generation[j] = 0;
 }
@@ -18,29 +18,59 @@
 
 #include <string.h>		/* memcpy() */
 
-#include "rcs.hh"		// LinkedList
+#include "rcs.hh"
 #include "interpl.hh"		// these decls
 #include "emc.hh"
 #include "emcglb.h"
-#include "linklist.hh"
 #include "nmlmsg.hh"            /* class NMLmsg */
 #include "rcs_print.hh"
 
+// nodes in the first block of a list nobody reserved room for
+#define MIN_NODES 16
+
 NML_INTERP_LIST interp_list;	/* NML Union, for interpreter */
 
 NML_INTERP_LIST::NML_INTERP_LIST()
 {
-    linked_list_ptr = new LinkedList;
-
+    head = 0;
+    count = 0;
+    held = NULL;
     next_line_number = 0;
     line_number = 0;
 }
 
 NML_INTERP_LIST::~NML_INTERP_LIST()
 {
-    if (NULL != linked_list_ptr) {
-	delete linked_list_ptr;
-	linked_list_ptr = NULL;
+    for (size_t i = 0; i < blocks.size(); i++) {
+	delete[] blocks[i];
+    }
+}
+
+void NML_INTERP_LIST::reserve(int n)
+{
+    // one more for the node held by get()
+    int more = n + 1 - (int) ring.size();
+
+    if (more > 0) {
+	add_nodes(more);
+    }
+}
+
+// allocates n more nodes, and lays the ring out again around them
+void NML_INTERP_LIST::add_nodes(int n)
+{
+    NML_INTERP_LIST_NODE *block = new NML_INTERP_LIST_NODE[n];
+    std::vector<NML_INTERP_LIST_NODE *> r(ring.size() + n);
+
+    blocks.push_back(block);
+    for (int i = 0; i < count; i++) {
+	r[i] = ring[(head + i) % ring.size()];
+    }
+    ring.swap(r);
+    head = 0;
+    free_nodes.reserve(ring.size());
+    for (int i = 0; i < n; i++) {
+	free_nodes.push_back(&block[i]);
     }
 }
 
@@ -59,6 +89,8 @@ int NML_INTERP_LIST::set_line_number(int line)
 
 int NML_INTERP_LIST::append(NMLmsg * nml_msg_ptr)
 {
+    NML_INTERP_LIST_NODE *node_ptr;
+
     /* check for invalid data */
     if (NULL == nml_msg_ptr) {
 	rcs_print_error
@@ -82,39 +114,28 @@ int NML_INTERP_LIST::append(NMLmsg * nml_msg_ptr)
 	    ("NML_INTERP_LIST::append : command size is invalid.");
 	return -1;
     }
-#ifdef DEBUG_INTERPL
-    if (sizeof(temp_node) < MAX_NML_COMMAND_SIZE + 4 ||
-	sizeof(temp_node) > MAX_NML_COMMAND_SIZE + 16 ||
-	((void *) &temp_node.line_number) >
-	((void *) &temp_node.command.commandbuf)) {
-	rcs_print_error
-	    ("NML_INTERP_LIST::append : assumptions about NML_INTERP_LIST_NODE have been violated.");
-	return -1;
-    }
-#endif
 
-    if (NULL == linked_list_ptr) {
-	return -1;
+    if (free_nodes.empty()) {
+	// double it
+	add_nodes(ring.empty() ? MIN_NODES : ring.size());
     }
+    node_ptr = free_nodes.back();
+    free_nodes.pop_back();
+
     // fill in the NML_INTERP_LIST_NODE
-    temp_node.line_number = next_line_number;
-    memcpy(temp_node.command.commandbuf, nml_msg_ptr, nml_msg_ptr->size);
+    node_ptr->line_number = next_line_number;
+    memcpy(node_ptr->command.commandbuf, nml_msg_ptr, nml_msg_ptr->size);
 
     // stick it on the list
-    linked_list_ptr->store_at_tail(&temp_node,
-				   nml_msg_ptr->size +
-				   sizeof(temp_node.line_number) +
-				   sizeof(temp_node.dummy) + 32 + (32 -
-								   nml_msg_ptr->
-								   size %
-								   32), 1);
+    ring[(head + count) % ring.size()] = node_ptr;
+    count++;
 
     if (emc_debug & EMC_DEBUG_INTERP_LIST) {
 	rcs_print
 	    ("NML_INTERP_LIST(%p)::append(nml_msg_ptr{size=%ld,type=%s}) : list_size=%d, line_number=%d\n",
              this,
 	     nml_msg_ptr->size, emc_symbol_lookup(nml_msg_ptr->type),
-	     linked_list_ptr->list_size, temp_node.line_number);
+	     count, node_ptr->line_number);
     }
 
     return 0;
@@ -125,21 +146,23 @@ NMLmsg *NML_INTERP_LIST::get()
     NMLmsg *ret;
     NML_INTERP_LIST_NODE *node_ptr;
 
-    if (NULL == linked_list_ptr) {
+    if (0 == count) {
 	line_number = 0;
 	return NULL;
     }
 
-    node_ptr = (NML_INTERP_LIST_NODE *) linked_list_ptr->retrieve_head();
-
-    if (NULL == node_ptr) {
-	line_number = 0;
-	return NULL;
+    // get it off the front; the last one can be reused now
+    node_ptr = ring[head];
+    head = (head + 1) % ring.size();
+    count--;
+    if (NULL != held) {
+	free_nodes.push_back(held);
     }
+    held = node_ptr;
+
     // save line number of this one, for use by get_line_number
     line_number = node_ptr->line_number;
 
-    // get it off the front
     ret = (NMLmsg *) ((char *) node_ptr->command.commandbuf);
 
     if (emc_debug & EMC_DEBUG_INTERP_LIST) {
@@ -148,7 +171,7 @@ NMLmsg *NML_INTERP_LIST::get()
             this,
             ret->size,
             emc_symbol_lookup(ret->type),
-            linked_list_ptr->list_size
+            count
         );
     }
 
@@ -157,12 +180,13 @@ NMLmsg *NML_INTERP_LIST::get()
 
 void NML_INTERP_LIST::clear()
 {
-    if (NULL != linked_list_ptr) {
-        if (emc_debug & EMC_DEBUG_INTERP_LIST) {
-            rcs_print("NML_INTERP_LIST(%p)::clear(): discarding %d items\n", this, linked_list_ptr->list_size);
-        }
+    if (emc_debug & EMC_DEBUG_INTERP_LIST) {
+        rcs_print("NML_INTERP_LIST(%p)::clear(): discarding %d items\n", this, count);
+    }
 
-	linked_list_ptr->delete_members();
+    for (; count > 0; count--) {
+	free_nodes.push_back(ring[head]);
+	head = (head + 1) % ring.size();
     }
 }
 
@@ -172,30 +196,21 @@ void NML_INTERP_LIST::print()
     NML_INTERP_LIST_NODE *node_ptr;
     int line_number;
 
-    if (NULL == linked_list_ptr) {
-	return;
-    }
-    node_ptr = (NML_INTERP_LIST_NODE *) linked_list_ptr->get_head();
-
-    rcs_print("NML_INTERP_LIST::print(): list size=%d\n",linked_list_ptr->list_size);
-    while (NULL != node_ptr) {
+    rcs_print("NML_INTERP_LIST::print(): list size=%d\n", count);
+    for (int i = 0; i < count; i++) {
+	node_ptr = ring[(head + i) % ring.size()];
 	line_number = node_ptr->line_number;
 	ret = (NMLmsg *) ((char *) node_ptr->command.commandbuf);
 	rcs_print("--> type=%s,  line_number=%d\n",
 		  emc_symbol_lookup((int)ret->type),
 		  line_number);
-	node_ptr = (NML_INTERP_LIST_NODE *) linked_list_ptr->get_next();
     }
     rcs_print("\n");
 }
 
 int NML_INTERP_LIST::len()
 {
-    if (NULL == linked_list_ptr) {
-	return 0;
-    }
-
-    return ((int) linked_list_ptr->list_size);
+    return count;
 }
 
 int NML_INTERP_LIST::get_line_number()
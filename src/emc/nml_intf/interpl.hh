@@ -18,6 +18,7 @@
 #define INTERP_LIST_HH
 
 #include <stdint.h>
+#include <vector>
 
 #define MAX_NML_COMMAND_SIZE 1000
 
@@ -45,6 +46,11 @@ struct NML_INTERP_LIST_NODE {
 };
 
 // here's the interp list itself
+// Nodes are allocated in blocks and never move or go back to the heap:
+// the list is a ring of pointers to them, and unused ones are kept on a
+// free stack, so appending and getting don't allocate once the list has
+// grown to its working size.  The command returned by get() stays valid
+// until the next get() that returns one, clear() included.
 class NML_INTERP_LIST {
   public:
     NML_INTERP_LIST();
@@ -58,11 +64,18 @@ class NML_INTERP_LIST {
     void clear();
     void print();
     int len();
+    void reserve(int n);	// make room for n commands up front
 
   private:
-    class LinkedList * linked_list_ptr;
-    NML_INTERP_LIST_NODE temp_node;	// filled in and put on the list
-    int next_line_number;	// line number used to fill temp_node
+    void add_nodes(int n);
+
+    std::vector<NML_INTERP_LIST_NODE *> blocks;	// for the destructor
+    std::vector<NML_INTERP_LIST_NODE *> ring;	// one entry per node
+    std::vector<NML_INTERP_LIST_NODE *> free_nodes;
+    int head;			// ring index of the oldest command
+    int count;			// commands on the list
+    NML_INTERP_LIST_NODE *held;	// node of the command from get()
+    int next_line_number;	// line number used for appends
     int line_number;		// line number of node from get()
 };
 
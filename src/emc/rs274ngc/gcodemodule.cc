@@ -24,6 +24,7 @@
 #include "interp_return.hh"
 #include "canon.hh"
 #include "config.h"		// LINELEN
+#include <vector>
 
 int _task = 0; // control preview behaviour when remapping
 
@@ -148,19 +149,94 @@ static InterpBase *pinterp;
 
 #define callmethod(o, m, f, ...) PyObject_CallMethod((o), (char*)(m), (char*)(f), ## __VA_ARGS__)
 
-static void maybe_new_line(int sequence_number=pinterp->sequence_number());
-static void maybe_new_line(int sequence_number) {
+// State of the line being executed, taken at its first canon call.
+static double line_settings[ACTIVE_SETTINGS];
+static int line_gcodes[ACTIVE_G_CODES];
+static int line_mcodes[ACTIVE_M_CODES];
+static bool line_pending;
+
+/* Batched moves.  If the callback has a "moves" method, straight traverses,
+ * straight feeds and arcs are not passed to Python one call at a time.  They
+ * are appended to the arrays below and handed over in chunks as
+ *
+ *     moves(lines, types, positions, arcs)
+ *
+ * where each argument is a bytearray holding a C array: lines is int (line
+ * number of each move), types is signed char (MOVE_TRAVERSE, MOVE_FEED or
+ * MOVE_ARC), positions is 9 doubles per move (x y z a b c u v w, or for an
+ * arc first_end second_end axis_end_point a b c u v w) and arcs is 3 doubles
+ * per arc (first_axis second_axis rotation).  Lengths are in inches, as for
+ * the unbatched calls.
+ *
+ * The arrays are flushed before any other callback, including the ones
+ * that return a value such as get_tool and check_abort, and next_line is
+ * only called for the current line at that point, so the callback sees
+ * every other call in the same order and with the same state as before.
+ */
+enum { MOVE_TRAVERSE, MOVE_FEED, MOVE_ARC };
+#define MOVE_CHUNK 4096
+
+static bool batch_moves;
+static std::vector<int> move_lines;
+static std::vector<signed char> move_types;
+static std::vector<double> move_positions;
+static std::vector<double> move_arcs;
+
+static PyObject *bytes_of(const void *data, size_t size) {
+    return PyByteArray_FromStringAndSize((const char *)data, size);
+}
+
+static void send_moves() {
+    if(move_lines.empty()) return;
+    if(interp_error) return;
+    PyObject *result =
+        callmethod(callback, "moves", "NNNN",
+            bytes_of(move_lines.data(), move_lines.size() * sizeof(int)),
+            bytes_of(move_types.data(), move_types.size()),
+            bytes_of(move_positions.data(),
+                     move_positions.size() * sizeof(double)),
+            bytes_of(move_arcs.data(), move_arcs.size() * sizeof(double)));
+    if(result == NULL) interp_error ++;
+    Py_XDECREF(result);
+    move_lines.clear();
+    move_types.clear();
+    move_positions.clear();
+    move_arcs.clear();
+}
+
+static void append_move(int line_number, int type, double p0, double p1,
+                        double p2, double p3, double p4, double p5,
+                        double p6, double p7, double p8) {
+    move_lines.push_back(line_number);
+    move_types.push_back(type);
+    double p[9] = {p0, p1, p2, p3, p4, p5, p6, p7, p8};
+    move_positions.insert(move_positions.end(), p, p + 9);
+    if(move_lines.size() >= MOVE_CHUNK) send_moves();
+}
+
+static void new_line(int sequence_number) {
     if(!pinterp) return;
     if(interp_error) return;
     if(sequence_number == last_sequence_number)
         return;
+    pinterp->active_settings(line_settings);
+    pinterp->active_g_codes(line_gcodes);
+    pinterp->active_m_codes(line_mcodes);
+    line_gcodes[0] = sequence_number;
+    last_sequence_number = sequence_number;
+    line_pending = true;
+}
+
+static void send_line() {
+    send_moves();
+    if(!line_pending) return;
+    if(interp_error) return;
+    line_pending = false;
     LineCode *new_line_code =
         (LineCode*)(PyObject_New(LineCode, &LineCodeType));
-    pinterp->active_settings(new_line_code->settings);
-    pinterp->active_g_codes(new_line_code->gcodes);
-    pinterp->active_m_codes(new_line_code->mcodes);
-    new_line_code->gcodes[0] = sequence_number;
-    last_sequence_number = sequence_number;
+    memcpy(new_line_code->settings, line_settings, sizeof(line_settings));
+    memcpy(new_line_code->gcodes, line_gcodes, sizeof(line_gcodes));
+    memcpy(new_line_code->mcodes, line_mcodes, sizeof(line_mcodes));
     PyObject *result = 
         callmethod(callback, "next_line", "O", new_line_code);
     Py_DECREF(new_line_code);
@@ -168,6 +244,12 @@ static void maybe_new_line(int sequence_number) {
     Py_XDECREF(result);
 }
 
+static void maybe_new_line(int sequence_number=pinterp->sequence_number());
+static void maybe_new_line(int sequence_number) {
+    new_line(sequence_number);
+    send_line();
+}
+
 void NURBS_FEED(int line_number, std::vector<CONTROL_POINT> nurbs_control_points, unsigned int k) {
     double u = 0.0;
     unsigned int n = nurbs_control_points.size() - 1;
@@ -202,6 +284,16 @@ void ARC_FEED(int line_number,
         v_position /= 25.4;
         w_position /= 25.4;
     }
+    if(batch_moves) {
+        new_line(line_number);
+        if(interp_error) return;
+        double arc[3] = {first_axis, second_axis, (double)rotation};
+        move_arcs.insert(move_arcs.end(), arc, arc + 3);
+        append_move(line_number, MOVE_ARC, first_end, second_end,
+                    axis_end_point, a_position, b_position, c_position,
+                    u_position, v_position, w_position);
+        return;
+    }
     maybe_new_line(line_number);
     if(interp_error) return;
     PyObject *result =
@@ -222,6 +314,12 @@ void STRAIGHT_FEED(int line_number,
     _pos_a=a; _pos_b=b; _pos_c=c;
     _pos_u=u; _pos_v=v; _pos_w=w;
     if(metric) { x /= 25.4; y /= 25.4; z /= 25.4; u /= 25.4; v /= 25.4; w /= 25.4; }
+    if(batch_moves) {
+        new_line(line_number);
+        if(interp_error) return;
+        append_move(line_number, MOVE_FEED, x, y, z, a, b, c, u, v, w);
+        return;
+    }
     maybe_new_line(line_number);
     if(interp_error) return;
     PyObject *result =
@@ -239,6 +337,12 @@ void STRAIGHT_TRAVERSE(int line_number,
     _pos_a=a; _pos_b=b; _pos_c=c;
     _pos_u=u; _pos_v=v; _pos_w=w;
     if(metric) { x /= 25.4; y /= 25.4; z /= 25.4; u /= 25.4; v /= 25.4; w /= 25.4; }
+    if(batch_moves) {
+        new_line(line_number);
+        if(interp_error) return;
+        append_move(line_number, MOVE_TRAVERSE, x, y, z, a, b, c, u, v, w);
+        return;
+    }
     maybe_new_line(line_number);
     if(interp_error) return;
     PyObject *result =
@@ -421,6 +525,7 @@ int  GET_EXTERNAL_TC_REASON() {return 0;}
 
 extern bool GET_BLOCK_DELETE(void) { 
     int bd = 0;
+    send_line();
     if(interp_error) return 0;
     PyObject *result =
         callmethod(callback, "get_block_delete", "");
@@ -534,6 +639,7 @@ void GET_EXTERNAL_PARAMETER_FILE_NAME(char *name, int max_size) {
 CANON_UNITS GET_EXTERNAL_LENGTH_UNIT_TYPE() { return CANON_UNITS_INCHES; }
 CANON_TOOL_TABLE GET_EXTERNAL_TOOL_TABLE(int pocket) {
     CANON_TOOL_TABLE t = {-1,-1,{{0,0,0},0,0,0,0,0,0},0,0,0,0};
+    send_line();
     if(interp_error) return t;
     PyObject *result =
         callmethod(callback, "get_tool", "i", pocket);
@@ -597,6 +703,7 @@ EmcPose GET_EXTERNAL_OFFSETS() {
 };
 
 int GET_EXTERNAL_AXIS_MASK() {
+    send_line();
     if(interp_error) return 7;
     PyObject *result =
         callmethod(callback, "get_axis_mask", "");
@@ -650,6 +757,7 @@ static bool PyFloat_CheckAndError(const char *func, PyObject *p)  {
 }
 
 double GET_EXTERNAL_ANGLE_UNITS() {
+    send_line();
     PyObject *result =
         callmethod(callback, "get_external_angular_units", "");
     if(result == NULL) interp_error++;
@@ -665,6 +773,7 @@ double GET_EXTERNAL_ANGLE_UNITS() {
 }
 
 double GET_EXTERNAL_LENGTH_UNITS() {
+    send_line();
     PyObject *result =
         callmethod(callback, "get_external_length_units", "");
     if(result == NULL) interp_error++;
@@ -680,6 +789,8 @@ double GET_EXTERNAL_LENGTH_UNITS() {
 }
 
 static bool check_abort() {
+    send_line();
+    if(interp_error) return 1;
     PyObject *result =
         callmethod(callback, "check_abort", "");
     if(!result) return 1;
@@ -737,6 +848,12 @@ static PyObject *parse_file(PyObject *self, PyObject *args) {
     metric=false;
     interp_error = 0;
     last_sequence_number = -1;
+    line_pending = false;
+    batch_moves = PyObject_HasAttrString(callback, "moves");
+    move_lines.clear();
+    move_types.clear();
+    move_positions.clear();
+    move_arcs.clear();
 
     _pos_x = _pos_y = _pos_z = _pos_a = _pos_b = _pos_c = 0;
     _pos_u = _pos_v = _pos_w = 0;
@@ -782,6 +899,7 @@ static PyObject *parse_file(PyObject *self, PyObject *args) {
         result = pinterp->execute();
     }
 out_error:
+    send_moves();
     if(pinterp)
     {
         auto interp = dynamic_cast<Interp*>(pinterp);
@@ -0,0 +1,438 @@
+/********************************************************************
+* Description: interp_expr.cc
+*
+*   Compiled expressions.
+*
+*   With [RS274NGC]EXPRESSION_CACHE set, read_real_expression keeps a
+*   compiled form of each bracketed expression it reads, keyed by the
+*   expression text.  When the same text comes around again (the body
+*   of an O-word loop, a subroutine called many times) the compiled
+*   form is evaluated instead of reading the text character by
+*   character.  Numbered parameters with a constant index are resolved
+*   to their slot, and names of named parameters are interned, when the
+*   expression is compiled.
+*
+*   Only expressions that evaluate cleanly take the compiled path.  If
+*   anything goes wrong (a named parameter that does not exist, an
+*   index that is out of range, a domain error, a result that is not a
+*   number) the expression is read again the usual way, so errors and
+*   their messages are exactly those of read_real_expression.  A named
+*   parameter backed by Python may have side effects, so expressions
+*   that read one are never evaluated from the compiled form: calling
+*   it there and again on the way back through the usual path would
+*   run it twice.
+*
+* License: GPL Version 2
+* System: Linux
+*
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "rs274ngc.hh"
+#include "rs274ngc_return.hh"
+#include "interp_internal.hh"
+#include "rs274ngc_interp.hh"
+
+using namespace interp_param_global;
+
+// compiled expressions kept before the cache is emptied and refilled
+#define MAX_CACHED_EXPRESSIONS 4096
+// deepest evaluation stack a compiled expression may need
+#define EXPR_STACK 32
+// binary operations waiting for their right operand; precedences in an
+// expression only ever increase between reductions, so six is enough
+#define EXPR_PENDING 8
+
+enum expr_opcode {
+    EXPR_NUMBER,                // push number
+    EXPR_PARAMETER,             // push parameters[arg]
+    EXPR_PARAMETER_INDIRECT,    // replace index on top with parameters[index]
+    EXPR_NAMED,                 // push named parameter names[arg]
+    EXPR_EXISTS_NAMED,          // push 1 if names[arg] exists, else 0
+    EXPR_EXISTS_INDIRECT,       // replace index on top with 1 if in range
+    EXPR_NEGATE,
+    EXPR_UNARY,                 // execute_unary arg on top
+    EXPR_ATAN,                  // two argument atan, in degrees
+    EXPR_BINARY,                // execute_binary arg on the top two
+};
+
+struct expr_op {
+    int opcode;
+    int arg;
+    double number;
+};
+
+struct compiled_expression {
+    bool ok;                    // false: read this one the usual way
+    std::vector<expr_op> ops;
+    std::vector<const char *> names;    // interned
+};
+
+typedef std::unordered_map<std::string, compiled_expression> expression_map;
+
+static expression_map cache;
+static std::string key;
+// evaluations in progress; a named parameter backed by Python may run
+// more G-code while one is, and that must not empty the cache under it
+static int evaluating;
+
+// the integer read_integer_value would make of a value
+static bool to_index(double value, int *index)
+{
+    *index = (int) floor(value);
+    if ((value - *index) > 0.9999)
+        *index = (int) ceil(value);
+    else if ((value - *index) > 0.0001)
+        return false;
+    return true;
+}
+
+// Length of the bracketed expression at the start of line, up to and
+// including the matching bracket, or 0 if it isn't closed.  Names of
+// named parameters may contain brackets (#<_ini[axis_x]max_velocity>),
+// so they are skipped.
+static int expression_length(const char *line)
+{
+    int depth = 0;
+
+    for (const char *p = line; *p; p++) {
+        if (p[0] == '#' && p[1] == '<') {
+            p = strchr(p, '>');
+            if (!p)
+                return 0;
+        } else if (*p == '[') {
+            depth++;
+        } else if (*p == ']' && --depth == 0) {
+            return p - line + 1;
+        }
+    }
+    return 0;
+}
+
+// Turns expression text into a program for a stack machine.  The text is
+// read by the same readers read_real_expression uses, following the same
+// grammar, so it stops wherever read_real_expression would stop.
+struct expression_compiler {
+    Interp *interp;
+    char *line;
+    int counter;
+    compiled_expression *expr;
+    int depth;
+    int max_depth;
+
+    void emit(int opcode, int arg = 0, double number = 0.0, int pushes = 0) {
+        expr_op op = { opcode, arg, number };
+        expr->ops.push_back(op);
+        depth += pushes;
+        if (depth > max_depth)
+            max_depth = depth;
+    }
+
+    bool expression();
+    bool value();
+    bool parameter();
+    bool unary();
+};
+
+// read_real_expression
+bool expression_compiler::expression()
+{
+    int pending[EXPR_PENDING];
+    int n = 0;
+    int operation;
+
+    if (line[counter] != '[')
+        return false;
+    counter++;
+    for (;;) {
+        if (!value())
+            return false;
+        if (interp->read_operation(line, &counter, &operation) != INTERP_OK)
+            return false;
+        while (n > 0 && interp->precedence(operation) <=
+                        interp->precedence(pending[n - 1]))
+            emit(EXPR_BINARY, pending[--n], 0.0, -1);
+        if (operation == RIGHT_BRACKET)
+            return true;
+        if (n == EXPR_PENDING)
+            return false;
+        pending[n++] = operation;
+    }
+}
+
+// read_real_value
+bool expression_compiler::value()
+{
+    char c = line[counter];
+    char c1;
+    double number;
+
+    if (c == 0)
+        return false;
+    c1 = line[counter + 1];
+
+    if (c == '[')
+        return expression();
+    if (c == '#')
+        return parameter();
+    if ((c == '+' || c == '-') && c1 && !isdigit(c1) && c1 != '.') {
+        counter++;
+        if (!value())
+            return false;
+        if (c == '-')
+            emit(EXPR_NEGATE);
+        return true;
+    }
+    if (c >= 'a' && c <= 'z')
+        return unary();
+    if (interp->read_real_number(line, &counter, &number) != INTERP_OK)
+        return false;
+    emit(EXPR_NUMBER, 0, number, 1);
+    return true;
+}
+
+// read_parameter
+bool expression_compiler::parameter()
+{
+    char name[LINELEN + 1];
+    int index;
+
+    counter++;
+    if (line[counter] == '<') {
+        if (interp->read_name(line, &counter, name) != INTERP_OK)
+            return false;
+        expr->names.push_back(intern_name(name));
+        emit(EXPR_NAMED, expr->names.size() - 1, 0.0, 1);
+        return true;
+    }
+    if (!value())
+        return false;
+    expr_op &last = expr->ops.back();
+    if (last.opcode == EXPR_NUMBER && to_index(last.number, &index) &&
+        index >= 1 && index < RS274NGC_MAX_PARAMETERS) {
+        last.opcode = EXPR_PARAMETER;
+        last.arg = index;
+    } else {
+        emit(EXPR_PARAMETER_INDIRECT);
+    }
+    return true;
+}
+
+// read_unary, read_bracketed_parameter and read_atan
+bool expression_compiler::unary()
+{
+    char name[LINELEN + 1];
+    int operation;
+
+    if (interp->read_operation_unary(line, &counter, &operation) != INTERP_OK)
+        return false;
+    if (line[counter] != '[')
+        return false;
+
+    if (operation == EXISTS) {
+        counter++;
+        if (line[counter] != '#')
+            return false;
+        counter++;
+        if (line[counter] == '<') {
+            if (interp->read_name(line, &counter, name) != INTERP_OK)
+                return false;
+            expr->names.push_back(intern_name(name));
+            emit(EXPR_EXISTS_NAMED, expr->names.size() - 1, 0.0, 1);
+        } else {
+            if (!value())
+                return false;
+            emit(EXPR_EXISTS_INDIRECT);
+        }
+        if (line[counter] != ']')
+            return false;
+        counter++;
+        return true;
+    }
+
+    if (!expression())
+        return false;
+    if (operation == ATAN) {
+        if (line[counter] != '/')
+            return false;
+        counter++;
+        if (!expression())
+            return false;
+        emit(EXPR_ATAN, 0, 0.0, -1);
+    } else {
+        emit(EXPR_UNARY, operation);
+    }
+    return true;
+}
+
+static compiled_expression *find_expression(Interp *interp, char *start,
+                                            int length)
+{
+    key.assign(start, length);
+    expression_map::iterator it = cache.find(key);
+    if (it != cache.end())
+        return &it->second;
+
+    if (cache.size() >= MAX_CACHED_EXPRESSIONS) {
+        if (evaluating)
+            return NULL;
+        cache.clear();
+    }
+    compiled_expression *expr = &cache[key];
+
+    // compile a copy, the readers want a terminated line
+    std::string text(key);
+    expression_compiler compiler = { interp, &text[0], 0, expr, 0, 0 };
+    expr->ok = compiler.expression() && compiler.counter == length &&
+               compiler.max_depth <= EXPR_STACK;
+    if (!expr->ok) {
+        expr->ops.clear();
+        expr->names.clear();
+    }
+    return expr;
+}
+
+// Whether reading named parameter name calls into Python.
+static bool python_param(Interp *interp, const char *name)
+{
+    int level = (name[0] == '_') ? 0 : interp->_setup.call_level;
+    parameter_map &params = interp->_setup.sub_context[level].named_params;
+    parameter_map_iterator pi = params.find(name);
+
+    return pi != params.end() && (pi->second.attr & PA_PYTHON);
+}
+
+// Runs a compiled expression.  Returns false, leaving *value alone, where
+// read_real_expression would have returned an error, and in a few places
+// where it would not (see the nan check).  Nothing with a side effect
+// runs before it returns false; an expression that reads a Python
+// parameter is marked to be read the usual way from then on.
+static bool evaluate(Interp *interp, compiled_expression *expr,
+                     double *parameters, double *value)
+{
+    double stack[EXPR_STACK];
+    int top = -1;
+    int index;
+    int exists;
+    bool comp = interp->_setup.cutter_comp_side;
+
+    for (size_t i = 0; i < expr->ops.size(); i++) {
+        const expr_op &op = expr->ops[i];
+        switch (op.opcode) {
+        case EXPR_NUMBER:
+            stack[++top] = op.number;
+            break;
+        case EXPR_PARAMETER:
+            if (comp && op.arg >= 5420 && op.arg <= 5428)
+                return false;
+            stack[++top] = parameters[op.arg];
+            break;
+        case EXPR_PARAMETER_INDIRECT:
+            if (!to_index(stack[top], &index) ||
+                index < 1 || index >= RS274NGC_MAX_PARAMETERS ||
+                (comp && index >= 5420 && index <= 5428))
+                return false;
+            stack[top] = parameters[index];
+            break;
+        case EXPR_NAMED:
+            if (python_param(interp, expr->names[op.arg])) {
+                expr->ok = false;
+                return false;
+            }
+            if (interp->find_named_param(expr->names[op.arg], &exists,
+                                         &stack[++top]) != INTERP_OK ||
+                !exists)
+                return false;
+            break;
+        case EXPR_EXISTS_NAMED:
+            if (python_param(interp, expr->names[op.arg])) {
+                expr->ok = false;
+                return false;
+            }
+            if (interp->find_named_param(expr->names[op.arg], &exists,
+                                         &stack[++top]) != INTERP_OK)
+                return false;
+            stack[top] = exists ? 1.0 : 0.0;
+            break;
+        case EXPR_EXISTS_INDIRECT:
+            if (!to_index(stack[top], &index))
+                return false;
+            stack[top] = index >= 1 && index < RS274NGC_MAX_PARAMETERS;
+            break;
+        case EXPR_NEGATE:
+            stack[top] = -stack[top];
+            break;
+        case EXPR_UNARY:
+            if (interp->execute_unary(&stack[top], op.arg) != INTERP_OK)
+                return false;
+            break;
+        case EXPR_ATAN:
+            top--;
+            stack[top] = atan2(stack[top], stack[top + 1]);
+            stack[top] = (stack[top] * 180.0) / M_PIl;
+            break;
+        case EXPR_BINARY:
+            top--;
+            if (interp->execute_binary(&stack[top], op.arg,
+                                       &stack[top + 1]) != INTERP_OK)
+                return false;
+            break;
+        }
+        // read_real_value only checks the values it reads, checking every
+        // intermediate result as well just sends a few more to the slow path
+        if (std::isnan(stack[top]) || std::isinf(stack[top]))
+            return false;
+    }
+    *value = stack[0];
+    return true;
+}
+
+/****************************************************************************/
+
+/*! read_cached_expression
+
+Returned Value: bool
+   true if the expression at the counter was evaluated from its compiled
+   form, false if it has to be read by read_real_expression.
+
+Side effects:
+   If true is returned, the value of the expression is put into what
+   value points at and the counter is moved past the expression.
+   If false is returned, nothing is changed except possibly the error
+   message, which read_real_expression will set again.
+
+Called by: read_real_expression
+
+*/
+
+bool Interp::read_cached_expression(char *line,  //!< string: line of RS274/NGC code being processed
+                                    int *counter,        //!< pointer to a counter for position on the line
+                                    double *value,       //!< pointer to double to be computed
+                                    double *parameters)  //!< array of system parameters
+{
+    char *start = line + *counter;
+    int length = expression_length(start);
+    compiled_expression *expr;
+    bool ok;
+
+    if (length == 0)
+        return false;
+    expr = find_expression(this, start, length);
+    if (!expr || !expr->ok)
+        return false;
+
+    evaluating++;
+    ok = evaluate(this, expr, parameters, value);
+    evaluating--;
+    if (ok)
+        *counter += length;
+    return ok;
+}
@@ -16,9 +16,11 @@
 #include <algorithm>
 #include "config.h"
 #include <limits.h>
+#include <ctype.h>
 #include <stdio.h>
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <bitset>
 #include "canon.hh"
 #include "emcpos.h"
@@ -324,6 +326,13 @@ enum RETRACT_MODE
 
 // string table - to get rid of strdup/free
 const char *strstore(const char *s);
+// like strstore, but all spellings of a name that differ only in case
+// give the same pointer; used for parameter and O-word names
+const char *intern_name(const char *s);
+
+// memory-mapped program files, see interp_program.cc
+FILE *ngc_fopen(const char *filename, bool mapped);
+bool ngc_find_sub(FILE *fp, const char *name, bool fanuc_barrier, int *skipped);
 
 
 // Block execution phases in execution order
@@ -413,6 +422,27 @@ struct nocase_cmp
     }
 };
 
+// case insensitive hash and equality for std::unordered_map etc; names
+// from intern_name compare equal by address
+struct nocase_hash
+{
+    size_t operator()(const char *s) const
+    {
+        size_t h = 2166136261u;
+        for (; *s; s++)
+            h = (h ^ (unsigned char) tolower(*s)) * 16777619u;
+        return h;
+    }
+};
+
+struct nocase_equal
+{
+    bool operator()(const char *s1, const char *s2) const
+    {
+        return s1 == s2 || strcasecmp(s1, s2) == 0;
+    }
+};
+
 typedef std::map<const char *,remap,nocase_cmp> remap_map;
 typedef remap_map::iterator remap_iterator;
 
@@ -551,13 +581,19 @@ enum call_types {
 
 enum retopts { RET_NONE, RET_DOUBLE, RET_INT, RET_YIELD, RET_STOPITERATION, RET_ERRORMSG };
 
-// parameters will go to a std::map<const char *,parameter_value_pointer>
+// parameters will go to a std::unordered_map<const char *,parameter_value_pointer>
 struct parameter_value_struct {
     double value;
     unsigned attr;
 };
 
-typedef std::map<const char *, parameter_value, nocase_cmp> parameter_map;
+// key_comp() is for boost.python's map_indexing_suite, which keeps the
+// proxies it hands out for elements sorted by key
+struct parameter_map :
+    std::unordered_map<const char *, parameter_value, nocase_hash, nocase_equal>
+{
+    nocase_cmp key_comp() const { return nocase_cmp(); }
+};
 typedef parameter_map::iterator parameter_map_iterator;
 
 #define PA_READONLY	1
@@ -619,8 +655,8 @@ struct offset_struct {
   int repeat_count;
 };
 
-typedef std::map<const char *, offset, nocase_cmp> offset_map_type;
-typedef std::map<const char *, offset, nocase_cmp>::iterator offset_map_iterator;
+typedef std::unordered_map<const char *, offset, nocase_hash, nocase_equal> offset_map_type;
+typedef offset_map_type::iterator offset_map_iterator;
 
 /*
 
@@ -796,6 +832,11 @@ struct setup
   int feature_set;
 
     int disable_fanuc_style_sub;
+    // read program files through a memory mapping, and index them for
+    // sub lookups
+    int mmap_programs;
+    // keep a compiled form of expressions, see interp_expr.cc
+    int expression_cache;
     // M99 in main is treated as program end by default; this causes
     // control to skip to beginning of file
     bool loop_on_main_m99;
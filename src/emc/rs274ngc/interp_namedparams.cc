@@ -336,7 +336,7 @@ int Interp::find_named_param(
 	      parameter_value param;  // cache the value
 	      param.value = inivalue;
 	      param.attr = PA_GLOBAL | PA_READONLY | PA_FROM_INI;
-	      _setup.sub_context[0].named_params[strstore(nameBuf)] = param;
+	      _setup.sub_context[0].named_params[intern_name(nameBuf)] = param;
 	      return INTERP_OK;
 	  } 
       }
@@ -467,7 +467,7 @@ int Interp::add_named_param(
   }
   param.value = 0.0;
   param.attr = attr;
-  _setup.sub_context[level].named_params[strstore(nameBuf)] = param;
+  _setup.sub_context[level].named_params[intern_name(nameBuf)] = param;
   return INTERP_OK;
 }
 
@@ -751,7 +751,7 @@ int Interp::init_python_predef_parameter(const char *name)
 	}
 	param.value = 0.0;
 	param.attr = PA_READONLY|PA_PYTHON|PA_GLOBAL;
-	_setup.sub_context[0].named_params[strstore(name)] = param;
+	_setup.sub_context[0].named_params[intern_name(name)] = param;
     }
     return INTERP_OK;
 }
@@ -461,7 +461,8 @@ int Interp::execute_return(setup_pointer settings, context_pointer current_frame
 		//!!!KL must open the new file, if changed
 		if (0 != strcmp(settings->filename, previous_frame->filename))  {
 		    fclose(settings->file_pointer);
-		    settings->file_pointer = fopen(previous_frame->filename, "r");
+		    settings->file_pointer = ngc_fopen(previous_frame->filename,
+						       settings->mmap_programs);
 		    if (settings->file_pointer == NULL)  {
 			ERS(NCE_CANNOT_REOPEN_FILE, 
 			    previous_frame->filename,
@@ -556,7 +557,7 @@ int Interp::control_back_to( block_pointer block, // pointer to block
 	if (0 != strcmp(settings->filename,
 			op->filename)) {
 	    // open the new file...
-	    newFP = fopen(op->filename, "r");
+	    newFP = ngc_fopen(op->filename, settings->mmap_programs);
 	    // set the line number
 	    settings->sequence_number = 0;
             strncpy(settings->filename, op->filename, sizeof(settings->filename));
@@ -608,6 +609,14 @@ int Interp::control_back_to( block_pointer block, // pointer to block
     settings->skipping_o = block->o_name; // start skipping
     settings->skipping_to_sub = block->o_name; // start skipping
     settings->skipping_start = settings->sequence_number;
+
+    // in a mapped program, go straight to the definition
+    int skipped;
+    if (settings->file_pointer &&
+	ngc_find_sub(settings->file_pointer, block->o_name,
+		     settings->disable_fanuc_style_sub, &skipped)) {
+	settings->sequence_number += skipped;
+    }
     return INTERP_OK;
 }
 
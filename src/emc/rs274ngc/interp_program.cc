@@ -0,0 +1,440 @@
+/********************************************************************
+* Description: interp_program.cc
+*
+*   Memory-mapped program files.
+*
+*   With [RS274NGC]MMAP_PROGRAMS set, program and subroutine files are
+*   mapped once and read through a stdio stream on top of the mapping,
+*   so reopening a file on call and return and seeking around in it
+*   costs no system calls.  The first time a subroutine has to be
+*   searched for in a file, the file is scanned once for O-word sub
+*   definitions, and that index is kept with the mapping: later
+*   searches jump to the definition instead of skipping line by line.
+*
+* License: GPL Version 2
+* System: Linux
+*
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "rs274ngc.hh"
+#include "interp_internal.hh"
+
+// lines between entries of the line index
+#define LINE_CHECKPOINT 1024
+// mappings kept around after the last stream on them is closed
+#define MAX_CACHED_PROGRAMS 16
+
+namespace {
+
+struct ProgramMap {
+    const char *base;
+    size_t size;
+    dev_t dev;
+    ino_t ino;
+    struct timespec mtime;
+
+    // built on the first sub search; everything below is file offsets
+    bool indexed;
+    std::vector<long> lines;    // every LINE_CHECKPOINT'th line
+    std::unordered_map<std::string, std::vector<long> > subs;
+    std::vector<long> barriers; // lines a search must not jump past
+    std::vector<long> fanuc;    // bare 'ONNN' lines
+
+    ProgramMap() : base(NULL), size(0), dev(0), ino(0), indexed(false) {}
+    ~ProgramMap() { if (base) munmap((void *)base, size); }
+
+    void index();
+    void indexLine(const char *p, const char *eol);
+    static bool hasSubMcode(const char *s);
+    static bool isOwordKeyword(const char *s);
+    int lineOf(long offset);
+};
+
+struct ProgramStream {
+    std::shared_ptr<ProgramMap> map;
+    off64_t pos;
+    FILE *fp;
+};
+
+std::map<std::string, std::shared_ptr<ProgramMap> > programs;
+std::map<FILE *, ProgramStream *> streams;
+
+}
+
+void ProgramMap::index()
+{
+    const char *p = base, *end = base + size;
+    long line;
+
+    for (line = 0; p < end; line++) {
+        const char *eol = (const char *) memchr(p, '\n', end - p);
+        if (!eol)
+            eol = end;
+        if (line % LINE_CHECKPOINT == 0)
+            lines.push_back(p - base);
+        indexLine(p, eol);
+        p = eol + 1;
+    }
+    indexed = true;
+}
+
+/* Classify one line the way read_text() and read_items() would see it.
+   Anything the reader could stop at, or fail on, while skipping to a
+   sub and that can't be settled here becomes a barrier: the search
+   jumps no further and leaves the rest to the reader. That includes
+   M98/M99 lines and O-words read_o() would reject. */
+void ProgramMap::indexLine(const char *p, const char *eol)
+{
+    long offset = p - base;
+    char buf[LINELEN];
+    const char *s;
+    std::string name;
+    int n;
+
+    // fgets() splits longer lines, and read_text() rejects them
+    if ((eol - p) + (eol < base + size) >= LINELEN - 1) {
+        barriers.push_back(offset);
+        return;
+    }
+
+    // as close_and_downcase(), up to the first comment
+    for (n = 0; p < eol; p++) {
+        char c = tolower((unsigned char) *p);
+        if (c == ' ' || c == '\t' || c == '\r')
+            continue;
+        buf[n++] = c;
+        if (c == '(' || c == ';')
+            break;
+    }
+    buf[n] = 0;
+
+    // M98 and M99 go to read_o() like O-words do
+    if (hasSubMcode(buf)) {
+        barriers.push_back(offset);
+        return;
+    }
+    // only block delete, N- and O-words and '%' can start a line of interest
+    if (buf[0] != '/' && buf[0] != 'n' && buf[0] != 'o' && buf[0] != '%')
+        return;
+
+    // program end in a percent-delimited file
+    if (strcmp(buf, "%") == 0) {
+        barriers.push_back(offset);
+        return;
+    }
+
+    s = buf;
+    bool slash = (*s == '/');
+    if (slash)
+        s++;
+    if (*s == 'n') {
+        s++;
+        if (!isdigit((unsigned char) *s)) {
+            barriers.push_back(offset);
+            return;
+        }
+        while (isdigit((unsigned char) *s))
+            s++;
+        if (*s == '.') {
+            s++;
+            if (!isdigit((unsigned char) *s)) {
+                barriers.push_back(offset);
+                return;
+            }
+            while (isdigit((unsigned char) *s))
+                s++;
+        }
+    }
+    if (*s != 'o')
+        return;
+    // whether this is read at all depends on the block delete switch
+    if (slash) {
+        barriers.push_back(offset);
+        return;
+    }
+
+    s++;
+    if (*s == '<') {
+        const char *e = strchr(s, '>');
+        if (!e) {
+            barriers.push_back(offset);
+            return;
+        }
+        name.assign(s + 1, e);
+        s = e + 1;
+    } else if (isdigit((unsigned char) *s)) {
+        int value = 0, digits = 0;
+        for (; isdigit((unsigned char) *s); s++) {
+            if (++digits > 9) {
+                barriers.push_back(offset);
+                return;
+            }
+            value = 10 * value + (*s - '0');
+        }
+        // read as a real number; leave that to the reader
+        if (*s == '.') {
+            barriers.push_back(offset);
+            return;
+        }
+        name = std::to_string(value);
+    } else {
+        // computed O-word
+        barriers.push_back(offset);
+        return;
+    }
+
+    if (strncmp(s, "sub", 3) == 0) {
+        subs[name].push_back(offset);
+    } else if (*s == '(' || *s == ';' || *s == 0) {
+        subs[name].push_back(offset);
+        fanuc.push_back(offset);
+    } else if (strncmp(s, "call", 4) == 0 || strncmp(s, "return", 6) == 0 ||
+               strncmp(s, "endsub", 6) == 0) {
+        // the reader parses these fully when the name matches
+        subs[name].push_back(offset);
+    } else if (!isOwordKeyword(s)) {
+        // read_o() fails on it
+        barriers.push_back(offset);
+    }
+}
+
+/* Whether a line, without blanks and in lower case, has an M-word the
+   reader could take for M98 or M99. An 'm' outside a comment or a
+   name, followed by anything but a plain number, counts too. */
+bool ProgramMap::hasSubMcode(const char *s)
+{
+    for (; *s && *s != '(' && *s != ';'; s++) {
+        if (*s == '<') {
+            const char *e = strchr(s, '>');
+            if (!e)
+                return false;
+            s = e;
+            continue;
+        }
+        if (*s != 'm')
+            continue;
+        if (!isdigit((unsigned char) s[1]))
+            return true;
+        while (s[1] == '0')
+            s++;
+        if (s[1] == '9' && (s[2] == '8' || s[2] == '9') &&
+            !isdigit((unsigned char) s[3]))
+            return true;
+    }
+    return false;
+}
+
+/* Whether read_o() knows the word after an O-word name. */
+bool ProgramMap::isOwordKeyword(const char *s)
+{
+    static const char *const keywords[] = {
+        "sub", "endsub", "call", "do", "while", "repeat", "if", "elseif",
+        "else", "endif", "break", "continue", "endwhile", "endrepeat",
+        "return",
+    };
+
+    for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+        if (strncmp(s, keywords[i], strlen(keywords[i])) == 0)
+            return true;
+    }
+    return false;
+}
+
+/* Number of lines fgets() returns reading up to offset. */
+int ProgramMap::lineOf(long offset)
+{
+    std::vector<long>::iterator it =
+        std::upper_bound(lines.begin(), lines.end(), offset) - 1;
+    int line = (it - lines.begin()) * LINE_CHECKPOINT;
+    const char *p = base + *it, *end = base + offset;
+
+    while (p < end && (p = (const char *) memchr(p, '\n', end - p))) {
+        line++;
+        p++;
+    }
+    if (offset > 0 && base[offset - 1] != '\n')
+        line++;
+    return line;
+}
+
+static ssize_t stream_read(void *cookie, char *buf, size_t len)
+{
+    ProgramStream *s = (ProgramStream *) cookie;
+    size_t left = 0;
+
+    if (s->pos < (off64_t) s->map->size)
+        left = s->map->size - s->pos;
+    if (len > left)
+        len = left;
+    memcpy(buf, s->map->base + s->pos, len);
+    s->pos += len;
+    return len;
+}
+
+static int stream_seek(void *cookie, off64_t *offset, int whence)
+{
+    ProgramStream *s = (ProgramStream *) cookie;
+    off64_t pos;
+
+    switch (whence) {
+    case SEEK_SET:
+        pos = *offset;
+        break;
+    case SEEK_CUR:
+        pos = s->pos + *offset;
+        break;
+    case SEEK_END:
+        pos = s->map->size + *offset;
+        break;
+    default:
+        return -1;
+    }
+    if (pos < 0)
+        return -1;
+    s->pos = *offset = pos;
+    return 0;
+}
+
+static int stream_close(void *cookie)
+{
+    ProgramStream *s = (ProgramStream *) cookie;
+
+    streams.erase(s->fp);
+    delete s;
+    return 0;
+}
+
+static std::shared_ptr<ProgramMap> map_program(const char *filename)
+{
+    std::map<std::string, std::shared_ptr<ProgramMap> >::iterator it;
+    std::shared_ptr<ProgramMap> map;
+    struct stat st;
+    void *base;
+    int fd;
+
+    if (stat(filename, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+        return map;
+
+    it = programs.find(filename);
+    if (it != programs.end()) {
+        ProgramMap *m = it->second.get();
+        if (m->dev == st.st_dev && m->ino == st.st_ino &&
+            m->size == (size_t) st.st_size &&
+            m->mtime.tv_sec == st.st_mtim.tv_sec &&
+            m->mtime.tv_nsec == st.st_mtim.tv_nsec)
+            return it->second;
+        // changed on disk; streams still open on the old one keep it
+        programs.erase(it);
+    }
+
+    fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return map;
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return map;
+    madvise(base, st.st_size, MADV_SEQUENTIAL);
+
+    map = std::make_shared<ProgramMap>();
+    map->base = (const char *) base;
+    map->size = st.st_size;
+    map->dev = st.st_dev;
+    map->ino = st.st_ino;
+    map->mtime = st.st_mtim;
+
+    if (programs.size() >= MAX_CACHED_PROGRAMS) {
+        for (it = programs.begin(); it != programs.end();) {
+            if (it->second.use_count() == 1)
+                it = programs.erase(it);
+            else
+                ++it;
+        }
+    }
+    programs[filename] = map;
+    return map;
+}
+
+/* Open a program file for reading. If mapped is set and the file can be
+   mapped, the stream reads from the mapping; otherwise this is fopen(). */
+FILE *ngc_fopen(const char *filename, bool mapped)
+{
+    cookie_io_functions_t io = { stream_read, NULL, stream_seek, stream_close };
+    std::shared_ptr<ProgramMap> map;
+    ProgramStream *s;
+    FILE *fp;
+
+    if (mapped)
+        map = map_program(filename);
+    if (!map)
+        return fopen(filename, "r");
+
+    s = new ProgramStream;
+    s->map = map;
+    s->pos = 0;
+    fp = fopencookie(s, "r", io);
+    if (!fp) {
+        delete s;
+        return fopen(filename, "r");
+    }
+    s->fp = fp;
+    streams[fp] = s;
+    return fp;
+}
+
+/* Move a mapped program stream ahead to where skipping to sub 'name'
+   would next have to look at a line: the next definition of it, or a
+   line that needs the reader's attention, or the end of the file.
+   *skipped is set to the number of lines passed over. Returns false,
+   leaving fp alone, if it is not a mapped stream. */
+bool ngc_find_sub(FILE *fp, const char *name, bool fanuc_barrier, int *skipped)
+{
+    std::map<FILE *, ProgramStream *>::iterator it = streams.find(fp);
+    ProgramMap *m;
+    long pos, target;
+
+    if (it == streams.end())
+        return false;
+    m = it->second->map.get();
+    pos = ftell(fp);
+    if (pos < 0)
+        return false;
+    if (!m->indexed)
+        m->index();
+
+    target = m->size;
+    auto first_after = [pos, &target](const std::vector<long> &v) {
+        std::vector<long>::const_iterator i =
+            std::lower_bound(v.begin(), v.end(), pos);
+        if (i != v.end() && *i < target)
+            target = *i;
+    };
+    auto sub = m->subs.find(name);
+    if (sub != m->subs.end())
+        first_after(sub->second);
+    first_after(m->barriers);
+    // with Fanuc-style subs disabled, reading any bare O-word is an error
+    if (fanuc_barrier)
+        first_after(m->fanuc);
+
+    *skipped = 0;
+    if (target > pos) {
+        *skipped = m->lineOf(target) - m->lineOf(pos);
+        fseek(fp, target, SEEK_SET);
+    }
+    return true;
+}
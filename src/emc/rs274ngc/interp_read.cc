@@ -1682,7 +1682,7 @@ int Interp::read_o(    /* ARGUMENTS                                     */
     case M_98:
     case O_return:
     case M_99:
-	block->o_name = strstore(oNameBuf);
+	block->o_name = intern_name(oNameBuf);
 	logDebug("global case:|%s|", block->o_name);
 	break;
 
@@ -1704,7 +1704,7 @@ int Interp::read_o(    /* ARGUMENTS                                     */
 	  logDebug("not defining_sub:|%s|", subName);
 	}
       sprintf(fullNameBuf, "%s#%s", subName, oNameBuf);
-      block->o_name = strstore(fullNameBuf);
+      block->o_name = intern_name(fullNameBuf);
       logDebug("local case:|%s|", block->o_name);
     }
   logDebug("o_type:%s o_name: %s  line:%d %s", o_ops[block->o_type], block->o_name,
@@ -2170,7 +2170,7 @@ int Interp::read_parameter_setting(
       logDebug("setting up named param[%d]:|%s| value:%lf",
                _setup.named_parameter_occurrence, param, value);
 
-      dup = strstore(param); // no more need to free this
+      dup = intern_name(param); // no more need to free this
       if(dup == 0)
       {
           ERS(NCE_OUT_OF_MEMORY);
@@ -2657,6 +2657,9 @@ int Interp::read_real_expression(char *line,     //!< string: line of RS274/NGC
   int stack_index;
 
   CHKS((line[*counter] != '['), NCE_BUG_FUNCTION_SHOULD_NOT_HAVE_BEEN_CALLED);
+  if (_setup.expression_cache &&
+      read_cached_expression(line, counter, value, parameters))
+    return INTERP_OK;
   *counter = (*counter + 1);
   CHP(read_real_value(line, counter, values, parameters));
   CHP(read_operation(line, counter, operators));
@@ -176,6 +176,8 @@ setup::setup() :
     mdi_interrupt(0),
     feature_set(0),
     disable_fanuc_style_sub(false),
+    mmap_programs(0),
+    expression_cache(0),
     loop_on_main_m99(false),
     disable_g92_persistence(0),
     pythis(),
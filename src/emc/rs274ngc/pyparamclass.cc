@@ -23,6 +23,8 @@
 #include <boost/python/extract.hpp>
 #include <boost/python/suite/indexing/map_indexing_suite.hpp>
 #include <map>
+#include <vector>
+#include <algorithm>
 
 namespace bp = boost::python;
 extern int _task;  // zero in gcodemodule, 1 in milltask
@@ -97,10 +99,15 @@ double ParamClass::setitem(bp::object sub, double dvalue)
 
 bp::list ParamClass::namelist(context &c) const {
     bp::list result;
+    std::vector<const char *> names;
     for(parameter_map::iterator it = c.named_params.begin();
 	it != c.named_params.end(); ++it) {
-	result.append( it->first);
+	names.push_back(it->first);
     }
+    // named_params is hashed, keep handing out names in order
+    std::sort(names.begin(), names.end(), nocase_cmp());
+    for (size_t i = 0; i < names.size(); i++)
+	result.append(names[i]);
     return result;
 }
 
@@ -478,6 +478,8 @@ int read_dollar(char *line, int *counter, block_pointer block,
                   double *parameters);
  int read_real_expression(char *line, int *counter,
                                 double *hold2, double *parameters);
+ bool read_cached_expression(char *line, int *counter, double *value,
+                             double *parameters);
  int read_real_number(char *line, int *counter, double *double_ptr);
  int read_real_value(char *line, int *counter, double *double_ptr,
                            double *parameters);
@@ -1048,6 +1048,9 @@ int Interp::init()
 	  logDebug("init:  DISABLE_FANUC_STYLE_SUB = %d",
 		   _setup.disable_fanuc_style_sub);
 
+	  inifile.Find(&_setup.mmap_programs, "MMAP_PROGRAMS", "RS274NGC");
+	  inifile.Find(&_setup.expression_cache, "EXPRESSION_CACHE", "RS274NGC");
+
           // close it
           inifile.Close();
       }
@@ -1386,7 +1389,7 @@ int Interp::open(const char *filename) //!< string: the name of the input NC-pro
     }
   CHKS((_setup.file_pointer != NULL), NCE_A_FILE_IS_ALREADY_OPEN);
   CHKS((strlen(filename) > (LINELEN - 1)), NCE_FILE_NAME_TOO_LONG);
-  _setup.file_pointer = fopen(filename, "r");
+  _setup.file_pointer = ngc_fopen(filename, _setup.mmap_programs);
   CHKS((_setup.file_pointer == NULL), NCE_UNABLE_TO_OPEN_FILE, filename);
   line = _setup.linetext;
   for (index = -1; index == -1;) {      /* skip blank lines */
@@ -1687,7 +1690,8 @@ int Interp::unwind_call(int status, const char *file, int line, const char *func
 	if (sub->filename && sub->filename[0]) {
 	    if(0 != strcmp(_setup.filename, sub->filename)) {
 		fclose(_setup.file_pointer);
-		_setup.file_pointer = fopen(sub->filename, "r");
+		_setup.file_pointer = ngc_fopen(sub->filename,
+						_setup.mmap_programs);
 		logDebug("unwind_call: reopening '%s' at %ld",
 			 sub->filename, sub->position);
 		strcpy(_setup.filename, sub->filename);
@@ -2537,7 +2541,7 @@ FILE *Interp::find_ngc_file(setup_pointer settings,const char *basename, char *f
 
     // first look in the program_prefix place
     sprintf(newFileName, "%s/%s", settings->program_prefix, tmpFileName);
-    newFP = fopen(newFileName, "r");
+    newFP = ngc_fopen(newFileName, settings->mmap_programs);
 
     // then look in the subroutines place
     if (!newFP) {
@@ -2545,7 +2549,7 @@ FILE *Interp::find_ngc_file(setup_pointer settings,const char *basename, char *f
 	    if (!settings->subroutines[dct])
 		continue;
 	    sprintf(newFileName, "%s/%s", settings->subroutines[dct], tmpFileName);
-	    newFP = fopen(newFileName, "r");
+	    newFP = ngc_fopen(newFileName, settings->mmap_programs);
 	    if (newFP) {
 		// logOword("fopen: |%s|", newFileName);
 		break; // use first occurrence in dir search
@@ -2561,7 +2565,7 @@ FILE *Interp::find_ngc_file(setup_pointer settings,const char *basename, char *f
 	    // create the long name
 	    sprintf(newFileName, "%s/%s",
 		    foundPlace, tmpFileName);
-	    newFP = fopen(newFileName, "r");
+	    newFP = ngc_fopen(newFileName, settings->mmap_programs);
 	}
     }
     if (foundhere && (newFP != NULL)) 
@@ -2581,6 +2585,16 @@ const char *strstore(const char *s)
     return pair.first->c_str();
 }
 
+const char *intern_name(const char *s)
+{
+    static std::unordered_set<const char *, nocase_hash, nocase_equal> names;
+
+    auto it = names.find(s);
+    if (it != names.end())
+        return *it;
+    return *names.insert(strstore(s)).first;
+}
+
 context_struct::context_struct()
 : position(0), sequence_number(0), filename(""), subName(""),
   m98_loop_counter(-1), context_status(0), call_type(0)
@@ -2593,5 +2607,11 @@ context_struct::context_struct()
 
 void context_struct::clear()
 {
+    // hold on to the named parameter table, so a frame that is entered
+    // over and over doesn't rebuild its buckets every time
+    parameter_map params;
+    params.swap(named_params);
     new (this) context_struct();
+    named_params.swap(params);
+    named_params.clear();
 }
@@ -42,6 +42,7 @@
 #include <errno.h>
 
 StandaloneInterpInternals _sai = StandaloneInterpInternals();
+SaiMotionListener *_sai_motion_listener = nullptr;
 
 char               _parameter_file_name[PARAMETER_FILE_NAME_LENGTH];
 
@@ -235,6 +236,8 @@ void STRAIGHT_TRAVERSE( int line_number,
   _sai._program_position_a = a; /*AA*/
   _sai._program_position_b = b; /*BB*/
   _sai._program_position_c = c; /*CC*/
+  if (_sai_motion_listener)
+    _sai_motion_listener->straight_traverse(line_number);
 }
 
 /* Machining Attributes */
@@ -362,6 +365,9 @@ void ARC_FEED(int line_number,
   _sai._program_position_a = a; /*AA*/
   _sai._program_position_b = b; /*BB*/
   _sai._program_position_c = c; /*CC*/
+  if (_sai_motion_listener)
+    _sai_motion_listener->arc_feed(line_number, first_axis, second_axis,
+                                   rotation);
 }
 
 void STRAIGHT_FEED(int line_number,
@@ -387,6 +393,8 @@ void STRAIGHT_FEED(int line_number,
   _sai._program_position_a = a; /*AA*/
   _sai._program_position_b = b; /*BB*/
   _sai._program_position_c = c; /*CC*/
+  if (_sai_motion_listener)
+    _sai_motion_listener->straight_feed(line_number);
 }
 
 
@@ -448,6 +456,8 @@ void RIGID_TAP(int line_number, double x, double y, double z, double scale)
 void DWELL(double seconds)
 {
   ECHO_WITH_ARGS("%.4f", seconds);
+  if (_sai_motion_listener)
+    _sai_motion_listener->dwell(seconds);
 }
 
 /* Spindle Functions */
@@ -71,5 +71,22 @@ struct StandaloneInterpInternals
   int  _toolchanger_reason ;
 };
 
+/* Optional consumer of the motion seen by the standalone canon, e.g. to
+   drive the trajectory planner offline. Called after _sai has been updated,
+   so the end point is _sai._program_position_* (in current program units,
+   before G5x / G92 offsets). */
+class SaiMotionListener
+{
+public:
+  virtual ~SaiMotionListener() {}
+  virtual void straight_traverse(int line_number) = 0;
+  virtual void straight_feed(int line_number) = 0;
+  virtual void arc_feed(int line_number, double first_axis,
+                        double second_axis, int rotation) = 0;
+  virtual void dwell(double seconds) = 0;
+};
+
+extern SaiMotionListener *_sai_motion_listener;
+
 void reset_internals();
 #endif // SAICANON_HH
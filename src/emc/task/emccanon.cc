@@ -847,18 +847,319 @@ static VelData getStraightVelocity(CANON_POSITION pos)
             pos.w);
 }
 
+/**
+ * Velocity and acceleration bounds for a circular or spiral move from the
+ * current end point to endpt, turning full_angle about a normal along
+ * which it advances axis_len.  v_max_axes and a_max_axes are the limits
+ * of the axes spanning the plane of the arc.
+ */
+static void getArcLimits(double start_radius, double end_radius,
+        double full_angle, double axis_len,
+        double v_max_axes, double a_max_axes,
+        CANON_POSITION const &endpt, double &v_max, double &a_max)
+{
+    //Use total angle to get spiral properties
+    double spiral = end_radius - start_radius;
+    double dr = spiral / fabs(full_angle);
+    double min_radius = fmin(start_radius, end_radius);
+    double effective_radius = sqrt(dr*dr + min_radius*min_radius);
+
+    //FIXME allow tangential acceleration like in TP
+    double a_max_normal = a_max_axes * sqrt(3.0)/2.0;
+    canon_debug("a_max_axes = %f\n", a_max_axes);
+
+    // Compute the centripetal acceleration
+    double v_max_radial = sqrt(a_max_normal * effective_radius);
+    canon_debug("v_max_radial = %f\n", v_max_radial);
+
+    // Restrict our maximum velocity in-plane if need be
+    double v_max_planar = MIN(v_max_radial, v_max_axes);
+    canon_debug("v_max_planar = %f\n", v_max_planar);
+
+    // Find the equivalent maximum velocity for a linear displacement
+    // This accounts for speed restrictions due to helical and other axes
+    VelData veldata = getStraightVelocity(endpt);
+
+    // Compute spiral length, first by the minimum circular arc length
+    double circular_length = min_radius * fabs(full_angle);
+    // Then by linear approximation of the spiral arc length function of angle
+    // TODO use quadratic approximation
+    double spiral_length = hypot(circular_length, spiral);
+
+    // Compute total XYZ arc length
+    double total_xyz_length = hypot(spiral_length, axis_len);
+
+    // Next, compute the minimum time that we must take to complete the segment. 
+    // The motion computation gives us min time needed for the helical and auxiliary axes
+    double t_max_motion = veldata.tmax;
+    // Assumes worst case that velocity can be in any direction in the plane, so
+    // we assume tangential velocity is always less than the planar velocity limit.
+    // The spiral time is the min time needed to stay under the planar velocity limit.
+    double t_max_spiral = spiral_length / v_max_planar;
+
+    // Now, compute actual XYZ max velocity from this min time and the total arc length
+    double t_max = fmax(t_max_motion, t_max_spiral);
+
+    v_max = total_xyz_length / t_max;
+    canon_debug("v_max = %f\n", v_max);
+
+
+//COMPUTE ACCEL
+    
+    // Use "straight" acceleration measure to compute acceleration bounds due
+    // to non-circular components (helical axis, other axes)
+    AccelData accdata = getStraightAcceleration(endpt);
+
+    double tt_max_motion = accdata.tmax;
+    double tt_max_spiral = spiral_length / a_max_axes;
+    double tt_max = fmax(tt_max_motion, tt_max_spiral);
+
+    // a_max could be higher than a_max_axes, but the projection onto the
+    // circle plane and helical axis will still be within limits
+    a_max = total_xyz_length / tt_max;
+}
+
+/*
+  Naive CAM: in continuous mode with a G64 Q tolerance, runs of short
+  feeds are collected in chained_points and sent to motion as a single
+  line or arc that stays within the tolerance of every point.  The chain
+  starts at canon.endPoint, which does not move until the chain is
+  flushed.
+
+  The current fit is kept in chain_fit and each new point is checked
+  against it in constant time.  Only when a point does not fit is the
+  whole chain refit, as a 9-axis line to the new point or as the arc
+  through the start, the middle point and the new point, and only if the
+  chain has grown by a quarter since the last attempt, so the work per
+  chain stays linear in its length.
+
+  Points are held to half the tolerance of the fit, which leaves the
+  other half for the move actually sent, as that ends on the last point
+  rather than on the fit.  On an arc the distance along the normal and
+  the ABCUVW coordinates must be linear in the angle turned, as motion
+  interpolates them that way, and each chord of the polyline must also
+  stay within half the tolerance of the arc so that a corner between two
+  long lines never becomes a round.  Rotary coordinates are compared in
+  degrees against the same tolerance.
+*/
 #include <vector>
 struct pt { double x, y, z, a, b, c, u, v, w; int line_no;};
 
 static std::vector<struct pt> chained_points;
 
+enum { FIT_LINE, FIT_ARC };
+
+static struct chain_fit {
+    int type;
+    size_t refit_size;		// chain size at the last refit attempt
+    // line: unit direction in 9 axes and distance of the last point
+    double dir[9];
+    double t_last;
+    // arc: start is at angle 0 on e1, travel is counterclockwise about
+    // normal; z, a, b, c, u, v, w are lin0 + angle * rate
+    PM_CARTESIAN center, e1, e2, normal;
+    double radius, theta_last;
+    double lin0[7], rate[7];
+} fit;
+
+static void pt_coords(const struct pt &p, double q[9]) {
+    q[0] = p.x; q[1] = p.y; q[2] = p.z;
+    q[3] = p.a; q[4] = p.b; q[5] = p.c;
+    q[6] = p.u; q[7] = p.v; q[8] = p.w;
+}
+
+static void start_coords(double s[9]) {
+    s[0] = canon.endPoint.x; s[1] = canon.endPoint.y; s[2] = canon.endPoint.z;
+    s[3] = canon.endPoint.a; s[4] = canon.endPoint.b; s[5] = canon.endPoint.c;
+    s[6] = canon.endPoint.u; s[7] = canon.endPoint.v; s[8] = canon.endPoint.w;
+}
+
+// Fit a line from the chain start through q, with q the only point
+static void fit_line(const struct pt &p) {
+    double s[9], q[9], len = 0;
+    start_coords(s);
+    pt_coords(p, q);
+    for(int i = 0; i < 9; i++) {
+        fit.dir[i] = q[i] - s[i];
+        len += fit.dir[i] * fit.dir[i];
+    }
+    len = sqrt(len);
+    for(int i = 0; i < 9; i++) {
+        fit.dir[i] = len > 0 ? fit.dir[i] / len : 0;
+    }
+    fit.type = FIT_LINE;
+    fit.t_last = len;
+}
+
+static bool fits_line(const struct pt &p, double tol) {
+    double s[9], q[9], t = 0, d2 = 0;
+    start_coords(s);
+    pt_coords(p, q);
+    for(int i = 0; i < 9; i++) {
+        double d = q[i] - s[i];
+        t += d * fit.dir[i];
+        d2 += d * d;
+    }
+    if(t < fit.t_last || d2 - t * t > tol * tol) return false;
+    fit.t_last = t;
+    return true;
+}
+
+// Fit the circle through the chain start, m and q, traversed in that order
+static bool fit_arc(const struct pt &m, const struct pt &p) {
+    PM_CARTESIAN s = canon.endPoint.xyz();
+    PM_CARTESIAN a = PM_CARTESIAN(m.x, m.y, m.z) - s;
+    PM_CARTESIAN b = PM_CARTESIAN(p.x, p.y, p.z) - s;
+    PM_CARTESIAN n = cross(a, b);
+    double n2 = dot(n, n);
+    // nearly colinear points make a huge, meaningless circle
+    if(n2 <= 1e-12 * dot(a, a) * dot(b, b)) return false;
+
+    fit.type = FIT_ARC;
+    fit.center = s + cross(dot(a, a) * b - dot(b, b) * a, n) / (2 * n2);
+    fit.normal = unit(n);
+    fit.e1 = s - fit.center;
+    fit.radius = mag(fit.e1);
+    fit.e1 = fit.e1 / fit.radius;
+    fit.e2 = cross(fit.normal, fit.e1);
+    fit.theta_last = 0;
+
+    double q[9];
+    pt_coords(p, q);
+    PM_CARTESIAN r = PM_CARTESIAN(p.x, p.y, p.z) - fit.center;
+    double theta = atan2(dot(r, fit.e2), dot(r, fit.e1));
+    if(theta <= 0) theta += 2 * M_PI;
+    fit.lin0[0] = 0;
+    fit.rate[0] = dot(r, fit.normal) / theta;
+    double s9[9];
+    start_coords(s9);
+    for(int i = 1; i < 7; i++) {
+        fit.lin0[i] = s9[i + 2];
+        fit.rate[i] = (q[i + 2] - s9[i + 2]) / theta;
+    }
+    return true;
+}
+
+static bool fits_arc(const struct pt &p, double tol) {
+    PM_CARTESIAN r = PM_CARTESIAN(p.x, p.y, p.z) - fit.center;
+    double x = dot(r, fit.e1), y = dot(r, fit.e2);
+    if(fabs(hypot(x, y) - fit.radius) > tol) return false;
+
+    // the turn from the last point, which must go forward, and not so far
+    // that the chord between the two points strays from the arc
+    double step = remainder(atan2(y, x) - fit.theta_last, 2 * M_PI);
+    if(step < 0 && step > -1e-9) step = 0;
+    if(step < 0) return false;
+    if(fit.radius * (1 - cos(step / 2)) > tol) return false;
+    double theta = fit.theta_last + step;
+    if(theta > 2 * M_PI - 1e-3) return false;
+
+    double q[9];
+    pt_coords(p, q);
+    q[2] = dot(r, fit.normal);
+    for(int i = 0; i < 7; i++) {
+        if(fabs(q[i + 2] - (fit.lin0[i] + theta * fit.rate[i])) > tol)
+            return false;
+    }
+    fit.theta_last = theta;
+    return true;
+}
+
+static bool fits(const struct pt &p, double tol) {
+    return fit.type == FIT_ARC ? fits_arc(p, tol) : fits_line(p, tol);
+}
+
+// Try a line, then an arc, through the chain and p
+static bool refit(const struct pt &p, double tol) {
+    size_t n = chained_points.size();
+    chain_fit saved = fit;
+    fit.refit_size = n + 1;
+    saved.refit_size = n + 1;
+
+    fit_line(p);
+    fit.t_last = 0;
+    bool ok = true;
+    for(size_t i = 0; ok && i < n; i++) {
+        ok = fits_line(chained_points[i], tol);
+    }
+    if(ok && fits_line(p, tol)) return true;
+
+    if(fit_arc(chained_points[n / 2], p)) {
+        ok = true;
+        for(size_t i = 0; ok && i < n; i++) {
+            ok = fits_arc(chained_points[i], tol);
+        }
+        if(ok && fits_arc(p, tol)) return true;
+    }
+
+    fit = saved;
+    return false;
+}
+
 static void drop_segments(void) {
     chained_points.clear();
 }
 
+static void flush_arc(void) {
+    struct pt &pos = chained_points.back();
+    CANON_POSITION endpt(pos.x, pos.y, pos.z,
+                         pos.a, pos.b, pos.c, pos.u, pos.v, pos.w);
+
+    PM_CARTESIAN r = endpt.xyz() - fit.center;
+    double axis_len = dot(r, fit.normal);
+    double end_radius = mag(r - axis_len * fit.normal);
+
+    // the arc may lie in any plane, so hold it to the slowest of XYZ
+    double v_max_axes = 0, a_max_axes = 0;
+    bool have_axis = false;
+    for(int i = 0; i < 3; i++) {
+        if(!axis_valid(i)) continue;
+        double vi = FROM_EXT_LEN(emcAxisGetMaxVelocity(i));
+        double ai = FROM_EXT_LEN(emcAxisGetMaxAcceleration(i));
+        v_max_axes = have_axis ? MIN(vi, v_max_axes) : vi;
+        a_max_axes = have_axis ? MIN(ai, a_max_axes) : ai;
+        have_axis = true;
+    }
+
+    double v_max, a_max;
+    getArcLimits(fit.radius, end_radius, fit.theta_last, axis_len,
+                 v_max_axes, a_max_axes, endpt, v_max, a_max);
+    double vel = MIN(canon.linearFeedRate, v_max);
+
+    EMC_TRAJ_CIRCULAR_MOVE circularMoveMsg;
+    circularMoveMsg.feed_mode = canon.feed_mode;
+    circularMoveMsg.end = to_ext_pose(endpt);
+    circularMoveMsg.center = to_ext_len(fit.center);
+    circularMoveMsg.normal = to_ext_len(fit.normal);
+    circularMoveMsg.turn = 0;
+    circularMoveMsg.type = EMC_MOTION_TYPE_FEED;
+    circularMoveMsg.vel = toExtVel(vel);
+    circularMoveMsg.ini_maxvel = toExtVel(v_max);
+    circularMoveMsg.acc = toExtAcc(a_max);
+
+    canon.cartesian_move = 1;
+    if((vel && a_max) || canon.spindle[canon.spindle_num].synched) {
+        interp_list.set_line_number(pos.line_no);
+        interp_list.append(circularMoveMsg);
+    }
+    canonUpdateEndPoint(endpt);
+
+    drop_segments();
+}
+
 static void flush_segments(void) {
     if(chained_points.empty()) return;
 
+#ifdef SHOW_JOINED_SEGMENTS
+    for(unsigned int i=0; i != chained_points.size(); i++) { printf("."); }
+    printf(fit.type == FIT_ARC ? ")\n" : "\n");
+#endif
+
+    if(fit.type == FIT_ARC) {
+        flush_arc();
+        return;
+    }
+
     struct pt &pos = chained_points.back();
 
     double x = pos.x, y = pos.y, z = pos.z;
@@ -867,11 +1168,6 @@ static void flush_segments(void) {
     
     int line_no = pos.line_no;
 
-#ifdef SHOW_JOINED_SEGMENTS
-    for(unsigned int i=0; i != chained_points.size(); i++) { printf("."); }
-    printf("\n");
-#endif
-
     VelData linedata = getStraightVelocity(x, y, z, a, b, c, u, v, w);
     double vel = linedata.vel;
 
@@ -938,39 +1234,17 @@ static void get_last_pos(double &lx, double &ly, double &lz) {
 }
 
 static bool
-linkable(double x, double y, double z, 
-         double a, double b, double c, 
-         double u, double v, double w) {
-    struct pt &pos = chained_points.back();
+linkable(const struct pt &p) {
     if(canon.motionMode != CANON_CONTINUOUS || canon.naivecamTolerance == 0)
         return false;
-    //FIXME make this length controlled elsewhere?
-    if(chained_points.size() > 100) return false;
-
-    //If ABCUVW motion, then the tangent calculation fails?
-    // TODO is there a fundamental reason that we can't handle 9D motion here?
-    if(a != pos.a) return false;
-    if(b != pos.b) return false;
-    if(c != pos.c) return false;
-    if(u != pos.u) return false;
-    if(v != pos.v) return false;
-    if(w != pos.w) return false;
-
-    if(x==canon.endPoint.x && y==canon.endPoint.y && z==canon.endPoint.z) return false;
-    
-    for(std::vector<struct pt>::iterator it = chained_points.begin();
-            it != chained_points.end(); it++) {
-        PM_CARTESIAN M(x-canon.endPoint.x, y-canon.endPoint.y, z-canon.endPoint.z),
-                     B(canon.endPoint.x, canon.endPoint.y, canon.endPoint.z),
-                     P(it->x, it->y, it->z);
-        double t0 = dot(M, P-B) / dot(M, M);
-        if(t0 < 0) t0 = 0;
-        if(t0 > 1) t0 = 1;
-
-        double D = mag(P - (B + t0 * M));
-        if(D > canon.naivecamTolerance) return false;
-    }
-    return true;
+
+    double tol = canon.naivecamTolerance / 2;
+    if(fits(p, tol)) return true;
+
+    size_t n = chained_points.size();
+    if(n < 8 || 4 * n >= 5 * fit.refit_size)
+        return refit(p, tol);
+    return false;
 }
 
 static void
@@ -978,22 +1252,15 @@ see_segment(int line_number,
 	    double x, double y, double z, 
             double a, double b, double c,
             double u, double v, double w) {
-    bool changed_abc = (a != canon.endPoint.a)
-        || (b != canon.endPoint.b)
-        || (c != canon.endPoint.c);
-
-    bool changed_uvw = (u != canon.endPoint.u)
-        || (v != canon.endPoint.v)
-        || (w != canon.endPoint.w);
-
-    if(!chained_points.empty() && !linkable(x, y, z, a, b, c, u, v, w)) {
-        flush_segments();
-    }
     pt pos = {x, y, z, a, b, c, u, v, w, line_number};
-    chained_points.push_back(pos);
-    if(changed_abc || changed_uvw) {
+    if(!chained_points.empty() && !linkable(pos)) {
         flush_segments();
     }
+    if(chained_points.empty()) {
+        fit_line(pos);
+        fit.refit_size = 1;
+    }
+    chained_points.push_back(pos);
 }
 
 void FINISH() {
@@ -1667,12 +1934,6 @@ void ARC_FEED(int line_number,
 
 	canon_debug("full_angle = %.17e\n", full_angle);
 
-    //Use total angle to get spiral properties
-    double spiral = end_radius - start_radius;
-    double dr = spiral / fabs(full_angle);
-    double min_radius = fmin(start_radius, end_radius);
-    double effective_radius = sqrt(dr*dr + min_radius*min_radius);
-
     // KLUDGE: assumes 0,1,2 for X Y Z
     // Find normal axis
     int norm_axis_ind = (2 - shift_ind) % 3;
@@ -1705,60 +1966,12 @@ void ARC_FEED(int line_number,
         }
     }
 
-    //FIXME allow tangential acceleration like in TP
-    double a_max_normal = a_max_axes * sqrt(3.0)/2.0;
-    canon_debug("a_max_axes = %f\n", a_max_axes);
-
-    // Compute the centripetal acceleration
-    double v_max_radial = sqrt(a_max_normal * effective_radius);
-    canon_debug("v_max_radial = %f\n", v_max_radial);
-
-    // Restrict our maximum velocity in-plane if need be
-    double v_max_planar = MIN(v_max_radial, v_max_axes);
-    canon_debug("v_max_planar = %f\n", v_max_planar);
-
-    // Find the equivalent maximum velocity for a linear displacement
-    // This accounts for speed restrictions due to helical and other axes
-    VelData veldata = getStraightVelocity(endpt);
-
-    // Compute spiral length, first by the minimum circular arc length
-    double circular_length = min_radius * fabs(full_angle);
-    // Then by linear approximation of the spiral arc length function of angle
-    // TODO use quadratic approximation
-    double spiral_length = hypot(circular_length, spiral);
-
-    // Compute length along normal axis and total XYZ arc length
+    // Compute length along normal axis
     double axis_len = dot(end_cart - canon.endPoint.xyz(), normal_cart);
-    double total_xyz_length = hypot(spiral_length, axis_len);
 
-    // Next, compute the minimum time that we must take to complete the segment. 
-    // The motion computation gives us min time needed for the helical and auxiliary axes
-    double t_max_motion = veldata.tmax;
-    // Assumes worst case that velocity can be in any direction in the plane, so
-    // we assume tangential velocity is always less than the planar velocity limit.
-    // The spiral time is the min time needed to stay under the planar velocity limit.
-    double t_max_spiral = spiral_length / v_max_planar;
-
-    // Now, compute actual XYZ max velocity from this min time and the total arc length
-    double t_max = fmax(t_max_motion, t_max_spiral);
-
-    double v_max = total_xyz_length / t_max;
-    canon_debug("v_max = %f\n", v_max);
-
-
-//COMPUTE ACCEL
-    
-    // Use "straight" acceleration measure to compute acceleration bounds due
-    // to non-circular components (helical axis, other axes)
-    AccelData accdata = getStraightAcceleration(endpt);
-
-    double tt_max_motion = accdata.tmax;
-    double tt_max_spiral = spiral_length / a_max_axes;
-    double tt_max = fmax(tt_max_motion, tt_max_spiral);
-
-    // a_max could be higher than a_max_axes, but the projection onto the
-    // circle plane and helical axis will still be within limits
-    double a_max = total_xyz_length / tt_max;
+    double v_max, a_max;
+    getArcLimits(start_radius, end_radius, full_angle, axis_len,
+                 v_max_axes, a_max_axes, endpt, v_max, a_max);
 
     // Limit velocity by maximum
     double vel = MIN(canon.linearFeedRate, v_max);
@@ -440,6 +440,7 @@ static NML_INTERP_LIST mdi_execute_queue;
 // MDI input queue
 static NML_INTERP_LIST mdi_input_queue;
 #define  MAX_MDI_QUEUE 10
+#define INTERP_LIST_SLACK 64
 static int max_mdi_queued_commands = MAX_MDI_QUEUE;
 
 /*
@@ -2849,6 +2850,102 @@ static int emcTaskExecute(void)
     return retval;
 }
 
+// seconds between status writes when only the heartbeats change
+#define STATUS_KEEPALIVE 1.0
+
+static bool changed(const void *a, const void *b, const void *end)
+{
+    return memcmp(a, b, (const char *) end - (const char *) a) != 0;
+}
+
+/* Bump the generation counters of the sections of the status that
+   differ from what was last written, so that readers can skip copying
+   the rest.  Returns true if anything but the heartbeats changed.  The
+   counters start from the time task came up, so that a reader that
+   outlives a restart doesn't take new sections for ones it has. */
+static bool emcStatusGenerations(EMC_STAT *stat)
+{
+    static EMC_STAT *last = 0;
+    bool any = false;
+    int j;
+
+    if (!last) {
+	uint32_t seed = (uint32_t) (etime() * 1000.0);
+
+	stat->generation = stat->task_generation = seed;
+	stat->motion_generation = stat->io_generation = seed;
+	stat->tool_table_generation = seed;
+	for (j = 0; j < EMCMOT_MAX_JOINTS; j++)
+	    stat->joint_generation[j] = seed;
+	last = new EMC_STAT;
+	memcpy((void *) last, (void *) stat, sizeof(EMC_STAT));
+	return true;
+    }
+
+    // heartbeats change every cycle and would make every section new
+    last->task.heartbeat = stat->task.heartbeat;
+    last->motion.heartbeat = stat->motion.heartbeat;
+    last->io.heartbeat = stat->io.heartbeat;
+
+    if (changed(&stat->task, &last->task, &stat->task + 1)) {
+	stat->task_generation++;
+	memcpy((void *) &last->task, (void *) &stat->task, sizeof(stat->task));
+	any = true;
+    }
+    if (changed(&stat->motion, &last->motion, &stat->motion.joint[0]) ||
+	changed(&stat->motion.joint[EMCMOT_MAX_JOINTS],
+		&last->motion.joint[EMCMOT_MAX_JOINTS], &stat->motion + 1)) {
+	stat->motion_generation++;
+	memcpy((void *) &last->motion, (void *) &stat->motion,
+	       (char *) &stat->motion.joint[0] - (char *) &stat->motion);
+	memcpy((void *) &last->motion.joint[EMCMOT_MAX_JOINTS],
+	       (void *) &stat->motion.joint[EMCMOT_MAX_JOINTS],
+	       (char *) (&stat->motion + 1) -
+	       (char *) &stat->motion.joint[EMCMOT_MAX_JOINTS]);
+	any = true;
+    }
+    for (j = 0; j < EMCMOT_MAX_JOINTS; j++) {
+	if (changed(&stat->motion.joint[j], &last->motion.joint[j],
+		    &stat->motion.joint[j + 1])) {
+	    stat->joint_generation[j]++;
+	    memcpy((void *) &last->motion.joint[j],
+		   (void *) &stat->motion.joint[j], sizeof(EMC_JOINT_STAT));
+	    any = true;
+	}
+    }
+    if (changed(&stat->io, &last->io, &stat->io.tool.toolTable[0]) ||
+	changed(&stat->io.tool.toolTable[CANON_POCKETS_MAX],
+		&last->io.tool.toolTable[CANON_POCKETS_MAX], &stat->io + 1)) {
+	stat->io_generation++;
+	memcpy((void *) &last->io, (void *) &stat->io,
+	       (char *) &stat->io.tool.toolTable[0] - (char *) &stat->io);
+	memcpy((void *) &last->io.tool.toolTable[CANON_POCKETS_MAX],
+	       (void *) &stat->io.tool.toolTable[CANON_POCKETS_MAX],
+	       (char *) (&stat->io + 1) -
+	       (char *) &stat->io.tool.toolTable[CANON_POCKETS_MAX]);
+	any = true;
+    }
+    if (changed(&stat->io.tool.toolTable[0], &last->io.tool.toolTable[0],
+		&stat->io.tool.toolTable[CANON_POCKETS_MAX])) {
+	stat->tool_table_generation++;
+	memcpy((void *) last->io.tool.toolTable,
+	       (void *) stat->io.tool.toolTable,
+	       sizeof(stat->io.tool.toolTable));
+	any = true;
+    }
+    // the EMC_STAT_MSG header and debug
+    if (changed(stat, last, &stat->task) || stat->debug != last->debug) {
+	memcpy((void *) last, (void *) stat,
+	       (char *) &stat->task - (char *) stat);
+	last->debug = stat->debug;
+	any = true;
+    }
+
+    if (any)
+	stat->generation++;
+    return any;
+}
+
 // called to allocate and init resources
 static int emctask_startup()
 {
@@ -3265,6 +3362,7 @@ int main(int argc, char *argv[])
     int num_latency_warnings = 0;
     int latency_excursion_factor = 10;  // if latency is worse than (factor * expected), it's an excursion
     double minTime, maxTime;
+    double lastStatusWrite = 0.0;
 
     bindtextdomain("linuxcnc", EMC2_PO_DIR);
     setlocale(LC_MESSAGES,"");
@@ -3307,6 +3405,9 @@ int main(int argc, char *argv[])
 	emctask_shutdown();
 	exit(1);
     }
+    // readahead stops once the list is past emc_task_interp_max_len, but
+    // the last line read can queue a few more; the list grows if needed
+    interp_list.reserve(emc_task_interp_max_len + INTERP_LIST_SLACK);
 
     // get our status data structure
     // moved up from emc_startup so we can expose it in Python right away
@@ -3536,7 +3637,13 @@ int main(int argc, char *argv[])
 	// since emcStatus was passed to the WM init functions, it
 	// will be updated in the _update() functions above. There's
 	// no need to call the individual functions on all WM items.
-	emcStatusBuffer->write(emcStatus);
+	// Readers peeking an unchanged buffer copy nothing, so skip the
+	// write while only the heartbeats move.
+	if (emcStatusGenerations(emcStatus) ||
+	    etime() - lastStatusWrite >= STATUS_KEEPALIVE) {
+	    emcStatusBuffer->write(emcStatus);
+	    lastStatusWrite = etime();
+	}
 
 	// wait on timer cycle, if specified, or calculate actual
 	// interval if ini file says to run full out via
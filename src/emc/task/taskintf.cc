@@ -863,6 +863,11 @@ int emcJointLoadComp(int joint, const char *file, int type)
     return usrmotLoadComp(joint, file, type);
 }
 
+int emcJointLoadCompGrid(int joint, const char *file)
+{
+    return usrmotLoadCompGrid(joint, file);
+}
+
 static emcmot_config_t emcmotConfig;
 int get_emcmot_debug_info = 0;
 
@@ -1532,7 +1537,8 @@ int emcTrajUpdate(EMC_TRAJ_STAT * stat)
     }
 
     stat->inpos = emcmotStatus.motionFlag & EMCMOT_MOTION_INPOS_BIT;
-    stat->queue = emcmotStatus.depth;
+    // moves task has queued that motion hasn't taken yet count too
+    stat->queue = emcmotStatus.depth + usrmotPendingCommands(&emcmotStatus);
     stat->activeQueue = emcmotStatus.activeDepth;
     stat->queueFull = emcmotStatus.queueFull;
     stat->id = emcmotStatus.id;
@@ -2023,6 +2029,13 @@ int emcSetupArcBlends(int arcBlendEnable,
     return usrmotWriteEmcmotCommand(&emcmotCommand);
 }
 
+int emcSetPlannerType(int plannerType, double maxJerk) {
+    emcmotCommand.command = EMCMOT_SET_PLANNER_TYPE;
+    emcmotCommand.plannerType = plannerType;
+    emcmotCommand.maxJerk = maxJerk;
+    return usrmotWriteEmcmotCommand(&emcmotCommand);
+}
+
 int emcSetMaxFeedOverride(double maxFeedScale) {
     emcmotCommand.command = EMCMOT_SET_MAX_FEED_OVERRIDE;
     emcmotCommand.maxFeedScale = maxFeedScale;
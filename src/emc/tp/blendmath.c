@@ -1858,3 +1858,208 @@ double pmCircleEffectiveMinRadius(PmCircle const * circle)
     return effective_radius;
 }
 
+
+/** @section scurve Jerk-limited (S-curve) profile math */
+
+/**
+ * Advance a constant-jerk phase of a motion profile.
+ * Updates the velocity and acceleration in place after time t at jerk j, and
+ * returns the distance covered during the phase.
+ */
+static double jerkPhaseAdvance(double * const v, double * const a,
+        double j, double t)
+{
+    double dist = *v * t + *a * pmSq(t) / 2.0 + j * pmSq(t) * t / 6.0;
+    *v += *a * t + j * pmSq(t) / 2.0;
+    *a += j * t;
+    return dist;
+}
+
+/**
+ * Find the shortest distance needed to slow to velocity v_final and
+ * acceleration a_final, starting at velocity v_0 and acceleration a_0.
+ * The profile ramps the acceleration down at the jerk limit (possibly holding
+ * at -a_max), then back up to a_final as it arrives at v_final. The final
+ * acceleration should be zero or negative (i.e. still braking). Returns zero
+ * if we can settle below v_final without braking at all. If j_max is not
+ * positive, this reduces to the usual constant-acceleration stopping
+ * distance.
+ */
+double findSCurveStopDistance(double v_0, double a_0, double v_final,
+        double a_final, double a_max, double j_max)
+{
+    if (j_max <= 0.0) {
+        if (v_0 <= v_final) {
+            return 0.0;
+        }
+        return (pmSq(v_0) - pmSq(v_final)) / (2.0 * a_max);
+    }
+
+    double v = v_0;
+    double a = bisaturate(a_0, a_max, -a_max);
+    double a_f = bisaturate(a_final, 0.0, -a_max);
+
+    // If releasing the acceleration now settles at or below the final
+    // velocity, we never catch up with the braking curve.
+    double a_pos = fmax(a, 0.0);
+    if (v + pmSq(a_pos) / (2.0 * j_max) <= v_final) {
+        return 0.0;
+    }
+
+    // Peak deceleration needed with no constant acceleration phase
+    double a_peak_sq = (v - v_final) * j_max + (pmSq(a) + pmSq(a_f)) / 2.0;
+    double a_min = fmin(a, a_f);
+    if (a_peak_sq < pmSq(a_min)) {
+        // Ramping straight to the final acceleration already slows us down
+        // enough, so that is all we can (or need to) do.
+        if (a_f > a) {
+            // Braking harder than we need to, so we're done as soon as we
+            // drop to the final velocity
+            double disc = fmax(pmSq(a) - 2.0 * j_max * (v - v_final), 0.0);
+            double t_cross = (-a - pmSqrt(disc)) / j_max;
+            return jerkPhaseAdvance(&v, &a, j_max, fmax(t_cross, 0.0));
+        }
+        return jerkPhaseAdvance(&v, &a, -j_max, (a - a_f) / j_max);
+    }
+
+    double a_peak = -pmSqrt(a_peak_sq);
+    double t_hold = 0.0;
+    if (a_peak < -a_max) {
+        a_peak = -a_max;
+        t_hold = (v - v_final + (pmSq(a) + pmSq(a_f)) / (2.0 * j_max)
+                - pmSq(a_max) / j_max) / a_max;
+    }
+
+    double dist = jerkPhaseAdvance(&v, &a, -j_max, (a - a_peak) / j_max);
+    dist += jerkPhaseAdvance(&v, &a, 0.0, t_hold);
+    dist += jerkPhaseAdvance(&v, &a, j_max, (a_f - a_peak) / j_max);
+    return dist;
+}
+
+/**
+ * Find the highest cruise velocity that can come to a complete stop within a
+ * distance, starting with zero acceleration.
+ * This is the jerk-limited counterpart of findVPeak (which gives the peak
+ * velocity of a triangle over twice the distance).
+ */
+double findSCurveStopVel(double distance, double a_max, double j_max)
+{
+    if (j_max <= 0.0) {
+        return pmSqrt(2.0 * a_max * distance);
+    }
+    if (distance <= 0.0) {
+        return 0.0;
+    }
+
+    // Without reaching a_max, the stop takes 2 * sqrt(v / j) at an average
+    // velocity of v / 2
+    double v = cbrt(pmSq(distance) * j_max);
+    if (v * j_max <= pmSq(a_max)) {
+        return v;
+    }
+
+    // Otherwise, there's a constant deceleration phase, and
+    // v^2 / a_max + v * a_max / j_max = 2 * distance
+    double t_ramp = a_max / j_max;
+    return a_max / 2.0 * (pmSqrt(pmSq(t_ramp) + 8.0 * distance / a_max) - t_ramp);
+}
+
+/**
+ * Find how long a constant-jerk phase takes to cover a distance.
+ * The distance must be reachable within t_max. Velocity is positive and
+ * the acceleration stays non-negative over the phase, so the distance is
+ * convex and increasing in time, and Newton's method started from t_max
+ * converges from above.
+ */
+static double jerkPhaseTime(double v, double a, double j, double t_max,
+        double distance)
+{
+    double t = t_max;
+    int i;
+    for (i = 0; i < TP_SCURVE_NEWTON_ITERATIONS; ++i) {
+        double f = v * t + a * pmSq(t) / 2.0 + j * pmSq(t) * t / 6.0 - distance;
+        double df = v + a * t + j * pmSq(t) / 2.0;
+        if (df <= 0.0) {
+            break;
+        }
+        double step = f / df;
+        t -= step;
+        if (fabs(step) < TP_TIME_EPSILON) {
+            break;
+        }
+    }
+    return bisaturate(t, t_max, 0.0);
+}
+
+/**
+ * Find the highest velocity a distance before a braking state (v_final,
+ * a_final), along a jerk-limited braking curve that starts from cruise at
+ * v_max.
+ * Running time backwards from the final state, the deceleration ramps up at
+ * the jerk limit until it reaches a_max, holds, then ramps back down so that
+ * it reaches zero just as the velocity reaches v_max. Since the curve is
+ * built this way, the start state it returns (through a_start) can be fed
+ * back in to extend the curve over the previous segment, and a start
+ * velocity at v_max always comes with zero acceleration. If j_max is not
+ * positive, this is the usual sqrt(v_final^2 + 2 * a_max * distance).
+ */
+double findSCurveMaxStartVel(double v_final, double a_final, double distance,
+        double a_max, double j_max, double v_max, double * const a_start)
+{
+    if (j_max <= 0.0) {
+        *a_start = -a_max;
+        return pmSqrt(pmSq(v_final) + 2.0 * a_max * distance);
+    }
+
+    // Work in reverse time, where g is the deceleration (positive)
+    double v = v_final;
+    double g = bisaturate(-a_final, a_max, 0.0);
+    double d = fmax(distance, 0.0);
+
+    // Ramp up until we hit a_max, or have to start ramping down for v_max
+    double t_up = (a_max - g) / j_max;
+    double v_margin = v_max - v - pmSq(g) / (2.0 * j_max);
+    double t_release = 0.0;
+    if (v_margin > 0.0) {
+        t_release = (pmSqrt(pmSq(g) + j_max * v_margin) - g) / j_max;
+    }
+    t_up = fmin(t_up, t_release);
+    double v_up = v;
+    double g_up = g;
+    double d_up = jerkPhaseAdvance(&v_up, &g_up, j_max, t_up);
+    if (d <= d_up) {
+        double t = jerkPhaseTime(v, g, j_max, t_up, d);
+        jerkPhaseAdvance(&v, &g, j_max, t);
+        *a_start = -g;
+        return v;
+    }
+    d -= d_up;
+    v = v_up;
+    g = g_up;
+
+    // Hold at a_max until it's time to release
+    double t_hold = fmax(v_max - v - pmSq(g) / (2.0 * j_max), 0.0) / fmax(g, TP_ACCEL_EPSILON);
+    double d_hold = v * t_hold + g * pmSq(t_hold) / 2.0;
+    if (d <= d_hold) {
+        *a_start = -g;
+        return pmSqrt(pmSq(v) + 2.0 * g * d);
+    }
+    d -= d_hold;
+    jerkPhaseAdvance(&v, &g, 0.0, t_hold);
+
+    // Release the deceleration, arriving at v_max with zero acceleration
+    double t_down = g / j_max;
+    double v_down = v;
+    double g_down = g;
+    double d_down = jerkPhaseAdvance(&v_down, &g_down, -j_max, t_down);
+    if (d <= d_down) {
+        double t = jerkPhaseTime(v, g, -j_max, t_down, d);
+        jerkPhaseAdvance(&v, &g, -j_max, t);
+        *a_start = -g;
+        return v;
+    }
+
+    // Cruising at v_max from here on back
+    *a_start = 0.0;
+    return v_down;
+}
@@ -263,4 +263,12 @@ static inline double findVPeak(double a_t_max, double distance)
 {
     return pmSqrt(a_t_max * distance);
 }
+
+double findSCurveStopDistance(double v_0, double a_0, double v_final,
+        double a_final, double a_max, double j_max);
+
+double findSCurveStopVel(double distance, double a_max, double j_max);
+
+double findSCurveMaxStartVel(double v_final, double a_final, double distance,
+        double a_max, double j_max, double v_max, double * const a_start);
 #endif
@@ -127,6 +127,7 @@ typedef struct {
     double maxvel;          // max possible vel (feed override stops here)
     double currentvel;      // keep track of current step (vel * cycle_time)
     double finalvel;        // velocity to aim for at end of segment
+    double finalacc;        // acceleration at end of segment (S-curve braking)
     double term_vel;        // actual velocity at termination of segment
     double kink_vel;        // Temporary way to store our calculation of maximum velocity we can handle if this segment is declared tangent with the next
     double kink_accel_reduce_prev; // How much to reduce the allowed tangential acceleration to account for the extra acceleration at an approximate tangent intersection.
@@ -134,6 +135,7 @@ typedef struct {
 
     //Acceleration
     double maxaccel;        // accel calc'd by task
+    double currentacc;      // acceleration used in the last cycle
     double acc_ratio_tan;// ratio between normal and tangential accel
     
     int id;                 // segment's serial number
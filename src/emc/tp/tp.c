@@ -130,6 +130,19 @@ STATIC double tpGetTangentKinkRatio(void) {
 }
 
 
+/**
+ * Get the tangential jerk limit for S-curve velocity profiles.
+ * Returns 0 if the planner is using trapezoidal (acceleration limited only)
+ * profiles.
+ */
+STATIC double tpGetMaxJerk(void) {
+    if (emcmotConfig->plannerType != TP_PLANNER_SCURVE) {
+        return 0.0;
+    }
+    return fmax(emcmotConfig->maxJerk, 0.0);
+}
+
+
 STATIC int tpGetMachineAccelBounds(PmCartesian  * const acc_bound) {
     if (!acc_bound) {
         return TP_ERR_FAIL;
@@ -293,6 +306,22 @@ STATIC inline double tpGetRealFinalVel(TP_STRUCT const * const tp,
 }
 
 
+/**
+ * Get the acceleration to aim for at the end of a segment.
+ * This is only non-zero (braking) if the final velocity is set by the
+ * optimizer's jerk-limited braking curve, rather than a target velocity or a
+ * stop.
+ */
+STATIC inline double tpGetRealFinalAccel(TP_STRUCT const * const tp,
+        TC_STRUCT const * const tc, TC_STRUCT const * const nexttc) {
+    double v_final = tpGetRealFinalVel(tp, tc, nexttc);
+    if (v_final < tc->finalvel) {
+        return 0.0;
+    }
+    return tc->finalacc;
+}
+
+
 /**
  * Convert the 2-part spindle position and sign to a signed double.
  */
@@ -669,7 +698,7 @@ STATIC double tpCalculateTriangleVel(TC_STRUCT const *tc) {
 STATIC double tpCalculateOptimizationInitialVel(TP_STRUCT const * const tp, TC_STRUCT * const tc)
 {
     double acc_scaled = tcGetTangentialMaxAccel(tc);
-    double triangle_vel = findVPeak(acc_scaled, tc->target);
+    double triangle_vel = findSCurveStopVel(tc->target / 2.0, acc_scaled, tpGetMaxJerk());
     double max_vel = tpGetMaxTargetVel(tp, tc);
     tp_debug_json_start(tpCalculateOptimizationInitialVel);
     tp_debug_json_double(triangle_vel);
@@ -1554,10 +1583,7 @@ STATIC int tpComputeOptimalVelocity(TP_STRUCT const * const tp, TC_STRUCT * cons
     //trajectory parameters
     double acc_this = tcGetTangentialMaxAccel(tc);
 
-    // Find the reachable velocity of tc, moving backwards in time
-    double vs_back = pmSqrt(pmSq(tc->finalvel) + 2.0 * acc_this * tc->target);
     // Find the reachable velocity of prev1_tc, moving forwards in time
-
     double vf_limit_this = tc->maxvel;
     double vf_limit_prev = prev1_tc->maxvel;
     if (prev1_tc->kink_vel >=0  && prev1_tc->term_cond == TC_TERM_COND_TANGENT) {
@@ -1567,15 +1593,23 @@ STATIC int tpComputeOptimalVelocity(TP_STRUCT const * const tp, TC_STRUCT * cons
     //Limit the PREVIOUS velocity by how much we can overshoot into
     double vf_limit = fmin(vf_limit_this, vf_limit_prev);
 
+    // Find the reachable velocity of tc, moving backwards in time
+    double acc_back = 0.0;
+    double vs_back = findSCurveMaxStartVel(tc->finalvel, tc->finalacc,
+            tc->target, acc_this, tpGetMaxJerk(), vf_limit, &acc_back);
+
     if (vs_back >= vf_limit ) {
         //If we've hit the requested velocity, then prev_tc is definitely a "peak"
         vs_back = vf_limit;
+        // Cruising at the limit, so any braking starts from zero acceleration
+        acc_back = 0.0;
         prev1_tc->optimization_state = TC_OPTIM_AT_MAX;
         tp_debug_print("found peak due to v_limit %f\n", vf_limit);
     }
 
     //Limit tc's target velocity to avoid creating "humps" in the velocity profile
     prev1_tc->finalvel = vs_back;
+    prev1_tc->finalacc = acc_back;
 
     //Reduce max velocity to match sample rate
     double sample_maxvel = tc->target / (tp->cycleTime * TP_MIN_SEGMENT_CYCLES);
@@ -1588,13 +1622,34 @@ STATIC int tpComputeOptimalVelocity(TP_STRUCT const * const tp, TC_STRUCT * cons
 }
 
 
+/**
+ * Get the lookahead depth used by the optimizer.
+ * The INI setting is clamped to the queue size, since we can never look
+ * further back than the segments actually stored.
+ */
+STATIC int tpGetOptimizationDepth(TP_STRUCT const * const tp)
+{
+    int depth = emcmotConfig->arcBlendOptDepth;
+    if (depth > tp->queue.size) {
+        return tp->queue.size;
+    }
+    return depth;
+}
+
+
 /**
  * Do "rising tide" optimization to find allowable final velocities for each queued segment.
  * Walk along the queue from the back to the front. Based on the "current"
  * segment's final velocity, calculate the previous segment's maximum allowable
  * final velocity. The depth we walk along the queue is controlled by the
- * TP_LOOKAHEAD_DEPTH constant for now. The process safetly aborts early due to
- * a short queue or other conflicts.
+ * ARC_BLEND_OPTIMIZATION_DEPTH INI setting (bounded by the queue size). The
+ * process safetly aborts early due to a short queue or other conflicts.
+ *
+ * The pass is incremental: segments further back were already planned from
+ * the final velocity of the segment after them, so once a segment's final
+ * velocity comes out unchanged, nothing before it can change either. This
+ * keeps the cost of adding a segment roughly constant even with a deep
+ * lookahead.
  */
 STATIC int tpRunOptimization(TP_STRUCT * const tp) {
     // Pointers to the "current", previous, and 2nd previous trajectory
@@ -1606,7 +1661,7 @@ STATIC int tpRunOptimization(TP_STRUCT * const tp) {
 
     int ind, x;
     int len = tcqLen(&tp->queue);
-    //TODO make lookahead depth configurable from the INI file
+    int depth = tpGetOptimizationDepth(tp);
 
     int hit_peaks = 0;
     // Flag that says we've hit at least 1 non-tangent segment
@@ -1616,8 +1671,9 @@ STATIC int tpRunOptimization(TP_STRUCT * const tp) {
      * the front. We can't do anything with the very last element because its
      * length may change if a new line is added to the queue.*/
 
-    for (x = 1; x < emcmotConfig->arcBlendOptDepth + 2; ++x) {
+    for (x = 1; x < depth + 2; ++x) {
         tp_info_print("==== Optimization step %d ====\n",x);
+        bool unchanged = false;
 
         // Update the pointers to the trajectory segments in use
         ind = len-x;
@@ -1670,6 +1726,7 @@ STATIC int tpRunOptimization(TP_STRUCT * const tp) {
             //slight hiccup, but the alternative is a sudden hard stop.
             tp_debug_print("Found atspeed at id %d\n",tc->id);
             tc->finalvel = 0.0;
+            tc->finalacc = 0.0;
         }
 
         if (!tc->finalized) {
@@ -1682,12 +1739,24 @@ STATIC int tpRunOptimization(TP_STRUCT * const tp) {
             if (prev1_tc->kink_vel >=0  && prev1_tc->term_cond == TC_TERM_COND_TANGENT) {
               prev1_tc->finalvel = fmin(prev1_tc->finalvel, prev1_tc->kink_vel);
             }
+            // Arrive cruising, so that we can stop from there with S-curves too
+            prev1_tc->finalacc = 0.0;
             tc->finalvel = 0.0;
+            tc->finalacc = 0.0;
         } else {
+            double prev_finalvel = prev1_tc->finalvel;
+            double prev_finalacc = prev1_tc->finalacc;
             tpComputeOptimalVelocity(tp, tc, prev1_tc);
+            unchanged = fabs(prev1_tc->finalvel - prev_finalvel) < TP_VEL_EPSILON
+                && fabs(prev1_tc->finalacc - prev_finalacc) < TP_ACCEL_EPSILON;
         }
 
         tc->active_depth = x - 2 - hit_peaks;
+        if (unchanged) {
+            tp_debug_print("final velocity of segment %d unchanged, stopping optimization\n",
+                    ind-1);
+            return TP_ERR_OK;
+        }
 #ifdef TP_OPTIMIZATION_LAZY
         if (tc->optimization_state == TC_OPTIM_AT_MAX) {
             hit_peaks++;
@@ -2308,6 +2377,111 @@ void tpCalculateTrapezoidalAccel(TP_STRUCT const * const tp, TC_STRUCT * const t
     *vel_desired = maxnewvel;
 }
 
+/**
+ * Check if a candidate end-of-cycle acceleration still lets us reach the
+ * final velocity within the segment using a jerk-limited profile.
+ * The acceleration ramps linearly from a to acc over the cycle, so the
+ * velocity update uses the average of the two.
+ */
+STATIC int tpSCurveAccelIsSafe(TC_STRUCT const * const tc, double acc, double a,
+        double dx, double v_final, double a_final, double a_max, double j_max)
+{
+    double v = tc->currentvel;
+    double dt = fmax(tc->cycle_time, TP_TIME_EPSILON);
+    double v_next = fmax(v + (a + acc) * 0.5 * dt, 0.0);
+    double dx_next = dx - (v + v_next) * 0.5 * dt;
+    return findSCurveStopDistance(v_next, acc, v_final, a_final, a_max, j_max) <= dx_next;
+}
+
+/**
+ * Compute the acceleration for a cycle based on a jerk-limited (S-curve)
+ * motion profile.
+ * @param tc trajectory segment being processed.
+ *
+ * The acceleration can only change by j_max * dt each cycle. We pick the
+ * acceleration that tracks the target velocity without overshoot, then limit
+ * it to the largest value that still lets us slow to the final velocity by
+ * the end of the segment. If even the hardest jerk-limited braking isn't
+ * enough (e.g. feed override jumped or the segment was cut short by a blend),
+ * fall back to the trapezoidal profile, which respects the acceleration limit
+ * but not the jerk limit.
+ */
+STATIC void tpCalculateSCurveAccel(TP_STRUCT const * const tp, TC_STRUCT * const tc, TC_STRUCT const * const nexttc,
+        double * const acc, double * const vel_desired)
+{
+    tc_debug_print("using S-curve acceleration\n");
+
+    double tc_target_vel = tpGetRealTargetVel(tp, tc);
+    double tc_finalvel = tpGetRealFinalVel(tp, tc, nexttc);
+    double tc_finalacc = tpGetRealFinalAccel(tp, tc, nexttc);
+    double dx = tcGetDistanceToGo(tc, tp->reverse_run);
+    double a_max = tcGetTangentialMaxAccel(tc);
+    double j_max = tpGetMaxJerk();
+    // The acceleration is held through the first part of a split cycle, so
+    // allow the whole cycle's worth of change in what's left of it.
+    double da = j_max * tp->cycleTime;
+    double dt = fmax(tc->cycle_time, TP_TIME_EPSILON);
+
+    double v = tc->currentvel;
+    double a = bisaturate(tc->currentacc, a_max, -a_max);
+
+    // Velocity we'd settle at if we started releasing the acceleration now
+    double v_settle = v + a * fabs(a) / (2.0 * j_max);
+
+    double a_track;
+    if (v_settle < tc_target_vel - TP_VEL_EPSILON) {
+        a_track = fmin(a + da, a_max);
+    } else if (v_settle > tc_target_vel + TP_VEL_EPSILON) {
+        a_track = fmax(a - da, -a_max);
+    } else if (a > 0.0) {
+        a_track = fmax(a - da, 0.0);
+    } else {
+        a_track = fmin(a + da, 0.0);
+    }
+
+    double a_low = fmax(a - da, -a_max);
+    a_track = fmax(a_track, a_low);
+
+    double a_next;
+    if (tpSCurveAccelIsSafe(tc, a_track, a, dx, tc_finalvel, tc_finalacc, a_max, j_max)) {
+        a_next = a_track;
+        *vel_desired = tc_target_vel;
+    } else if (!tpSCurveAccelIsSafe(tc, a_low, a, dx, tc_finalvel, tc_finalacc, a_max, j_max)) {
+        tc_debug_print("S-curve can't stop in time, falling back to trapezoidal\n");
+        double acc_trap = 0, vel_trap = 0;
+        tpCalculateTrapezoidalAccel(tp, tc, nexttc, &acc_trap, &vel_trap);
+        // The trapezoidal acceleration is applied over the whole cycle
+        tc->currentacc = fmin(a_low, acc_trap);
+        *acc = tc->currentacc;
+        *vel_desired = v + *acc * dt;
+        return;
+    } else {
+        // Bisect for the largest acceleration that lets us make the final velocity
+        double a_safe = a_low;
+        double a_unsafe = a_track;
+        int i;
+        for (i = 0; i < TP_SCURVE_BISECT_ITERATIONS; ++i) {
+            double a_mid = (a_safe + a_unsafe) / 2.0;
+            if (tpSCurveAccelIsSafe(tc, a_mid, a, dx, tc_finalvel, tc_finalacc, a_max, j_max)) {
+                a_safe = a_mid;
+            } else {
+                a_unsafe = a_mid;
+            }
+        }
+        a_next = a_safe;
+        // We're limited by the end of the segment, so this is final deceleration
+        *vel_desired = v + (a + a_next) * 0.5 * dt;
+    }
+
+    // Acceleration ramps from a to a_next over the cycle
+    *acc = (a + a_next) * 0.5;
+    if (v + *acc * dt <= 0.0) {
+        // Coming to a stop, so the acceleration drops out with the velocity
+        a_next = 0.0;
+    }
+    tc->currentacc = a_next;
+}
+
 /**
  * Calculate "ramp" acceleration for a cycle.
  */
@@ -2949,9 +3123,13 @@ STATIC int tpUpdateCycle(TP_STRUCT * const tp,
     int res_accel = 1;
     double acc=0, vel_desired=0;
     
-    // If the slowdown is not too great, use velocity ramping instead of trapezoidal velocity
-    // Also, don't ramp up for parabolic blends
-    if (tc->accel_mode && tc->term_cond == TC_TERM_COND_TANGENT) {
+    if (tpGetMaxJerk() > 0.0) {
+        // Jerk-limited profile handles velocity ramping on its own
+        tpCalculateSCurveAccel(tp, tc, nexttc, &acc, &vel_desired);
+        res_accel = TP_ERR_OK;
+    } else if (tc->accel_mode && tc->term_cond == TC_TERM_COND_TANGENT) {
+        // If the slowdown is not too great, use velocity ramping instead of trapezoidal velocity
+        // Also, don't ramp up for parabolic blends
         res_accel = tpCalculateRampAccel(tp, tc, nexttc, &acc, &vel_desired);
     }
 
@@ -3023,6 +3201,49 @@ STATIC inline int tcSetSplitCycle(TC_STRUCT * const tc, double split_time,
 }
 
 
+/**
+ * Find the split time for a jerk-limited profile.
+ * The acceleration can't jump to a_max to meet the end of the segment like
+ * the trapezoidal estimate assumes, so carry on at the current acceleration
+ * and see where we cross the end.
+ */
+STATIC int tpCheckSCurveEndCondition(TP_STRUCT const * const tp, TC_STRUCT * const tc)
+{
+    double dx = tcGetDistanceToGo(tc, tp->reverse_run);
+    double v = tc->currentvel;
+    double a = tc->currentacc;
+    double dt;
+
+    if (fabs(a) < TP_ACCEL_EPSILON) {
+        if (v * tp->cycleTime < dx) {
+            return TP_ERR_NO_ACTION;
+        }
+        dt = dx / fmax(v, TP_VEL_EPSILON);
+    } else {
+        double disc = pmSq(v) + 2.0 * a * dx;
+        if (disc < 0) {
+            tc_debug_print(" decelerating to a stop before the end\n");
+            return TP_ERR_NO_ACTION;
+        }
+        // Numerically stable root of a/2 * dt^2 + v * dt - dx = 0
+        dt = 2.0 * dx / (v + pmSqrt(disc));
+    }
+
+    double v_f = fmax(v + a * dt, 0.0);
+    if (dt < TP_TIME_EPSILON) {
+        tc_debug_print("revised dt small, finishing tc\n");
+        tc->progress = tcGetTarget(tc, tp->reverse_run);
+        tcSetSplitCycle(tc, 0.0, v_f);
+    } else if (dt < tp->cycleTime) {
+        tc_debug_print(" S-curve split, v_f = %f, a = %f\n", v_f, a);
+        tcSetSplitCycle(tc, dt, v_f);
+    } else {
+        tc_debug_print(" dt = %f, not at end yet\n", dt);
+        return TP_ERR_NO_ACTION;
+    }
+    return TP_ERR_OK;
+}
+
 /**
  * Check remaining time in a segment and calculate split cycle if necessary.
  * This function estimates how much time we need to complete the next segment.
@@ -3058,6 +3279,10 @@ STATIC int tpCheckEndCondition(TP_STRUCT const * const tp, TC_STRUCT * const tc,
     }
 
 
+    if (tpGetMaxJerk() > 0.0) {
+        return tpCheckSCurveEndCondition(tp, tc);
+    }
+
     double v_f = tpGetRealFinalVel(tp, tc, nexttc);
     double v_avg = (tc->currentvel + v_f) / 2.0;
 
@@ -3177,6 +3402,7 @@ STATIC int tpHandleSplitCycle(TP_STRUCT * const tp, TC_STRUCT * const tc,
         case TC_TERM_COND_TANGENT:
             nexttc->cycle_time = tp->cycleTime - tc->cycle_time;
             nexttc->currentvel = tc->term_vel;
+            nexttc->currentacc = tc->currentacc;
             tp_debug_print("Doing tangent split\n");
             break;
         case TC_TERM_COND_PARABOLIC:
@@ -46,6 +46,11 @@
 #define TP_MIN_ARC_LENGTH 1e-6
 #define TP_BIG_NUM 1e10
 
+/* Bisection steps used to find the S-curve acceleration for a cycle */
+#define TP_SCURVE_BISECT_ITERATIONS 12
+/* Newton steps used to extend an S-curve braking profile backwards */
+#define TP_SCURVE_NEWTON_ITERATIONS 20
+
 /**
  * TP return codes.
  * This enum is a catch-all for useful return statuses from TP
@@ -72,6 +77,14 @@ typedef enum {
     TP_ERR_LAST
 } tp_err_t;
 
+/**
+ * Velocity profile shapes, selected by [TRAJ]PLANNER_TYPE.
+ */
+typedef enum {
+    TP_PLANNER_TRAPEZOIDAL = 0,
+    TP_PLANNER_SCURVE = 1,
+} tp_planner_type_t;
+
 /**
  * Persistant data for spindle status within tpRunCycle.
  * This structure encapsulates some static variables to simplify refactoring of
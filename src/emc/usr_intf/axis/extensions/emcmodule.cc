@@ -214,7 +214,9 @@ static int emcWaitCommandComplete(pyCommandChannel *s, double timeout) {
 
     do {
         double now = etime();
-        if(s->s->peek() == EMC_STAT_TYPE) {
+        // as in emcSendCommand, the status that completes the command
+        // may have been taken by an earlier peek
+        if(s->s->peek() >= 0) {
            EMC_STAT *stat = (EMC_STAT*)s->s->get_address();
            int serial_diff = stat->echo_serial_number - s->serial;
            if (serial_diff > 0) {
@@ -238,12 +240,15 @@ static int emcSendCommand(pyCommandChannel *s, RCS_CMD_MSG & cmd) {
 
     double start = etime();
     while (etime() - start < EMC_COMMAND_TIMEOUT) {
-        EMC_STAT *stat = (EMC_STAT*)s->s->get_address();
-        int serial_diff = stat->echo_serial_number - s->serial;
-        if(s->s->peek() == EMC_STAT_TYPE &&
-           serial_diff >= 0) {
+        // task only writes status when it changes, so look at what the
+        // last peek left even when this one has nothing new
+        if(s->s->peek() >= 0) {
+            EMC_STAT *stat = (EMC_STAT*)s->s->get_address();
+            int serial_diff = stat->echo_serial_number - s->serial;
+            if(serial_diff >= 0) {
                 return 0;
-           }
+            }
+        }
         esleep(EMC_COMMAND_DELAY);
     }
     return -1;
@@ -283,18 +288,86 @@ static bool check_stat(RCS_STAT_CHANNEL *emcStatusBuffer) {
     return true;
 }
 
+static void copy_range(EMC_STAT *to, const EMC_STAT *from,
+        const void *start, const void *end) {
+    size_t offset = (const char *)start - (const char *)from;
+    memcpy((char *)to + offset, start, (const char *)end - (const char *)start);
+}
+
+/* Copy the sections of the status whose generation differs from the
+   copy we have; the top-level part and the generations always. */
+static void update_status(EMC_STAT *to, const EMC_STAT *from) {
+    copy_range(to, from, from, &from->task);
+    if(to->task_generation != from->task_generation)
+        copy_range(to, from, &from->task, &from->task + 1);
+    if(to->motion_generation != from->motion_generation) {
+        copy_range(to, from, &from->motion, &from->motion.joint[0]);
+        copy_range(to, from, &from->motion.joint[EMCMOT_MAX_JOINTS],
+                &from->motion + 1);
+    }
+    for(int j = 0; j < EMCMOT_MAX_JOINTS; j++) {
+        if(to->joint_generation[j] != from->joint_generation[j])
+            copy_range(to, from, &from->motion.joint[j],
+                    &from->motion.joint[j + 1]);
+    }
+    if(to->io_generation != from->io_generation) {
+        copy_range(to, from, &from->io, &from->io.tool.toolTable[0]);
+        copy_range(to, from, &from->io.tool.toolTable[CANON_POCKETS_MAX],
+                &from->io + 1);
+    }
+    if(to->tool_table_generation != from->tool_table_generation)
+        copy_range(to, from, &from->io.tool.toolTable[0],
+                &from->io.tool.toolTable[CANON_POCKETS_MAX]);
+    // heartbeats aren't counted as changes
+    to->task.heartbeat = from->task.heartbeat;
+    to->motion.heartbeat = from->motion.heartbeat;
+    to->io.heartbeat = from->io.heartbeat;
+    copy_range(to, from, &from->debug, from + 1);
+}
+
 static PyObject *poll(pyStatChannel *s, PyObject *o) {
     if(!check_stat(s->c)) return NULL;
     if(s->c->peek() == EMC_STAT_TYPE) {
         EMC_STAT *emcStatus = static_cast<EMC_STAT*>(s->c->get_address());
-        memcpy(&s->status, emcStatus, sizeof(EMC_STAT));
+        update_status(&s->status, emcStatus);
     }
     Py_INCREF(Py_None);
     return Py_None;
 }
 
+static PyObject *wait_changed(pyStatChannel *s, PyObject *o) {
+    unsigned int generation = s->status.generation;
+    double timeout = EMC_COMMAND_TIMEOUT;
+    if(!PyArg_ParseTuple(o, "|Id:emc.stat.wait_changed", &generation, &timeout))
+        return NULL;
+    if(!check_stat(s->c)) return NULL;
+
+    double start = etime();
+    do {
+        if(s->c->peek() == EMC_STAT_TYPE) {
+            EMC_STAT *emcStatus = static_cast<EMC_STAT*>(s->c->get_address());
+            update_status(&s->status, emcStatus);
+        }
+        if(s->status.generation != generation) {
+            Py_INCREF(Py_True);
+            return Py_True;
+        }
+        double left = timeout - (etime() - start);
+        Py_BEGIN_ALLOW_THREADS
+        esleep(fmin(left, EMC_COMMAND_DELAY));
+        Py_END_ALLOW_THREADS
+    } while(etime() - start < timeout);
+    Py_INCREF(Py_False);
+    return Py_False;
+}
+
 static PyMethodDef Stat_methods[] = {
     {"poll", (PyCFunction)poll, METH_NOARGS, "Update current machine state"},
+    {"wait_changed", (PyCFunction)wait_changed, METH_VARARGS,
+        "wait_changed([generation[, timeout]]) -> bool\n\n"
+        "Poll until the status generation differs from 'generation' (by\n"
+        "default the one seen by the last poll).  Returns False if that\n"
+        "didn't happen within 'timeout' seconds."},
     {NULL}
 };
 
@@ -304,6 +377,11 @@ static PyMemberDef Stat_members[] = {
     {(char*)"echo_serial_number", T_INT, O(echo_serial_number), READONLY},
     {(char*)"echo_serial_number", T_INT, O(echo_serial_number), READONLY},
     {(char*)"state", T_INT, O(status), READONLY},
+    {(char*)"generation", T_UINT, O(generation), READONLY},
+    {(char*)"task_generation", T_UINT, O(task_generation), READONLY},
+    {(char*)"motion_generation", T_UINT, O(motion_generation), READONLY},
+    {(char*)"io_generation", T_UINT, O(io_generation), READONLY},
+    {(char*)"tool_table_generation", T_UINT, O(tool_table_generation), READONLY},
 
 // task
     {(char*)"task_mode", T_INT, O(task.mode), READONLY},
@@ -516,6 +594,15 @@ static PyObject *Stat_homed(pyStatChannel *s) {
     return res;
 }
 
+static PyObject *Stat_joint_generation(pyStatChannel *s) {
+    PyObject *res = PyTuple_New(EMCMOT_MAX_JOINTS);
+    for(int i = 0; i < EMCMOT_MAX_JOINTS; i++) {
+        PyTuple_SET_ITEM(res, i,
+                PyLong_FromUnsignedLong(s->status.joint_generation[i]));
+    }
+    return res;
+}
+
 static PyObject *Stat_ain(pyStatChannel *s) {
     return double_array(s->status.motion.analog_input, EMCMOT_MAX_AIO);
 }
@@ -712,6 +799,7 @@ static PyGetSetDef Stat_getsetlist[] = {
     {(char*)"dtg", (getter)Stat_dtg},
     {(char*)"joint_position", (getter)Stat_joint_position},
     {(char*)"joint_actual_position", (getter)Stat_joint_actual},
+    {(char*)"joint_generation", (getter)Stat_joint_generation},
     {(char*)"probed_position", (getter)Stat_probed},
     {(char*)"settings", (getter)Stat_activesettings, (setter)NULL,
         (char*)"This is an array containing the Interp active settings: sequence number,\n"
@@ -1063,6 +1063,10 @@ class AxisCanon(GLCanon, StatMixin):
             notifications.add("info",self.notify_message)
             self.notify = 0
 
+    def moves(self, *args):
+        GLCanon.moves(self, *args)
+        self.progress.update(self.lineno)
+
 
 progress_re = re.compile("^FILTER_PROGRESS=(\\d*)$")
 def filter_program(program_filter, infilename, outfilename):
@@ -20,7 +20,7 @@
 
     Invoking:
 
-    halsampler [-c chan_num] [-n num_samples] [-t]
+    halsampler [-c chan_num] [-n num_samples] [-t] [-b | -m] [filename]
 
     'chan_num', if present, specifies the sampler channel to use.
     The default is channel zero.
@@ -32,6 +32,10 @@
     '-t' tells sampler to print the sample number at the start
     of each line.
 
+    '-b' writes binary records instead of text, in the format
+    described in streamer_file.h.  '-m' does the same, but writes
+    'filename' through a memory mapping instead of with write(2).
+
 */
 
 /** This program is free software; you can redistribute it and/or
@@ -68,16 +72,23 @@
 #include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
+#include <errno.h>
 
 #include "rtapi.h"		/* RTAPI realtime OS API */
 #include "hal.h"                /* HAL public API decls */
 #include "streamer.h"
+#include "streamer_file.h"
 
 /***********************************************************************
 *                  LOCAL FUNCTION DECLARATIONS                         *
 ************************************************************************/
 
+static int map_open(int fd);
+static char *map_space(void);
+static int map_close(void);
+
 /***********************************************************************
 *                         GLOBAL VARIABLES                             *
 ************************************************************************/
@@ -88,6 +99,17 @@ int exitval = 1;	/* program return code - 1 means error */
 int ignore_sig = 0;	/* used to flag critical regions */
 char comp_name[HAL_NAME_LEN+1];	/* name for this instance of sampler */
 
+#define BATCH 256	/* samples taken from the fifo at a time */
+
+/* output file window for -m; the window is followed by enough slack
+   for a batch of records, so it only has to move between batches */
+#define MAP_WINDOW	(64 << 20)
+#define MAP_SLACK	(BATCH * STREAMER_FILE_MAX_RECORD + STREAMER_FILE_HEADER)
+int map_fd = -1;
+char *map_base = MAP_FAILED;	/* mapping of the window */
+off_t map_offset;		/* file offset of the window */
+size_t map_pos;			/* next byte to be written in the window */
+
 /***********************************************************************
 *                            MAIN PROGRAM                              *
 ************************************************************************/
@@ -106,16 +128,20 @@ static void quit(int sig)
 
 int main(int argc, char **argv)
 {
-    int n, channel, tag;
-    long int samples;
+    int n, i, channel, tag, binary, mapped, got, count;
+    long int samples, overruns;
     unsigned this_sample, last_sample=0;
     char *cp, *cp2;
     hal_stream_t stream;
+    streamer_file_t file;
 
     /* set return code to "fail", clear it later if all goes well */
     exitval = 1;
     channel = 0;
     tag = 0;
+    binary = 0;
+    mapped = 0;
+    overruns = 0;
     samples = -1;  /* -1 means run forever */
     /* FIXME - if I wasn't so lazy I'd learn how to use getopt() here */
     for ( n = 1 ; n < argc ; n++ ) {
@@ -147,6 +173,12 @@ int main(int argc, char **argv)
 	case 't':
 	    tag = 1;
 	    break;
+	case 'm':
+	    mapped = 1;
+	    /* fall through */
+	case 'b':
+	    binary = 1;
+	    break;
 	default:
 	    fprintf(stderr,"ERROR: unknown option '%s'\n", cp );
 	    exit(1);
@@ -160,9 +192,27 @@ int main(int argc, char **argv)
 	    exit(1);
 	}
 	// make stdout be the named file
-	fd = open(argv[n], O_WRONLY | O_CREAT, 0666);
+	if ( mapped ) {
+	    fd = open(argv[n], O_RDWR | O_CREAT | O_TRUNC, 0666);
+	} else if ( binary ) {
+	    fd = open(argv[n], O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	} else {
+	    fd = open(argv[n], O_WRONLY | O_CREAT, 0666);
+	}
+	if ( fd < 0 ) {
+	    perror(argv[n]);
+	    exit(1);
+	}
 	close(1);
 	dup2(fd, 1);
+	close(fd);
+    } else if ( mapped ) {
+	fprintf(stderr, "ERROR: -m needs a filename\n");
+	exit(1);
+    }
+    if ( mapped && map_open(1) < 0 ) {
+	perror("mmap");
+	exit(1);
     }
     /* register signal handlers - if the process is killed
        we need to call hal_exit() to free the shared memory */
@@ -189,60 +239,175 @@ int main(int argc, char **argv)
 	goto out;
     }
     int num_pins = hal_stream_element_count(&stream);
+    if ( binary ) {
+	/* sampler.N is usually running by now, and says the period */
+	char funct_name[HAL_NAME_LEN+1];
+	snprintf(funct_name, sizeof(funct_name), "sampler.%d", channel);
+	streamer_file_init(&file, &stream, streamer_funct_period(funct_name));
+	if ( mapped ) {
+	    streamer_file_put_header(&file, map_base);
+	    map_pos += file.header_size;
+	} else {
+	    char header[STREAMER_FILE_HEADER];
+	    streamer_file_put_header(&file, header);
+	    fwrite(header, sizeof(header), 1, stdout);
+	}
+    }
     while ( samples != 0 ) {
-	union hal_stream_data buf[num_pins];
+	union hal_stream_data buf[BATCH * num_pins];
+	unsigned sampleno[BATCH];
+	char records[binary && !mapped ? BATCH * file.record_size : 1];
+	char *start, *rec;
 	hal_stream_wait_readable(&stream, &stop);
 	if(stop) break;
-	int res = hal_stream_read(&stream, buf, &this_sample);
-	if (res < 0) {
-	    errno = -res;
-	    perror("hal_stream_read");
-	    goto out;
-	}
-	++last_sample;
-	if ( this_sample != last_sample ) {
-	    printf ( "overrun\n");
-	    last_sample = this_sample;
+	/* drain a batch of samples at once, so the writer gets the
+	   space back in one go and the output is written in blocks */
+	count = BATCH;
+	if ( samples > 0 && samples < count ) {
+	    count = samples;
 	}
-	if ( tag ) {
-	    printf ( "%d ", this_sample-1 );
+	got = hal_stream_read_many(&stream, buf, sampleno, count);
+	start = mapped ? map_space() : records;
+	if ( start == NULL ) {
+	    goto out;
 	}
-	for ( n = 0 ; n < num_pins; n++ ) {
-	    switch ( hal_stream_element_type(&stream, n) ) {
-	    case HAL_FLOAT:
-		printf ( "%f ", buf[n].f);
-		break;
-	    case HAL_BIT:
-		if ( buf[n].b ) {
-		    printf ( "1 " );
+	rec = start;
+	for ( i = 0 ; i < got ; i++ ) {
+	    union hal_stream_data *data = &buf[i * num_pins];
+	    this_sample = sampleno[i];
+	    ++last_sample;
+	    if ( this_sample != last_sample ) {
+		if ( binary ) {
+		    /* the gap shows in the sample numbers */
+		    overruns++;
 		} else {
-		    printf ( "0 " );
+		    printf ( "overrun\n");
+		}
+		last_sample = this_sample;
+	    }
+	    if ( binary ) {
+		rec = streamer_file_put(&file, rec, data, this_sample);
+		continue;
+	    }
+	    if ( tag ) {
+		printf ( "%d ", this_sample-1 );
+	    }
+	    for ( n = 0 ; n < num_pins; n++ ) {
+		switch ( hal_stream_element_type(&stream, n) ) {
+		case HAL_FLOAT:
+		    printf ( "%f ", data[n].f);
+		    break;
+		case HAL_BIT:
+		    if ( data[n].b ) {
+			printf ( "1 " );
+		    } else {
+			printf ( "0 " );
+		    }
+		    break;
+		case HAL_U32:
+		    printf ( "%lu ", (unsigned long)data[n].u);
+		    break;
+		case HAL_S32:
+		    printf ( "%ld ", (long)data[n].s);
+		    break;
+		default:
+		    /* better not happen */
+		    goto out;
 		}
-		break;
-	    case HAL_U32:
-		printf ( "%lu ", (unsigned long)buf[n].u);
-		break;
-	    case HAL_S32:
-		printf ( "%ld ", (long)buf[n].s);
-		break;
-	    default:
-		/* better not happen */
+	    }
+	    printf ( "\n" );
+	}
+	if ( mapped ) {
+	    map_pos += rec - start;
+	} else if ( rec > start ) {
+	    if ( fwrite(start, rec - start, 1, stdout) != 1 ) {
+		perror("write");
 		goto out;
 	    }
 	}
-	printf ( "\n" );
 	if ( samples > 0 ) {
-	    samples--;
+	    samples -= got;
 	}
     }
+    if ( overruns ) {
+	fprintf(stderr, "halsampler: %ld overruns\n", overruns);
+    }
     /* run was succesfull */
     exitval = 0;
 
 out:
     ignore_sig = 1;
+    if ( mapped && map_close() < 0 ) {
+	perror("halsampler");
+	exitval = 1;
+    }
     hal_stream_detach(&stream);
     if ( comp_id >= 0 ) {
 	hal_exit(comp_id);
     }
     return exitval;
 }
+
+/***********************************************************************
+*                   LOCAL FUNCTION DEFINITIONS                         *
+************************************************************************/
+
+/* map the first window of output file 'fd' */
+static int map_open(int fd)
+{
+    int err;
+
+    map_fd = fd;
+    map_offset = 0;
+    map_pos = 0;
+    /* allocate the space, so a full disk fails here and not with a
+       SIGBUS when the mapping is written */
+    err = posix_fallocate(map_fd, 0, MAP_WINDOW + MAP_SLACK);
+    if ( err ) {
+	errno = err;
+	return -1;
+    }
+    map_base = mmap(NULL, MAP_WINDOW + MAP_SLACK, PROT_READ | PROT_WRITE,
+	MAP_SHARED, map_fd, 0);
+    return map_base == MAP_FAILED ? -1 : 0;
+}
+
+/* where the next record goes, with room for a batch of them, or NULL
+   if the file can't be extended */
+static char *map_space(void)
+{
+    int err;
+
+    if ( map_pos < MAP_WINDOW ) {
+	return map_base + map_pos;
+    }
+    /* move the window on, the slack at its end becomes its start */
+    munmap(map_base, MAP_WINDOW + MAP_SLACK);
+    map_offset += MAP_WINDOW;
+    map_pos -= MAP_WINDOW;
+    err = posix_fallocate(map_fd, map_offset, MAP_WINDOW + MAP_SLACK);
+    if ( err == 0 ) {
+	map_base = mmap(NULL, MAP_WINDOW + MAP_SLACK, PROT_READ | PROT_WRITE,
+	    MAP_SHARED, map_fd, map_offset);
+    }
+    if ( err || map_base == MAP_FAILED ) {
+	fprintf(stderr, "ERROR: can't extend output file: %s\n",
+	    strerror(err ? err : errno));
+	map_base = MAP_FAILED;
+	return NULL;
+    }
+    return map_base + map_pos;
+}
+
+/* unmap the output file and cut it to the data written */
+static int map_close(void)
+{
+    if ( map_fd < 0 ) {
+	return 0;
+    }
+    if ( map_base != MAP_FAILED ) {
+	munmap(map_base, MAP_WINDOW + MAP_SLACK);
+	map_base = MAP_FAILED;
+    }
+    return ftruncate(map_fd, map_offset + map_pos);
+}
@@ -0,0 +1,267 @@
+/********************************************************************
+* Description:  streamer_file.c
+*               Binary file format shared by "halsampler" and
+*               "halstreamer", see streamer_file.h.
+*
+* License: GPL Version 2
+*
+* Copyright (c) 2026 All rights reserved.
+*
+********************************************************************/
+
+#include <string.h>
+#include <stdint.h>
+#include <endian.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"		/* HAL public API decls */
+#include "../hal_priv.h"	/* private HAL decls */
+#include <rtapi_mutex.h>
+#include "streamer_file.h"
+
+static void put_u32(char *p, uint32_t v)
+{
+    v = htole32(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+static void put_u64(char *p, uint64_t v)
+{
+    v = htole64(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+static uint32_t get_u32(const char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return le32toh(v);
+}
+
+static uint64_t get_u64(const char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return le64toh(v);
+}
+
+static int type_size(hal_type_t type)
+{
+    switch (type) {
+    case HAL_FLOAT:
+	return 8;
+    case HAL_BIT:
+	return 1;
+    default:
+	return 4;
+    }
+}
+
+static void set_record_size(streamer_file_t *file)
+{
+    int n;
+
+    file->record_size = 4;
+    for (n = 0; n < file->num_pins; n++) {
+	file->record_size += type_size(file->type[n]);
+    }
+}
+
+void streamer_file_init(streamer_file_t *file, hal_stream_t *stream,
+    unsigned long long period)
+{
+    int n;
+
+    memset(file, 0, sizeof(*file));
+    file->num_pins = hal_stream_element_count(stream);
+    for (n = 0; n < file->num_pins; n++) {
+	file->type[n] = hal_stream_element_type(stream, n);
+    }
+    file->header_size = STREAMER_FILE_HEADER;
+    file->period = period;
+    set_record_size(file);
+}
+
+void streamer_file_put_header(streamer_file_t *file, char *buf)
+{
+    int n;
+
+    memset(buf, 0, STREAMER_FILE_HEADER);
+    memcpy(buf, STREAMER_FILE_MAGIC, 8);
+    put_u32(buf + 8, file->header_size);
+    put_u32(buf + 12, file->record_size);
+    put_u64(buf + 16, file->period);
+    put_u32(buf + 24, file->num_pins);
+    for (n = 0; n < file->num_pins; n++) {
+	switch (file->type[n]) {
+	case HAL_FLOAT:
+	    buf[28 + n] = 'f';
+	    break;
+	case HAL_BIT:
+	    buf[28 + n] = 'b';
+	    break;
+	case HAL_U32:
+	    buf[28 + n] = 'u';
+	    break;
+	default:
+	    buf[28 + n] = 's';
+	    break;
+	}
+    }
+}
+
+const char *streamer_file_get_header(streamer_file_t *file, const char *buf)
+{
+    int n;
+
+    memset(file, 0, sizeof(*file));
+    if (memcmp(buf, STREAMER_FILE_MAGIC, 8) != 0) {
+	return "not a binary stream file";
+    }
+    file->header_size = get_u32(buf + 8);
+    file->record_size = get_u32(buf + 12);
+    file->period = get_u64(buf + 16);
+    file->num_pins = get_u32(buf + 24);
+    if (file->header_size < STREAMER_FILE_HEADER) {
+	return "bad header size";
+    }
+    if (file->num_pins < 1 || file->num_pins > HAL_STREAM_MAX_PINS) {
+	return "bad number of pins";
+    }
+    for (n = 0; n < file->num_pins; n++) {
+	switch (buf[28 + n]) {
+	case 'f':
+	    file->type[n] = HAL_FLOAT;
+	    break;
+	case 'b':
+	    file->type[n] = HAL_BIT;
+	    break;
+	case 'u':
+	    file->type[n] = HAL_U32;
+	    break;
+	case 's':
+	    file->type[n] = HAL_S32;
+	    break;
+	default:
+	    return "bad pin type";
+	}
+    }
+    n = file->record_size;
+    set_record_size(file);
+    if (n != file->record_size) {
+	return "bad record size";
+    }
+    return NULL;
+}
+
+const char *streamer_file_check(streamer_file_t *file, hal_stream_t *stream)
+{
+    int n;
+
+    if (file->num_pins != hal_stream_element_count(stream)) {
+	return "number of pins does not match the stream";
+    }
+    for (n = 0; n < file->num_pins; n++) {
+	if (file->type[n] != hal_stream_element_type(stream, n)) {
+	    return "pin types do not match the stream";
+	}
+    }
+    return NULL;
+}
+
+char *streamer_file_put(streamer_file_t *file, char *rec,
+    const union hal_stream_data *data, unsigned sampleno)
+{
+    int n;
+    double f;
+    uint64_t u;
+
+    put_u32(rec, sampleno);
+    rec += 4;
+    for (n = 0; n < file->num_pins; n++) {
+	switch (file->type[n]) {
+	case HAL_FLOAT:
+	    f = data[n].f;
+	    memcpy(&u, &f, sizeof(u));
+	    put_u64(rec, u);
+	    rec += 8;
+	    break;
+	case HAL_BIT:
+	    *rec++ = data[n].b ? 1 : 0;
+	    break;
+	case HAL_U32:
+	    put_u32(rec, data[n].u);
+	    rec += 4;
+	    break;
+	default:
+	    put_u32(rec, data[n].s);
+	    rec += 4;
+	    break;
+	}
+    }
+    return rec;
+}
+
+const char *streamer_file_get(streamer_file_t *file, const char *rec,
+    union hal_stream_data *data, unsigned *sampleno)
+{
+    int n;
+    double f;
+    uint64_t u;
+
+    if (sampleno) {
+	*sampleno = get_u32(rec);
+    }
+    rec += 4;
+    for (n = 0; n < file->num_pins; n++) {
+	switch (file->type[n]) {
+	case HAL_FLOAT:
+	    u = get_u64(rec);
+	    memcpy(&f, &u, sizeof(f));
+	    data[n].f = f;
+	    rec += 8;
+	    break;
+	case HAL_BIT:
+	    data[n].b = *rec++ != 0;
+	    break;
+	case HAL_U32:
+	    data[n].u = get_u32(rec);
+	    rec += 4;
+	    break;
+	default:
+	    data[n].s = (int32_t) get_u32(rec);
+	    rec += 4;
+	    break;
+	}
+    }
+    return rec;
+}
+
+unsigned long long streamer_funct_period(const char *name)
+{
+    hal_funct_t *funct;
+    hal_thread_t *thread;
+    hal_list_t *list_root, *list_entry;
+    int next_thread;
+    unsigned long long period = 0;
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    funct = halpr_find_funct_by_name(name);
+    next_thread = funct ? hal_data->thread_list_ptr : 0;
+    while (next_thread != 0 && period == 0) {
+	thread = SHMPTR(next_thread);
+	list_root = &(thread->funct_list);
+	list_entry = list_next(list_root);
+	while (list_entry != list_root) {
+	    if (SHMPTR(((hal_funct_entry_t *) list_entry)->funct_ptr)
+		== funct) {
+		period = thread->period;
+		break;
+	    }
+	    list_entry = list_next(list_entry);
+	}
+	next_thread = thread->next_ptr;
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    return period;
+}
@@ -0,0 +1,71 @@
+/********************************************************************
+* Description:  streamer_file.h
+*               Binary file format shared by "halsampler" and
+*               "halstreamer".
+*
+* License: GPL Version 2
+*
+* Copyright (c) 2026 All rights reserved.
+*
+********************************************************************/
+/** A binary stream file starts with a header of STREAMER_FILE_HEADER
+    bytes or more:
+
+	 0  char[8]  "HALSTRM1"
+	 8  u32      size of the header, where the first record starts
+	12  u32      size of a record
+	16  u64      sample period in ns, 0 if not known
+	24  u32      number of pins
+	28  char[24] config string of the stream, e.g. "ffbs"
+	52           zero up to the end of the header
+
+    followed by records of a u32 sample number and then, in config
+    string order, an 8 byte IEEE double for each float pin, 1 byte
+    for each bit pin and 4 bytes for each u32 or s32 pin, without
+    padding.  All numbers are little-endian.
+*/
+
+#ifndef STREAMER_FILE_H
+#define STREAMER_FILE_H
+
+#define STREAMER_FILE_MAGIC	"HALSTRM1"
+#define STREAMER_FILE_HEADER	64
+#define STREAMER_FILE_MAX_RECORD	(4 + 8 * HAL_STREAM_MAX_PINS)
+
+typedef struct {
+    int num_pins;
+    hal_type_t type[HAL_STREAM_MAX_PINS];
+    int header_size;		/* bytes before the first record */
+    int record_size;		/* bytes per record */
+    unsigned long long period;	/* sample period in ns, 0 if unknown */
+} streamer_file_t;
+
+/* describe the records of 'stream' */
+extern void streamer_file_init(streamer_file_t *file, hal_stream_t *stream,
+    unsigned long long period);
+
+/* fill in the STREAMER_FILE_HEADER bytes of header at 'buf' */
+extern void streamer_file_put_header(streamer_file_t *file, char *buf);
+
+/* read the first STREAMER_FILE_HEADER bytes of a file at 'buf';
+   returns NULL, or a message saying what is wrong with it */
+extern const char *streamer_file_get_header(streamer_file_t *file,
+    const char *buf);
+
+/* returns NULL if records of 'file' can be written to 'stream', or a
+   message saying why not */
+extern const char *streamer_file_check(streamer_file_t *file,
+    hal_stream_t *stream);
+
+/* store one sample as a record at 'rec', returning the end of it */
+extern char *streamer_file_put(streamer_file_t *file, char *rec,
+    const union hal_stream_data *data, unsigned sampleno);
+
+/* load one sample from the record at 'rec', returning the end of it */
+extern const char *streamer_file_get(streamer_file_t *file, const char *rec,
+    union hal_stream_data *data, unsigned *sampleno);
+
+/* period of the thread that runs HAL function 'name', 0 if none does */
+extern unsigned long long streamer_funct_period(const char *name);
+
+#endif /* STREAMER_FILE_H */
@@ -20,13 +20,17 @@
 
     Invoking:
 
-    halstreamer [chan_num]
+    halstreamer [-c chan_num] [-b | -m] [filename]
 
     'chan_num', if present, specifies the streamer channel to use.
     The default is channel zero.  Since hal_stream takes its data
     from stdin, it will almost always either need to have stdin 
     redirected from a file, or have data piped into it from some
     other program.
+
+    '-b' reads binary records, as written by 'halsampler -b', instead
+    of text.  '-m' does the same, but maps the input file into memory
+    instead of reading it.
 */
 
 /** This program is free software; you can redistribute it and/or
@@ -63,16 +67,21 @@
 #include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
+#include <errno.h>
 
 #include "rtapi.h"		/* RTAPI realtime OS API */
 #include "hal.h"                /* HAL public API decls */
 #include "streamer.h"
+#include "streamer_file.h"
 
 /***********************************************************************
 *                  LOCAL FUNCTION DECLARATIONS                         *
 ************************************************************************/
 
+static int stream_binary(hal_stream_t *stream, int channel, int mapped);
+
 /***********************************************************************
 *                         GLOBAL VARIABLES                             *
 ************************************************************************/
@@ -98,10 +107,11 @@ static void quit(int sig)
 }
 
 #define BUF_SIZE 4000
+#define BATCH 256	/* samples put in the fifo at a time */
 
 int main(int argc, char **argv)
 {
-    int n, channel, line=0;
+    int n, channel, binary, mapped, line=0;
     char *cp, *cp2;
     hal_stream_t stream;
     char buf[BUF_SIZE];
@@ -110,6 +120,8 @@ int main(int argc, char **argv)
     /* set return code to "fail", clear it later if all goes well */
     exitval = 1;
     channel = 0;
+    binary = 0;
+    mapped = 0;
     for ( n = 1 ; n < argc ; n++ ) {
 	cp = argv[n];
 	if ( *cp != '-' ) {
@@ -126,6 +138,12 @@ int main(int argc, char **argv)
 		exit(1);
 	    }
 	    break;
+	case 'm':
+	    mapped = 1;
+	    /* fall through */
+	case 'b':
+	    binary = 1;
+	    break;
 	default:
 	    fprintf(stderr,"ERROR: unknown option '%s'\n", cp );
 	    exit(1);
@@ -140,6 +158,10 @@ int main(int argc, char **argv)
 	}
 	// make stdin be the named file
 	fd = open(argv[n], O_RDONLY);
+	if ( fd < 0 ) {
+	    perror(argv[n]);
+	    exit(1);
+	}
 	close(0);
 	dup2(fd, 0);
     }
@@ -168,6 +190,12 @@ int main(int argc, char **argv)
 	perror("hal_stream_attach");
 	goto out;
     }
+    if ( binary ) {
+	if ( stream_binary(&stream, channel, mapped) == 0 ) {
+	    exitval = 0;
+	}
+	goto out;
+    }
     int num_pins = hal_stream_element_count(&stream);
     while ( fgets(buf, BUF_SIZE, stdin) ) {
 	/* skip comment lines */
@@ -254,3 +282,107 @@ out:
     }
     return exitval;
 }
+
+/***********************************************************************
+*                   LOCAL FUNCTION DEFINITIONS                         *
+************************************************************************/
+
+/* copy the binary records on stdin to the fifo, a batch at a time */
+static int stream_binary(hal_stream_t *stream, int channel, int mapped)
+{
+    streamer_file_t file;
+    char header[STREAMER_FILE_HEADER];
+    char funct_name[HAL_NAME_LEN+1];
+    const char *errmsg, *map = MAP_FAILED, *rec;
+    char *records = NULL;
+    struct stat st;
+    size_t pos = 0;
+    unsigned long long period;
+    int n, count, num_pins, result = -1;
+
+    if ( mapped ) {
+	if ( fstat(0, &st) < 0 || st.st_size < STREAMER_FILE_HEADER ) {
+	    fprintf(stderr, "ERROR: -m needs a binary stream file\n");
+	    return -1;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, 0, 0);
+	if ( map == MAP_FAILED ) {
+	    perror("mmap");
+	    return -1;
+	}
+	madvise((void *)map, st.st_size, MADV_SEQUENTIAL);
+	memcpy(header, map, sizeof(header));
+    } else if ( fread(header, sizeof(header), 1, stdin) != 1 ) {
+	fprintf(stderr, "ERROR: no binary stream header\n");
+	return -1;
+    }
+    errmsg = streamer_file_get_header(&file, header);
+    if ( errmsg == NULL ) {
+	errmsg = streamer_file_check(&file, stream);
+    }
+    if ( errmsg != NULL ) {
+	fprintf(stderr, "ERROR: %s\n", errmsg);
+	goto out;
+    }
+    snprintf(funct_name, sizeof(funct_name), "streamer.%d", channel);
+    period = streamer_funct_period(funct_name);
+    if ( file.period != 0 && period != 0 && file.period != period ) {
+	fprintf(stderr, "WARNING: samples taken every %llu ns are "
+	    "replayed every %llu ns\n", file.period, period);
+    }
+    if ( mapped ) {
+	pos = file.header_size;
+    } else {
+	/* skip the rest of a longer header */
+	for ( n = STREAMER_FILE_HEADER ; n < file.header_size ; n++ ) {
+	    if ( getchar() == EOF ) {
+		break;
+	    }
+	}
+	records = malloc(BATCH * file.record_size);
+	if ( records == NULL ) {
+	    perror("malloc");
+	    goto out;
+	}
+    }
+    num_pins = file.num_pins;
+    while ( !stop ) {
+	union hal_stream_data data[BATCH * num_pins];
+	if ( mapped ) {
+	    count = st.st_size > pos ? (st.st_size - pos) / file.record_size : 0;
+	    if ( count > BATCH ) {
+		count = BATCH;
+	    }
+	    rec = map + pos;
+	    pos += count * file.record_size;
+	} else {
+	    count = fread(records, file.record_size, BATCH, stdin);
+	    rec = records;
+	}
+	if ( count == 0 ) {
+	    break;
+	}
+	for ( n = 0 ; n < count ; n++ ) {
+	    rec = streamer_file_get(&file, rec, &data[n * num_pins], NULL);
+	}
+	for ( n = 0 ; n < count && !stop ; ) {
+	    hal_stream_wait_writable(stream, &stop);
+	    n += hal_stream_write_many(stream, &data[n * num_pins], count - n);
+	}
+    }
+    if ( !mapped && ferror(stdin) ) {
+	perror("read");
+	goto out;
+    }
+    if ( mapped && !stop && pos != (size_t)st.st_size ) {
+	fprintf(stderr, "WARNING: incomplete record at end of input\n");
+    }
+    result = 0;
+
+out:
+    if ( map != MAP_FAILED ) {
+	munmap((void *)map, st.st_size);
+    }
+    free(records);
+    return result;
+}
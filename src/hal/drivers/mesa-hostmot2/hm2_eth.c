@@ -17,9 +17,11 @@
  *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#define _GNU_SOURCE /* recvmmsg() */
 #include <sys/fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <linux/sockios.h>
 #include <net/if_arp.h>
 #include <netinet/in.h>
@@ -94,6 +96,9 @@ RTAPI_MP_ARRAY_STRING(config, MAX_ETH_BOARDS, "config string for the AnyIO board
 int debug = 0;
 RTAPI_MP_INT(debug, "Developer/debug use only!  Enable debug logging.");
 
+static int busy_poll = 0;
+RTAPI_MP_INT(busy_poll, "microseconds to busy poll the network device for read replies, 0 to sleep between checks");
+
 static int boards_count = 0;
 
 int comm_active = 0;
@@ -553,13 +558,15 @@ static int init_board(hm2_eth_t *board, const char *board_ip) {
     board->local_addr.sin_family      = AF_INET;
     board->local_addr.sin_addr.s_addr = INADDR_ANY;
 
+    board->loopback = (ntohl(board->server_addr.sin_addr.s_addr) >> 24) == IN_LOOPBACKNET;
+
     ret = connect(board->sockfd, (struct sockaddr *) &board->server_addr, sizeof(struct sockaddr_in));
     if (ret < 0) {
         LL_PRINT("ERROR: can't connect: %s\n", strerror(errno));
         return -errno;
     }
 
-    if(!use_iptables()) {
+    if(!board->loopback && !use_iptables()) {
         LL_PRINT(\
 "WARNING: Unable to restrict other access to the hm2-eth device.\n"
 "This means that other software using the same network interface can violate\n"
@@ -583,6 +590,14 @@ static int init_board(hm2_eth_t *board, const char *board_ip) {
         return -errno;
     }
 
+    if (busy_poll > 0) {
+        ret = setsockopt(board->sockfd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll));
+        if (ret < 0) {
+            LL_PRINT("ERROR: can't set busy poll: %s\n", strerror(errno));
+            return -errno;
+        }
+    }
+
     memset(&board->req, 0, sizeof(board->req));
     struct sockaddr_in *sin;
 
@@ -591,21 +606,23 @@ static int init_board(hm2_eth_t *board, const char *board_ip) {
     sin->sin_addr.s_addr = inet_addr(board_ip);
 
     board->req.arp_ha.sa_family = AF_LOCAL;
-    board->req.arp_flags = ATF_PERM | ATF_COM;
     ret = fetch_hwaddr( board_ip, board->sockfd, (void*)&board->req.arp_ha.sa_data );
     if(ret < 0) {
         LL_PRINT("ERROR: %s: Could not retrieve mac address\n", board_ip);
         return ret;
     }
 
-    ret = ioctl_siocsarp(board);
-    if(ret < 0) {
-        perror("ioctl SIOCSARP");
-        board->req.arp_flags &= ~ATF_PERM;
-        return -errno;
+    if(!board->loopback) {
+        board->req.arp_flags = ATF_PERM | ATF_COM;
+        ret = ioctl_siocsarp(board);
+        if(ret < 0) {
+            perror("ioctl SIOCSARP");
+            board->req.arp_flags &= ~ATF_PERM;
+            return -errno;
+        }
     }
 
-    if(use_iptables())
+    if(!board->loopback && use_iptables())
     {
         ret = install_iptables_board(board->sockfd);
         if(ret < 0) return ret;
@@ -698,6 +715,24 @@ static int hm2_eth_read(hm2_lowlevel_io_t *this, rtapi_u32 addr, void *buffer, i
     return 1;  // success
 }
 
+static int send_write_packet(hm2_eth_t *board) {
+    int send;
+    long long t0, t1;
+
+    t0 = rtapi_get_time();
+    send = eth_socket_send(board->sockfd, (void*) &board->write_packet, board->write_packet_size, 0);
+    board->write_pending = false;
+    if(send < 0) {
+        LL_PRINT("ERROR: sending packet: %s\n", strerror(errno));
+        return 0;
+    }
+    t1 = rtapi_get_time();
+    LL_PRINT_IF(debug, "enqueue_write(%d) : PACKET SEND [SIZE: %d | TIME: %llu]\n", board->write_cnt, send, t1 - t0);
+    board->write_packet_ptr = board->write_packet;
+    board->write_packet_size = 0;
+    return 1;
+}
+
 static int hm2_eth_send_queued_reads(hm2_lowlevel_io_t *this) {
     hm2_eth_t *board = this->private;
     int send;
@@ -726,7 +761,25 @@ static int hm2_eth_send_queued_reads(hm2_lowlevel_io_t *this) {
     board->queue_reads_count++;
     board->queue_buff_size += 8;
 
-    send = eth_socket_send(board->sockfd, (void*) &board->read_packet, board->read_packet_ptr - board->read_packet, 0);
+    int read_size = board->read_packet_ptr - board->read_packet;
+    if(board->write_pending
+            && board->write_packet_size + read_size <= (int)sizeof(board->read_packet)) {
+        // the board carries out the writes before the reads, just as if
+        // they had been sent on their own
+        struct iovec iov[2] = {
+            { board->write_packet, board->write_packet_size },
+            { board->read_packet, read_size },
+        };
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+        send = sendmsg(board->sockfd, &msg, 0);
+        board->write_packet_ptr = board->write_packet;
+        board->write_packet_size = 0;
+        board->write_pending = false;
+    } else {
+        if(board->write_pending && !send_write_packet(board)) return 0;
+        send = eth_socket_send(board->sockfd, (void*) &board->read_packet, read_size, 0);
+    }
+    board->read_send_time = rtapi_get_time();
     if(send < 0) {
         LL_PRINT("ERROR: sending packet: %s\n", strerror(errno));
         return 0;
@@ -761,10 +814,31 @@ static void decrement_soft_error(hm2_eth_t *board) {
     *board->hal->packet_error_exceeded = 0;
 }
 
+static void record_rtt(hm2_eth_t *board, long long rtt) {
+    int i;
+
+    if(!board->hal) return;
+    if(*board->hal->rtt_reset) {
+        *board->hal->rtt_max = 0;
+        for(i = 0; i < HM2_ETH_RTT_BUCKETS; i++)
+            *board->hal->rtt_hist[i] = 0;
+    }
+    *board->hal->rtt = rtt;
+    if(rtt > *board->hal->rtt_max)
+        *board->hal->rtt_max = rtt;
+    i = HM2_ETH_RTT_BUCKETS - 1;
+    if(board->hal->rtt_bucket > 0 && rtt / board->hal->rtt_bucket < i)
+        i = rtt / board->hal->rtt_bucket;
+    (*board->hal->rtt_hist[i])++;
+}
+
 static int hm2_eth_receive_queued_reads(hm2_lowlevel_io_t *this) {
     hm2_eth_t *board = this->private;
-    int recv, i = 0;
-    rtapi_u8 tmp_buffer[board->queue_buff_size];
+    int recv, i = 0, j, k;
+    rtapi_u8 tmp_buffer[MAX_ETH_RECV_PACKETS][board->queue_buff_size];
+    struct iovec iov[MAX_ETH_RECV_PACKETS];
+    struct mmsghdr msgs[MAX_ETH_RECV_PACKETS];
+    bool received = false, confirmed = false;
     long long t1, t2;
     t1 = rtapi_get_time();
     
@@ -786,15 +860,36 @@ static int hm2_eth_receive_queued_reads(hm2_lowlevel_io_t *this) {
  
     if(!board->hal) this->read_time = t1;
     unsigned long long read_deadline = this->read_time + read_timeout;
+
+    memset(msgs, 0, sizeof(msgs));
+    for (k = 0; k < MAX_ETH_RECV_PACKETS; k++) {
+        iov[k].iov_base = tmp_buffer[k];
+        iov[k].iov_len = board->queue_buff_size;
+        msgs[k].msg_hdr.msg_iov = &iov[k];
+        msgs[k].msg_hdr.msg_iovlen = 1;
+    }
+
+    // take every reply that has arrived in one call, so a stale reply
+    // to an earlier request doesn't cost a trip round the loop; with
+    // busy_poll, the socket spins on the device for the first one
+    // instead of being woken up for it
     do {
-do_recv_packet:
         errno = 0;
-        recv = eth_socket_recv(board->sockfd, (void*) &tmp_buffer, board->queue_buff_size, MSG_DONTWAIT);
-        if(recv < 0) rtapi_delay(READ_PCK_DELAY_NS);
+        recv = recvmmsg(board->sockfd, msgs, MAX_ETH_RECV_PACKETS,
+                busy_poll > 0 ? MSG_WAITFORONE : MSG_DONTWAIT, NULL);
+        if(recv < 0 && busy_poll <= 0) rtapi_delay(READ_PCK_DELAY_NS);
         t2 = rtapi_get_time();
         i++;
-    } while (recv != board->queue_buff_size && t2 < read_deadline);
-    if(recv != board->queue_buff_size) {
+        for (k = 0; k < recv && !confirmed; k++) {
+            if ((int) msgs[k].msg_len != board->queue_buff_size) continue;
+            received = true;
+            for (j = 0; j < board->queue_reads_count; j++) {
+                memcpy(board->queue_reads[j].buffer, &tmp_buffer[k][board->queue_reads[j].from], board->queue_reads[j].size);
+            }
+            confirmed = board->confirm_read_cnt == board->read_cnt;
+        }
+    } while (!confirmed && t2 < read_deadline);
+    if(!received) {
         board->read_packet_ptr = board->read_packet;
         board->queue_reads_count = 0;
         board->queue_buff_size = 0;
@@ -802,14 +897,8 @@ do_recv_packet:
         return -EAGAIN;
     }
 
-    LL_PRINT_IF(debug, "enqueue_read(%d) : PACKET RECV [SIZE: %d | TRIES: %d | TIME: %llu]\n", board->read_cnt, recv, i, t2 - t1);
-
-    for (i = 0; i < board->queue_reads_count; i++) {
-        memcpy(board->queue_reads[i].buffer, &tmp_buffer[board->queue_reads[i].from], board->queue_reads[i].size);
-    }
-
-    if(board->confirm_read_cnt != board->read_cnt && t2 < read_deadline)
-        goto do_recv_packet;
+    LL_PRINT_IF(debug, "enqueue_read(%d) : PACKET RECV [SIZE: %d | TRIES: %d | TIME: %llu]\n", board->read_cnt, board->queue_buff_size, i, t2 - t1);
+    if(confirmed) record_rtt(board, t2 - board->read_send_time);
 
     board->read_packet_ptr = board->read_packet;
     board->queue_reads_count = 0;
@@ -871,10 +960,9 @@ static int hm2_eth_write(hm2_lowlevel_io_t *this, rtapi_u32 addr, const void *bu
 }
 
 static int hm2_eth_send_queued_writes(hm2_lowlevel_io_t *this) {
-    int send;
-    long long t0, t1;
     hm2_eth_t *board = this->private;
 
+    if(board->write_pending && !send_write_packet(board)) return 0;
     board->write_cnt++;
     // XXX this is missing a check for exceeding the maximum packet size!
     lbp16_cmd_addr *packet = (lbp16_cmd_addr *) board->write_packet_ptr;
@@ -883,24 +971,24 @@ static int hm2_eth_send_queued_writes(hm2_lowlevel_io_t *this) {
     memcpy(board->write_packet_ptr, &board->write_cnt, 4);
     board->write_packet_ptr += 4;
     board->write_packet_size += (sizeof(*packet) + 4);
-    
-    t0 = rtapi_get_time();
-    send = eth_socket_send(board->sockfd, (void*) &board->write_packet, board->write_packet_size, 0);
-    if(send < 0) {
-        LL_PRINT("ERROR: sending packet: %s\n", strerror(errno));
-        return 0;
+
+    // hold the writes back to go out with the next read request; if no
+    // read request comes before the next writes, they are sent on their
+    // own then (see hm2_eth_enqueue_write)
+    if(board->hal && board->hal->packet_coalesce) {
+        board->write_pending = true;
+        return 1;
     }
-    t1 = rtapi_get_time();
-    LL_PRINT_IF(debug, "enqueue_write(%d) : PACKET SEND [SIZE: %d | TIME: %llu]\n", board->write_cnt, send, t1 - t0);
-    board->write_packet_ptr = board->write_packet;
-    board->write_packet_size = 0;
-    return 1;
+    return send_write_packet(board);
 }
 
 static int hm2_eth_enqueue_write(hm2_lowlevel_io_t *this, rtapi_u32 addr, const void *buffer, int size) {
     hm2_eth_t *board = this->private;
     if (comm_active == 0) return 1;
     if (size == 0) return 1;
+    // writes still held back for a read request that never came go out
+    // now, on their own, so they aren't sent in front of this cycle's
+    if(board->write_pending && !send_write_packet(board)) return 0;
     lbp16_cmd_addr *packet = (lbp16_cmd_addr *) board->write_packet_ptr;
 
     // XXX this is missing a check for exceeding the maximum packet size!
@@ -1184,7 +1272,7 @@ static int hm2_eth_probe(hm2_eth_t *board) {
 }
 
 static int hm2_eth_items(hm2_eth_t *board) {
-    int r;
+    int r, i;
 
     board->hal = hal_malloc(sizeof(*board->hal));
     if(!board->hal) return -ENOMEM;
@@ -1245,6 +1333,56 @@ static int hm2_eth_items(hm2_eth_t *board) {
         return r;
     *board->hal->packet_error_exceeded = 0;
 
+    if((r = hal_param_bit_newf(HAL_RW,
+            &board->hal->packet_coalesce,
+            board->llio.comp_id,
+            "%s.packet-coalesce",
+            board->llio.name)) < 0)
+        return r;
+    board->hal->packet_coalesce = 0;
+
+    if((r = hal_param_s32_newf(HAL_RW,
+            &board->hal->rtt_bucket,
+            board->llio.comp_id,
+            "%s.packet-rtt-bucket",
+            board->llio.name)) < 0)
+        return r;
+    board->hal->rtt_bucket = 25000;
+
+    if((r = hal_pin_s32_newf(HAL_OUT,
+            &board->hal->rtt,
+            board->llio.comp_id,
+            "%s.packet-rtt",
+            board->llio.name)) < 0)
+        return r;
+    *board->hal->rtt = 0;
+
+    if((r = hal_pin_s32_newf(HAL_OUT,
+            &board->hal->rtt_max,
+            board->llio.comp_id,
+            "%s.packet-rtt-max",
+            board->llio.name)) < 0)
+        return r;
+    *board->hal->rtt_max = 0;
+
+    if((r = hal_pin_bit_newf(HAL_IN,
+            &board->hal->rtt_reset,
+            board->llio.comp_id,
+            "%s.packet-rtt-reset",
+            board->llio.name)) < 0)
+        return r;
+    *board->hal->rtt_reset = 0;
+
+    for(i = 0; i < HM2_ETH_RTT_BUCKETS; i++) {
+        if((r = hal_pin_u32_newf(HAL_OUT,
+                &board->hal->rtt_hist[i],
+                board->llio.comp_id,
+                "%s.packet-rtt-hist.%02d",
+                board->llio.name, i)) < 0)
+            return r;
+        *board->hal->rtt_hist[i] = 0;
+    }
+
     return 0;
 }
 
@@ -1289,12 +1427,13 @@ int rtapi_app_main(void) {
 
     for(i = 0; i<num_boards; i++) {
         char ifbuf[64]; // more than enough for eth0
+        boards[i].read_cnt = boards[i].write_cnt = 0;
+        if(boards[i].loopback) continue;
         char *ifptr = fetch_ifname(boards[i].sockfd, ifbuf, sizeof(ifbuf));
         if(!ifptr) {
             LL_PRINT("failed to retrieve interface name for board");
             continue;
         } 
-        boards[i].read_cnt = boards[i].write_cnt = 0;
         int *added = kvlist_lookup(&ifnames, ifptr);
         if(*added) continue;
         install_iptables_perinterface(ifptr);
@@ -29,6 +29,12 @@
 
 #define MAX_ETH_READS 64
 
+// datagrams taken from the socket by one receive call
+#define MAX_ETH_RECV_PACKETS 4
+
+// buckets in the packet-rtt-hist pins
+#define HM2_ETH_RTT_BUCKETS 16
+
 typedef struct {
     void *buffer;
     int size;
@@ -51,6 +57,10 @@ typedef struct {
     rtapi_u8 write_packet[1400];
     rtapi_u8 *write_packet_ptr;
     int write_packet_size;
+    // with packet-coalesce, the queued writes wait to go out in the same
+    // packet as the next read request
+    bool write_pending;
+    long long read_send_time;
     uint32_t read_cnt, write_cnt;
     // these two fields must be kept together, they're read by a single
     // read-request
@@ -59,15 +69,24 @@ typedef struct {
     int comm_error_counter;
     uint16_t old_rxudpcount, rxudpcount;
     struct arpreq req;
+    // a board on 127.0.0.0/8 is a software emulator; it gets no arp
+    // entry and no iptables rules
+    bool loopback;
 
     struct {
         hal_s32_t read_timeout;
         hal_s32_t packet_error_limit;
         hal_s32_t packet_error_increment;
         hal_s32_t packet_error_decrement;
+        hal_bit_t packet_coalesce;
+        hal_s32_t rtt_bucket;
         hal_bit_t *packet_error;
         hal_s32_t *packet_error_level;
         hal_bit_t *packet_error_exceeded;
+        hal_s32_t *rtt;
+        hal_s32_t *rtt_max;
+        hal_bit_t *rtt_reset;
+        hal_u32_t *rtt_hist[HM2_ETH_RTT_BUCKETS];
     } *hal;
 } hm2_eth_t;
 
@@ -0,0 +1,477 @@
+/*    This is a component of LinuxCNC
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+//
+//  hm2_eth_emu answers LBP16 on a UDP socket the way a Mesa ethernet
+//  board does, so hm2_eth can be loaded and timed without hardware:
+//
+//      hm2_eth_emu &
+//      halcmd loadrt hm2_eth board_ip=127.0.0.1
+//
+//  It presents a 7I76E or 7I96 board name and a HostMot2 IDROM with a
+//  watchdog, IOPorts, LEDs, stepgens and encoders.  Behind the IDROM is
+//  a plain register file with just enough behaviour for the driver to
+//  see a live board: the stepgen accumulators advance at the commanded
+//  rates, encoder N counts the steps of stepgen N, GPIO outputs read
+//  back on their pins, and the watchdog bites (and stops the stepgens)
+//  if it isn't reset in time.  The pin layout is not that of the real
+//  firmware.
+//
+//  Replies can be delayed by a fixed latency plus random jitter, and
+//  requests and replies can be dropped, to see how the driver copes.
+//
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "rtapi.h"
+#include "hostmot2.h"
+#include "lbp16.h"
+
+#define EMU_IDROM_ADDR      0x0400
+#define EMU_MD_OFFSET       0x0040
+#define EMU_PD_OFFSET       0x0200
+
+#define EMU_LED_ADDR        0x0200
+#define EMU_WATCHDOG_ADDR   0x0C00
+#define EMU_IOPORT_ADDR     0x1000
+#define EMU_STEPGEN_ADDR    0x2000
+#define EMU_ENCODER_ADDR    0x3000
+
+#define EMU_REGISTER_STRIDE 0x100
+#define EMU_INSTANCE_STRIDE 4
+
+#define EMU_PORTS           3
+#define EMU_PORT_WIDTH      17
+#define EMU_PINS            (EMU_PORTS * EMU_PORT_WIDTH)
+#define EMU_MAX_STEPGENS    16
+#define EMU_MAX_ENCODERS    8
+
+// comm control space: number of packets received
+#define EMU_RXUDPCOUNT      0x08
+// ethernet eeprom: where the MAC address is kept, low byte first
+#define EMU_EEPROM_MAC      0x02
+
+static struct {
+    const char *name;
+    char board_name[16];
+    char idrom_name[8];
+} boards[] = {
+    { "7i76e", "7I76E-16", "MESA7I76" },
+    { "7i96",  "7I96",     "MESA7I96" },
+};
+
+static struct {
+    uint8_t mem[LBP16_MEM_SPACE_COUNT][0x10000];
+    uint16_t addr[LBP16_MEM_SPACE_COUNT];
+
+    int num_stepgens, num_encoders;
+    uint32_t clock_low, clock_high;
+
+    uint32_t gpio_out[EMU_PORTS];
+    int64_t stepgen_acc[EMU_MAX_STEPGENS];
+    uint64_t clocks;
+    struct timespec start, last, last_pet;
+    int bitten;
+} emu;
+
+static int verbose;
+static volatile sig_atomic_t done;
+static unsigned long packets_in, replies_out, requests_lost, replies_lost;
+
+static void set32(uint16_t addr, uint32_t val) {
+    memcpy(&emu.mem[0][addr], &val, 4);
+}
+
+static uint32_t get32(uint16_t addr) {
+    uint32_t val;
+    memcpy(&val, &emu.mem[0][addr], 4);
+    return val;
+}
+
+static int64_t ns_between(const struct timespec *a, const struct timespec *b) {
+    return (b->tv_sec - a->tv_sec) * 1000000000LL + (b->tv_nsec - a->tv_nsec);
+}
+
+static void set_md(int index, int gtag, int version, int instances,
+        int base, int num_registers, uint32_t multiple_registers) {
+    uint16_t addr = EMU_IDROM_ADDR + EMU_MD_OFFSET + index * 12;
+    // everything runs from ClockLow and uses stride selector 0
+    set32(addr, gtag | (version << 8) | (1 << 16) | (instances << 24));
+    set32(addr + 4, base | (num_registers << 16));
+    set32(addr + 8, multiple_registers);
+}
+
+static void set_pd(int pin, int sec_tag, int sec_unit, int sec_pin) {
+    uint16_t addr = EMU_IDROM_ADDR + EMU_PD_OFFSET + pin * 4;
+    set32(addr, sec_pin | (sec_tag << 8) | (sec_unit << 16) | (HM2_GTAG_IOPORT << 24));
+}
+
+static void build_board(int board) {
+    uint16_t base = EMU_IDROM_ADDR;
+    int i, md = 0, pin = 0;
+    static const uint8_t mac[6] = { 0x00, 0x60, 0x1b, 0x00, 0x00, 0x01 };
+
+    memcpy(&emu.mem[LBP16_SPACE_BOARD_INFO >> 10][0], boards[board].board_name, 16);
+    for (i = 0; i < 6; i++)
+        emu.mem[LBP16_SPACE_ETH_EEPROM >> 10][EMU_EEPROM_MAC + i] = mac[5 - i];
+
+    set32(HM2_ADDR_IOCOOKIE, HM2_IOCOOKIE);
+    memcpy(&emu.mem[0][HM2_ADDR_CONFIGNAME], HM2_CONFIGNAME, HM2_CONFIGNAME_LENGTH);
+    set32(HM2_ADDR_IDROM_OFFSET, EMU_IDROM_ADDR);
+
+    set32(base + offsetof(hm2_idrom_t, idrom_type), 3);
+    set32(base + offsetof(hm2_idrom_t, offset_to_modules), EMU_MD_OFFSET);
+    set32(base + offsetof(hm2_idrom_t, offset_to_pin_desc), EMU_PD_OFFSET);
+    memcpy(&emu.mem[0][base + offsetof(hm2_idrom_t, board_name)], boards[board].idrom_name, 8);
+    set32(base + offsetof(hm2_idrom_t, fpga_size), 9);
+    set32(base + offsetof(hm2_idrom_t, fpga_pins), 144);
+    set32(base + offsetof(hm2_idrom_t, io_ports), EMU_PORTS);
+    set32(base + offsetof(hm2_idrom_t, io_width), EMU_PINS);
+    set32(base + offsetof(hm2_idrom_t, port_width), EMU_PORT_WIDTH);
+    set32(base + offsetof(hm2_idrom_t, clock_low), emu.clock_low);
+    set32(base + offsetof(hm2_idrom_t, clock_high), emu.clock_high);
+    set32(base + offsetof(hm2_idrom_t, instance_stride_0), EMU_INSTANCE_STRIDE);
+    set32(base + offsetof(hm2_idrom_t, instance_stride_1), 0x40);
+    set32(base + offsetof(hm2_idrom_t, register_stride_0), EMU_REGISTER_STRIDE);
+    set32(base + offsetof(hm2_idrom_t, register_stride_1), 4);
+
+    // versions and register counts are the ones the driver accepts
+    set_md(md++, HM2_GTAG_WATCHDOG, 0, 1, EMU_WATCHDOG_ADDR, 3, 0);
+    set_md(md++, HM2_GTAG_IOPORT, 0, EMU_PORTS, EMU_IOPORT_ADDR, 5, 0x1F);
+    if (emu.num_encoders)
+        set_md(md++, HM2_GTAG_ENCODER, 3, emu.num_encoders, EMU_ENCODER_ADDR, 5, 0x03);
+    if (emu.num_stepgens)
+        set_md(md++, HM2_GTAG_STEPGEN, 2, emu.num_stepgens, EMU_STEPGEN_ADDR, 10, 0x1FF);
+    set_md(md++, HM2_GTAG_LED, 0, 1, EMU_LED_ADDR, 1, 0);
+    // the zeroed register file already holds the end-of-list sentinel
+
+    // the watchdog is asleep until the driver sets a timeout
+    set32(EMU_WATCHDOG_ADDR, 0x80000000);
+
+    for (i = 0; i < emu.num_stepgens; i++) {
+        set_pd(pin++, HM2_GTAG_STEPGEN, i, 0x81);
+        set_pd(pin++, HM2_GTAG_STEPGEN, i, 0x82);
+    }
+    for (i = 0; i < emu.num_encoders; i++) {
+        set_pd(pin++, HM2_GTAG_ENCODER, i, 0x01);
+        set_pd(pin++, HM2_GTAG_ENCODER, i, 0x02);
+        set_pd(pin++, HM2_GTAG_ENCODER, i, 0x03);
+    }
+    while (pin < EMU_PINS)
+        set_pd(pin++, 0, 0, 0);
+}
+
+// bring the moving parts of the board up to the time a packet arrived
+static void advance(const struct timespec *now) {
+    uint64_t clocks = (double)ns_between(&emu.start, now) * emu.clock_low / 1e9;
+    int64_t elapsed = clocks - emu.clocks;
+    uint32_t timer = get32(EMU_WATCHDOG_ADDR);
+    uint32_t ts_div, ts;
+    int i;
+
+    emu.clocks = clocks;
+    emu.last = *now;
+
+    if (!emu.bitten && !(timer & 0x80000000)
+            && (double)ns_between(&emu.last_pet, now) * emu.clock_low / 1e9 > timer + 1.) {
+        emu.bitten = 1;
+        set32(EMU_WATCHDOG_ADDR + EMU_REGISTER_STRIDE, 1);
+        if (verbose) fprintf(stderr, "hm2_eth_emu: watchdog bit\n");
+    }
+
+    for (i = 0; i < emu.num_stepgens; i++) {
+        int32_t rate = get32(EMU_STEPGEN_ADDR + i * EMU_INSTANCE_STRIDE);
+        if (!emu.bitten)
+            emu.stepgen_acc[i] += (int64_t)rate * elapsed;
+        set32(EMU_STEPGEN_ADDR + EMU_REGISTER_STRIDE + i * EMU_INSTANCE_STRIDE,
+                (uint32_t)(emu.stepgen_acc[i] >> 16));
+    }
+
+    ts_div = get32(EMU_ENCODER_ADDR + 2 * EMU_REGISTER_STRIDE) & 0xFFFF;
+    ts = (clocks / (ts_div + 2)) & 0xFFFF;
+    set32(EMU_ENCODER_ADDR + 3 * EMU_REGISTER_STRIDE, ts);
+    for (i = 0; i < emu.num_encoders; i++) {
+        uint32_t count = i < emu.num_stepgens ? (uint32_t)(emu.stepgen_acc[i] >> 32) : 0;
+        set32(EMU_ENCODER_ADDR + i * EMU_INSTANCE_STRIDE, (count & 0xFFFF) | (ts << 16));
+    }
+
+    // outputs read back their value, inputs float high
+    for (i = 0; i < EMU_PORTS; i++) {
+        uint32_t ddr = get32(EMU_IOPORT_ADDR + EMU_REGISTER_STRIDE + i * EMU_INSTANCE_STRIDE);
+        set32(EMU_IOPORT_ADDR + i * EMU_INSTANCE_STRIDE,
+                ((emu.gpio_out[i] & ddr) | ~ddr) & ((1u << EMU_PORT_WIDTH) - 1));
+    }
+}
+
+static void hm2_write32(uint16_t addr, uint32_t val) {
+    if (addr >= EMU_IOPORT_ADDR && addr < EMU_IOPORT_ADDR + EMU_PORTS * EMU_INSTANCE_STRIDE) {
+        emu.gpio_out[(addr - EMU_IOPORT_ADDR) / EMU_INSTANCE_STRIDE] = val;
+        return;
+    }
+    if (addr == EMU_WATCHDOG_ADDR + 2 * EMU_REGISTER_STRIDE) {
+        emu.last_pet = emu.last;
+    } else if (addr == EMU_WATCHDOG_ADDR + EMU_REGISTER_STRIDE) {
+        // clearing has-bit restarts the watchdog
+        if (!(val & 1) && emu.bitten) {
+            emu.bitten = 0;
+            emu.last_pet = emu.last;
+        }
+    } else if (addr == EMU_WATCHDOG_ADDR) {
+        emu.last_pet = emu.last;
+    } else if (addr >= EMU_STEPGEN_ADDR + EMU_REGISTER_STRIDE
+            && addr < EMU_STEPGEN_ADDR + EMU_REGISTER_STRIDE + emu.num_stepgens * EMU_INSTANCE_STRIDE) {
+        // the accumulators can't be written
+        return;
+    }
+    set32(addr, val);
+}
+
+// carry out the commands in one request; returns the size of the reply
+static int process(const uint8_t *req, int len, uint8_t *reply, int reply_size) {
+    int pos = 0, out = 0;
+
+    while (pos + LBP16_CMD_SIZE <= len) {
+        uint16_t cmd = req[pos] | (req[pos + 1] << 8);
+        int space = (cmd >> 10) & 7;
+        int width = 1 << ((cmd >> 8) & 3);
+        int count = cmd & LBP16_MAX_PACKET_DATA_SIZE;
+        int i, j;
+        uint16_t addr;
+
+        pos += LBP16_CMD_SIZE;
+        if (cmd & LBP16_ADDR) {
+            if (pos + LBP16_ADDR_SIZE > len) break;
+            addr = req[pos] | (req[pos + 1] << 8);
+            pos += LBP16_ADDR_SIZE;
+        } else {
+            addr = emu.addr[space];
+        }
+
+        if (!(cmd & LBP16_WRITE) && out + count * width > reply_size) break;
+
+        if (cmd & LBP16_INFO_ACC) {
+            // memory area info isn't used by hm2_eth; read as zeros
+            if (!(cmd & LBP16_WRITE)) {
+                memset(reply + out, 0, count * width);
+                out += count * width;
+            } else {
+                pos += count * width;
+            }
+            continue;
+        }
+
+        for (i = 0; i < count; i++) {
+            if (cmd & LBP16_WRITE) {
+                if (pos + width > len) return out;
+                if (space == 0 && width == 4) {
+                    uint32_t val;
+                    memcpy(&val, req + pos, 4);
+                    hm2_write32(addr, val);
+                } else {
+                    for (j = 0; j < width; j++)
+                        emu.mem[space][(uint16_t)(addr + j)] = req[pos + j];
+                }
+                pos += width;
+            } else {
+                for (j = 0; j < width; j++)
+                    reply[out++] = emu.mem[space][(uint16_t)(addr + j)];
+            }
+            if (cmd & LBP16_ADDR_AUTO_INC)
+                addr += width;
+        }
+        emu.addr[space] = addr;
+    }
+    return out;
+}
+
+static int lost(double percent) {
+    return percent > 0 && drand48() * 100. < percent;
+}
+
+static void wait_until(const struct timespec *t) {
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, t, NULL) == EINTR && !done)
+        ;
+}
+
+static void quit(int sig) {
+    done = 1;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+"Usage: hm2_eth_emu [options]\n"
+"Answer LBP16 requests like a Mesa ethernet board, for hm2_eth tests.\n"
+"  -a ADDRESS   address to listen on (default 127.0.0.1)\n"
+"  -b BOARD     board to present: 7i76e or 7i96 (default 7i76e)\n"
+"  -s N         number of stepgens (default 5)\n"
+"  -e N         number of encoders (default 1)\n"
+"  -l USEC      delay every reply by USEC microseconds\n"
+"  -j USEC      and by up to USEC more, at random\n"
+"  -p PERCENT   lose this percentage of requests, and of replies\n"
+"  -v           report lost packets and watchdog bites\n");
+}
+
+int main(int argc, char **argv) {
+    const char *address = "127.0.0.1";
+    double latency = 0, jitter = 0, loss = 0;
+    int board = 0, sockfd, opt, i;
+    struct sockaddr_in addr;
+    struct sigaction sa;
+    uint8_t req[1500], reply[0x10000];
+
+    emu.num_stepgens = 5;
+    emu.num_encoders = 1;
+    emu.clock_low = 100000000;
+    emu.clock_high = 200000000;
+
+    while ((opt = getopt(argc, argv, "a:b:s:e:l:j:p:vh")) != -1) {
+        switch (opt) {
+        case 'a': address = optarg; break;
+        case 'b':
+            for (board = 0; board < (int)(sizeof(boards) / sizeof(boards[0])); board++)
+                if (strcasecmp(optarg, boards[board].name) == 0) break;
+            if (board == (int)(sizeof(boards) / sizeof(boards[0]))) {
+                fprintf(stderr, "hm2_eth_emu: unknown board '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 's': emu.num_stepgens = atoi(optarg); break;
+        case 'e': emu.num_encoders = atoi(optarg); break;
+        case 'l': latency = atof(optarg); break;
+        case 'j': jitter = atof(optarg); break;
+        case 'p': loss = atof(optarg); break;
+        case 'v': verbose = 1; break;
+        default: usage(); return opt != 'h';
+        }
+    }
+
+    if (emu.num_stepgens < 0 || emu.num_stepgens > EMU_MAX_STEPGENS
+            || emu.num_encoders < 0 || emu.num_encoders > EMU_MAX_ENCODERS
+            || 2 * emu.num_stepgens + 3 * emu.num_encoders > EMU_PINS) {
+        fprintf(stderr, "hm2_eth_emu: %d stepgens and %d encoders don't fit on %d pins\n",
+                emu.num_stepgens, emu.num_encoders, EMU_PINS);
+        return 1;
+    }
+
+    sockfd = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sockfd < 0) {
+        perror("hm2_eth_emu: socket");
+        return 1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(LBP16_UDP_PORT);
+    if (inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+        fprintf(stderr, "hm2_eth_emu: bad address '%s'\n", address);
+        return 1;
+    }
+    if (bind(sockfd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("hm2_eth_emu: bind");
+        return 1;
+    }
+
+    build_board(board);
+    clock_gettime(CLOCK_MONOTONIC, &emu.start);
+    emu.last = emu.last_pet = emu.start;
+    srand48(emu.start.tv_nsec);
+
+    // no SA_RESTART, so a signal gets us out of recvfrom()
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = quit;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    fprintf(stderr, "hm2_eth_emu: %s with %d stepgens and %d encoders on %s:%d\n",
+            boards[board].board_name, emu.num_stepgens, emu.num_encoders,
+            address, LBP16_UDP_PORT);
+
+    while (!done) {
+        struct sockaddr_in from;
+        socklen_t fromlen = sizeof(from);
+        struct timespec now;
+        int len, out;
+
+        len = recvfrom(sockfd, req, sizeof(req), 0, (struct sockaddr *)&from, &fromlen);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            perror("hm2_eth_emu: recvfrom");
+            return 1;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        packets_in++;
+
+        if (lost(loss)) {
+            requests_lost++;
+            if (verbose) fprintf(stderr, "hm2_eth_emu: lost request %lu\n", packets_in);
+            continue;
+        }
+
+        {
+            uint16_t *rxudpcount = (uint16_t *)&emu.mem[LBP16_SPACE_COMM_CTRL >> 10][EMU_RXUDPCOUNT];
+            (*rxudpcount)++;
+        }
+        advance(&now);
+        out = process(req, len, reply, sizeof(reply));
+        if (out == 0) continue;
+
+        if (lost(loss)) {
+            replies_lost++;
+            if (verbose) fprintf(stderr, "hm2_eth_emu: lost reply %lu\n", packets_in);
+            continue;
+        }
+
+        if (latency > 0 || jitter > 0) {
+            long long ns = (latency + drand48() * jitter) * 1000;
+            now.tv_sec += ns / 1000000000;
+            now.tv_nsec += ns % 1000000000;
+            if (now.tv_nsec >= 1000000000) {
+                now.tv_sec++;
+                now.tv_nsec -= 1000000000;
+            }
+            wait_until(&now);
+        }
+
+        if (sendto(sockfd, reply, out, 0, (struct sockaddr *)&from, fromlen) < 0) {
+            perror("hm2_eth_emu: sendto");
+            continue;
+        }
+        replies_out++;
+    }
+
+    fprintf(stderr, "hm2_eth_emu: %lu requests, %lu replies, %lu requests and %lu replies lost\n",
+            packets_in, replies_out, requests_lost, replies_lost);
+    if (verbose) {
+        for (i = 0; i < emu.num_stepgens; i++)
+            fprintf(stderr, "hm2_eth_emu: stepgen %d at %lld steps\n",
+                    i, (long long)(emu.stepgen_acc[i] >> 32));
+    }
+    close(sockfd);
+    return 0;
+}
@@ -661,6 +661,15 @@ extern int hal_export_funct(const char *name, void (*funct) (void *, long),
 extern int hal_create_thread(const char *name, unsigned long period_nsec,
     int uses_fp);
 
+/** hal_create_thread_cpu() is hal_create_thread() for a thread that
+    must run on a particular CPU, such as one set aside for it with
+    isolcpus.  'cpu_id' is the number of the CPU, or RTAPI_DEFAULT_CPU
+    for the CPU hal_create_thread() would use.  Fails if that CPU is
+    not available.
+*/
+extern int hal_create_thread_cpu(const char *name, unsigned long period_nsec,
+    int uses_fp, int cpu_id);
+
 /** hal_thread_delete() deletes a realtime thread.
     'name' is the name of the thread, which must have been created
     by 'hal_create_thread()'.
@@ -671,6 +680,18 @@ extern int hal_create_thread(const char *name, unsigned long period_nsec,
 */
 extern int hal_thread_delete(const char *name);
 
+/** hal_thread_add_worker() gives a thread a worker task on CPU
+    'cpu_id' (or RTAPI_DEFAULT_CPU).  Each period the workers help
+    the thread run its parallel groups; see
+    hal_add_funct_to_thread_group().  Workers run with the period and
+    priority of their thread, and are deleted with it.  A thread can
+    have up to eight workers.
+    Returns 0, or a negative error code.
+    Call only from realtime init code, not from user
+    space or realtime code.
+*/
+extern int hal_thread_add_worker(const char *name, int cpu_id);
+
 #endif /* RTAPI */
 
 /** hal_add_funct_to_thread() adds a function exported by a
@@ -697,6 +718,22 @@ extern int hal_thread_delete(const char *name);
 extern int hal_add_funct_to_thread(const char *funct_name, const char *thread_name,
     int position);
 
+/** hal_add_funct_to_thread_group() is hal_add_funct_to_thread() for a
+    function that belongs to parallel group 'group'.  Functions next to
+    each other in a thread with the same non-zero group number form a
+    parallel group: if the thread has workers, they may run at the same
+    time, in any order, on different CPUs, and the thread goes on to
+    the next function only when all of them have finished.  Functions
+    in a group must not use each other's outputs, or share any other
+    data.  Without workers, or with 'group' zero, functions run one
+    after another as usual.
+    Returns 0, or a negative error code.    Call
+    only from within user space or init code, not from
+    realtime code.
+*/
+extern int hal_add_funct_to_thread_group(const char *funct_name,
+    const char *thread_name, int position, int group);
+
 /** hal_del_funct_from_thread() removes a function from a thread.
     'funct_name' is the name of the function, as specified in
     a call to hal_export_funct().
@@ -869,12 +906,19 @@ extern int hal_stream_depth(hal_stream_t *stream);
 extern int hal_stream_maxdepth(hal_stream_t *stream);
 extern int hal_stream_num_underruns(hal_stream_t *stream);
 extern int hal_stream_num_overruns(hal_stream_t *stream);
+/** read up to 'count' samples into consecutive records of 'buf', and
+    their sample numbers into 'sampleno' unless it is NULL; returns the
+    number read, which is 0 and not an underrun if there were none */
+extern int hal_stream_read_many(hal_stream_t *stream, union hal_stream_data *buf, unsigned *sampleno, int count);
 #ifdef ULAPI
 extern void hal_stream_wait_readable(hal_stream_t *stream, sig_atomic_t *stop);
 #endif
 
 extern int hal_stream_write(hal_stream_t *stream, union hal_stream_data *buf);
 extern bool hal_stream_writable(hal_stream_t *stream);
+/** write as many as fit of the 'count' consecutive records in 'buf';
+    returns the number written, without counting overruns */
+extern int hal_stream_write_many(hal_stream_t *stream, union hal_stream_data *buf, int count);
 #ifdef ULAPI
 extern void hal_stream_wait_writable(hal_stream_t *stream, sig_atomic_t *stop);
 #endif
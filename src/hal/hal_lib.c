@@ -151,12 +151,37 @@ static void free_funct_entry_struct(hal_funct_entry_t * funct_entry);
 static void free_thread_struct(hal_thread_t * thread);
 #endif /* RTAPI */
 
+/** The index_xxx() and unindex_xxx() functions add and remove an
+    object (and the original name of an aliased pin or param) to and
+    from the name index used by the find_xxx_by_name() functions.
+    They must be called whenever an object is added to or removed from
+    its list, or renamed.  Removing an object that is not in the index
+    is harmless.  Unindexing also drops the object as the insertion
+    hint for its list.
+*/
+static void index_pin(hal_pin_t * pin);
+static void unindex_pin(hal_pin_t * pin);
+static void index_sig(hal_sig_t * sig);
+static void unindex_sig(hal_sig_t * sig);
+static void index_param(hal_param_t * param);
+static void unindex_param(hal_param_t * param);
+#ifdef RTAPI
+static void index_funct(hal_funct_t * funct);
+static void unindex_funct(hal_funct_t * funct);
+#endif /* RTAPI */
+
 #ifdef RTAPI
 /** 'thread_task()' is a function that is invoked as a realtime task.
     It implements a thread, by running down the thread's function list
     and calling each function in turn.
 */
 static void thread_task(void *arg);
+
+/** 'worker_task()' is the realtime task of a worker added to a thread
+    by hal_thread_add_worker().  It helps the thread run the functions
+    of its parallel groups.
+*/
+static void worker_task(void *arg);
 #endif /* RTAPI */
 
 /***********************************************************************
@@ -712,14 +737,24 @@ int hal_pin_new(const char *name, hal_type_t type, hal_pin_dir_t dir,
     rtapi_snprintf(new->name, sizeof(new->name), "%s", name);
     /* make 'data_ptr' point to dummy signal */
     *data_ptr_addr = comp->shmem_base + SHMOFF(&(new->dummysig));
-    /* search list for 'name' and insert new structure */
+    /* search list for 'name' and insert new structure.  Components
+       usually create pins in name order, so start after the last pin
+       inserted if it sorts before this one */
     prev = &(hal_data->pin_list_ptr);
+    if (hal_data->pin_insert_hint != 0) {
+	ptr = SHMPTR(hal_data->pin_insert_hint);
+	if (strcmp(ptr->name, new->name) < 0) {
+	    prev = &(ptr->next_ptr);
+	}
+    }
     next = *prev;
     while (1) {
 	if (next == 0) {
 	    /* reached end of list, insert here */
 	    new->next_ptr = next;
 	    *prev = SHMOFF(new);
+	    index_pin(new);
+	    hal_data->pin_insert_hint = SHMOFF(new);
 	    rtapi_mutex_give(&(hal_data->mutex));
 	    return 0;
 	}
@@ -729,6 +764,8 @@ int hal_pin_new(const char *name, hal_type_t type, hal_pin_dir_t dir,
 	    /* found the right place for it, insert here */
 	    new->next_ptr = next;
 	    *prev = SHMOFF(new);
+	    index_pin(new);
+	    hal_data->pin_insert_hint = SHMOFF(new);
 	    rtapi_mutex_give(&(hal_data->mutex));
 	    return 0;
 	}
@@ -824,6 +861,8 @@ int hal_pin_alias(const char *pin_name, const char *alias)
 	prev = &(pin->next_ptr);
 	next = *prev;
     }
+    /* names are about to change, take it out of the index too */
+    unindex_pin(pin);
     if ( alias != NULL ) {
 	/* adding a new alias */
 	if ( pin->oldname == 0 ) {
@@ -852,6 +891,7 @@ int hal_pin_alias(const char *pin_name, const char *alias)
 	    /* reached end of list, insert here */
 	    pin->next_ptr = next;
 	    *prev = SHMOFF(pin);
+	    index_pin(pin);
 	    rtapi_mutex_give(&(hal_data->mutex));
 	    return 0;
 	}
@@ -861,6 +901,7 @@ int hal_pin_alias(const char *pin_name, const char *alias)
 	    /* found the right place for it, insert here */
 	    pin->next_ptr = next;
 	    *prev = SHMOFF(pin);
+	    index_pin(pin);
 	    rtapi_mutex_give(&(hal_data->mutex));
 	    return 0;
 	}
@@ -971,14 +1012,23 @@ with the C standard.
     new->writers = 0;
     new->bidirs = 0;
     rtapi_snprintf(new->name, sizeof(new->name), "%s", name);
-    /* search list for 'name' and insert new structure */
+    /* search list for 'name' and insert new structure, starting after
+       the last signal inserted if it sorts before this one */
     prev = &(hal_data->sig_list_ptr);
+    if (hal_data->sig_insert_hint != 0) {
+	ptr = SHMPTR(hal_data->sig_insert_hint);
+	if (strcmp(ptr->name, new->name) < 0) {
+	    prev = &(ptr->next_ptr);
+	}
+    }
     next = *prev;
     while (1) {
 	if (next == 0) {
 	    /* reached end of list, insert here */
 	    new->next_ptr = next;
 	    *prev = SHMOFF(new);
+	    index_sig(new);
+	    hal_data->sig_insert_hint = SHMOFF(new);
 	    rtapi_mutex_give(&(hal_data->mutex));
 	    return 0;
 	}
@@ -988,6 +1038,8 @@ with the C standard.
 	    /* found the right place for it, insert here */
 	    new->next_ptr = next;
 	    *prev = SHMOFF(new);
+	    index_sig(new);
+	    hal_data->sig_insert_hint = SHMOFF(new);
 	    rtapi_mutex_give(&(hal_data->mutex));
 	    return 0;
 	}
@@ -1416,14 +1468,23 @@ int hal_param_new(const char *name, hal_type_t type, hal_param_dir_t dir, void *
     new->type = type;
     new->dir = dir;
     rtapi_snprintf(new->name, sizeof(new->name), "%s", name);
-    /* search list for 'name' and insert new structure */
+    /* search list for 'name' and insert new structure, starting after
+       the last param inserted if it sorts before this one */
     prev = &(hal_data->param_list_ptr);
+    if (hal_data->param_insert_hint != 0) {
+	ptr = SHMPTR(hal_data->param_insert_hint);
+	if (strcmp(ptr->name, new->name) < 0) {
+	    prev = &(ptr->next_ptr);
+	}
+    }
     next = *prev;
     while (1) {
 	if (next == 0) {
 	    /* reached end of list, insert here */
 	    new->next_ptr = next;
 	    *prev = SHMOFF(new);
+	    index_param(new);
+	    hal_data->param_insert_hint = SHMOFF(new);
 	    rtapi_mutex_give(&(hal_data->mutex));
 	    return 0;
 	}
@@ -1433,6 +1494,8 @@ int hal_param_new(const char *name, hal_type_t type, hal_param_dir_t dir, void *
 	    /* found the right place for it, insert here */
 	    new->next_ptr = next;
 	    *prev = SHMOFF(new);
+	    index_param(new);
+	    hal_data->param_insert_hint = SHMOFF(new);
 	    rtapi_mutex_give(&(hal_data->mutex));
 	    return 0;
 	}
@@ -1626,6 +1689,8 @@ int hal_param_alias(const char *param_name, const char *alias)
 	prev = &(param->next_ptr);
 	next = *prev;
     }
+    /* names are about to change, take it out of the index too */
+    unindex_param(param);
     if ( alias != NULL ) {
 	/* adding a new alias */
 	if ( param->oldname == 0 ) {
@@ -1654,6 +1719,7 @@ int hal_param_alias(const char *param_name, const char *alias)
 	    /* reached end of list, insert here */
 	    param->next_ptr = next;
 	    *prev = SHMOFF(param);
+	    index_param(param);
 	    rtapi_mutex_give(&(hal_data->mutex));
 	    return 0;
 	}
@@ -1663,6 +1729,7 @@ int hal_param_alias(const char *param_name, const char *alias)
 	    /* found the right place for it, insert here */
 	    param->next_ptr = next;
 	    *prev = SHMOFF(param);
+	    index_param(param);
 	    rtapi_mutex_give(&(hal_data->mutex));
 	    return 0;
 	}
@@ -1754,6 +1821,7 @@ int hal_export_funct(const char *name, void (*funct) (void *, long),
 	    /* reached end of list, insert here */
 	    new->next_ptr = next;
 	    *prev = SHMOFF(new);
+	    index_funct(new);
 	    /* break out of loop and init the new function */
 	    break;
 	}
@@ -1763,6 +1831,7 @@ int hal_export_funct(const char *name, void (*funct) (void *, long),
 	    /* found the right place for it, insert here */
 	    new->next_ptr = next;
 	    *prev = SHMOFF(new);
+	    index_funct(new);
 	    /* break out of loop and init the new function */
 	    break;
 	}
@@ -1806,6 +1875,13 @@ int hal_export_funct(const char *name, void (*funct) (void *, long),
 }
 
 int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
+{
+    return hal_create_thread_cpu(name, period_nsec, uses_fp,
+	RTAPI_DEFAULT_CPU);
+}
+
+int hal_create_thread_cpu(const char *name, unsigned long period_nsec,
+    int uses_fp, int cpu_id)
 {
     int next, cmp, prev_priority;
     int retval, n;
@@ -1814,7 +1890,8 @@ int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
     char buf[HAL_NAME_LEN + 1];
 
     rtapi_print_msg(RTAPI_MSG_DBG,
-	"HAL: creating thread %s, %ld nsec\n", name, period_nsec);
+	"HAL: creating thread %s, %ld nsec, cpu %d\n", name, period_nsec,
+	cpu_id);
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: create_thread called before init\n");
@@ -1865,6 +1942,7 @@ int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
     }
     /* initialize the structure */
     new->uses_fp = uses_fp;
+    new->cpu_id = cpu_id;
     rtapi_snprintf(new->name, sizeof(new->name), "%s", name);
     /* have to create and start a task to run the thread */
     if (hal_data->thread_list_ptr == 0) {
@@ -1926,11 +2004,17 @@ int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
     new->priority = rtapi_prio_next_lower(prev_priority);
     /* create task - owned by library module, not caller */
     retval = rtapi_task_new(thread_task, new, new->priority,
-	lib_module_id, HAL_STACKSIZE, uses_fp);
+	lib_module_id, HAL_STACKSIZE, uses_fp, cpu_id);
     if (retval < 0) {
 	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL_LIB: could not create task for thread %s\n", name);
+	if (cpu_id != RTAPI_DEFAULT_CPU) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL_LIB: could not create task for thread %s on cpu %d\n",
+		name, cpu_id);
+	} else {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL_LIB: could not create task for thread %s\n", name);
+	}
 	return -EINVAL;
     }
     new->task_id = retval;
@@ -2025,9 +2109,73 @@ extern int hal_thread_delete(const char *name)
     return -EINVAL;
 }
 
+int hal_thread_add_worker(const char *name, int cpu_id)
+{
+    hal_thread_t *thread;
+    int task_id, retval;
+
+    if (hal_data == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread_add_worker called before init\n");
+	return -EINVAL;
+    }
+    if (hal_data->lock & HAL_LOCK_CONFIG) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread_add_worker called while HAL is locked\n");
+	return -EPERM;
+    }
+    rtapi_print_msg(RTAPI_MSG_DBG,
+	"HAL: adding worker on cpu %d to thread '%s'\n", cpu_id, name);
+    /* get mutex before accessing data structures */
+    rtapi_mutex_get(&(hal_data->mutex));
+    thread = halpr_find_thread_by_name(name);
+    if (thread == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread '%s' not found\n", name);
+	return -EINVAL;
+    }
+    if (thread->num_workers >= HAL_MAX_WORKERS) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread '%s' already has %d workers\n", name,
+	    HAL_MAX_WORKERS);
+	return -EINVAL;
+    }
+    /* the worker runs at the priority and period of its thread, only
+       on another CPU; owned by library module, not caller */
+    task_id = rtapi_task_new(worker_task, thread, thread->priority,
+	lib_module_id, HAL_STACKSIZE, thread->uses_fp, cpu_id);
+    if (task_id < 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL_LIB: could not create worker for thread %s on cpu %d\n",
+	    name, cpu_id);
+	return -EINVAL;
+    }
+    retval = rtapi_task_start(task_id, thread->period);
+    if (retval < 0) {
+	rtapi_task_delete(task_id);
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL_LIB: could not start worker for thread %s: %d\n", name,
+	    retval);
+	return -EINVAL;
+    }
+    thread->worker_task_id[thread->num_workers++] = task_id;
+    rtapi_mutex_give(&(hal_data->mutex));
+    return 0;
+}
+
 #endif /* RTAPI */
 
 int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int position)
+{
+    return hal_add_funct_to_thread_group(funct_name, thread_name, position, 0);
+}
+
+int hal_add_funct_to_thread_group(const char *funct_name,
+    const char *thread_name, int position, int group)
 {
     hal_thread_t *thread;
     hal_funct_t *funct;
@@ -2059,6 +2207,11 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: bad position: 0\n");
 	return -EINVAL;
     }
+    if (group < 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: bad group: %d\n", group);
+	return -EINVAL;
+    }
     /* make sure we were given a function name */
     if (funct_name == 0) {
 	/* no name supplied */
@@ -2151,6 +2304,7 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
     funct_entry->funct_ptr = SHMOFF(funct);
     funct_entry->arg = funct->arg;
     funct_entry->funct = funct->funct;
+    funct_entry->group = group;
     /* add the entry to the list */
     list_add_after((hal_list_t *) funct_entry, list_entry);
     /* update the function usage count */
@@ -2366,6 +2520,145 @@ hal_list_t *list_remove_entry(hal_list_t * entry)
     return next;
 }
 
+/* FNV-1a hash of a HAL name */
+static unsigned int name_hash(const char *name)
+{
+    unsigned int hash = 2166136261u;
+
+    while (*name != '\0') {
+	hash ^= (unsigned char) *name++;
+	hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* returns the bucket for 'name' in the index at offset 'table',
+   which has 'size' entries */
+static int *name_bucket(rtapi_intptr_t table, unsigned int size,
+    const char *name)
+{
+    int *buckets = SHMPTR(table);
+
+    return &buckets[name_hash(name) & (size - 1)];
+}
+
+/* adds the struct at 'p', whose chain link is at offset 'link', to the
+   front of 'bucket' */
+static void bucket_add(int *bucket, void *p, size_t link)
+{
+    *(int *) ((char *) p + link) = *bucket;
+    *bucket = SHMOFF(p);
+}
+
+/* removes the struct at 'p' from 'bucket', if it is there */
+static void bucket_remove(int *bucket, void *p, size_t link)
+{
+    int *prev = bucket;
+
+    while (*prev != 0) {
+	char *entry = SHMPTR(*prev);
+	if (entry == p) {
+	    *prev = *(int *) (entry + link);
+	    *(int *) (entry + link) = 0;
+	    return;
+	}
+	prev = (int *) (entry + link);
+    }
+}
+
+static void index_pin(hal_pin_t * pin)
+{
+    hal_oldname_t *oldname;
+
+    bucket_add(name_bucket(hal_data->pin_hash, HAL_PIN_HASH_SIZE, pin->name),
+	pin, offsetof(hal_pin_t, hash_next));
+    if (pin->oldname != 0) {
+	oldname = SHMPTR(pin->oldname);
+	oldname->owner_ptr = SHMOFF(pin);
+	bucket_add(name_bucket(hal_data->pin_oldname_hash,
+	    HAL_OLDNAME_HASH_SIZE, oldname->name),
+	    oldname, offsetof(hal_oldname_t, hash_next));
+    }
+}
+
+static void unindex_pin(hal_pin_t * pin)
+{
+    hal_oldname_t *oldname;
+
+    bucket_remove(name_bucket(hal_data->pin_hash, HAL_PIN_HASH_SIZE,
+	pin->name), pin, offsetof(hal_pin_t, hash_next));
+    if (pin->oldname != 0) {
+	oldname = SHMPTR(pin->oldname);
+	bucket_remove(name_bucket(hal_data->pin_oldname_hash,
+	    HAL_OLDNAME_HASH_SIZE, oldname->name),
+	    oldname, offsetof(hal_oldname_t, hash_next));
+    }
+    if (hal_data->pin_insert_hint == SHMOFF(pin)) {
+	hal_data->pin_insert_hint = 0;
+    }
+}
+
+static void index_sig(hal_sig_t * sig)
+{
+    bucket_add(name_bucket(hal_data->sig_hash, HAL_SIG_HASH_SIZE, sig->name),
+	sig, offsetof(hal_sig_t, hash_next));
+}
+
+static void unindex_sig(hal_sig_t * sig)
+{
+    bucket_remove(name_bucket(hal_data->sig_hash, HAL_SIG_HASH_SIZE,
+	sig->name), sig, offsetof(hal_sig_t, hash_next));
+    if (hal_data->sig_insert_hint == SHMOFF(sig)) {
+	hal_data->sig_insert_hint = 0;
+    }
+}
+
+static void index_param(hal_param_t * param)
+{
+    hal_oldname_t *oldname;
+
+    bucket_add(name_bucket(hal_data->param_hash, HAL_PARAM_HASH_SIZE,
+	param->name), param, offsetof(hal_param_t, hash_next));
+    if (param->oldname != 0) {
+	oldname = SHMPTR(param->oldname);
+	oldname->owner_ptr = SHMOFF(param);
+	bucket_add(name_bucket(hal_data->param_oldname_hash,
+	    HAL_OLDNAME_HASH_SIZE, oldname->name),
+	    oldname, offsetof(hal_oldname_t, hash_next));
+    }
+}
+
+static void unindex_param(hal_param_t * param)
+{
+    hal_oldname_t *oldname;
+
+    bucket_remove(name_bucket(hal_data->param_hash, HAL_PARAM_HASH_SIZE,
+	param->name), param, offsetof(hal_param_t, hash_next));
+    if (param->oldname != 0) {
+	oldname = SHMPTR(param->oldname);
+	bucket_remove(name_bucket(hal_data->param_oldname_hash,
+	    HAL_OLDNAME_HASH_SIZE, oldname->name),
+	    oldname, offsetof(hal_oldname_t, hash_next));
+    }
+    if (hal_data->param_insert_hint == SHMOFF(param)) {
+	hal_data->param_insert_hint = 0;
+    }
+}
+
+#ifdef RTAPI
+static void index_funct(hal_funct_t * funct)
+{
+    bucket_add(name_bucket(hal_data->funct_hash, HAL_FUNCT_HASH_SIZE,
+	funct->name), funct, offsetof(hal_funct_t, hash_next));
+}
+
+static void unindex_funct(hal_funct_t * funct)
+{
+    bucket_remove(name_bucket(hal_data->funct_hash, HAL_FUNCT_HASH_SIZE,
+	funct->name), funct, offsetof(hal_funct_t, hash_next));
+}
+#endif /* RTAPI */
+
 hal_comp_t *halpr_find_comp_by_name(const char *name)
 {
     int next;
@@ -2392,25 +2685,29 @@ hal_pin_t *halpr_find_pin_by_name(const char *name)
     hal_pin_t *pin;
     hal_oldname_t *oldname;
 
-    /* search pin list for 'name' */
-    next = hal_data->pin_list_ptr;
+    /* search the pin index bucket for 'name' */
+    next = *name_bucket(hal_data->pin_hash, HAL_PIN_HASH_SIZE, name);
     while (next != 0) {
 	pin = SHMPTR(next);
 	if (strcmp(pin->name, name) == 0) {
 	    /* found a match */
 	    return pin;
 	}
-	if (pin->oldname != 0 ) {
-	    oldname = SHMPTR(pin->oldname);
-	    if (strcmp(oldname->name, name) == 0) {
-		/* found a match */
-		return pin;
-	    }
-	}
 	/* didn't find it yet, look at next one */
-	next = pin->next_ptr;
+	next = pin->hash_next;
     }
-    /* if loop terminates, we reached end of list with no match */
+    /* not a pin name, maybe the original name of an aliased pin */
+    next = *name_bucket(hal_data->pin_oldname_hash, HAL_OLDNAME_HASH_SIZE,
+	name);
+    while (next != 0) {
+	oldname = SHMPTR(next);
+	if (strcmp(oldname->name, name) == 0) {
+	    /* found a match */
+	    return SHMPTR(oldname->owner_ptr);
+	}
+	next = oldname->hash_next;
+    }
+    /* if loop terminates, we reached end of bucket with no match */
     return 0;
 }
 
@@ -2419,8 +2716,8 @@ hal_sig_t *halpr_find_sig_by_name(const char *name)
     int next;
     hal_sig_t *sig;
 
-    /* search signal list for 'name' */
-    next = hal_data->sig_list_ptr;
+    /* search the signal index bucket for 'name' */
+    next = *name_bucket(hal_data->sig_hash, HAL_SIG_HASH_SIZE, name);
     while (next != 0) {
 	sig = SHMPTR(next);
 	if (strcmp(sig->name, name) == 0) {
@@ -2428,9 +2725,9 @@ hal_sig_t *halpr_find_sig_by_name(const char *name)
 	    return sig;
 	}
 	/* didn't find it yet, look at next one */
-	next = sig->next_ptr;
+	next = sig->hash_next;
     }
-    /* if loop terminates, we reached end of list with no match */
+    /* if loop terminates, we reached end of bucket with no match */
     return 0;
 }
 
@@ -2440,25 +2737,29 @@ hal_param_t *halpr_find_param_by_name(const char *name)
     hal_param_t *param;
     hal_oldname_t *oldname;
 
-    /* search parameter list for 'name' */
-    next = hal_data->param_list_ptr;
+    /* search the parameter index bucket for 'name' */
+    next = *name_bucket(hal_data->param_hash, HAL_PARAM_HASH_SIZE, name);
     while (next != 0) {
 	param = SHMPTR(next);
 	if (strcmp(param->name, name) == 0) {
 	    /* found a match */
 	    return param;
 	}
-	if (param->oldname != 0 ) {
-	    oldname = SHMPTR(param->oldname);
-	    if (strcmp(oldname->name, name) == 0) {
-		/* found a match */
-		return param;
-	    }
-	}
 	/* didn't find it yet, look at next one */
-	next = param->next_ptr;
+	next = param->hash_next;
     }
-    /* if loop terminates, we reached end of list with no match */
+    /* not a param name, maybe the original name of an aliased param */
+    next = *name_bucket(hal_data->param_oldname_hash, HAL_OLDNAME_HASH_SIZE,
+	name);
+    while (next != 0) {
+	oldname = SHMPTR(next);
+	if (strcmp(oldname->name, name) == 0) {
+	    /* found a match */
+	    return SHMPTR(oldname->owner_ptr);
+	}
+	next = oldname->hash_next;
+    }
+    /* if loop terminates, we reached end of bucket with no match */
     return 0;
 }
 
@@ -2487,8 +2788,8 @@ hal_funct_t *halpr_find_funct_by_name(const char *name)
     int next;
     hal_funct_t *funct;
 
-    /* search function list for 'name' */
-    next = hal_data->funct_list_ptr;
+    /* search the function index bucket for 'name' */
+    next = *name_bucket(hal_data->funct_hash, HAL_FUNCT_HASH_SIZE, name);
     while (next != 0) {
 	funct = SHMPTR(next);
 	if (strcmp(funct->name, name) == 0) {
@@ -2496,9 +2797,9 @@ hal_funct_t *halpr_find_funct_by_name(const char *name)
 	    return funct;
 	}
 	/* didn't find it yet, look at next one */
-	next = funct->next_ptr;
+	next = funct->hash_next;
     }
-    /* if loop terminates, we reached end of list with no match */
+    /* if loop terminates, we reached end of bucket with no match */
     return 0;
 }
 
@@ -2636,6 +2937,102 @@ hal_pin_t *halpr_find_pin_by_sig(hal_sig_t * sig, hal_pin_t * start)
     return 0;
 }
 
+/* allocates a statistics block for a funct or thread if 'stats' doesn't
+   point at one yet
+*/
+static int alloc_stats(int *stats)
+{
+    hal_stats_t *s;
+
+    if (*stats != 0) {
+	return 0;
+    }
+    s = shmalloc_dn(sizeof(hal_stats_t));
+    if (s == 0) {
+	return -ENOMEM;
+    }
+    memset(s, 0, sizeof(hal_stats_t));
+    *stats = SHMOFF(s);
+    return 0;
+}
+
+int halpr_set_stats(int enable)
+{
+    int next;
+    hal_funct_t *funct;
+    hal_thread_t *thread;
+
+    if (enable) {
+	/* every funct and thread needs somewhere to put its numbers
+	   before the threads start looking for them */
+	next = hal_data->funct_list_ptr;
+	while (next != 0) {
+	    funct = SHMPTR(next);
+	    if (alloc_stats(&funct->stats) != 0) {
+		return -ENOMEM;
+	    }
+	    next = funct->next_ptr;
+	}
+	next = hal_data->thread_list_ptr;
+	while (next != 0) {
+	    thread = SHMPTR(next);
+	    if (alloc_stats(&thread->stats) != 0) {
+		return -ENOMEM;
+	    }
+	    next = thread->next_ptr;
+	}
+    }
+    hal_data->stats_enabled = (enable != 0);
+    return 0;
+}
+
+void halpr_reset_stats(void)
+{
+    int next;
+    hal_funct_t *funct;
+    hal_thread_t *thread;
+
+    next = hal_data->funct_list_ptr;
+    while (next != 0) {
+	funct = SHMPTR(next);
+	if (funct->stats != 0) {
+	    memset(SHMPTR(funct->stats), 0, sizeof(hal_stats_t));
+	}
+	next = funct->next_ptr;
+    }
+    next = hal_data->thread_list_ptr;
+    while (next != 0) {
+	thread = SHMPTR(next);
+	if (thread->stats != 0) {
+	    memset(SHMPTR(thread->stats), 0, sizeof(hal_stats_t));
+	}
+	next = thread->next_ptr;
+    }
+}
+
+rtapi_u64 halpr_stats_percentile(hal_stats_t * stats, int permille)
+{
+    rtapi_u64 count, edge;
+    int n;
+
+    if (stats->runs == 0) {
+	return 0;
+    }
+    count = 0;
+    for (n = 0; n < HAL_STATS_BUCKETS - 1; n++) {
+	count += stats->hist[n];
+	if (count * 1000 >= stats->runs * permille) {
+	    break;
+	}
+    }
+    /* the bucket edge is an upper bound, but so is the longest run */
+    edge = (rtapi_u64) 1 << (n + 1);
+    if (edge > stats->max_ns) {
+	edge = stats->max_ns;
+    }
+    return edge;
+}
+
 /***********************************************************************
 *                     LOCAL FUNCTION CODE                              *
 ************************************************************************/
@@ -2768,15 +3165,168 @@ void rtapi_app_exit(void)
 	"HAL_LIB: kernel lib removed successfully\n");
 }
 
+/* returns the histogram bucket for a run time of 'ns', without using
+   anything the kernel might not provide */
+static int stats_bucket(rtapi_u64 ns)
+{
+    int n;
+
+    if (ns >> 32) {
+	return HAL_STATS_BUCKETS - 1;
+    }
+    n = 0;
+    if (ns >> 16) { ns >>= 16; n += 16; }
+    if (ns >> 8) { ns >>= 8; n += 8; }
+    if (ns >> 4) { ns >>= 4; n += 4; }
+    if (ns >> 2) { ns >>= 2; n += 2; }
+    if (ns >> 1) { n += 1; }
+    return (n < HAL_STATS_BUCKETS) ? n : HAL_STATS_BUCKETS - 1;
+}
+
+static void record_stats(hal_stats_t * stats, rtapi_u64 ns, int overrun)
+{
+    stats->runs++;
+    stats->total_ns += ns;
+    if (ns > stats->max_ns) {
+	stats->max_ns = ns;
+    }
+    if (overrun) {
+	stats->overruns++;
+    }
+    stats->hist[stats_bucket(ns)]++;
+}
+
+/* spin-wait hint for the loops that wait on another CPU */
+#if defined(__i386__) || defined(__x86_64__)
+#define hal_cpu_relax() __asm__ __volatile__("pause" ::: "memory")
+#else
+#define hal_cpu_relax() __asm__ __volatile__("" ::: "memory")
+#endif
+
+/* A thread with workers shares out each parallel group, a run of
+   entries with the same non-zero group number, through 'dispatch':
+   the group sequence number in the top 32 bits, the number of entries
+   in the group in the next 16, and the index of the next entry to be
+   claimed in the low 16.  Claiming an entry is a compare-and-swap of
+   the whole word, so it can only succeed for the group it was read
+   for.  The thread takes part itself and waits at the end of the
+   group until 'group_done' says every entry has finished, so a worker
+   that is late or not running at all only costs speed.
+*/
+#define DISPATCH_NEXT(d)	((int)((d) & 0xffff))
+#define DISPATCH_COUNT(d)	((int)(((d) >> 16) & 0xffff))
+#define DISPATCH_SEQUENCE(d)	((unsigned int)((d) >> 32))
+#define MAX_GROUP_SIZE		0xffff
+
+/* call one entry of a thread's function list and record its execution
+   time; 'start_time' is the clock count and '*ns' the time in ns (if
+   stats are enabled) when it was called; '*ns' is updated to the time
+   it returned, and the clock count at that point is returned */
+static long long int call_funct(hal_thread_t *thread,
+    hal_funct_entry_t *funct_entry, long long int start_time,
+    long long int *ns, int stats_enabled)
+{
+    hal_funct_t *funct;
+    long long int end_time, start_ns;
+
+    /* call the function */
+    funct_entry->funct(funct_entry->arg, thread->period);
+    /* capture execution time */
+    end_time = rtapi_get_clocks();
+    /* point to function structure */
+    funct = SHMPTR(funct_entry->funct_ptr);
+    /* update execution time data */
+    *(funct->runtime) = (hal_s32_t)(end_time - start_time);
+    if ( *(funct->runtime) > funct->maxtime) {
+	funct->maxtime = *(funct->runtime);
+	funct->maxtime_increased = 1;
+    } else {
+	funct->maxtime_increased = 0;
+    }
+    if (stats_enabled) {
+	start_ns = *ns;
+	*ns = rtapi_get_time();
+	if (funct->stats != 0) {
+	    record_stats(SHMPTR(funct->stats), *ns - start_ns,
+		*ns - thread->cycle_start > thread->period);
+	}
+    }
+    return end_time;
+}
+
+/* claim the next entry of the current parallel group and run it;
+   returns zero if there was nothing left to claim */
+static int run_group_funct(hal_thread_t *thread, int stats_enabled)
+{
+    unsigned long long dispatch;
+    hal_funct_entry_t *funct_entry;
+    long long int ns;
+    int n;
+
+    dispatch = atomic_load_explicit(&thread->dispatch, memory_order_acquire);
+    n = DISPATCH_NEXT(dispatch);
+    if (n >= DISPATCH_COUNT(dispatch)) {
+	return 0;
+    }
+    /* only valid if the claim succeeds, as the group can't change
+       before all of its entries are claimed */
+    funct_entry = SHMPTR(thread->group_ptr);
+    if (!__sync_bool_compare_and_swap(&thread->dispatch, dispatch,
+	    dispatch + 1)) {
+	/* somebody else got there first */
+	return 1;
+    }
+    while (n-- > 0) {
+	funct_entry = SHMPTR(funct_entry->links.next);
+    }
+    ns = stats_enabled ? rtapi_get_time() : 0;
+    call_funct(thread, funct_entry, rtapi_get_clocks(), &ns, stats_enabled);
+    __sync_fetch_and_add(&thread->group_done, 1);
+    return 1;
+}
+
+/* run the parallel group that starts at 'first' together with the
+   workers, and return the entry that follows it */
+static hal_funct_entry_t *run_group(hal_thread_t *thread,
+    hal_funct_entry_t *first, hal_funct_entry_t *funct_root,
+    int stats_enabled)
+{
+    hal_funct_entry_t *funct_entry;
+    unsigned long long sequence;
+    int count;
+
+    count = 0;
+    funct_entry = first;
+    while (funct_entry != funct_root && funct_entry->group == first->group
+	&& count < MAX_GROUP_SIZE) {
+	count++;
+	funct_entry = SHMPTR(funct_entry->links.next);
+    }
+    thread->group_ptr = SHMOFF(first);
+    thread->group_done = 0;
+    sequence = DISPATCH_SEQUENCE(thread->dispatch) + 1;
+    atomic_store_explicit(&thread->dispatch,
+	(sequence << 32) | ((unsigned long long)count << 16),
+	memory_order_release);
+    while (run_group_funct(thread, stats_enabled)) {
+    }
+    while (atomic_load_explicit(&thread->group_done, memory_order_acquire)
+	< count) {
+	hal_cpu_relax();
+    }
+    return funct_entry;
+}
+
 /* this is the task function that implements threads in realtime */
 
 static void thread_task(void *arg)
 {
     hal_thread_t *thread;
-    hal_funct_t *funct;
     hal_funct_entry_t *funct_root, *funct_entry;
     long long int start_time, end_time;
     long long int thread_start_time;
+    long long int end_ns;
+    int stats_enabled, parallel;
 
     thread = arg;
     while (1) {
@@ -2784,47 +3334,131 @@ static void thread_task(void *arg)
 	    /* point at first function on function list */
 	    funct_root = (hal_funct_entry_t *) & (thread->funct_list);
 	    funct_entry = SHMPTR(funct_root->links.next);
+	    /* statistics are kept in ns, which costs an extra clock
+	       read per funct, so only do it when asked to */
+	    stats_enabled = hal_data->stats_enabled;
+	    parallel = thread->num_workers > 0;
+	    end_ns = thread->cycle_start = 0;
+	    if (stats_enabled || parallel) {
+		thread->cycle_start = rtapi_get_time();
+		end_ns = thread->cycle_start;
+	    }
+	    /* let the workers know a period has started */
+	    if (parallel) {
+		thread->busy = 1;
+		atomic_store_explicit(&thread->cycle, thread->cycle + 1,
+		    memory_order_release);
+	    }
 	    /* execution time logging */
 	    start_time = rtapi_get_clocks();
 	    end_time = start_time;
 	    thread_start_time = start_time;
 	    /* run thru function list */
 	    while (funct_entry != funct_root) {
-		/* call the function */
-		funct_entry->funct(funct_entry->arg, thread->period);
-		/* capture execution time */
-		end_time = rtapi_get_clocks();
-		/* point to function structure */
-		funct = SHMPTR(funct_entry->funct_ptr);
-		/* update execution time data */
-		*(funct->runtime) = (hal_s32_t)(end_time - start_time);
-		if ( *(funct->runtime) > funct->maxtime) {
-		    funct->maxtime = *(funct->runtime);
-		    funct->maxtime_increased = 1;
+		if (parallel && funct_entry->group != 0) {
+		    funct_entry = run_group(thread, funct_entry, funct_root,
+			stats_enabled);
+		    end_time = rtapi_get_clocks();
+		    if (stats_enabled) {
+			end_ns = rtapi_get_time();
+		    }
 		} else {
-		    funct->maxtime_increased = 0;
+		    end_time = call_funct(thread, funct_entry, start_time,
+			&end_ns, stats_enabled);
+		    /* point to next next entry in list */
+		    funct_entry = SHMPTR(funct_entry->links.next);
 		}
-		/* point to next next entry in list */
-		funct_entry = SHMPTR(funct_entry->links.next);
 		/* prepare to measure time for next funct */
 		start_time = end_time;
 	    }
+	    if (parallel) {
+		atomic_store_explicit(&thread->busy, 0, memory_order_release);
+	    }
 	    /* update thread execution time */
 	    *(thread->runtime) = (hal_s32_t)(end_time - thread_start_time);
 	    if ( *(thread->runtime) > thread->maxtime) {
 	        thread->maxtime = *(thread->runtime);
 	    }
+	    if (stats_enabled && thread->stats != 0) {
+		record_stats(SHMPTR(thread->stats),
+		    end_ns - thread->cycle_start,
+		    end_ns - thread->cycle_start > thread->period);
+	    }
 	}
 	/* wait until next period */
 	rtapi_wait();
     }
 }
+
+/* Workers run with the period of their thread, on their own CPUs.
+   Each period a worker waits a moment for the thread to start, then
+   helps with its parallel groups until the thread is done.  Where RTAPI
+   supports it, the worker steers its own period to wake half of that
+   moment before the thread does. */
+static void worker_task(void *arg)
+{
+    hal_thread_t *thread;
+    long long int wake, phase;
+    long int period, margin;
+    unsigned int cycle, last_cycle;
+
+    thread = arg;
+    last_cycle = atomic_load_explicit(&thread->cycle, memory_order_acquire);
+    while (1) {
+	rtapi_wait();
+	wake = rtapi_get_time();
+	period = thread->period;
+	margin = period / 50;
+	while ((cycle = atomic_load_explicit(&thread->cycle,
+		    memory_order_acquire)) == last_cycle
+	    && rtapi_get_time() - wake < margin) {
+	    hal_cpu_relax();
+	}
+#ifdef RTAPI_TASK_PLL_SUPPORT
+	/* how far after the start of the thread's period we woke */
+	phase = wake - thread->cycle_start;
+	if (thread->cycle_start != 0 && phase > -period
+	    && phase < 2 * period) {
+	    while (phase > period / 2) {
+		phase -= period;
+	    }
+	    while (phase <= -period / 2) {
+		phase += period;
+	    }
+	    rtapi_task_pll_set_correction((-margin / 2 - phase) / 4);
+	}
+#else
+	(void)phase;
+#endif
+	if (cycle == last_cycle) {
+	    /* the thread isn't running, or we are far off */
+	    continue;
+	}
+	last_cycle = cycle;
+	while (atomic_load_explicit(&thread->busy, memory_order_acquire)
+	    && atomic_load_explicit(&thread->cycle, memory_order_acquire)
+		== cycle) {
+	    if (!run_group_funct(thread, hal_data->stats_enabled)) {
+		hal_cpu_relax();
+	    }
+	}
+    }
+}
 #endif /* RTAPI */
 
 /* see the declarations of these functions (near top of file) for
    a description of what they do.
 */
 
+static rtapi_intptr_t init_name_index(unsigned int size)
+{
+    /* HAL_SIZE leaves room for these, so this can't fail */
+    int *buckets = shmalloc_dn(size * sizeof(int));
+
+    memset(buckets, 0, size * sizeof(int));
+    return SHMOFF(buckets);
+}
+
 static int init_hal_data(void)
 {
     /* has the block already been initialized? */
@@ -2866,6 +3500,17 @@ static int init_hal_data(void)
     hal_data->shmem_bot = sizeof(hal_data_t);
     hal_data->shmem_top = HAL_SIZE;
     hal_data->lock = HAL_LOCK_NONE;
+    /* allocate the (empty) name index */
+    hal_data->pin_hash = init_name_index(HAL_PIN_HASH_SIZE);
+    hal_data->sig_hash = init_name_index(HAL_SIG_HASH_SIZE);
+    hal_data->param_hash = init_name_index(HAL_PARAM_HASH_SIZE);
+    hal_data->funct_hash = init_name_index(HAL_FUNCT_HASH_SIZE);
+    hal_data->pin_oldname_hash = init_name_index(HAL_OLDNAME_HASH_SIZE);
+    hal_data->param_oldname_hash = init_name_index(HAL_OLDNAME_HASH_SIZE);
+    hal_data->pin_insert_hint = 0;
+    hal_data->sig_insert_hint = 0;
+    hal_data->param_insert_hint = 0;
+    hal_data->stats_enabled = 0;
     /* done, release mutex */
     rtapi_mutex_give(&(hal_data->mutex));
     return 0;
@@ -2981,6 +3626,8 @@ static hal_pin_t *alloc_pin_struct(void)
 	p->dir = 0;
 	p->signal = 0;
 	memset(&p->dummysig, 0, sizeof(hal_data_u));
+	p->oldname = 0;
+	p->hash_next = 0;
 	p->name[0] = '\0';
     }
     return p;
@@ -3009,6 +3656,7 @@ static hal_sig_t *alloc_sig_struct(void)
 	p->readers = 0;
 	p->writers = 0;
 	p->bidirs = 0;
+	p->hash_next = 0;
 	p->name[0] = '\0';
     }
     return p;
@@ -3034,6 +3682,8 @@ static hal_param_t *alloc_param_struct(void)
 	p->next_ptr = 0;
 	p->data_ptr = 0;
 	p->owner_ptr = 0;
+	p->oldname = 0;
+	p->hash_next = 0;
 	p->type = 0;
 	p->name[0] = '\0';
     }
@@ -3058,12 +3708,26 @@ static hal_oldname_t *halpr_alloc_oldname_struct(void)
     if (p) {
 	/* make sure it's empty */
 	p->next_ptr = 0;
+	p->hash_next = 0;
+	p->owner_ptr = 0;
 	p->name[0] = '\0';
     }
     return p;
 }
 
 #ifdef RTAPI
+/* a recycled funct or thread keeps its statistics block, but not the
+   numbers in it; a new one gets a block if statistics are on */
+static void init_stats(int *stats)
+{
+    if (*stats != 0) {
+	memset(SHMPTR(*stats), 0, sizeof(hal_stats_t));
+    } else if (hal_data->stats_enabled) {
+	/* if this fails the funct or thread just goes unrecorded */
+	alloc_stats(stats);
+    }
+}
+
 static hal_funct_t *alloc_funct_struct(void)
 {
     hal_funct_t *p;
@@ -3078,6 +3742,9 @@ static hal_funct_t *alloc_funct_struct(void)
     } else {
 	/* nothing on free list, allocate a brand new one */
 	p = shmalloc_dn(sizeof(hal_funct_t));
+	if (p) {
+	    p->stats = 0;
+	}
     }
     if (p) {
 	/* make sure it's empty */
@@ -3088,7 +3755,9 @@ static hal_funct_t *alloc_funct_struct(void)
 	p->users = 0;
 	p->arg = 0;
 	p->funct = 0;
+	p->hash_next = 0;
 	p->name[0] = '\0';
+	init_stats(&p->stats);
     }
     return p;
 }
@@ -3117,6 +3786,7 @@ static hal_funct_entry_t *alloc_funct_entry_struct(void)
 	p->funct_ptr = 0;
 	p->arg = 0;
 	p->funct = 0;
+	p->group = 0;
     }
     return p;
 }
@@ -3136,6 +3806,9 @@ static hal_thread_t *alloc_thread_struct(void)
     } else {
 	/* nothing on free list, allocate a brand new one */
 	p = shmalloc_dn(sizeof(hal_thread_t));
+	if (p) {
+	    p->stats = 0;
+	}
     }
     if (p) {
 	/* make sure it's empty */
@@ -3144,8 +3817,17 @@ static hal_thread_t *alloc_thread_struct(void)
 	p->period = 0;
 	p->priority = 0;
 	p->task_id = 0;
+	p->cpu_id = RTAPI_DEFAULT_CPU;
+	p->num_workers = 0;
+	p->cycle = 0;
+	p->busy = 0;
+	p->cycle_start = 0;
+	p->dispatch = 0;
+	p->group_ptr = 0;
+	p->group_done = 0;
 	list_init_entry(&(p->funct_list));
 	p->name[0] = '\0';
+	init_stats(&p->stats);
     }
     return p;
 }
@@ -3287,8 +3969,10 @@ static void free_pin_struct(hal_pin_t * pin)
 {
 
     unlink_pin(pin);
+    unindex_pin(pin);
     /* clear contents of struct */
     if ( pin->oldname != 0 ) free_oldname_struct(SHMPTR(pin->oldname));
+    pin->oldname = 0;
     pin->data_ptr_addr = 0;
     pin->owner_ptr = 0;
     pin->type = 0;
@@ -3313,6 +3997,7 @@ static void free_sig_struct(hal_sig_t * sig)
 	/* check for another pin linked to the signal */
 	pin = halpr_find_pin_by_sig(sig, pin);
     }
+    unindex_sig(sig);
     /* clear contents of struct */
     sig->data_ptr = 0;
     sig->type = 0;
@@ -3327,8 +4012,10 @@ static void free_sig_struct(hal_sig_t * sig)
 
 static void free_param_struct(hal_param_t * p)
 {
+    unindex_param(p);
     /* clear contents of struct */
     if ( p->oldname != 0 ) free_oldname_struct(SHMPTR(p->oldname));
+    p->oldname = 0;
     p->data_ptr = 0;
     p->owner_ptr = 0;
     p->type = 0;
@@ -3389,6 +4076,7 @@ static void free_funct_struct(hal_funct_t * funct)
 	    next_thread = thread->next_ptr;
 	}
     }
+    unindex_funct(funct);
     /* clear contents of struct */
     funct->uses_fp = 0;
     funct->owner_ptr = 0;
@@ -3426,6 +4114,7 @@ static void free_thread_struct(hal_thread_t * thread)
 {
     hal_funct_entry_t *funct_entry;
     hal_list_t *list_root, *list_entry;
+    int n;
 /*! \todo Another #if 0 */
 #if 0
     rtapi_intptr_t *prev, next;
@@ -3435,6 +4124,12 @@ static void free_thread_struct(hal_thread_t * thread)
 
     /* if we're deleting a thread, we need to stop all threads */
     hal_data->threads_running = 0;
+    /* stop its workers while the thread can still finish its period */
+    for (n = 0; n < thread->num_workers; n++) {
+	rtapi_task_pause(thread->worker_task_id[n]);
+	rtapi_task_delete(thread->worker_task_id[n]);
+    }
+    thread->num_workers = 0;
     /* and stop the task associated with this thread */
     rtapi_task_pause(thread->task_id);
     rtapi_task_delete(thread->task_id);
@@ -3988,6 +4683,45 @@ int hal_stream_read(hal_stream_t *stream, union hal_stream_data *buf, unsigned *
     return 0;
 }
 
+int hal_stream_read_many(hal_stream_t *stream, union hal_stream_data *buf,
+        unsigned *sampleno, int count) {
+    int in = hal_stream_atomic_load_in(stream),
+        out = hal_stream_atomic_load_out(stream);
+    int num_pins = stream->fifo->num_pins;
+    int stride = num_pins + 1;
+    int n;
+    for(n = 0; n < count && out != in; n++) {
+        union hal_stream_data *dptr = &stream->fifo->data[out * stride];
+        memcpy(buf, dptr, sizeof(union hal_stream_data) * num_pins);
+        buf += num_pins;
+        if(sampleno) sampleno[n] = dptr[num_pins].s;
+        out = hal_stream_advance(stream, out);
+    }
+    /* hand the whole batch back to the writer at once */
+    if(n) hal_stream_atomic_store_out(stream, out);
+    return n;
+}
+
+int hal_stream_write_many(hal_stream_t *stream, union hal_stream_data *buf,
+        int count) {
+    int in = hal_stream_atomic_load_in(stream),
+        out = hal_stream_atomic_load_out(stream);
+    int num_pins = stream->fifo->num_pins;
+    int stride = num_pins + 1;
+    int n;
+    for(n = 0; n < count; n++) {
+        int newin = hal_stream_advance(stream, in);
+        if(newin == out) break;
+        union hal_stream_data *dptr = &stream->fifo->data[in * stride];
+        memcpy(dptr, buf, sizeof(union hal_stream_data) * num_pins);
+        buf += num_pins;
+        dptr[num_pins].s = ++stream->fifo->this_sample;
+        in = newin;
+    }
+    if(n) hal_stream_atomic_store_in(stream, in);
+    return n;
+}
+
 int hal_stream_attach(hal_stream_t *stream, int comp_id, int key, const char *typestring) {
     int i;
 
@@ -4125,8 +4859,11 @@ EXPORT_SYMBOL(hal_set_constructor);
 EXPORT_SYMBOL(hal_export_funct);
 
 EXPORT_SYMBOL(hal_create_thread);
+EXPORT_SYMBOL(hal_create_thread_cpu);
+EXPORT_SYMBOL(hal_thread_add_worker);
 
 EXPORT_SYMBOL(hal_add_funct_to_thread);
+EXPORT_SYMBOL(hal_add_funct_to_thread_group);
 EXPORT_SYMBOL(hal_del_funct_from_thread);
 
 EXPORT_SYMBOL(hal_start_threads);
@@ -4147,6 +4884,10 @@ EXPORT_SYMBOL(halpr_find_funct_by_owner);
 
 EXPORT_SYMBOL(halpr_find_pin_by_sig);
 
+EXPORT_SYMBOL(halpr_set_stats);
+EXPORT_SYMBOL(halpr_reset_stats);
+EXPORT_SYMBOL(halpr_stats_percentile);
+
 EXPORT_SYMBOL(hal_pin_alias);
 EXPORT_SYMBOL(hal_param_alias);
 
@@ -4168,6 +4909,8 @@ EXPORT_SYMBOL_GPL(hal_stream_depth);
 EXPORT_SYMBOL_GPL(hal_stream_maxdepth);
 EXPORT_SYMBOL_GPL(hal_stream_write);
 EXPORT_SYMBOL_GPL(hal_stream_read);
+EXPORT_SYMBOL_GPL(hal_stream_write_many);
+EXPORT_SYMBOL_GPL(hal_stream_read_many);
 EXPORT_SYMBOL_GPL(hal_stream_attach);
 EXPORT_SYMBOL_GPL(hal_stream_detach);
 EXPORT_SYMBOL_GPL(hal_stream_element_count);
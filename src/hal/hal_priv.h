@@ -159,9 +159,49 @@ typedef struct {
 */
 typedef struct {
     rtapi_intptr_t next_ptr;		/* next struct (used for free list only) */
+    int hash_next;		/* next entry in the same name index bucket */
+    int owner_ptr;		/* pin or param that has this original name */
     char name[HAL_NAME_LEN + 1];	/* the original name */
 } hal_oldname_t;
 
+/** HAL name index.
+    Besides the sorted lists, pins, signals, parameters and functions are
+    chained into hash tables keyed by name, so that the find_xxx_by_name()
+    functions don't have to walk lists that may hold many thousands of
+    entries.  The original names of aliased pins and parameters go into
+    separate tables.  Each table is an array of offsets to the first
+    struct in each bucket, allocated from HAL shared memory when the
+    block is initialized; the structs are chained through 'hash_next'.
+    Table sizes must be powers of two.
+*/
+#define HAL_PIN_HASH_SIZE	2048
+#define HAL_SIG_HASH_SIZE	1024
+#define HAL_PARAM_HASH_SIZE	1024
+#define HAL_FUNCT_HASH_SIZE	256
+#define HAL_OLDNAME_HASH_SIZE	64
+
+/** Execution time statistics for functs and threads.
+    When enabled (see halpr_set_stats()), thread_task() times every
+    funct and every pass through each thread in nanoseconds and keeps
+    a histogram with logarithmic buckets: 'hist[n]' counts runs that
+    took at least 2^n ns (1 ns for n == 0) but less than 2^(n+1) ns,
+    and the last bucket also counts anything longer.  A thread
+    overrun is a pass that took longer than the thread period; a
+    funct overrun is a run of the funct that ended later than one
+    period after its thread started.  The blocks are allocated from
+    HAL shared memory the first time statistics are enabled and stay
+    with the funct or thread struct from then on.
+*/
+#define HAL_STATS_BUCKETS	32
+
+typedef struct {
+    rtapi_u64 runs;		/* number of runs recorded */
+    rtapi_u64 overruns;		/* number of runs that missed the deadline */
+    rtapi_u64 total_ns;		/* sum of all run times */
+    rtapi_u64 max_ns;		/* longest run time */
+    rtapi_u64 hist[HAL_STATS_BUCKETS];	/* run time histogram */
+} hal_stats_t;
+
 /* Master HAL data structure
    There is a single instance of this structure in the machine.
    It resides at the base of the HAL shared memory block, where it
@@ -201,6 +241,16 @@ typedef struct {
     int exact_base_period;      /* if set, pretend that rtapi satisfied our
 				   period request exactly */
     unsigned char lock;         /* hal locking, can be one of the HAL_LOCK_* types */
+    rtapi_intptr_t pin_hash;		/* name index of pins */
+    rtapi_intptr_t sig_hash;		/* name index of signals */
+    rtapi_intptr_t param_hash;		/* name index of parameters */
+    rtapi_intptr_t funct_hash;		/* name index of functions */
+    rtapi_intptr_t pin_oldname_hash;	/* original names of aliased pins */
+    rtapi_intptr_t param_oldname_hash;	/* original names of aliased params */
+    rtapi_intptr_t pin_insert_hint;	/* pin most recently added to list */
+    rtapi_intptr_t sig_insert_hint;	/* signal most recently added to list */
+    rtapi_intptr_t param_insert_hint;	/* param most recently added to list */
+    int stats_enabled;		/* non-zero if threads record statistics */
 } hal_data_t;
 
 /** HAL 'component' data structure.
@@ -231,6 +281,7 @@ typedef struct {
     int signal;			/* signal to which pin is linked */
     hal_data_u dummysig;	/* if unlinked, data_ptr points here */
     int oldname;		/* old name if aliased, else zero */
+    int hash_next;		/* next pin in the same name index bucket */
     hal_type_t type;		/* data type */
     hal_pin_dir_t dir;		/* pin direction */
     char name[HAL_NAME_LEN + 1];	/* pin name */
@@ -246,6 +297,7 @@ typedef struct {
     int readers;		/* number of input pins linked */
     int writers;		/* number of output pins linked */
     int bidirs;			/* number of I/O pins linked */
+    int hash_next;		/* next signal in the same name index bucket */
     char name[HAL_NAME_LEN + 1];	/* signal name */
 } hal_sig_t;
 
@@ -257,6 +309,7 @@ typedef struct {
     int data_ptr;		/* offset of parameter value */
     int owner_ptr;		/* component that owns this signal */
     int oldname;		/* old name if aliased, else zero */
+    int hash_next;		/* next param in the same name index bucket */
     hal_type_t type;		/* data type */
     hal_param_dir_t dir;	/* data direction */
     char name[HAL_NAME_LEN + 1];	/* parameter name */
@@ -289,6 +342,8 @@ typedef struct {
     hal_s32_t* runtime;	/* (pin) duration of last run, in CPU cycles */
     hal_s32_t maxtime;	/* (param) duration of longest run, in CPU cycles */
     hal_bit_t maxtime_increased;	/* on last call, maxtime increased */
+    int hash_next;		/* next funct in the same name index bucket */
+    int stats;			/* execution statistics, zero if none yet */
     char name[HAL_NAME_LEN + 1];	/* function name */
 } hal_funct_t;
 
@@ -297,9 +352,11 @@ typedef struct {
     void *arg;			/* argument for function */
     void (*funct) (void *, long);	/* ptr to function code */
     int funct_ptr;		/* pointer to function */
+    int group;			/* parallel group, zero if none */
 } hal_funct_entry_t;
 
 #define HAL_STACKSIZE 16384	/* realtime task stacksize */
+#define HAL_MAX_WORKERS 8	/* worker tasks per thread */
 
 typedef struct {
     rtapi_intptr_t next_ptr;		/* next thread in linked list */
@@ -307,11 +364,23 @@ typedef struct {
     long int period;		/* period of the thread, in nsec */
     int priority;		/* priority of the thread */
     int task_id;		/* ID of the task that runs this thread */
+    int cpu_id;			/* CPU requested for the task, or default */
     hal_s32_t* runtime;	/* (pin) duration of last run, in CPU cycles */
     hal_s32_t maxtime;	/* (param) duration of longest run, in CPU cycles */
     hal_list_t funct_list;	/* list of functions to run */
     char name[HAL_NAME_LEN + 1];	/* thread name */
     int comp_id;
+    int stats;			/* execution statistics, zero if none yet */
+    /* worker tasks that help run parallel groups, and the state shared
+       with them */
+    int num_workers;
+    int worker_task_id[HAL_MAX_WORKERS];
+    unsigned int cycle;		/* bumped at the start of each period */
+    int busy;			/* set while a period is being run */
+    long long int cycle_start;	/* rtapi_get_time() at start of period */
+    unsigned long long dispatch;	/* current group, see run_group() */
+    rtapi_intptr_t group_ptr;	/* first entry of the current group */
+    int group_done;		/* number of its entries finished */
 } hal_thread_t;
 
 /* IMPORTANT:  If any of the structures in this file are changed, the
@@ -337,8 +406,10 @@ typedef struct {
 */
 
 #define HAL_KEY   0x48414C32	/* key used to open HAL shared memory */
-#define HAL_VER   0x0000000F	/* version code */
-#define HAL_SIZE  (85*4096)
+#define HAL_VER   0x00000013	/* version code */
+/* the last 18 pages are room for the hal_stats_t blocks of 256 functs
+   and threads, see halpr_set_stats() */
+#define HAL_SIZE  (108*4096)
 #define HAL_PSEUDO_COMP_PREFIX "__" /* prefix to identify a pseudo component */
 
 /* These pointers are set by hal_init() to point to the shmem block
@@ -435,6 +506,20 @@ extern hal_funct_t *halpr_find_funct_by_owner(hal_comp_t * owner,
 */
 extern hal_pin_t *halpr_find_pin_by_sig(hal_sig_t * sig, hal_pin_t * start);
 
+/** 'halpr_set_stats()' turns execution time statistics on (if 'enable'
+    is non-zero) or off.  Turning them on allocates a statistics block
+    for every funct and thread that doesn't have one yet; functs and
+    threads created later get theirs when they are created.  Returns 0
+    on success, or -ENOMEM if there isn't enough shared memory.
+    'halpr_reset_stats()' clears all the statistics collected so far.
+    'halpr_stats_percentile()' returns the upper edge, in ns, of the
+    histogram bucket below which at least 'permille'/1000 of the runs
+    in 'stats' fall, or 0 if nothing has been recorded.
+*/
+extern int halpr_set_stats(int enable);
+extern void halpr_reset_stats(void);
+extern rtapi_u64 halpr_stats_percentile(hal_stats_t * stats, int permille);
+
 
 /** hal_port_alloc allocates a new empty hal_port having a buffer of size bytes. 
     returns a negative value on failure or a hal_port_t which can be used with
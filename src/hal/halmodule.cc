@@ -1052,6 +1052,88 @@ PyObject *get_value(PyObject *self, PyObject *args) {
 }
 
 
+PyObject *set_stats(PyObject *self, PyObject *args) {
+    int enable, retval;
+    if(!PyArg_ParseTuple(args, "i", &enable)) return NULL;
+    if(!SHMPTR(0)) {
+	PyErr_Format(PyExc_RuntimeError,
+		"Cannot call before creating component");
+	return NULL;
+    }
+    rtapi_mutex_get(&(hal_data->mutex));
+    retval = halpr_set_stats(enable);
+    rtapi_mutex_give(&(hal_data->mutex));
+    if(retval < 0) return pyhal_error(retval);
+    Py_RETURN_NONE;
+}
+
+PyObject *reset_stats(PyObject *self, PyObject *args) {
+    if(!SHMPTR(0)) {
+	PyErr_Format(PyExc_RuntimeError,
+		"Cannot call before creating component");
+	return NULL;
+    }
+    rtapi_mutex_get(&(hal_data->mutex));
+    halpr_reset_stats();
+    rtapi_mutex_give(&(hal_data->mutex));
+    Py_RETURN_NONE;
+}
+
+static int add_stats(PyObject *result, const char *name, const char *kind,
+	hal_stats_t *stats) {
+    PyObject *hist = PyList_New(HAL_STATS_BUCKETS);
+    if(!hist) return -1;
+    for(int i = 0; i < HAL_STATS_BUCKETS; i++)
+	PyList_SET_ITEM(hist, i,
+		PyLong_FromUnsignedLongLong(stats->hist[i]));
+    PyObject *entry = Py_BuildValue("{s:s,s:K,s:K,s:K,s:K,s:N}",
+	    "type", kind,
+	    "runs", (unsigned long long)stats->runs,
+	    "overruns", (unsigned long long)stats->overruns,
+	    "total_ns", (unsigned long long)stats->total_ns,
+	    "max_ns", (unsigned long long)stats->max_ns,
+	    "hist", hist);
+    if(!entry) return -1;
+    int retval = PyDict_SetItemString(result, name, entry);
+    Py_DECREF(entry);
+    return retval;
+}
+
+PyObject *get_funct_stats(PyObject *self, PyObject *args) {
+    if(!SHMPTR(0)) {
+	PyErr_Format(PyExc_RuntimeError,
+		"Cannot call before creating component");
+	return NULL;
+    }
+    PyObject *result = PyDict_New();
+    if(!result) return NULL;
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    int next = hal_data->thread_list_ptr;
+    while(next != 0) {
+	hal_thread_t *thread = (hal_thread_t*)SHMPTR(next);
+	if(thread->stats != 0 && add_stats(result, thread->name, "thread",
+		    (hal_stats_t*)SHMPTR(thread->stats)) < 0)
+	    goto fail;
+	next = thread->next_ptr;
+    }
+    next = hal_data->funct_list_ptr;
+    while(next != 0) {
+	hal_funct_t *funct = (hal_funct_t*)SHMPTR(next);
+	if(funct->stats != 0 && add_stats(result, funct->name, "funct",
+		    (hal_stats_t*)SHMPTR(funct->stats)) < 0)
+	    goto fail;
+	next = funct->next_ptr;
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    return result;
+
+fail:
+    rtapi_mutex_give(&(hal_data->mutex));
+    Py_DECREF(result);
+    return NULL;
+}
+
 
 
 struct shmobject {
@@ -1451,6 +1533,12 @@ PyMethodDef module_methods[] = {
 	"set pin value"},
     {"get_value", get_value, METH_VARARGS,
 	".get_value('name'}: Gets the pin, param or signal value"},
+    {"set_stats", set_stats, METH_VARARGS,
+	".set_stats(enable): Turn execution time statistics of realtime threads and functions on or off"},
+    {"reset_stats", reset_stats, METH_NOARGS,
+	".reset_stats(): Clear the execution time statistics"},
+    {"get_funct_stats", get_funct_stats, METH_NOARGS,
+	".get_funct_stats(): Return a dict mapping each thread and function name to its execution time statistics.  'hist' is a list of run counts; entry n counts runs of 2**n to 2**(n+1) ns"},
     {NULL},
 };
 
@@ -160,6 +160,7 @@ struct halcmd_command halcmd_commands[] = {
     {"show",    FUNCT(do_show_cmd),    A_ONE | A_OPTIONAL | A_PLUS},
     {"source",  FUNCT(do_source_cmd),  A_ONE | A_TILDE },
     {"start",   FUNCT(do_start_cmd),   A_ZERO},
+    {"stats",   FUNCT(do_stats_cmd),   A_ONE },
     {"status",  FUNCT(do_status_cmd),  A_ONE | A_OPTIONAL },
     {"stop",    FUNCT(do_stop_cmd),    A_ZERO},
     {"unalias", FUNCT(do_unalias_cmd), A_TWO },
@@ -67,6 +67,7 @@ static void print_script_sig_info(int type, char **patterns);
 static void print_param_info(int type, char **patterns);
 static void print_funct_info(char **patterns);
 static void print_thread_info(char **patterns);
+static void print_funct_stats(char **patterns);
 static void print_comp_names(char **patterns);
 static void print_pin_names(char **patterns);
 static void print_sig_names(char **patterns);
@@ -133,6 +134,30 @@ int do_lock_cmd(char *command)
     return retval;
 }
 
+int do_stats_cmd(char *command)
+{
+    int retval=0;
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    if (strcmp(command, "on") == 0) {
+	retval = halpr_set_stats(1);
+    } else if (strcmp(command, "off") == 0) {
+	retval = halpr_set_stats(0);
+    } else if (strcmp(command, "reset") == 0) {
+	halpr_reset_stats();
+    } else {
+	rtapi_mutex_give(&(hal_data->mutex));
+	halcmd_error("Unknown 'stats' command '%s'\n", command);
+	return -EINVAL;
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+
+    if (retval != 0) {
+	halcmd_error("Not enough HAL shared memory for statistics\n");
+    }
+    return retval;
+}
+
 int do_unlock_cmd(char *command)
 {
     int retval=0;
@@ -309,13 +334,23 @@ int do_unecho_cmd(void) {
     return 0;
 }
 int do_addf_cmd(char *func, char *thread, char **opt) {
-    char *position_str = opt ? opt[0] : NULL;
-    int position = -1;
-    int retval;
-
-    if(position_str && *position_str) position = atoi(position_str);
+    int position = -1, group = 0;
+    int retval, i;
+
+    for(i = 0; opt && opt[i] && *opt[i]; i++) {
+        if(strncmp(opt[i], "group=", 6) == 0) {
+            char *cp;
+            group = strtol(opt[i] + 6, &cp, 0);
+            if(*cp || cp == opt[i] + 6 || group < 0) {
+                halcmd_error("value '%s' invalid for group\n", opt[i] + 6);
+                return -EINVAL;
+            }
+        } else {
+            position = atoi(opt[i]);
+        }
+    }
 
-    retval = hal_add_funct_to_thread(func, thread, position);
+    retval = hal_add_funct_to_thread_group(func, thread, position, group);
     if(retval == 0) {
         halcmd_info("Function '%s' added to thread '%s'\n",
                     func, thread);
@@ -1006,6 +1041,8 @@ int do_show_cmd(char *type, char **patterns)
 	print_funct_info(patterns);
     } else if (strcmp(type, "thread") == 0) {
 	print_thread_info(patterns);
+    } else if (strcmp(type, "funct-stats") == 0) {
+	print_funct_stats(patterns);
     } else if (strcmp(type, "alias") == 0) {
 	print_pin_aliases(patterns);
 	print_param_aliases(patterns);
@@ -1965,7 +2002,10 @@ static void print_thread_info(char **patterns)
 		funct = SHMPTR(fentry->funct_ptr);
 		/* scriptmode only uses one line per thread, which contains: 
 		   thread period, FP flag, name, then all functs separated by spaces  */
-		if (scriptmode == 0) {
+		if (scriptmode == 0 && fentry->group != 0) {
+		    halcmd_output("                 %2d %s (group %d)\n", n,
+			funct->name, fentry->group);
+		} else if (scriptmode == 0) {
 		    halcmd_output("                 %2d %s\n", n, funct->name);
 		} else {
 		    halcmd_output(" %s", funct->name);
@@ -1983,6 +2023,58 @@ static void print_thread_info(char **patterns)
     halcmd_output("\n");
 }
 
+static void print_stats_line(hal_stats_t *stats, const char *name)
+{
+    unsigned long long mean;
+
+    mean = (stats->runs != 0) ? stats->total_ns / stats->runs : 0;
+    halcmd_output(((scriptmode == 0)
+		    ? "%10llu %9llu %9llu %9llu %9llu %9llu %9llu  %s\n"
+		    : "%llu %llu %llu %llu %llu %llu %llu %s\n"),
+	(unsigned long long)stats->runs,
+	(unsigned long long)stats->overruns,
+	mean,
+	(unsigned long long)halpr_stats_percentile(stats, 500),
+	(unsigned long long)halpr_stats_percentile(stats, 990),
+	(unsigned long long)halpr_stats_percentile(stats, 999),
+	(unsigned long long)stats->max_ns,
+	name);
+}
+
+static void print_funct_stats(char **patterns)
+{
+    int next;
+    hal_thread_t *tptr;
+    hal_funct_t *fptr;
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    if (scriptmode == 0) {
+	halcmd_output("Execution Statistics (%s):\n",
+	    hal_data->stats_enabled ? "on" : "off, use 'stats on' to collect");
+	halcmd_output("      Runs  Overruns   Mean-ns    P50-ns    P99-ns  P99.9-ns"
+	    "    Max-ns  Name\n");
+    }
+    /* percentiles are the upper edges of power-of-two histogram buckets */
+    next = hal_data->thread_list_ptr;
+    while (next != 0) {
+	tptr = SHMPTR(next);
+	if (tptr->stats != 0 && match(patterns, tptr->name)) {
+	    print_stats_line(SHMPTR(tptr->stats), tptr->name);
+	}
+	next = tptr->next_ptr;
+    }
+    next = hal_data->funct_list_ptr;
+    while (next != 0) {
+	fptr = SHMPTR(next);
+	if (fptr->stats != 0 && match(patterns, fptr->name)) {
+	    print_stats_line(SHMPTR(fptr->stats), fptr->name);
+	}
+	next = fptr->next_ptr;
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    halcmd_output("\n");
+}
+
 static void print_comp_names(char **patterns)
 {
     int next;
@@ -2718,7 +2810,12 @@ static void save_threads(FILE *dst)
 	    /* print the function info */
 	    fentry = (hal_funct_entry_t *) list_entry;
 	    funct = SHMPTR(fentry->funct_ptr);
-	    fprintf(dst, "addf %s %s\n", funct->name, tptr->name);
+	    if (fentry->group != 0) {
+		fprintf(dst, "addf %s %s group=%d\n", funct->name, tptr->name,
+		    fentry->group);
+	    } else {
+		fprintf(dst, "addf %s %s\n", funct->name, tptr->name);
+	    }
 	    list_entry = list_next(list_entry);
 	}
 	next_thread = tptr->next_ptr;
@@ -2827,6 +2924,13 @@ int do_help_cmd(char *command)
 	printf("  none - no locking done.\n");
 	printf("  tune - some tuning is possible (setp & such).\n");
 	printf("  all  - HAL completely locked.\n");
+    } else if (strcmp(command, "stats") == 0) {
+	printf("stats on|off|reset\n");
+	printf("  Controls execution time statistics of realtime threads\n");
+	printf("  and functions.  While on, every run is timed and added\n");
+	printf("  to a histogram, and runs that end past the thread period\n");
+	printf("  are counted as overruns.  'reset' clears the statistics.\n");
+	printf("  Use 'show funct-stats' to print them.\n");
     } else if (strcmp(command, "unlock") == 0) {
 	printf("unlock [all|tune]\n");
 	printf("  Unlocks HAL to some degree.\n");
@@ -2877,13 +2981,15 @@ int do_help_cmd(char *command)
 	printf("stype signame\n");
 	printf("  Gets the type of signal 'signame'\n");
     } else if (strcmp(command, "addf") == 0) {
-	printf("addf functname threadname [position]\n");
+	printf("addf functname threadname [position] [group=N]\n");
 	printf("  Adds function 'functname' to thread 'threadname'.  If\n");
 	printf("  'position' is specified, adds the function to that spot\n");
 	printf("  in the thread, otherwise adds it to the end.  Negative\n");
 	printf("  'position' means position with respect to the end of the\n");
 	printf("  thread.  For example '1' is start of thread, '-1' is the\n");
 	printf("  end of the thread, '-3' is third from the end.\n");
+	printf("  Neighbouring functions with the same 'group=N' may run\n");
+	printf("  in parallel on the worker tasks of the thread.\n");
     } else if (strcmp(command, "delf") == 0) {
 	printf("delf functname threadname\n");
 	printf("  Removes function 'functname' from thread 'threadname'.\n");
@@ -2891,10 +2997,12 @@ int do_help_cmd(char *command)
 	printf("show [type] [pattern]\n");
 	printf("  Prints info about HAL items of the specified type.\n");
 	printf("  'type' is 'comp', 'pin', 'sig', 'param', 'funct',\n");
-	printf("  'thread', or 'all'.  If 'type' is omitted, it assumes\n");
-	printf("  'all' with no pattern.  If 'pattern' is specified\n");
+	printf("  'thread', 'funct-stats', or 'all'.  If 'type' is omitted,\n");
+	printf("  it assumes 'all' with no pattern.  If 'pattern' is specified\n");
 	printf("  it prints only those items whose names match the\n");
 	printf("  pattern, which may be a 'shell glob'.\n");
+	printf("  'funct-stats' prints the execution time statistics of\n");
+	printf("  threads and functions collected since 'stats on'.\n");
     } else if (strcmp(command, "list") == 0) {
 	printf("list type [pattern]\n");
 	printf("  Prints the names of HAL items of the specified type.\n");
@@ -2993,6 +3101,7 @@ static void print_help_commands(void)
     printf("  status              Display status information\n");
     printf("  save                Print config as commands\n");
     printf("  start, stop         Start/stop realtime threads\n");
+    printf("  stats               Collect execution time statistics\n");
     printf("  alias, unalias      Add or remove pin or parameter name aliases\n");
     printf("  echo, unecho        Echo commands from stdin to stderr\n");
     printf("  quit, exit          Exit from halcmd\n");
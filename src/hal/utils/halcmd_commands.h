@@ -58,6 +58,7 @@ extern int do_stop_cmd();
 extern int do_help_cmd(char *command);
 extern int do_lock_cmd(char *command);
 extern int do_unlock_cmd(char *command);
+extern int do_stats_cmd(char *command);
 extern int do_linkpp_cmd(char *first_pin_name, char *second_pin_name);
 extern int do_newsig_cmd(char *name, char *type);
 #if 0  /* newinst deferred to version 2.2 */
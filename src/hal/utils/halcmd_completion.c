@@ -51,7 +51,7 @@ static const char *command_table[] = {
     "linkps", "linksp", "linkpp", "unlinkp",
     "net", "newsig", "delsig", "getp", "gets", "setp", "sets", "ptype", "stype",
     "addf", "delf", "show", "list", "status", "save", "source",
-    "start", "stop", "quit", "exit", "help", "alias", "unalias", 
+    "start", "stop", "quit", "exit", "help", "alias", "unalias", "stats",
     NULL,
 };
 
@@ -67,6 +67,7 @@ static const char *alias_table[] = {
 
 static const char *show_table[] = {
     "all", "alias", "comp", "pin", "sig", "param", "funct", "thread",
+    "funct-stats",
     NULL,
 };
 
@@ -92,6 +93,7 @@ static const char *pintype_table[] = {
 
 static const char *lock_table[] = { "none", "tune", "all", NULL };
 static const char *unlock_table[] = { "tune", "all", NULL };
+static const char *stats_table[] = { "on", "off", "reset", NULL };
 
 static const char **string_table = NULL;
 
@@ -698,6 +700,8 @@ char **halcmd_completer(const char *text, int start, int end, hal_completer_func
         result = completion_matches_table(text, lock_table, func);
     } else if(startswith(buffer, "unlock ") && argno == 1) {
         result = completion_matches_table(text, unlock_table, func);
+    } else if(startswith(buffer, "stats ") && argno == 1) {
+        result = completion_matches_table(text, stats_table, func);
     } else if(startswith(buffer, "addf ") && argno == 1) {
         result = func(text, funct_generator);
     } else if(startswith(buffer, "addf ") && argno == 2) {
@@ -92,6 +92,8 @@ static void rm_normal_button_clicked(GtkWidget * widget, gpointer * gdata);
 static void rm_single_button_clicked(GtkWidget * widget, gpointer * gdata);
 static void rm_roll_button_clicked(GtkWidget * widget, gpointer * gdata);
 static void rm_stop_button_clicked(GtkWidget * widget, gpointer * gdata);
+static void rm_record_button_clicked(GtkWidget * widget, gpointer * gdata);
+static void change_run_mode(scope_run_mode_t mode);
 
 /***********************************************************************
 *                        MAIN() FUNCTION                               *
@@ -105,6 +107,7 @@ int main(int argc, gchar * argv[])
     int num_samples = SCOPE_NUM_SAMPLES_DEFAULT;
     char *ifilename = "autosave.halscope";
     char *ofilename = "autosave.halscope";
+    char *rfilename = NULL;
 
     bindtextdomain("linuxcnc", EMC2_PO_DIR);
     setlocale(LC_MESSAGES,"");
@@ -118,13 +121,13 @@ int main(int argc, gchar * argv[])
 
     while(1) {
         int c;
-        c = getopt(argc, argv, "hi:o:");
+        c = getopt(argc, argv, "hi:o:r:");
         if(c == -1) break;
         switch(c) {
          case 'h':
             rtapi_print_msg(RTAPI_MSG_ERR,
             _("Usage:\n  halscope [-h] [-i infile] [-o outfile]"
-            " [num_samples]\n"));
+            " [-r recordfile] [num_samples]\n"));
             return -1;
             break;
          case 'i':
@@ -133,6 +136,9 @@ int main(int argc, gchar * argv[])
          case 'o':
             ofilename = optarg;
             break;
+         case 'r':
+            rfilename = optarg;
+            break;
         }
     }
     if(argc > optind) num_samples = atoi(argv[argc-1]);
@@ -201,6 +207,13 @@ int main(int argc, gchar * argv[])
     init_trig();
     init_display();
     init_run_mode_window();
+    if (rfilename != NULL && init_stream(rfilename) < 0) {
+	/* carry on without recording */
+	rfilename = NULL;
+    }
+    if (rfilename != NULL) {
+	gtk_widget_set_sensitive(ctrl_usr->rm_record_button, TRUE);
+    }
     /* register signal handlers for ctrl-C and SIGTERM */
     signal(SIGINT, quit);
     signal(SIGTERM, quit);
@@ -210,10 +223,16 @@ int main(int argc, gchar * argv[])
     gtk_widget_show(ctrl_usr->main_win);
     /* read the saved config file */
     read_config_file(ifilename);
+    if (rfilename != NULL) {
+	/* asked to record, so start doing that */
+	gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(ctrl_usr->
+		rm_record_button), TRUE);
+    }
     /* arrange for periodic call of heartbeat() */
     gtk_timeout_add(100, heartbeat, NULL);
     /* enter the main loop */
     gtk_main();
+    close_stream();
     write_config_file(ofilename);
 
     return (0);
@@ -328,13 +347,16 @@ void start_capture(void)
 	}
     }
     ctrl_shm->pre_trig = (ctrl_shm->rec_len-2) * ctrl_usr->trig.position;
+    ctrl_shm->stream = (ctrl_usr->run_mode == RECORD);
+    if (ctrl_shm->stream) {
+	start_stream();
+    }
     ctrl_shm->state = INIT;
 }
 
-void capture_copy_data(void) {
+void set_channel_offsets(void)
+{
     int n, offs;
-    scope_data_t *src, *dst, *src_end;
-    int samp_len, samp_size;
 
     offs = 0;
     for (n = 0; n < 16; n++) {
@@ -347,6 +369,14 @@ void capture_copy_data(void) {
 	    ctrl_usr->vert.data_offset[n] = -1;
 	}
     }
+}
+
+void capture_copy_data(void) {
+    int n;
+    scope_data_t *src, *dst, *src_end;
+    int samp_len, samp_size;
+
+    set_channel_offsets();
     /* copy data from shared buffer to display buffer */
     ctrl_usr->samples = ctrl_shm->samples;
     samp_len = ctrl_shm->sample_len;
@@ -710,6 +740,11 @@ static void init_run_mode_window(void)
     ctrl_usr->rm_roll_button =
 	gtk_radio_button_new_with_label(gtk_radio_button_group
 	(GTK_RADIO_BUTTON(ctrl_usr->rm_stop_button)), _("Roll"));
+    ctrl_usr->rm_record_button =
+	gtk_radio_button_new_with_label(gtk_radio_button_group
+	(GTK_RADIO_BUTTON(ctrl_usr->rm_stop_button)), _("Record"));
+    /* recording needs a file from the command line */
+    gtk_widget_set_sensitive(ctrl_usr->rm_record_button, FALSE);
     /* now put them into the box */
     gtk_box_pack_start(GTK_BOX(ctrl_usr->run_mode_win),
 	ctrl_usr->rm_normal_button, FALSE, FALSE, 0);
@@ -717,6 +752,8 @@ static void init_run_mode_window(void)
 	ctrl_usr->rm_single_button, FALSE, FALSE, 0);
     gtk_box_pack_start(GTK_BOX(ctrl_usr->run_mode_win),
 	ctrl_usr->rm_roll_button, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(ctrl_usr->run_mode_win),
+	ctrl_usr->rm_record_button, FALSE, FALSE, 0);
     gtk_box_pack_start(GTK_BOX(ctrl_usr->run_mode_win),
 	ctrl_usr->rm_stop_button, FALSE, FALSE, 0);
     /* hook callbacks to buttons */
@@ -728,10 +765,13 @@ static void init_run_mode_window(void)
 	GTK_SIGNAL_FUNC(rm_roll_button_clicked), NULL);
     gtk_signal_connect(GTK_OBJECT(ctrl_usr->rm_stop_button), "clicked",
 	GTK_SIGNAL_FUNC(rm_stop_button_clicked), NULL);
+    gtk_signal_connect(GTK_OBJECT(ctrl_usr->rm_record_button), "clicked",
+	GTK_SIGNAL_FUNC(rm_record_button_clicked), NULL);
     /* and make them visible */
     gtk_widget_show(ctrl_usr->rm_normal_button);
     gtk_widget_show(ctrl_usr->rm_single_button);
     gtk_widget_show(ctrl_usr->rm_roll_button);
+    gtk_widget_show(ctrl_usr->rm_record_button);
     gtk_widget_show(ctrl_usr->rm_stop_button);
 }
 
@@ -807,10 +847,7 @@ static void rm_normal_button_clicked(GtkWidget * widget, gpointer * gdata)
 	/* not pressed, ignore it */
 	return;
     }
-    ctrl_usr->run_mode = NORMAL;
-    if (ctrl_shm->state == IDLE) {
-	start_capture();
-    }
+    change_run_mode(NORMAL);
 }
 
 static void rm_single_button_clicked(GtkWidget * widget, gpointer * gdata)
@@ -819,10 +856,7 @@ static void rm_single_button_clicked(GtkWidget * widget, gpointer * gdata)
 	/* not pressed, ignore it */
 	return;
     }
-    ctrl_usr->run_mode = SINGLE;
-    if (ctrl_shm->state == IDLE) {
-	start_capture();
-    }
+    change_run_mode(SINGLE);
 }
 
 static void rm_roll_button_clicked(GtkWidget * widget, gpointer * gdata)
@@ -831,10 +865,7 @@ static void rm_roll_button_clicked(GtkWidget * widget, gpointer * gdata)
 	/* not pressed, ignore it */
 	return;
     }
-    ctrl_usr->run_mode = ROLL;
-    if (ctrl_shm->state == IDLE) {
-	start_capture();
-    }
+    change_run_mode(ROLL);
 }
 
 static void rm_stop_button_clicked(GtkWidget * widget, gpointer * gdata)
@@ -850,6 +881,26 @@ static void rm_stop_button_clicked(GtkWidget * widget, gpointer * gdata)
     ctrl_usr->run_mode = STOP;
 }
 
+static void rm_record_button_clicked(GtkWidget * widget, gpointer * gdata)
+{
+    if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget)) != TRUE) {
+	/* not pressed, ignore it */
+	return;
+    }
+    change_run_mode(RECORD);
+}
+
+static void change_run_mode(scope_run_mode_t mode)
+{
+    ctrl_usr->run_mode = mode;
+    if (ctrl_shm->state == IDLE) {
+	start_capture();
+    } else if (mode == RECORD || ctrl_shm->state == STREAMING) {
+	/* a sweep and a recording don't mix, restart in the new mode */
+	prepare_scope_restart();
+    }
+}
+
 void prepare_scope_restart(void) {
     if(ctrl_usr->pending_restart) return;
     ctrl_shm->state = RESET;
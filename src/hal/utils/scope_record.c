@@ -0,0 +1,288 @@
+/** This file, 'scope_record.c', writes the record file of halscope's
+    RECORD mode.  It only knows the file format; which samples go into
+    the file is decided in 'scope_stream.c'.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"		/* HAL public API decls */
+#include "scope_record.h"	/* declarations for this file */
+
+/***********************************************************************
+*                         DOCUMENTATION                                *
+************************************************************************/
+
+/* The record file is a sequence of records, each a 4 character tag,
+   a u32 with the size of the payload, and the payload.  All numbers
+   are little-endian.  A new session starts each time recording starts:
+
+   HSRS  u64 sample period in ns, u32 samples before the trigger,
+         u32 samples from the trigger on, u32 number of channels, then
+         for each channel u8 channel number (1-16), u8 HAL type,
+         u8 length of the name and the name
+   HSRT  u64 sample number of a trigger
+   HSRB  u64 sample number of the first sample, u32 number of samples,
+         then the samples
+   HSRL  u64 sample number of the first sample lost, u64 number lost
+
+   Sample numbers count from 0 at the start of the session.  In a HSRB
+   block, each sample holds a value for every channel in the order of
+   the HSRS record.  The values are packed as a stream of bits, most
+   significant bit first, padded with 0 bits to a whole byte at the end
+   of the block.  Each channel is encoded relative to its value in the
+   sample before; the first sample of a block is relative to 0.
+
+   A float is stored as in Gorilla (Pelkonen et al., VLDB 2015): its 64
+   bit pattern is XORed with the one before.  If that is 0 (the value
+   did not change), a single 0 bit is written.  Otherwise a 1 bit, then
+   a 0 bit and the bits of the XOR that lie in the window of meaningful
+   bits of the last value written in full, if all of its 1 bits are in
+   that window, or else a 1 bit, the number of leading 0 bits (5 bits,
+   at most 31), the number of meaningful bits (6 bits, 64 written as 0)
+   and the meaningful bits, which become the new window.  A held value
+   takes one bit, a slowly changing one about as many bits as differ
+   from the value before.
+
+   A s32 or u32 is stored as the signed 32 bit difference to the value
+   before and a bit as the difference of its 0 or 1, both zigzag encoded
+   as a LEB128 varint of 8 bit groups in the bit stream.
+*/
+
+typedef struct {
+    unsigned char *p;		/* byte being filled */
+    int used;			/* bits of it filled so far */
+} bit_writer_t;
+
+/***********************************************************************
+*                  LOCAL FUNCTION PROTOTYPES                           *
+************************************************************************/
+
+static void write_record(FILE *fp, const char *tag,
+    const unsigned char *payload, int size);
+static unsigned char *put_u32(unsigned char *p, unsigned int v);
+static unsigned char *put_u64(unsigned char *p, unsigned long long v);
+static void put_bits(bit_writer_t *w, unsigned long long v, int n);
+static void put_varint(bit_writer_t *w, unsigned long long v);
+static void put_xor(bit_writer_t *w, unsigned long long x, int *lead,
+    int *trail);
+
+/***********************************************************************
+*                       PUBLIC FUNCTIONS                               *
+************************************************************************/
+
+void record_session(FILE *fp, unsigned long long period, int pre, int post,
+    int nchan, const int *num, const hal_type_t *type, char **name)
+{
+    unsigned char buf[20 + 16 * (3 + HAL_NAME_LEN)], *p;
+    int n, len;
+
+    p = put_u64(buf, period);
+    p = put_u32(p, pre);
+    p = put_u32(p, post);
+    p = put_u32(p, nchan);
+    for (n = 0; n < nchan; n++) {
+	*p++ = num[n];
+	*p++ = type[n];
+	len = name[n] ? strlen(name[n]) : 0;
+	if (len > HAL_NAME_LEN) {
+	    len = HAL_NAME_LEN;
+	}
+	*p++ = len;
+	memcpy(p, name[n], len);
+	p += len;
+    }
+    write_record(fp, "HSRS", buf, p - buf);
+}
+
+void record_trigger(FILE *fp, unsigned long long sample)
+{
+    unsigned char buf[8];
+
+    put_u64(buf, sample);
+    write_record(fp, "HSRT", buf, sizeof(buf));
+}
+
+void record_lost(FILE *fp, unsigned long long first,
+    unsigned long long count)
+{
+    unsigned char buf[16], *p;
+
+    p = put_u64(buf, first);
+    put_u64(p, count);
+    write_record(fp, "HSRL", buf, sizeof(buf));
+}
+
+void record_block(FILE *fp, unsigned char *block, unsigned long long first,
+    int count, const scope_data_t *hist, int hist_len, int nchan,
+    const hal_type_t *type)
+{
+    unsigned long long n, prev[16], raw, diff;
+    int lead[16], trail[16];
+    const scope_data_t *d;
+    unsigned char *p;
+    bit_writer_t w;
+    int k;
+
+    p = put_u64(block, first);
+    w.p = put_u32(p, count);
+    *w.p = 0;
+    w.used = 0;
+    for (k = 0; k < nchan; k++) {
+	prev[k] = 0;
+	lead[k] = -1;
+	trail[k] = 0;
+    }
+    for (n = first; n < first + count; n++) {
+	d = hist + (n % hist_len) * nchan;
+	for (k = 0; k < nchan; k++) {
+	    switch (type[k]) {
+	    case HAL_FLOAT:
+		raw = d[k].d_ireal;
+		put_xor(&w, raw ^ prev[k], &lead[k], &trail[k]);
+		break;
+	    case HAL_BIT:
+		raw = d[k].d_u8;
+		put_varint(&w, raw - prev[k]);
+		break;
+	    default:
+		raw = d[k].d_u32;
+		diff = (unsigned) (raw - prev[k]);
+		if (diff & 0x80000000u) {
+		    /* sign extend */
+		    diff |= 0xffffffff00000000ull;
+		}
+		put_varint(&w, diff);
+		break;
+	    }
+	    prev[k] = raw;
+	}
+    }
+    p = w.used ? w.p + 1 : w.p;
+    write_record(fp, "HSRB", block, p - block);
+}
+
+/***********************************************************************
+*                       LOCAL FUNCTIONS                                *
+************************************************************************/
+
+static void write_record(FILE *fp, const char *tag,
+    const unsigned char *payload, int size)
+{
+    unsigned char head[8];
+
+    memcpy(head, tag, 4);
+    put_u32(head + 4, size);
+    if (fwrite(head, sizeof(head), 1, fp) != 1 ||
+	fwrite(payload, size, 1, fp) != 1) {
+	fprintf(stderr, "halscope: error writing record file\n");
+    }
+}
+
+static unsigned char *put_u32(unsigned char *p, unsigned int v)
+{
+    int n;
+
+    for (n = 0; n < 4; n++) {
+	*p++ = v >> (8 * n);
+    }
+    return p;
+}
+
+static unsigned char *put_u64(unsigned char *p, unsigned long long v)
+{
+    int n;
+
+    for (n = 0; n < 8; n++) {
+	*p++ = v >> (8 * n);
+    }
+    return p;
+}
+
+static void put_bits(bit_writer_t *w, unsigned long long v, int n)
+{
+    int take;
+
+    /* the low n bits of v, highest first */
+    while (n > 0) {
+	take = 8 - w->used;
+	if (take > n) {
+	    take = n;
+	}
+	n -= take;
+	*w->p |= ((v >> n) & ((1u << take) - 1)) << (8 - w->used - take);
+	w->used += take;
+	if (w->used == 8) {
+	    *++w->p = 0;
+	    w->used = 0;
+	}
+    }
+}
+
+static void put_varint(bit_writer_t *w, unsigned long long v)
+{
+    unsigned long long u;
+
+    /* zigzag, so small negative numbers are short too */
+    u = (v << 1) ^ (0 - (v >> 63));
+    while (u >= 0x80) {
+	put_bits(w, (u & 0x7f) | 0x80, 8);
+	u >>= 7;
+    }
+    put_bits(w, u, 8);
+}
+
+static void put_xor(bit_writer_t *w, unsigned long long x, int *lead,
+    int *trail)
+{
+    int lz, tz, len;
+
+    if (x == 0) {
+	put_bits(w, 0, 1);
+	return;
+    }
+    lz = __builtin_clzll(x);
+    if (lz > 31) {
+	lz = 31;
+    }
+    tz = __builtin_ctzll(x);
+    if (*lead >= 0 && lz >= *lead && tz >= *trail) {
+	/* fits the window of the value before */
+	put_bits(w, 2, 2);
+	put_bits(w, x >> *trail, 64 - *lead - *trail);
+	return;
+    }
+    len = 64 - lz - tz;
+    put_bits(w, 3, 2);
+    put_bits(w, lz, 5);
+    put_bits(w, len & 63, 6);
+    put_bits(w, x >> tz, len);
+    *lead = lz;
+    *trail = tz;
+}
@@ -0,0 +1,71 @@
+#ifndef HALSC_RECORD_H
+#define HALSC_RECORD_H
+/** This file, 'scope_record.h', declares the functions that write the
+    record file of "halscope -r".  They are kept apart from the GTK
+    code in 'scope_stream.c' so that the file format can be tested on
+    its own.  The format is described in 'scope_record.c'.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include <stdio.h>
+#include "hal.h"
+#include "scope_shm.h"
+
+/***********************************************************************
+*                         TYPEDEFS AND DEFINES                         *
+************************************************************************/
+
+#define RECORD_BLOCK	1024	/* most samples in one HSRB record */
+
+/* size of the buffer record_block() needs; a varint is at most 10
+   bytes, a float at most 2 + 5 + 6 + 64 bits */
+#define RECORD_BLOCK_BYTES(nchan)	(13 + 10 * RECORD_BLOCK * (nchan))
+
+/***********************************************************************
+*                            FUNCTIONS                                 *
+************************************************************************/
+
+/* the HSRS record that starts a session; 'num' are the channel
+   numbers (1-16) and 'name' the names, which may be NULL */
+void record_session(FILE *fp, unsigned long long period, int pre, int post,
+    int nchan, const int *num, const hal_type_t *type, char **name);
+
+/* a HSRT record for a trigger at sample 'sample' */
+void record_trigger(FILE *fp, unsigned long long sample);
+
+/* a HSRL record for 'count' samples lost from sample 'first' on */
+void record_lost(FILE *fp, unsigned long long first,
+    unsigned long long count);
+
+/* a HSRB record of samples 'first' to 'first + count - 1', count at
+   most RECORD_BLOCK; sample N is at hist + (N % hist_len) * nchan,
+   and 'block' is a buffer of RECORD_BLOCK_BYTES(nchan) */
+void record_block(FILE *fp, unsigned char *block, unsigned long long first,
+    int count, const scope_data_t *hist, int hist_len, int nchan,
+    const hal_type_t *type);
+
+#endif /* HALSC_RECORD_H */
@@ -38,6 +38,7 @@
 #include "../hal_priv.h"	/* HAL private API decls */
 #include "scope_rt.h"		/* scope related declarations */
 #include "rtapi_string.h"
+#include "rtapi_atomic.h"
 
 /* module information */
 MODULE_AUTHOR("John Kasunich");
@@ -182,6 +183,15 @@ static void sample(void *arg, long period)
 	    ctrl_rt->data_type[n] = ctrl_shm->data_type[n];
 	    ctrl_rt->data_len[n] = ctrl_shm->data_len[n];
 	}
+	if (ctrl_shm->stream) {
+	    /* acquire until stopped, user space drains the buffer */
+	    ctrl_shm->stream_count = 0;
+	    ctrl_shm->trig_count = 0;
+	    ctrl_shm->state = STREAMING;
+	    /* dummy call to preset 'compare_result' */
+	    check_trigger();
+	    break;
+	}
 	/* set next state */
 	ctrl_shm->state = PRE_TRIG;
 	break;
@@ -232,6 +242,23 @@ static void sample(void *arg, long period)
     case DONE:
 	/* do nothing while GUI displays waveform */
 	break;
+    case STREAMING:
+	/* acquire a sample, overwriting the oldest one */
+	capture_sample();
+	/* publish it only once it is complete */
+	atomic_store_explicit(&ctrl_shm->stream_count,
+	    ctrl_shm->stream_count + 1, memory_order_release);
+	if (check_trigger()) {
+	    /* note the trigger and keep going, user space decides
+	       what to keep around it */
+	    ctrl_shm->trig_sample[ctrl_shm->trig_count % SCOPE_STREAM_TRIGS] =
+		ctrl_shm->stream_count - 1;
+	    atomic_store_explicit(&ctrl_shm->trig_count,
+		ctrl_shm->trig_count + 1, memory_order_release);
+	    ctrl_shm->force_trig = 0;
+	    ctrl_rt->auto_timer = 0;
+	}
+	break;
     default:
 	/* shouldn't get here - if we do, set a legal state */
 	ctrl_shm->state = IDLE;
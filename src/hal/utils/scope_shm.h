@@ -43,6 +43,7 @@
 
 #define SCOPE_SHM_KEY  0x130CF406
 #define SCOPE_NUM_SAMPLES_DEFAULT 16000
+#define SCOPE_STREAM_TRIGS 16	/* triggers remembered while streaming */
 
 typedef enum {
     IDLE = 0,			/* waiting for run command */
@@ -51,7 +52,8 @@ typedef enum {
     TRIG_WAIT,			/* waiting for trigger */
     POST_TRIG,			/* acquiring post-trigger data */
     DONE,			/* data acquisition complete */
-    RESET			/* data acquisition interrupted */
+    RESET,			/* data acquisition interrupted */
+    STREAMING			/* acquiring continuously into a ring */
 } scope_state_t;
 
 /* this struct holds a single value - one sample of one channel */
@@ -88,6 +90,11 @@ typedef struct {
     int curr;			/* R next sample to be acquired */
     int samples;		/* R number of valid samples */
     scope_state_t state;	/* RU current state */
+    int stream;			/* U INIT starts STREAMING, not PRE_TRIG */
+    unsigned int stream_count;	/* R samples acquired while STREAMING */
+    unsigned int trig_count;	/* R triggers seen while STREAMING */
+    unsigned int trig_sample[SCOPE_STREAM_TRIGS];	/* R sample number
+				   of trigger N at [N % SCOPE_STREAM_TRIGS] */
     int data_offset[16];	/* U data addr in shmem for each channel */
     hal_type_t data_type[16];	/* U data type for each channel */
     char data_len[16];		/* U data size, 0 if not to be acquired */
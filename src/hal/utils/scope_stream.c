@@ -0,0 +1,341 @@
+/** This file, 'scope_stream.c', records to disk for halscope.
+    In RECORD mode the realtime part acquires continuously into its
+    ring buffer and only counts samples and triggers.  This code drains
+    the ring from a GTK timeout, keeps a window of samples around each
+    trigger, and writes those windows to the record file as compressed
+    blocks.  The last complete window is also shown on the screen.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"		/* HAL public API decls */
+#include "rtapi_atomic.h"
+
+#include <gtk/gtk.h>
+#include "miscgtk.h"		/* generic GTK stuff */
+#include "scope_usr.h"		/* scope related declarations */
+#include "scope_record.h"	/* record file format */
+
+/***********************************************************************
+*                         DOCUMENTATION                                *
+************************************************************************/
+
+/* Samples are only written within pre-trigger samples before and
+   post-trigger samples after a trigger.  Windows that overlap are
+   merged.  If the drain falls behind the realtime code, the samples
+   it lost are noted with a HSRL record.  The file format is described
+   in 'scope_record.c'.
+*/
+
+#define STREAM_DRAIN_MS	20	/* how often the ring is drained */
+
+typedef struct {
+    FILE *fp;			/* the record file, NULL if none */
+    int timer;			/* drain timeout is running */
+    int nchan;			/* number of channels acquired */
+    hal_type_t type[16];	/* and their types */
+    int sample_len;		/* ring layout, copied from ctrl_shm */
+    int cap;			/* samples in the ring */
+    int pre;			/* samples kept before a trigger */
+    int post;			/* samples kept from a trigger on */
+    unsigned long long read;	/* next sample to take from the ring */
+    unsigned long long valid;	/* oldest sample in 'hist' that is intact */
+    unsigned long long write;	/* next sample to write to the file */
+    unsigned long long until;	/* end of the window(s) being written */
+    int shown;			/* window ending at 'until' was displayed */
+    unsigned int trig_read;	/* next trigger to take from ctrl_shm */
+    int hist_len;		/* samples in 'hist' */
+    scope_data_t *hist;		/* recent samples, sample N at N % hist_len */
+    unsigned char *block;	/* a HSRB record being built */
+} scope_stream_t;
+
+static scope_stream_t strm;
+
+/***********************************************************************
+*                  LOCAL FUNCTION PROTOTYPES                           *
+************************************************************************/
+
+static int drain_timeout(gpointer data);
+static void drain(void);
+static void take_samples(void);
+static void take_triggers(void);
+static void write_samples(void);
+static void show_window(void);
+
+/***********************************************************************
+*                       PUBLIC FUNCTIONS                               *
+************************************************************************/
+
+int init_stream(char *filename)
+{
+    strm.fp = fopen(filename, "wb");
+    if (strm.fp == NULL) {
+	fprintf(stderr, "halscope: can't open record file '%s'\n", filename);
+	return -1;
+    }
+    return 0;
+}
+
+void start_stream(void)
+{
+    int n, num[16];
+    char *name[16];
+
+    if (strm.fp == NULL) {
+	return;
+    }
+    /* finish the previous session, RT is idle so nothing moves */
+    if (strm.hist != NULL) {
+	drain();
+	free(strm.hist);
+	free(strm.block);
+	strm.hist = NULL;
+	strm.block = NULL;
+    }
+    strm.nchan = 0;
+    for (n = 0; n < 16; n++) {
+	if (ctrl_shm->data_len[n] > 0) {
+	    num[strm.nchan] = n + 1;
+	    name[strm.nchan] = ctrl_usr->chan[n].name;
+	    strm.type[strm.nchan++] = ctrl_shm->data_type[n];
+	}
+    }
+    strm.sample_len = ctrl_shm->sample_len;
+    strm.cap = ctrl_shm->rec_len;
+    strm.pre = ctrl_shm->pre_trig;
+    strm.post = ctrl_shm->rec_len - ctrl_shm->pre_trig;
+    strm.read = strm.valid = strm.write = strm.until = 0;
+    strm.shown = 1;
+    strm.trig_read = 0;
+    /* room for the unwritten part of a window and the samples before
+       the next trigger, each at most a ring full */
+    strm.hist_len = 2 * strm.cap;
+    strm.hist = malloc(sizeof(scope_data_t) * strm.hist_len * strm.nchan + 1);
+    strm.block = malloc(RECORD_BLOCK_BYTES(strm.nchan));
+    if (strm.hist == NULL || strm.block == NULL) {
+	fprintf(stderr, "halscope: out of memory, not recording\n");
+	free(strm.hist);
+	free(strm.block);
+	strm.hist = NULL;
+	strm.block = NULL;
+	return;
+    }
+    record_session(strm.fp, ctrl_usr->horiz.sample_period_ns, strm.pre,
+	strm.post, strm.nchan, num, strm.type, name);
+    fflush(strm.fp);
+    if (!strm.timer) {
+	gtk_timeout_add(STREAM_DRAIN_MS, drain_timeout, NULL);
+	strm.timer = 1;
+    }
+}
+
+void close_stream(void)
+{
+    if (strm.fp == NULL) {
+	return;
+    }
+    if (strm.hist != NULL) {
+	if (ctrl_shm->state == STREAMING) {
+	    /* freeze the ring for the last drain */
+	    ctrl_shm->state = RESET;
+	}
+	drain();
+    }
+    fclose(strm.fp);
+    strm.fp = NULL;
+}
+
+/***********************************************************************
+*                       LOCAL FUNCTIONS                                *
+************************************************************************/
+
+static int drain_timeout(gpointer data)
+{
+    if (strm.fp == NULL || strm.hist == NULL) {
+	strm.timer = 0;
+	return FALSE;
+    }
+    if (ctrl_shm->state == STREAMING) {
+	drain();
+	return TRUE;
+    }
+    if (ctrl_shm->state == INIT) {
+	/* RT hasn't started yet */
+	return TRUE;
+    }
+    /* stopped, pick up what is left and wait for the next start */
+    drain();
+    free(strm.hist);
+    free(strm.block);
+    strm.hist = NULL;
+    strm.block = NULL;
+    strm.timer = 0;
+    return FALSE;
+}
+
+static void drain(void)
+{
+    take_samples();
+    take_triggers();
+    write_samples();
+    fflush(strm.fp);
+}
+
+/* extend a 32 bit counter from RT to 64 bits, near 'ref' */
+static unsigned long long extend(unsigned long long ref, unsigned int v)
+{
+    return ref + (int) (v - (unsigned int) ref);
+}
+
+static void take_samples(void)
+{
+    unsigned long long count, first, n, oldest;
+    unsigned int rt_count;
+    size_t size;
+
+    rt_count = atomic_load_explicit(&ctrl_shm->stream_count,
+	memory_order_acquire);
+    count = extend(strm.read, rt_count);
+    first = strm.read;
+    if (count - first > (unsigned long long) strm.cap) {
+	/* RT went round the ring since the last drain */
+	first = count - strm.cap;
+	strm.valid = first;
+    }
+    size = sizeof(scope_data_t) * strm.nchan;
+    for (n = first; n < count; n++) {
+	memcpy(strm.hist + (n % strm.hist_len) * strm.nchan,
+	    ctrl_usr->buffer + (n % strm.cap) * strm.sample_len, size);
+    }
+    strm.read = count;
+    /* RT may have overwritten the oldest of them while we copied;
+       it is writing sample 'count' into the slot of 'count - cap' */
+    rt_count = atomic_load_explicit(&ctrl_shm->stream_count,
+	memory_order_acquire);
+    count = extend(strm.read, rt_count);
+    if (count >= (unsigned long long) strm.cap) {
+	oldest = count - strm.cap + 1;
+	if (oldest > first && oldest > strm.valid) {
+	    strm.valid = oldest;
+	}
+    }
+    if (strm.read > (unsigned long long) strm.hist_len &&
+	strm.read - strm.hist_len > strm.valid) {
+	strm.valid = strm.read - strm.hist_len;
+    }
+}
+
+static void take_triggers(void)
+{
+    unsigned long long trig, start;
+    unsigned int rt_count;
+
+    rt_count = atomic_load_explicit(&ctrl_shm->trig_count,
+	memory_order_acquire);
+    if (rt_count - strm.trig_read > SCOPE_STREAM_TRIGS) {
+	/* too many since the last drain, only the latest are known */
+	strm.trig_read = rt_count - SCOPE_STREAM_TRIGS;
+    }
+    while (strm.trig_read != rt_count) {
+	trig = extend(strm.read,
+	    ctrl_shm->trig_sample[strm.trig_read % SCOPE_STREAM_TRIGS]);
+	if (trig >= strm.read) {
+	    /* its sample came in after take_samples(), next time */
+	    break;
+	}
+	strm.trig_read++;
+	start = trig > (unsigned long long) strm.pre ? trig - strm.pre : 0;
+	if (start > strm.until) {
+	    /* not joined to the window before, finish that one and
+	       skip what is in between */
+	    write_samples();
+	    strm.write = start;
+	}
+	record_trigger(strm.fp, trig);
+	if (trig + strm.post > strm.until) {
+	    strm.until = trig + strm.post;
+	    strm.shown = 0;
+	}
+    }
+}
+
+static void write_samples(void)
+{
+    unsigned long long end, lost;
+    int count;
+
+    end = strm.until < strm.read ? strm.until : strm.read;
+    if (strm.write < end && strm.write < strm.valid) {
+	/* overwritten before they could be written */
+	lost = (strm.valid < end ? strm.valid : end) - strm.write;
+	record_lost(strm.fp, strm.write, lost);
+	strm.write += lost;
+    }
+    while (strm.write < end) {
+	count = end - strm.write;
+	if (count > RECORD_BLOCK) {
+	    count = RECORD_BLOCK;
+	}
+	record_block(strm.fp, strm.block, strm.write, count, strm.hist,
+	    strm.hist_len, strm.nchan, strm.type);
+	strm.write += count;
+    }
+    if (!strm.shown && strm.write >= strm.until) {
+	show_window();
+	strm.shown = 1;
+    }
+}
+
+/* put the rec_len samples up to the end of the window on screen */
+static void show_window(void)
+{
+    unsigned long long first, n;
+    scope_data_t *dst;
+    int k;
+
+    if (strm.until < (unsigned long long) strm.cap ||
+	strm.until - strm.cap < strm.valid) {
+	/* not all of it is at hand */
+	return;
+    }
+    set_channel_offsets();
+    dst = ctrl_usr->disp_buf;
+    memset(dst, 0, sizeof(scope_data_t) * ctrl_shm->buf_len);
+    first = strm.until - strm.cap;
+    for (n = first; n < strm.until; n++) {
+	for (k = 0; k < strm.nchan; k++) {
+	    dst[k] = strm.hist[(n % strm.hist_len) * strm.nchan + k];
+	}
+	dst += strm.sample_len;
+    }
+    ctrl_usr->samples = strm.cap;
+    refresh_display();
+}
@@ -196,7 +196,7 @@ typedef struct {
 
 /* this is the master user space control structure */
 
-typedef enum { STOP = 0, NORMAL, SINGLE, ROLL } scope_run_mode_t;
+typedef enum { STOP = 0, NORMAL, SINGLE, ROLL, RECORD } scope_run_mode_t;
 
 typedef struct {
     /* general data */
@@ -223,6 +223,7 @@ typedef struct {
     GtkWidget *rm_single_button;
     GtkWidget *rm_roll_button;
     GtkWidget *rm_stop_button;
+    GtkWidget *rm_record_button;
     /* subsection control data */
     scope_chan_t chan[16];	/* channel specific data */
     scope_horiz_t horiz;	/* horizontal control data */
@@ -253,6 +254,7 @@ void refresh_state_info(void);
 void capture_complete(void);
 void capture_cont(void);
 void start_capture(void);
+void set_channel_offsets(void);
 void request_display_refresh(int delay);
 void refresh_display(void);
 void refresh_trigger(void);
@@ -296,4 +298,9 @@ int set_trigger_mode(int mode);
 int set_run_mode(int mode);
 void prepare_scope_restart(void);
 void log_popup(int);
+
+/* recording to disk, in scope_stream.c */
+int init_stream(char *filename);
+void start_stream(void);
+void close_stream(void);
 #endif /* HALSC_USR_H */
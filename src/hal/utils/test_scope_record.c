@@ -0,0 +1,111 @@
+/** This file, 'test_scope_record.c', writes a halscope record file of
+    known samples to stdout, for tests/halscope-record to read back
+    with scripts/halscope-record.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"		/* HAL public API decls */
+#include "scope_record.h"	/* record file format */
+
+#define NCHAN	4
+#define HIST_LEN 16		/* less than the samples, so it wraps */
+
+/* the float bit patterns, chosen to take every path of the encoder;
+   samples 12 to 14 are lost, and each block starts again from 0 */
+static const unsigned long long f[] = {
+    0x3ff0000000000000ull,	/* 1.0, new window */
+    0x3ff0000000000000ull,	/* held */
+    0x4008000000000000ull,	/* 3.0, new window */
+    0x4000000000000000ull,	/* 2.0, inside the last window */
+    0x4004000000000000ull,	/* 2.5, new window */
+    0x4004000000000000ull,	/* held */
+    0x0000000000000001ull,	/* smallest denormal, 63 bit window */
+    0x8000000000000001ull,	/* its negative, 1 bit window */
+    0x0000000000000000ull,	/* 0, all 64 bits meaningful */
+    0xc08f410000000000ull,	/* -1000.125, inside the 64 bit window */
+    0xc08f410000000000ull,	/* held */
+    0x0000000000000002ull,	/* denormal, inside the 64 bit window */
+    0, 0, 0,			/* lost */
+    0x0000000000000002ull,	/* 62 leading zeros, written as 31 */
+    0x0000000000000004ull,	/* inside that window */
+    0x0000000000000004ull,	/* held */
+    0x3fe0000000000000ull,	/* 0.5, new window */
+    0x3fe8000000000000ull,	/* 0.75, inside the last window */
+    0xbfe8000000000000ull,	/* -0.75, sign bit only */
+    0x3fe8000000000000ull,	/* 0.75, the same bit again */
+    0x4059000000000000ull,	/* 100.0, new window */
+    0x4059000000000000ull,	/* held */
+};
+
+/* differences of both signs across the varint byte boundaries and
+   the 32 bit wrap */
+static const rtapi_s32 s[] = {
+    0, -1, 2147483647, -2147483647 - 1, -2147483647 - 1, 1, 123456789,
+    -5, -5, 0, 7, -300,
+    0, 0, 0,
+    -2147483647 - 1, 2147483647, 0, 63, -1, 63, -65, 8191, -8192,
+};
+
+static const rtapi_u32 u[] = {
+    0, 4294967295u, 0, 2147483648u, 2147483647u, 1, 1, 4000000000u,
+    5, 5, 0, 99,
+    0, 0, 0,
+    4294967295u, 4294967294u, 0, 1, 127, 128, 16384, 16383, 3000000000u,
+};
+
+static const unsigned char b[] = {
+    0, 1, 1, 0, 0, 1, 0, 1, 1, 1, 0, 1,
+    0, 0, 0,
+    1, 1, 0, 0, 1, 0, 1, 1, 0,
+};
+
+static const hal_type_t type[NCHAN] = { HAL_FLOAT, HAL_S32, HAL_U32, HAL_BIT };
+static const int num[NCHAN] = { 1, 2, 5, 16 };
+static char *name[NCHAN] = { "test.float", "test.s32", "test.u32", NULL };
+
+static scope_data_t hist[HIST_LEN * NCHAN];
+static unsigned char block[RECORD_BLOCK_BYTES(NCHAN)];
+
+/* put samples first to first + count - 1 in the history and write them */
+static void write_block(int first, int count)
+{
+    scope_data_t *d;
+    int n;
+
+    for (n = first; n < first + count; n++) {
+	d = hist + (n % HIST_LEN) * NCHAN;
+	memset(d, 0, sizeof(scope_data_t) * NCHAN);
+	d[0].d_ireal = f[n];
+	d[1].d_s32 = s[n];
+	d[2].d_u32 = u[n];
+	d[3].d_u8 = b[n];
+    }
+    record_block(stdout, block, first, count, hist, HIST_LEN, NCHAN, type);
+}
+
+int main(void)
+{
+    record_session(stdout, 1000000, 4, 8, NCHAN, num, type, name);
+    record_trigger(stdout, 4);
+    write_block(0, 12);
+    record_lost(stdout, 12, 3);
+    record_trigger(stdout, 19);
+    write_block(15, 9);
+    return 0;
+}
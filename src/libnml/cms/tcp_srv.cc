@@ -31,8 +31,11 @@ extern "C" {
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/epoll.h>		/* epoll_create1(), epoll_wait() */
+#include <fcntl.h>		/* fcntl(), O_NONBLOCK */
 #include <errno.h>		/* errno */
 #include <signal.h>		// SIGPIPE, signal()
+#include <math.h>		/* ceil() */
 
 #ifdef __cplusplus
 }
@@ -52,7 +55,6 @@ extern "C" {
 #include "_timer.h"
 #include "cmsdiag.hh"		// class CMS_DIAGNOSTICS_INFO
 extern "C" {
-#include "recvn.h"		/* recvn() */
 #include "sendn.h"		/* sendn() */
 }
 #include "physmem.hh"           // PHYSMEM_HANDLE
@@ -62,6 +64,9 @@ int tcpsvr_threads_killed = 0;
 int tcpsvr_threads_exited = 0;
 int tcpsvr_threads_returned_early = 0;
 
+/* Events handled per call to epoll_wait(), more stay queued for the next. */
+#define TCPSVR_MAX_EVENTS 64
+
 TCPSVR_BLOCKING_READ_REQUEST::TCPSVR_BLOCKING_READ_REQUEST()
 {
     access_type = CMS_READ_ACCESS;	/* read or just peek */
@@ -133,7 +138,9 @@ CMS_SERVER_REMOTE_PORT(_cms_server)
     client_ports = (LinkedList *) NULL;
     connection_socket = 0;
     connection_port = 0;
-    maxfdpl = 0;
+    epoll_fd = -1;
+    closed_clients = 0;
+    request_data = NULL;
     dtimeout = 20.0;
 
     memset(&server_socket_address, 0, sizeof(server_socket_address));
@@ -147,13 +154,9 @@ CMS_SERVER_REMOTE_PORT(_cms_server)
 	return;
     }
     polling_enabled = 0;
-    memset(&select_timeout, 0, sizeof(select_timeout));
-    select_timeout.tv_sec = 30;
-    select_timeout.tv_usec = 30;
+    next_poll_time = 0.0;
     subscription_buffers = NULL;
     current_poll_interval_millis = 30000;
-    memset(&read_fd_set, 0, sizeof(read_fd_set));
-    memset(&write_fd_set, 0, sizeof(write_fd_set));
 }
 
 CMS_SERVER_REMOTE_TCP_PORT::~CMS_SERVER_REMOTE_TCP_PORT()
@@ -219,6 +222,10 @@ void CMS_SERVER_REMOTE_TCP_PORT::unregister_port()
 	close(connection_socket);
 	connection_socket = 0;
     }
+    if (epoll_fd >= 0) {
+	close(epoll_fd);
+	epoll_fd = -1;
+    }
 }
 
 int CMS_SERVER_REMOTE_TCP_PORT::accept_local_port_cms(CMS * _cms)
@@ -283,7 +290,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::register_port()
 	    ntohs(server_socket_address.sin_port));
 	return;
     }
-    if (listen(connection_socket, 5) < 0) {
+    if (listen(connection_socket, SOMAXCONN) < 0) {
 	rcs_print_error("listen error: %d -- %s\n", errno, strerror(errno));
 	rcs_print_error("TCP Server: error on call to listen for port %d.\n",
 	    ntohs(server_socket_address.sin_port));
@@ -301,215 +308,287 @@ static void handle_pipe_error(int signum)
     rcs_print_error("SIGPIPE intercepted.\n");
 }
 
+/* Clients are served from one epoll set.  The listening socket is
+   registered with a NULL data pointer and each client with its
+   CLIENT_TCP_PORT, so an event leads straight to its client instead of
+   to a scan of every connection.  Client sockets are non-blocking: what
+   a client sends is collected in its input buffer and a request is only
+   handled once all of it has arrived, so a client that stops halfway
+   through a request can not stall the others.  Replies are written with
+   sendn(), bounded by dtimeout; subscription updates are queued per
+   client and written without blocking. */
 void CMS_SERVER_REMOTE_TCP_PORT::run()
 {
     int bytes_ready;
     int ready_descriptors;
+    struct epoll_event ev, events[TCPSVR_MAX_EVENTS];
     if (NULL == client_ports) {
 	rcs_print_error("CMS_SERVER: List of client ports is NULL.\n");
 	return;
     }
-    CLIENT_TCP_PORT *new_client_port, *client_port_to_check;
-    FD_ZERO(&read_fd_set);
-    FD_ZERO(&write_fd_set);
-    FD_SET(connection_socket, &read_fd_set);
-    maxfdpl = connection_socket + 1;
+    CLIENT_TCP_PORT *client_port_to_check;
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+	rcs_print_error("epoll_create1 error: %d -- %s\n", errno,
+	    strerror(errno));
+	return;
+    }
+    fcntl(connection_socket, F_SETFL,
+	fcntl(connection_socket, F_GETFL) | O_NONBLOCK);
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, connection_socket, &ev) < 0) {
+	rcs_print_error("epoll_ctl error: %d -- %s\n", errno,
+	    strerror(errno));
+	return;
+    }
     signal(SIGPIPE, handle_pipe_error);
     rcs_print_debug(PRINT_CMS_CONFIG_INFO,
 	"running server for TCP port %d (connection_socket = %d).\n",
 	ntohs(server_socket_address.sin_port), connection_socket);
 
     cms_server_count++;
-    fd_set read_fd_set_copy, write_fd_set_copy;
-    FD_ZERO(&read_fd_set_copy);
-    FD_ZERO(&write_fd_set_copy);
-    FD_SET(connection_socket, &read_fd_set_copy);
 
     while (1) {
+	int timeout_millis = -1;
 	if (polling_enabled) {
-	    memcpy(&read_fd_set_copy, &read_fd_set, sizeof(fd_set));
-	    memcpy(&write_fd_set_copy, &write_fd_set, sizeof(fd_set));
-	    select_timeout.tv_sec = current_poll_interval_millis / 1000;
-	    select_timeout.tv_usec =
-		(current_poll_interval_millis % 1000) * 1000;
-	    ready_descriptors =
-		select(maxfdpl, &read_fd_set, &write_fd_set,
-		(fd_set *) NULL, (timeval *) & select_timeout);
-	    if (ready_descriptors == 0) {
-		update_subscriptions();
-		memcpy(&read_fd_set, &read_fd_set_copy, sizeof(fd_set));
-		memcpy(&write_fd_set, &write_fd_set_copy, sizeof(fd_set));
-		continue;
+	    timeout_millis =
+		(int) ceil((next_poll_time - etime()) * 1000.0);
+	    if (timeout_millis < 0) {
+		timeout_millis = 0;
 	    }
-	} else {
-	    ready_descriptors =
-		select(maxfdpl, &read_fd_set, &write_fd_set,
-		(fd_set *) NULL, (timeval *) NULL);
-
 	}
+	ready_descriptors =
+	    epoll_wait(epoll_fd, events, TCPSVR_MAX_EVENTS, timeout_millis);
 	if (ready_descriptors < 0) {
-	    rcs_print_error("server: select error.(errno = %d | %s)\n",
-		errno, strerror(errno));
+	    if (errno != EINTR) {
+		rcs_print_error("server: epoll_wait error.(errno = %d | %s)\n",
+		    errno, strerror(errno));
+	    }
+	    ready_descriptors = 0;
 	}
 	if (NULL == client_ports) {
 	    rcs_print_error("CMS_SERVER: List of client ports is NULL.\n");
 	    return;
 	}
-	client_port_to_check = (CLIENT_TCP_PORT *) client_ports->get_head();
-	while (NULL != client_port_to_check) {
-	    if (FD_ISSET(client_port_to_check->socket_fd, &read_fd_set)) {
-		ioctl(client_port_to_check->socket_fd, FIONREAD,
-		    (caddr_t) & bytes_ready);
-		if (bytes_ready <= 0) {
-		    rcs_print_debug(PRINT_SOCKET_CONNECT,
-			"Socket closed by host with IP address %s.\n",
-			inet_ntoa(client_port_to_check->address.sin_addr));
-		    if (NULL != client_port_to_check->subscriptions) {
-			TCP_CLIENT_SUBSCRIPTION_INFO *clnt_sub_info =
-			    (TCP_CLIENT_SUBSCRIPTION_INFO *)
-			    client_port_to_check->subscriptions->get_head();
-			while (NULL != clnt_sub_info) {
-			    if (NULL != clnt_sub_info->sub_buf_info &&
-				clnt_sub_info->subscription_list_id >= 0) {
-				if (NULL !=
-				    clnt_sub_info->sub_buf_info->
-				    sub_clnt_info) {
-				    clnt_sub_info->sub_buf_info->
-					sub_clnt_info->
-					delete_node(clnt_sub_info->
-					subscription_list_id);
-				    if (clnt_sub_info->sub_buf_info->
-					sub_clnt_info->list_size < 1) {
-					delete clnt_sub_info->sub_buf_info->
-					    sub_clnt_info;
-					clnt_sub_info->sub_buf_info->
-					    sub_clnt_info = NULL;
-					if (NULL != subscription_buffers
-					    && clnt_sub_info->sub_buf_info->
-					    list_id >= 0) {
-					    subscription_buffers->
-						delete_node(clnt_sub_info->
-						sub_buf_info->list_id);
-					    delete clnt_sub_info->
-						sub_buf_info;
-					    clnt_sub_info->sub_buf_info =
-						NULL;
-					}
-				    }
-				    clnt_sub_info->sub_buf_info = NULL;
-				}
-				delete clnt_sub_info;
-				clnt_sub_info =
-				    (TCP_CLIENT_SUBSCRIPTION_INFO *)
-				    client_port_to_check->subscriptions->
-				    get_next();
-			    }
-			    delete client_port_to_check->subscriptions;
-			    client_port_to_check->subscriptions = NULL;
-			    recalculate_polling_interval();
-			}
-		    }
-		    if (client_port_to_check->threadId > 0
-			&& client_port_to_check->blocking) {
-			blocking_thread_kill(client_port_to_check->threadId);
-		    }
-		    close(client_port_to_check->socket_fd);
-		    FD_CLR(client_port_to_check->socket_fd, &read_fd_set);
-		    client_port_to_check->socket_fd = -1;
-		    delete client_port_to_check;
-		    client_ports->delete_current_node();
-		} else {
-		    if (client_port_to_check->blocking) {
-			if (client_port_to_check->threadId > 0) {
-			    rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
-				"Data received from %s:%d when it should be blocking (bytes_ready=%d).\n",
-				inet_ntoa
-				(client_port_to_check->address.
-				    sin_addr),
-				client_port_to_check->socket_fd, bytes_ready);
-			    rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
-				"Killing handler %d.\n",
-				client_port_to_check->threadId);
-
-			    blocking_thread_kill
-				(client_port_to_check->threadId);
-#if 0
-			    *((uint32_t *) temp_buffer) =
-				htonl(client_port_to_check->serial_number);
-			    *((uint32_t *) temp_buffer + 1) =
-				htonl((unsigned long)
-				CMS_SERVER_SIDE_ERROR);
-			    putbe32(temp_buffer + 8, 0);	/* size
-									 */
-			    putbe32(temp_buffer + 12, 0);	/* write_id
-									 */
-			    putbe32(temp_buffer + 16, 0);	/* was_read
-									 */
-			    sendn(client_port_to_check->socket_fd,
-				temp_buffer, 20, 0, dtimeout);
-#endif
-			    client_port_to_check->threadId = 0;
-			    client_port_to_check->blocking = 0;
-			}
-		    }
-		    handle_request(client_port_to_check);
-		}
-		ready_descriptors--;
-	    } else {
-		FD_SET(client_port_to_check->socket_fd, &read_fd_set);
+	for (int i = 0; i < ready_descriptors; i++) {
+	    client_port_to_check = (CLIENT_TCP_PORT *) events[i].data.ptr;
+	    if (NULL == client_port_to_check) {
+		accept_clients();
+		continue;
 	    }
-	    client_port_to_check =
-		(CLIENT_TCP_PORT *) client_ports->get_next();
-	}
-	if (FD_ISSET(connection_socket, &read_fd_set)
-	    && ready_descriptors > 0) {
-	    ready_descriptors--;
-	    socklen_t client_address_length;
-	    new_client_port = new CLIENT_TCP_PORT();
-	    client_address_length = sizeof(new_client_port->address);
-	    new_client_port->socket_fd = accept(connection_socket,
-		(struct sockaddr *)
-		&new_client_port->address, &client_address_length);
-	    current_clients++;
-	    if (current_clients > max_clients) {
-		max_clients = current_clients;
+	    if (client_port_to_check->socket_fd < 0) {
+		/* closed while handling an earlier event of this batch */
+		continue;
 	    }
-	    if (new_client_port->socket_fd < 0) {
-		rcs_print_error("server: accept error -- %d %s \n", errno,
-		    strerror(errno));
+	    if (events[i].events & EPOLLOUT) {
+		flush_client_output(client_port_to_check);
+	    }
+	    if (!(events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP |
+			EPOLLERR))) {
 		continue;
 	    }
-	    rcs_print_debug(PRINT_SOCKET_CONNECT,
-		"Socket opened by host with IP address %s.\n",
-		inet_ntoa(new_client_port->address.sin_addr));
-	    new_client_port->serial_number = 0;
-	    new_client_port->blocking = 0;
-	    if (NULL != client_ports) {
-		client_ports->store_at_tail(new_client_port,
-		    sizeof(new_client_port), 0);
+	    bytes_ready = read_client_input(client_port_to_check);
+	    if (bytes_ready < 0) {
+		rcs_print_debug(PRINT_SOCKET_CONNECT,
+		    "Socket closed by host with IP address %s.\n",
+		    inet_ntoa(client_port_to_check->address.sin_addr));
+		remove_client(client_port_to_check);
+		continue;
 	    }
-	    if (maxfdpl < new_client_port->socket_fd + 1) {
-		maxfdpl = new_client_port->socket_fd + 1;
+	    if (bytes_ready > 0 && client_port_to_check->blocking) {
+		if (client_port_to_check->threadId > 0) {
+		    rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
+			"Data received from %s:%d when it should be blocking (bytes_ready=%d).\n",
+			inet_ntoa(client_port_to_check->address.sin_addr),
+			client_port_to_check->socket_fd, bytes_ready);
+		    rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
+			"Killing handler %d.\n",
+			client_port_to_check->threadId);
+
+		    blocking_thread_kill(client_port_to_check->threadId);
+		    client_port_to_check->threadId = 0;
+		    client_port_to_check->blocking = 0;
+		}
 	    }
-	    FD_SET(new_client_port->socket_fd, &read_fd_set);
-	} else {
-	    FD_SET(connection_socket, &read_fd_set);
+	    handle_request(client_port_to_check);
 	}
-	if (0 != ready_descriptors) {
-	    rcs_print_error("%d descriptors ready but not serviced.\n",
-		ready_descriptors);
+	reap_clients();
+	if (polling_enabled && etime() >= next_poll_time) {
+	    update_subscriptions();
+	    next_poll_time = etime() + current_poll_interval_millis / 1000.0;
 	}
-	update_subscriptions();
     }
 }
 
-static int tcpsvr_handle_blocking_request_sigint_count = 0;
-static int tcpsvr_last_sig = 0;
+void CMS_SERVER_REMOTE_TCP_PORT::accept_clients()
+{
+    CLIENT_TCP_PORT *new_client_port;
+    socklen_t client_address_length;
+    struct epoll_event ev;
 
-void tcpsvr_handle_blocking_request_sigint_handler(int sig)
+    /* The listening socket is non-blocking: take every connection that
+       is waiting, so a burst of clients is not let in one per wakeup. */
+    while (1) {
+	new_client_port = new CLIENT_TCP_PORT();
+	client_address_length = sizeof(new_client_port->address);
+	new_client_port->socket_fd = accept4(connection_socket,
+	    (struct sockaddr *) &new_client_port->address,
+	    &client_address_length, SOCK_CLOEXEC | SOCK_NONBLOCK);
+	if (new_client_port->socket_fd < 0) {
+	    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+		rcs_print_error("server: accept error -- %d %s \n", errno,
+		    strerror(errno));
+	    }
+	    delete new_client_port;
+	    return;
+	}
+	current_clients++;
+	if (current_clients > max_clients) {
+	    max_clients = current_clients;
+	}
+	rcs_print_debug(PRINT_SOCKET_CONNECT,
+	    "Socket opened by host with IP address %s.\n",
+	    inet_ntoa(new_client_port->address.sin_addr));
+	new_client_port->serial_number = 0;
+	new_client_port->blocking = 0;
+	client_ports->store_at_tail(new_client_port,
+	    sizeof(new_client_port), 0);
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLRDHUP;
+	ev.data.ptr = new_client_port;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, new_client_port->socket_fd,
+		&ev) < 0) {
+	    rcs_print_error("epoll_ctl error: %d -- %s\n", errno,
+		strerror(errno));
+	    remove_client(new_client_port);
+	}
+    }
+}
+
+/* Drops a client's subscriptions and closes its socket.  The
+   CLIENT_TCP_PORT itself is only deleted by reap_clients() once the
+   current batch of events, which may still point to it, is done. */
+void CMS_SERVER_REMOTE_TCP_PORT::remove_client(CLIENT_TCP_PORT * clnt)
 {
-    tcpsvr_last_sig = sig;
-    tcpsvr_handle_blocking_request_sigint_count++;
+    if (clnt->socket_fd < 0) {
+	return;
+    }
+    if (NULL != clnt->subscriptions) {
+	TCP_CLIENT_SUBSCRIPTION_INFO *clnt_sub_info =
+	    (TCP_CLIENT_SUBSCRIPTION_INFO *) clnt->subscriptions->get_head();
+	while (NULL != clnt_sub_info) {
+	    detach_subscription(clnt_sub_info);
+	    delete clnt_sub_info;
+	    clnt_sub_info = (TCP_CLIENT_SUBSCRIPTION_INFO *)
+		clnt->subscriptions->get_next();
+	}
+	delete clnt->subscriptions;
+	clnt->subscriptions = NULL;
+	recalculate_polling_interval();
+    }
+    if (clnt->threadId > 0 && clnt->blocking) {
+	blocking_thread_kill(clnt->threadId);
+	clnt->threadId = 0;
+	clnt->blocking = 0;
+    }
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, clnt->socket_fd, NULL);
+    close(clnt->socket_fd);
+    clnt->socket_fd = -1;
+    current_clients--;
+    closed_clients++;
+}
+
+void CMS_SERVER_REMOTE_TCP_PORT::reap_clients()
+{
+    if (closed_clients < 1) {
+	return;
+    }
+    CLIENT_TCP_PORT *client = (CLIENT_TCP_PORT *) client_ports->get_head();
+    while (NULL != client) {
+	if (client->socket_fd < 0) {
+	    delete client;
+	    client_ports->delete_current_node();
+	}
+	client = (CLIENT_TCP_PORT *) client_ports->get_next();
+    }
+    closed_clients = 0;
+}
+
+void CMS_SERVER_REMOTE_TCP_PORT::set_client_events(CLIENT_TCP_PORT * clnt,
+    int want_write)
+{
+    struct epoll_event ev;
+
+    if (clnt->out_blocked == want_write || clnt->socket_fd < 0) {
+	return;
+    }
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP | (want_write ? EPOLLOUT : 0);
+    ev.data.ptr = clnt;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, clnt->socket_fd, &ev);
+    clnt->out_blocked = want_write;
+}
+
+/* Appends one message, header and data together, to what is waiting to
+   be written to the client. */
+int CMS_SERVER_REMOTE_TCP_PORT::queue_client_output(CLIENT_TCP_PORT * clnt,
+    const char *header, const void *data, long size)
+{
+    long needed = clnt->out_size + 20 + size;
+    if (needed > clnt->out_alloc) {
+	long new_alloc = clnt->out_alloc * 2;
+	if (new_alloc < needed) {
+	    new_alloc = needed;
+	}
+	char *new_buf = (char *) realloc(clnt->out_buf, new_alloc);
+	if (NULL == new_buf) {
+	    rcs_print_error("Can not allocate %ld bytes of client output.\n",
+		new_alloc);
+	    return -1;
+	}
+	clnt->out_buf = new_buf;
+	clnt->out_alloc = new_alloc;
+    }
+    memcpy(clnt->out_buf + clnt->out_size, header, 20);
+    if (size > 0) {
+	memcpy(clnt->out_buf + clnt->out_size + 20, data, size);
+    }
+    clnt->out_size = needed;
+    return 0;
+}
+
+/* Writes as much of the queued output as the socket takes without
+   blocking, and waits for EPOLLOUT to write the rest. */
+int CMS_SERVER_REMOTE_TCP_PORT::flush_client_output(CLIENT_TCP_PORT * clnt)
+{
+    while (clnt->out_sent < clnt->out_size) {
+	ssize_t nwritten = send(clnt->socket_fd,
+	    clnt->out_buf + clnt->out_sent,
+	    clnt->out_size - clnt->out_sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+	if (nwritten < 0) {
+	    if (errno == EINTR) {
+		continue;
+	    }
+	    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+		set_client_events(clnt, 1);
+		return 0;
+	    }
+	    /* a client that hung up is removed when its EPOLLIN comes */
+	    if (errno != EPIPE && errno != ECONNRESET) {
+		rcs_print_error("Send error: %d = %s\n", errno,
+		    strerror(errno));
+		clnt->errors++;
+	    }
+	    break;
+	}
+	clnt->out_sent += nwritten;
+    }
+    clnt->out_size = 0;
+    clnt->out_sent = 0;
+    set_client_events(clnt, 0);
+    return 0;
 }
 
 static void putbe32(char *addr, uint32_t val) {
@@ -523,6 +602,102 @@ static uint32_t getbe32(char *addr) {
     return ntohl(val);
 }
 
+/* Adds what the client has sent to its input buffer.  Returns the number
+   of bytes read, which may be 0, or -1 if the client hung up or the
+   connection failed. */
+int CMS_SERVER_REMOTE_TCP_PORT::read_client_input(CLIENT_TCP_PORT * clnt)
+{
+    if (clnt->in_alloc - clnt->in_size < 0x2000) {
+	long new_alloc = clnt->in_alloc * 2;
+	if (new_alloc < clnt->in_size + 0x2000) {
+	    new_alloc = clnt->in_size + 0x2000;
+	}
+	char *new_buf = (char *) realloc(clnt->in_buf, new_alloc);
+	if (NULL == new_buf) {
+	    rcs_print_error("Can not allocate %ld bytes of client input.\n",
+		new_alloc);
+	    return -1;
+	}
+	clnt->in_buf = new_buf;
+	clnt->in_alloc = new_alloc;
+    }
+    while (1) {
+	ssize_t nread = recv(clnt->socket_fd, clnt->in_buf + clnt->in_size,
+	    clnt->in_alloc - clnt->in_size, 0);
+	if (nread < 0) {
+	    if (errno == EINTR) {
+		continue;
+	    }
+	    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+		return 0;
+	    }
+	    if (errno != ECONNRESET) {
+		rcs_print_error("Recv error: %d = %s\n", errno,
+		    strerror(errno));
+	    }
+	    return -1;
+	}
+	if (nread == 0) {
+	    return -1;
+	}
+	clnt->in_size += nread;
+	return nread;
+    }
+}
+
+/* The length of a request, its 20 byte header included, as far as it
+   can be told from the header.  Returns -1 for a request that can not
+   be valid. */
+long CMS_SERVER_REMOTE_TCP_PORT::request_length(CMS_SERVER * server,
+    const char *header)
+{
+    long request_type = getbe32((char *) header + 4);
+    long buffer_number = getbe32((char *) header + 8);
+    long size;
+    int total_subdivisions = 1;
+
+    if (max_total_subdivisions > 1) {
+	total_subdivisions = server->get_total_subdivisions(buffer_number);
+    }
+    switch (request_type) {
+    case REMOTE_CMS_SET_DIAG_INFO_REQUEST_TYPE:
+	return 20 + 68;
+
+    case REMOTE_CMS_BLOCKING_READ_REQUEST_TYPE:
+	return total_subdivisions > 1 ? 20 + 8 : 20 + 4;
+
+    case REMOTE_CMS_READ_REQUEST_TYPE:
+	return total_subdivisions > 1 ? 20 + 4 : 20;
+
+    case REMOTE_CMS_WRITE_REQUEST_TYPE:
+	size = getbe32((char *) header + 16);
+	if (size < 0 || size > server->maximum_cms_size) {
+	    rcs_print_error("Write request of %ld bytes is too large.\n",
+		size);
+	    return -1;
+	}
+	return (total_subdivisions > 1 ? 20 + 4 : 20) + size;
+
+    case REMOTE_CMS_GET_KEYS_REQUEST_TYPE:
+	return 20 + 16;
+
+    case REMOTE_CMS_LOGIN_REQUEST_TYPE:
+	return 20 + 32;
+
+    default:
+	return 20;
+    }
+}
+
+static int tcpsvr_handle_blocking_request_sigint_count = 0;
+static int tcpsvr_last_sig = 0;
+
+void tcpsvr_handle_blocking_request_sigint_handler(int sig)
+{
+    tcpsvr_last_sig = sig;
+    tcpsvr_handle_blocking_request_sigint_count++;
+}
+
 #if defined(POSIX_THREADS) || defined(NO_THREADS)
 void *tcpsvr_handle_blocking_request(void *_req)
 {
@@ -641,13 +816,15 @@ void *tcpsvr_handle_blocking_request(void *_req)
 
 #endif
 
+/* Handles each request in the client's input buffer that has arrived
+   whole, and keeps the rest for when more comes in. */
 void CMS_SERVER_REMOTE_TCP_PORT::handle_request(CLIENT_TCP_PORT *
     _client_tcp_port)
 {
-    CLIENT_TCP_PORT *client_port_to_check = NULL;
     pid_t pid = getpid();
     pid_t tid = 0;
     CMS_SERVER *server;
+    long handled = 0, length;
     server = find_server(pid, tid);
     if (NULL == server) {
 	rcs_print_error
@@ -656,6 +833,49 @@ void CMS_SERVER_REMOTE_TCP_PORT::handle_request(CLIENT_TCP_PORT *
 	return;
     }
 
+    while (_client_tcp_port->socket_fd >= 0 &&
+	_client_tcp_port->in_size - handled >= 20) {
+	length = request_length(server, _client_tcp_port->in_buf + handled);
+	if (length < 0) {
+	    rcs_print_error("Bad request - closing connection(%d)\n",
+		_client_tcp_port->socket_fd);
+	    remove_client(_client_tcp_port);
+	    return;
+	}
+	if (_client_tcp_port->in_size - handled < length) {
+	    break;
+	}
+	/* Replies must not overtake updates still queued for the
+	   client. */
+	if (_client_tcp_port->out_sent < _client_tcp_port->out_size) {
+	    if (sendn(_client_tcp_port->socket_fd,
+		    _client_tcp_port->out_buf + _client_tcp_port->out_sent,
+		    _client_tcp_port->out_size - _client_tcp_port->out_sent,
+		    0, dtimeout) < 0) {
+		_client_tcp_port->errors++;
+	    }
+	    _client_tcp_port->out_size = 0;
+	    _client_tcp_port->out_sent = 0;
+	    set_client_events(_client_tcp_port, 0);
+	}
+	memcpy(temp_buffer, _client_tcp_port->in_buf + handled, 20);
+	request_data = _client_tcp_port->in_buf + handled + 20;
+	handled += length;
+	handle_one_request(server, _client_tcp_port);
+    }
+    request_data = NULL;
+    if (_client_tcp_port->socket_fd >= 0 && handled > 0) {
+	_client_tcp_port->in_size -= handled;
+	memmove(_client_tcp_port->in_buf, _client_tcp_port->in_buf + handled,
+	    _client_tcp_port->in_size);
+    }
+}
+
+/* Handles the request whose header is in temp_buffer and whose data
+   request_data points to. */
+void CMS_SERVER_REMOTE_TCP_PORT::handle_one_request(CMS_SERVER * server,
+    CLIENT_TCP_PORT * _client_tcp_port)
+{
     if (server->using_passwd_file) {
 	current_user_info = get_connected_user(_client_tcp_port->socket_fd);
     }
@@ -663,29 +883,10 @@ void CMS_SERVER_REMOTE_TCP_PORT::handle_request(CLIENT_TCP_PORT *
     if (_client_tcp_port->errors >= _client_tcp_port->max_errors) {
 	rcs_print_error("Too many errors - closing connection(%d)\n",
 	    _client_tcp_port->socket_fd);
-	client_port_to_check = (CLIENT_TCP_PORT *) client_ports->get_head();
-	while (NULL != client_port_to_check) {
-	    if (client_port_to_check->socket_fd ==
-		_client_tcp_port->socket_fd) {
-		delete client_port_to_check;
-		client_ports->delete_current_node();
-	    }
-	    client_port_to_check =
-		(CLIENT_TCP_PORT *) client_ports->get_next();
-	}
-	close(_client_tcp_port->socket_fd);
-	current_clients--;
-	FD_CLR(_client_tcp_port->socket_fd, &read_fd_set);
-	_client_tcp_port->socket_fd = -1;
-    }
-
-    if (recvn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, -1, NULL) < 0) {
-	rcs_print_error("Can not read from client port (%d) from %s\n",
-	    _client_tcp_port->socket_fd,
-	    inet_ntoa(_client_tcp_port->address.sin_addr));
-	_client_tcp_port->errors++;
+	remove_client(_client_tcp_port);
 	return;
     }
+
     long request_type, buffer_number, received_serial_number;
     received_serial_number = getbe32(temp_buffer);
     if (received_serial_number != _client_tcp_port->serial_number) {
@@ -733,7 +934,6 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
     long request_type, long buffer_number, long received_serial_number)
 {
     int total_subdivisions = 1;
-    CLIENT_TCP_PORT *client_port_to_check = NULL;
     switch (request_type) {
     case REMOTE_CMS_SET_DIAG_INFO_REQUEST_TYPE:
 	{
@@ -741,16 +941,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		_client_tcp_port->diag_info =
 		    new REMOTE_SET_DIAG_INFO_REQUEST();
 	    }
-	    if (recvn
-		(_client_tcp_port->socket_fd, server->set_diag_info_buf, 68,
-		    0, -1, NULL) < 0) {
-		rcs_print_error
-		    ("Can not read from client port (%d) from %s\n",
-		    _client_tcp_port->socket_fd,
-		    inet_ntoa(_client_tcp_port->address.sin_addr));
-		_client_tcp_port->errors++;
-		return;
-	    }
+	    memcpy(server->set_diag_info_buf, request_data, 68);
 	    _client_tcp_port->diag_info->bytes_moved = 0.0;
 	    _client_tcp_port->diag_info->buffer_number = buffer_number;
 	    memcpy(_client_tcp_port->diag_info->process_name,
@@ -1009,31 +1200,11 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		    server->get_total_subdivisions(buffer_number);
 	    }
 	    if (total_subdivisions > 1) {
-		if (recvn
-		    (_client_tcp_port->socket_fd,
-			(char *) (((uint32_t *) temp_buffer) + 5), 8, 0, -1,
-			NULL) < 0) {
-		    rcs_print_error
-			("Can not read from client port (%d) from %s\n",
-			_client_tcp_port->socket_fd,
-			inet_ntoa(_client_tcp_port->address.sin_addr));
-		    _client_tcp_port->errors++;
-		    return;
-		}
+		memcpy(((uint32_t *) temp_buffer) + 5, request_data, 8);
 		blocking_read_req->subdiv =
 		    ntohl(*((uint32_t *) temp_buffer + 6));
 	    } else {
-		if (recvn
-		    (_client_tcp_port->socket_fd,
-			(char *) (((uint32_t *) temp_buffer) + 5), 4, 0, -1,
-			NULL) < 0) {
-		    rcs_print_error
-			("Can not read from client port (%d) from %s\n",
-			_client_tcp_port->socket_fd,
-			inet_ntoa(_client_tcp_port->address.sin_addr));
-		    _client_tcp_port->errors++;
-		    return;
-		}
+		memcpy(((uint32_t *) temp_buffer) + 5, request_data, 4);
 	    }
 	    blocking_read_req->timeout_millis =
 		ntohl(*((uint32_t *) temp_buffer + 5));
@@ -1121,17 +1292,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		server->get_total_subdivisions(buffer_number);
 	}
 	if (total_subdivisions > 1) {
-	    if (recvn
-		(_client_tcp_port->socket_fd,
-		    (char *) (((uint32_t *) temp_buffer) + 5), 4, 0, -1,
-		    NULL) < 0) {
-		rcs_print_error
-		    ("Can not read from client port (%d) from %s\n",
-		    _client_tcp_port->socket_fd,
-		    inet_ntoa(_client_tcp_port->address.sin_addr));
-		_client_tcp_port->errors++;
-		return;
-	    }
+	    memcpy(((uint32_t *) temp_buffer) + 5, request_data, 4);
 	    server->read_req.subdiv = ntohl(*((uint32_t *) temp_buffer + 5));
 	} else {
 	    server->read_req.subdiv = 0;
@@ -1189,28 +1350,15 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		server->get_total_subdivisions(buffer_number);
 	}
 	if (total_subdivisions > 1) {
-	    if (recvn
-		(_client_tcp_port->socket_fd,
-		    (char *) (((uint32_t *) temp_buffer) + 5), 4, 0, -1,
-		    NULL) < 0) {
-		rcs_print_error
-		    ("Can not read from client port (%d) from %s\n",
-		    _client_tcp_port->socket_fd,
-		    inet_ntoa(_client_tcp_port->address.sin_addr));
-		_client_tcp_port->errors++;
-		return;
-	    }
+	    memcpy(((uint32_t *) temp_buffer) + 5, request_data, 4);
+	    request_data += 4;
 	    server->write_req.subdiv = ntohl(*((uint32_t *) temp_buffer + 5));
 	} else {
 	    server->write_req.subdiv = 0;
 	}
 	if (server->write_req.size > 0) {
-	    if (recvn
-		(_client_tcp_port->socket_fd, server->write_req.data,
-		    server->write_req.size, 0, -1, NULL) < 0) {
-		_client_tcp_port->errors++;
-		return;
-	    }
+	    memcpy(server->write_req.data, request_data,
+		server->write_req.size);
 	}
 	REMOTE_WRITE_REPLY *reply;
 	server->write_reply = reply =
@@ -1239,6 +1387,11 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		rcs_print_error("Server could not process request.\n");
 	    }
 	}
+	/* Subscribers see a remote write at once instead of at the next
+	   poll. */
+	if (NULL != server->write_reply) {
+	    push_subscription(buffer_number);
+	}
 	break;
 
     case REMOTE_CMS_CHECK_IF_READ_REQUEST_TYPE:
@@ -1372,33 +1525,12 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	break;
 
     case REMOTE_CMS_CLOSE_CHANNEL_REQUEST_TYPE:
-	client_port_to_check = (CLIENT_TCP_PORT *) client_ports->get_head();
-	while (NULL != client_port_to_check) {
-	    if (client_port_to_check->socket_fd ==
-		_client_tcp_port->socket_fd) {
-		break;
-	    }
-	    client_port_to_check =
-		(CLIENT_TCP_PORT *) client_ports->get_next();
-	}
-	FD_CLR(_client_tcp_port->socket_fd, &read_fd_set);
-	close(_client_tcp_port->socket_fd);
-	current_clients--;
-	if (NULL != _client_tcp_port->subscriptions) {
-	    remove_subscription_client(_client_tcp_port, buffer_number);
-	}
-	_client_tcp_port->socket_fd = -1;
-	delete _client_tcp_port;
-	client_ports->delete_current_node();
+	remove_client(_client_tcp_port);
 	break;
 
     case REMOTE_CMS_GET_KEYS_REQUEST_TYPE:
 	server->get_keys_req.buffer_number = buffer_number;
-	if (recvn(_client_tcp_port->socket_fd,
-		server->get_keys_req.name, 16, 0, -1, NULL) < 0) {
-	    _client_tcp_port->errors++;
-	    return;
-	}
+	memcpy(server->get_keys_req.name, request_data, 16);
 	server->get_keys_reply =
 	    (REMOTE_GET_KEYS_REPLY *) server->process_request(&server->
 	    get_keys_req);
@@ -1424,16 +1556,8 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 
     case REMOTE_CMS_LOGIN_REQUEST_TYPE:
 	server->login_req.buffer_number = buffer_number;
-	if (recvn(_client_tcp_port->socket_fd,
-		server->login_req.name, 16, 0, -1, NULL) < 0) {
-	    _client_tcp_port->errors++;
-	    return;
-	}
-	if (recvn(_client_tcp_port->socket_fd,
-		server->login_req.passwd, 16, 0, -1, NULL) < 0) {
-	    _client_tcp_port->errors++;
-	    return;
-	}
+	memcpy(server->login_req.name, request_data, 16);
+	memcpy(server->login_req.passwd, request_data + 16, 16);
 	server->login_reply =
 	    (REMOTE_LOGIN_REPLY *) server->process_request(&server->
 	    login_req);
@@ -1560,30 +1684,21 @@ void CMS_SERVER_REMOTE_TCP_PORT::add_subscription_client(int buffer_number,
     temp_clnt_info->subscription_type = subscription_type;
     temp_clnt_info->poll_interval_millis = poll_interval_millis;
     recalculate_polling_interval();
+    next_poll_time = 0.0;
 }
 
 void CMS_SERVER_REMOTE_TCP_PORT::remove_subscription_client(CLIENT_TCP_PORT *
     clnt, int buffer_number)
 {
+    if (NULL == clnt->subscriptions) {
+	return;
+    }
     TCP_CLIENT_SUBSCRIPTION_INFO *temp_clnt_info =
 	(TCP_CLIENT_SUBSCRIPTION_INFO *) clnt->subscriptions->get_head();
     while (temp_clnt_info != NULL) {
 	if (temp_clnt_info->buffer_number == buffer_number) {
-	    if (NULL != temp_clnt_info->sub_buf_info) {
-		if (NULL != temp_clnt_info->sub_buf_info->sub_clnt_info) {
-		    temp_clnt_info->sub_buf_info->sub_clnt_info->
-			delete_node(temp_clnt_info->subscription_list_id);
-		    if (temp_clnt_info->sub_buf_info->sub_clnt_info->
-			list_size == 0) {
-			subscription_buffers->delete_node(temp_clnt_info->
-			    sub_buf_info->list_id);
-			delete temp_clnt_info->sub_buf_info->sub_clnt_info;
-			temp_clnt_info->sub_buf_info->sub_clnt_info = NULL;
-			delete temp_clnt_info->sub_buf_info;
-			temp_clnt_info->sub_buf_info = NULL;
-		    }
-		}
-	    }
+	    detach_subscription(temp_clnt_info);
+	    clnt->subscriptions->delete_current_node();
 	    delete temp_clnt_info;
 	    temp_clnt_info = NULL;
 	    break;
@@ -1594,10 +1709,45 @@ void CMS_SERVER_REMOTE_TCP_PORT::remove_subscription_client(CLIENT_TCP_PORT *
     recalculate_polling_interval();
 }
 
+/* Takes a client's subscription out of the list of its buffer, and the
+   buffer out of subscription_buffers once nobody subscribes to it. */
+void CMS_SERVER_REMOTE_TCP_PORT::detach_subscription(
+    TCP_CLIENT_SUBSCRIPTION_INFO * clnt_sub_info)
+{
+    TCP_BUFFER_SUBSCRIPTION_INFO *buf_info = clnt_sub_info->sub_buf_info;
+    clnt_sub_info->sub_buf_info = NULL;
+    if (NULL == buf_info || NULL == buf_info->sub_clnt_info) {
+	return;
+    }
+    TCP_CLIENT_SUBSCRIPTION_INFO *temp_clnt_info =
+	(TCP_CLIENT_SUBSCRIPTION_INFO *) buf_info->sub_clnt_info->get_head();
+    while (NULL != temp_clnt_info) {
+	if (temp_clnt_info == clnt_sub_info) {
+	    buf_info->sub_clnt_info->delete_current_node();
+	    break;
+	}
+	temp_clnt_info = (TCP_CLIENT_SUBSCRIPTION_INFO *)
+	    buf_info->sub_clnt_info->get_next();
+    }
+    if (buf_info->sub_clnt_info->list_size < 1) {
+	if (NULL != subscription_buffers && buf_info->list_id >= 0) {
+	    subscription_buffers->delete_node(buf_info->list_id);
+	}
+	delete buf_info;
+    }
+}
+
+/* Polled subscriptions are served at the shortest interval any client
+   asked for.  Variable subscriptions get each new message, so their
+   buffers are checked for a change every clock tick. */
 void CMS_SERVER_REMOTE_TCP_PORT::recalculate_polling_interval()
 {
     int min_poll_interval_millis = 30000;
+    int tick_millis = (int) (clk_tck() * 1000.0);
     polling_enabled = 0;
+    if (NULL == subscription_buffers) {
+	return;
+    }
     TCP_BUFFER_SUBSCRIPTION_INFO *buf_info =
 	(TCP_BUFFER_SUBSCRIPTION_INFO *) subscription_buffers->get_head();
     while (NULL != buf_info) {
@@ -1613,20 +1763,23 @@ void CMS_SERVER_REMOTE_TCP_PORT::recalculate_polling_interval()
 		    temp_clnt_info->poll_interval_millis;
 		polling_enabled = 1;
 	    }
+	    if (temp_clnt_info->subscription_type ==
+		CMS_VARIABLE_SUBSCRIPTION) {
+		min_poll_interval_millis = tick_millis;
+		polling_enabled = 1;
+	    }
 	    temp_clnt_info = (TCP_CLIENT_SUBSCRIPTION_INFO *)
 		buf_info->sub_clnt_info->get_next();
 	}
 	buf_info =
 	    (TCP_BUFFER_SUBSCRIPTION_INFO *) subscription_buffers->get_next();
     }
-    if (min_poll_interval_millis >= ((int) (clk_tck() * 1000.0))) {
+    if (min_poll_interval_millis >= tick_millis) {
 	current_poll_interval_millis = min_poll_interval_millis;
     } else {
-	current_poll_interval_millis = ((int) (clk_tck() * 1000.0));
+	current_poll_interval_millis = tick_millis;
     }
-    select_timeout.tv_sec = current_poll_interval_millis / 1000;
-    select_timeout.tv_usec = (current_poll_interval_millis % 1000) * 1000;
-    dtimeout = (current_poll_interval_millis + 10) * 1000.0;
+    dtimeout = (current_poll_interval_millis + 10) / 1000.0;
     if (dtimeout < 0.5) {
 	dtimeout = 0.5;
     }
@@ -1651,82 +1804,102 @@ void CMS_SERVER_REMOTE_TCP_PORT::update_subscriptions()
     TCP_BUFFER_SUBSCRIPTION_INFO *buf_info =
 	(TCP_BUFFER_SUBSCRIPTION_INFO *) subscription_buffers->get_head();
     while (NULL != buf_info) {
-	server->read_req.buffer_number = buf_info->buffer_number;
-	server->read_req.access_type = CMS_READ_ACCESS;
-	server->read_req.last_id_read = buf_info->min_last_id;
-	server->read_reply =
-	    (REMOTE_READ_REPLY *) server->process_request(&server->read_req);
-	if (NULL == server->read_reply) {
-	    rcs_print_error("Server could not process request.\n");
-	    buf_info = (TCP_BUFFER_SUBSCRIPTION_INFO *)
-		subscription_buffers->get_next();
-	    continue;
-	}
-	if (server->read_reply->write_id == buf_info->min_last_id ||
-	    server->read_reply->size < 1) {
-	    buf_info = (TCP_BUFFER_SUBSCRIPTION_INFO *)
-		subscription_buffers->get_next();
-	    continue;
+	update_subscription(server, buf_info, cur_time);
+	buf_info =
+	    (TCP_BUFFER_SUBSCRIPTION_INFO *) subscription_buffers->get_next();
+    }
+    flush_subscription_output();
+}
+
+void CMS_SERVER_REMOTE_TCP_PORT::push_subscription(int buffer_number)
+{
+    if (NULL == subscription_buffers) {
+	return;
+    }
+    CMS_SERVER *server = find_server(getpid(), 0);
+    if (NULL == server) {
+	return;
+    }
+    TCP_BUFFER_SUBSCRIPTION_INFO *buf_info =
+	(TCP_BUFFER_SUBSCRIPTION_INFO *) subscription_buffers->get_head();
+    while (NULL != buf_info) {
+	if (buf_info->buffer_number == buffer_number) {
+	    update_subscription(server, buf_info, etime());
+	    flush_subscription_output();
+	    return;
 	}
-	putbe32(temp_buffer, 0);
-	putbe32(temp_buffer + 4, server->read_reply->status);
-	putbe32(temp_buffer + 8, server->read_reply->size);
-	putbe32(temp_buffer + 12, server->read_reply->write_id);
-	putbe32(temp_buffer + 16, server->read_reply->was_read);
-	TCP_CLIENT_SUBSCRIPTION_INFO *temp_clnt_info =
-	    (TCP_CLIENT_SUBSCRIPTION_INFO *) buf_info->sub_clnt_info->
-	    get_head();
-	buf_info->min_last_id = server->read_reply->write_id;
-	while (temp_clnt_info != NULL) {
-	    double time_diff = cur_time - temp_clnt_info->last_sub_sent_time;
-	    int time_diff_millis = (int) ((double) time_diff * 1000.0);
-	    rcs_print_debug(PRINT_SERVER_SUBSCRIPTION_ACTIVITY,
-		"Subscription time_diff_millis=%d\n", time_diff_millis);
-	    if (((temp_clnt_info->subscription_type == CMS_POLLED_SUBSCRIPTION
-			&& time_diff_millis + 10 >=
-			temp_clnt_info->poll_interval_millis)
-		    || temp_clnt_info->subscription_type ==
-		    CMS_VARIABLE_SUBSCRIPTION)
-		&& temp_clnt_info->last_id_read !=
-		server->read_reply->write_id) {
+	buf_info =
+	    (TCP_BUFFER_SUBSCRIPTION_INFO *) subscription_buffers->get_next();
+    }
+}
+
+/* Reads the buffer once and queues the message for every subscriber
+   that is due for it.  Clients whose socket has not drained since the
+   last update are skipped; they get the newest message once it has. */
+void CMS_SERVER_REMOTE_TCP_PORT::update_subscription(CMS_SERVER * server,
+    TCP_BUFFER_SUBSCRIPTION_INFO * buf_info, double cur_time)
+{
+    char header[20];
+    server->read_req.buffer_number = buf_info->buffer_number;
+    server->read_req.access_type = CMS_READ_ACCESS;
+    server->read_req.last_id_read = buf_info->min_last_id;
+    server->read_reply =
+	(REMOTE_READ_REPLY *) server->process_request(&server->read_req);
+    if (NULL == server->read_reply) {
+	rcs_print_error("Server could not process request.\n");
+	return;
+    }
+    if (server->read_reply->write_id == buf_info->min_last_id ||
+	server->read_reply->size < 1) {
+	return;
+    }
+    putbe32(header, 0);
+    putbe32(header + 4, server->read_reply->status);
+    putbe32(header + 8, server->read_reply->size);
+    putbe32(header + 12, server->read_reply->write_id);
+    putbe32(header + 16, server->read_reply->was_read);
+    TCP_CLIENT_SUBSCRIPTION_INFO *temp_clnt_info =
+	(TCP_CLIENT_SUBSCRIPTION_INFO *) buf_info->sub_clnt_info->get_head();
+    buf_info->min_last_id = server->read_reply->write_id;
+    while (temp_clnt_info != NULL) {
+	double time_diff = cur_time - temp_clnt_info->last_sub_sent_time;
+	int time_diff_millis = (int) ((double) time_diff * 1000.0);
+	rcs_print_debug(PRINT_SERVER_SUBSCRIPTION_ACTIVITY,
+	    "Subscription time_diff_millis=%d\n", time_diff_millis);
+	if (((temp_clnt_info->subscription_type == CMS_POLLED_SUBSCRIPTION
+		    && time_diff_millis + 10 >=
+		    temp_clnt_info->poll_interval_millis)
+		|| temp_clnt_info->subscription_type ==
+		CMS_VARIABLE_SUBSCRIPTION)
+	    && temp_clnt_info->last_id_read != server->read_reply->write_id
+	    && !temp_clnt_info->clnt_port->out_blocked) {
+	    CLIENT_TCP_PORT *clnt = temp_clnt_info->clnt_port;
+	    putbe32(header, clnt->serial_number + 1);
+	    if (queue_client_output(clnt, header, server->read_reply->data,
+		    server->read_reply->size) == 0) {
+		clnt->serial_number++;
 		temp_clnt_info->last_id_read = server->read_reply->write_id;
 		temp_clnt_info->last_sub_sent_time = cur_time;
-		temp_clnt_info->clnt_port->serial_number++;
-		putbe32(temp_buffer, temp_clnt_info->clnt_port->serial_number);
-		if (server->read_reply->size < 0x2000 - 20
-		    && server->read_reply->size > 0) {
-		    memcpy(temp_buffer + 20, server->read_reply->data,
-			server->read_reply->size);
-		    if (sendn
-			(temp_clnt_info->clnt_port->socket_fd, temp_buffer,
-			    20 + server->read_reply->size, 0, dtimeout) < 0) {
-			temp_clnt_info->clnt_port->errors++;
-			return;
-		    }
-		} else {
-		    if (sendn(temp_clnt_info->clnt_port->socket_fd,
-			    temp_buffer, 20, 0, dtimeout) < 0) {
-			temp_clnt_info->clnt_port->errors++;
-			return;
-		    }
-		    if (server->read_reply->size > 0) {
-			if (sendn(temp_clnt_info->clnt_port->socket_fd,
-				server->read_reply->data,
-				server->read_reply->size, 0, dtimeout) < 0) {
-			    temp_clnt_info->clnt_port->errors++;
-			    return;
-			}
-		    }
-		}
-	    }
-	    if (temp_clnt_info->last_id_read < buf_info->min_last_id) {
-		buf_info->min_last_id = temp_clnt_info->last_id_read;
 	    }
-	    temp_clnt_info = (TCP_CLIENT_SUBSCRIPTION_INFO *)
-		buf_info->sub_clnt_info->get_next();
 	}
-	buf_info =
-	    (TCP_BUFFER_SUBSCRIPTION_INFO *) subscription_buffers->get_next();
+	if (temp_clnt_info->last_id_read < buf_info->min_last_id) {
+	    buf_info->min_last_id = temp_clnt_info->last_id_read;
+	}
+	temp_clnt_info = (TCP_CLIENT_SUBSCRIPTION_INFO *)
+	    buf_info->sub_clnt_info->get_next();
+    }
+}
+
+/* One write per client for everything update_subscription() queued. */
+void CMS_SERVER_REMOTE_TCP_PORT::flush_subscription_output()
+{
+    CLIENT_TCP_PORT *client = (CLIENT_TCP_PORT *) client_ports->get_head();
+    while (NULL != client) {
+	if (client->socket_fd >= 0 && !client->out_blocked &&
+	    client->out_size > 0) {
+	    flush_client_output(client);
+	}
+	client = (CLIENT_TCP_PORT *) client_ports->get_next();
     }
 }
 
@@ -1785,6 +1958,14 @@ CLIENT_TCP_PORT::CLIENT_TCP_PORT()
     address.sin_addr.s_addr = htonl(INADDR_ANY);
     socket_fd = -1;
     subscriptions = NULL;
+    in_buf = NULL;
+    in_size = 0;
+    in_alloc = 0;
+    out_buf = NULL;
+    out_size = 0;
+    out_sent = 0;
+    out_alloc = 0;
+    out_blocked = 0;
     tid = -1;
     pid = -1;
     blocking_read_req = NULL;
@@ -1815,6 +1996,14 @@ CLIENT_TCP_PORT::~CLIENT_TCP_PORT()
 	blocking_read_req = NULL;
     }
 #endif
+    if (NULL != in_buf) {
+	free(in_buf);
+	in_buf = NULL;
+    }
+    if (NULL != out_buf) {
+	free(out_buf);
+	out_buf = NULL;
+    }
     if (NULL != diag_info) {
 	delete diag_info;
 	diag_info = NULL;
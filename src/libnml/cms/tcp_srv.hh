@@ -43,6 +43,8 @@ extern "C" {
 
 #define MAX_TCP_BUFFER_SIZE 16
 class CLIENT_TCP_PORT;
+class TCP_BUFFER_SUBSCRIPTION_INFO;
+class TCP_CLIENT_SUBSCRIPTION_INFO;
 
 class CMS_SERVER_REMOTE_TCP_PORT:public CMS_SERVER_REMOTE_PORT {
   public:
@@ -54,9 +56,13 @@ class CMS_SERVER_REMOTE_TCP_PORT:public CMS_SERVER_REMOTE_PORT {
     void unregister_port();
     double dtimeout;
   protected:
-      fd_set read_fd_set, write_fd_set;
     void handle_request(CLIENT_TCP_PORT *);
-    int maxfdpl;
+    void handle_one_request(CMS_SERVER * server, CLIENT_TCP_PORT *);
+    int read_client_input(CLIENT_TCP_PORT *);
+    long request_length(CMS_SERVER * server, const char *header);
+    const char *request_data;	/* after the header of the request handled */
+    int epoll_fd;
+    int closed_clients;
     LinkedList *client_ports;
     LinkedList *subscription_buffers;
     int connection_socket;
@@ -66,12 +72,24 @@ class CMS_SERVER_REMOTE_TCP_PORT:public CMS_SERVER_REMOTE_PORT {
     char temp_buffer[0x2000];
     int current_poll_interval_millis;
     int polling_enabled;
-    struct timeval select_timeout;
+    double next_poll_time;
+    void accept_clients();
+    void remove_client(CLIENT_TCP_PORT *);
+    void reap_clients();
+    void set_client_events(CLIENT_TCP_PORT *, int want_write);
+    int queue_client_output(CLIENT_TCP_PORT *, const char *header,
+	const void *data, long size);
+    int flush_client_output(CLIENT_TCP_PORT *);
     void update_subscriptions();
+    void update_subscription(CMS_SERVER * server,
+	TCP_BUFFER_SUBSCRIPTION_INFO * buf_info, double cur_time);
+    void push_subscription(int buffer_number);
+    void flush_subscription_output();
     void add_subscription_client(int buffer_number, int subscription_type,
 	int poll_interval_millis, CLIENT_TCP_PORT * clnt);
     void remove_subscription_client(CLIENT_TCP_PORT * clnt,
 	int buffer_number);
+    void detach_subscription(TCP_CLIENT_SUBSCRIPTION_INFO * clnt_sub_info);
     void recalculate_polling_interval();
     void switch_function(CLIENT_TCP_PORT *
 	_client_tcp_port,
@@ -115,6 +133,11 @@ class CLIENT_TCP_PORT {
     struct sockaddr_in address;
     int socket_fd;
     LinkedList *subscriptions;
+    char *in_buf;		/* requests not yet handled */
+    long in_size, in_alloc;
+    char *out_buf;		/* subscription updates not yet sent */
+    long out_size, out_sent, out_alloc;
+    int out_blocked;		/* waiting for the socket to drain */
     pid_t tid;
     pid_t pid;
     int blocking;
@@ -18,6 +18,13 @@
 #include <string.h>             /* strstr() */
 #include <ctype.h>              /* isspace() */
 #include <fcntl.h>
+#include <limits.h>             /* UINT_MAX */
+#include <sys/stat.h>           /* fstat() */
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 
 #include "config.h"
@@ -45,14 +52,232 @@ static bool check_line_endings(const char *s) {
     return false;
 }
 
+/* The whole file is parsed once, when it is opened, into a list of
+   entries plus a table from tag name to the entries with that tag, both
+   for the file as a whole and for each section.  The tables keep the
+   entries in file order, so 'num' picks the Nth occurrence in the file
+   (or section), as it would reading the file line by line.
+
+   Errors found while parsing are remembered by line number, and only
+   reported by lookups that would have had to read past the bad line. */
+struct IniFile::Index {
+    struct Entry {
+        std::string             value;
+        bool                    hasValue;       /* false if no '=' value */
+        unsigned int            lineNo;
+    };
+
+    typedef std::unordered_map<std::string, std::vector<int> > TagMap;
+
+    struct Section {
+        unsigned int            lineNo;         /* line of [section] */
+        unsigned int            endLineNo;      /* line of the next [..] */
+        TagMap                  tags;
+    };
+
+    struct Error {
+        unsigned int            lineNo;
+        ErrorCode               errCode;
+    };
+
+    typedef std::unordered_map<std::string, Section> SectionMap;
+
+    std::vector<Entry>          entries;
+    TagMap                      tags;           /* all entries in the file */
+    SectionMap                  sections;
+    std::vector<Error>          errors;         /* in line order */
+    unsigned int                lineCount;
+
+    void                        Parse(FILE *fp);
+    void                        AddLine(const char *line, unsigned int lineNo,
+                                        Section **current);
+    const Error *               FindError(unsigned int after,
+                                          unsigned int upTo,
+                                          bool lineEndingsOnly) const;
+};
+
+void
+IniFile::Index::Parse(FILE *fp)
+{
+    char                        line[LINELEN + 2];   /* 1 for newline, 1 for NULL */
+    std::string                 eline;
+    int                         extend_ct = 0;
+    unsigned int                lineNo = 0;
+    Section                     *current = NULL;
+    size_t                      len;
+
+    rewind(fp);
+    while (fgets(line, LINELEN + 1, fp) != NULL) {
+        lineNo++;
+
+        if (check_line_endings(line)) {
+            Error err = { lineNo, ERR_CONVERSION };
+            errors.push_back(err);
+            eline.clear();
+            extend_ct = 0;
+            continue;
+        }
+
+        /* strip off newline */
+        len = strlen(line);
+        if (len > 0 && line[len - 1] == '\n') {
+            line[--len] = 0;
+        }
+
+        // honor backslash (\) as line-end escape
+        if (len > 0 && line[len - 1] == '\\') {
+            eline.append(line, len - 1);
+            if (++extend_ct > MAX_EXTEND_LINES) {
+                fprintf(stderr,
+                    "INIFILE lineno=%d:Too many backslash line extends (limit=%d)\n",
+                    lineNo, MAX_EXTEND_LINES);
+                Error err = { lineNo, ERR_OVER_EXTENDED };
+                errors.push_back(err);
+                eline.clear();
+                extend_ct = 0;
+            }
+            continue; // get next line to extend
+        }
+        eline.append(line, len);
+        extend_ct = 0;
+
+        AddLine(eline.c_str(), lineNo, &current);
+        eline.clear();
+    }
+    lineCount = lineNo;
+}
+
+void
+IniFile::Index::AddLine(const char *line, unsigned int lineNo,
+                        Section **current)
+{
+    const char                  *nonWhite;
+    const char                  *valueString;
+    size_t                      len;
+
+    if (NULL == (nonWhite = SkipWhite(line))) {
+        /* blank line or comment-- skip */
+        return;
+    }
+
+    if (nonWhite[0] == '[') {
+        /* a section tag ends the current section.  Lookups only ever see
+           the first section of a given name. */
+        if (*current != NULL) {
+            (*current)->endLineNo = lineNo;
+            *current = NULL;
+        }
+        const char *end = strchr(nonWhite, ']');
+        if (end != NULL) {
+            std::string name(nonWhite + 1, end);
+            if (sections.find(name) == sections.end()) {
+                Section &section = sections[name];
+                section.lineNo = lineNo;
+                section.endLineNo = UINT_MAX;
+                *current = &section;
+            }
+        }
+        return;
+    }
+
+    /* the tag runs up to whitespace or =, and a tag alone on a line
+       doesn't count */
+    len = strcspn(nonWhite, " \t\r\n=");
+    if (nonWhite[len] == 0) {
+        return;
+    }
+    std::string tag(nonWhite, len);
+
+    Entry entry;
+    entry.lineNo = lineNo;
+    valueString = AfterEqual(nonWhite + len);
+    entry.hasValue = (valueString != NULL);
+    if (valueString != NULL) {
+        /* Eliminate white space at the end of a line also. */
+        entry.value = valueString;
+        len = entry.value.find_last_not_of(" \t\r");
+        entry.value.erase(len + 1);
+    }
+
+    int n = entries.size();
+    entries.push_back(entry);
+    tags[tag].push_back(n);
+    if (*current != NULL) {
+        (*current)->tags[tag].push_back(n);
+    }
+}
+
+/*! Returns the first error on a line after 'after' up to and including
+   'upTo', or NULL if there is none.  Searching for a section header only
+   ever looked at line endings. */
+const IniFile::Index::Error *
+IniFile::Index::FindError(unsigned int after, unsigned int upTo,
+                          bool lineEndingsOnly) const
+{
+    for (size_t i = 0; i < errors.size(); i++) {
+        const Error &err = errors[i];
+        if (err.lineNo <= after) {
+            continue;
+        }
+        if (err.lineNo > upTo) {
+            break;
+        }
+        if (!lineEndingsOnly || err.errCode == ERR_CONVERSION) {
+            return &err;
+        }
+    }
+    return NULL;
+}
+
+/*! Returns the parsed form of the file open on 'fp'.  A process tends to
+   open its ini file many times over (once for each subsystem it sets up,
+   and once per lookup through iniFind()), so the result is kept, and only
+   parsed again if the file changes. */
+std::shared_ptr<IniFile::Index>
+IniFile::IndexFile(FILE *fp)
+{
+    struct CacheEntry {
+        off_t                   size;
+        struct timespec         mtime;
+        std::shared_ptr<Index>  index;
+    };
+    static std::map<std::pair<dev_t, ino_t>, CacheEntry> cache;
+    static std::mutex           cacheLock;
+
+    struct stat                 st;
+    std::shared_ptr<Index>      index;
+
+    if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode)) {
+        index = std::make_shared<Index>();
+        index->Parse(fp);
+        return index;
+    }
+
+    std::lock_guard<std::mutex> guard(cacheLock);
+    CacheEntry &cached = cache[std::make_pair(st.st_dev, st.st_ino)];
+    if (cached.index && cached.size == st.st_size
+        && cached.mtime.tv_sec == st.st_mtim.tv_sec
+        && cached.mtime.tv_nsec == st.st_mtim.tv_nsec) {
+        return cached.index;
+    }
+
+    index = std::make_shared<Index>();
+    index->Parse(fp);
+    cached.size = st.st_size;
+    cached.mtime = st.st_mtim;
+    cached.index = index;
+    return index;
+}
+
+
 IniFile::IniFile(int _errMask, FILE *_fp)
 {
     fp = _fp;
     errMask = _errMask;
     owned = false;
 
-    if(fp != NULL)
-        LockFile();
+    if(fp != NULL && LockFile())
+        index = IndexFile(fp);
 }
 
 
@@ -77,6 +302,8 @@ IniFile::Open(const char *file)
     if(!LockFile())
         return(false);
 
+    index = IndexFile(fp);
+
     return(true);
 }
 
@@ -98,6 +325,7 @@ IniFile::Close()
 
         fp = NULL;
     }
+    index.reset();
 
     return(rVal == 0);
 }
@@ -187,25 +415,15 @@ IniFile::Find(double *result, StrDoublePair *pPair,
 
    @param num (optionally) the Nth occurrence of the tag.
 
-   @return pointer to the the variable after the '=' delimiter */
+   @return pointer to the the variable after the '=' delimiter.  It stays
+   valid until the file is closed. */
 const char *
 IniFile::Find(const char *_tag, const char *_section, int _num, int *lineno)
 {
-    // WTF, return a pointer to the middle of a local buffer?
-    // FIX: this is totally non-reentrant.
-    static char                 line[LINELEN + 2] = "";        /* 1 for newline, 1 for NULL */
-    char                        bracketSection[LINELEN + 2] = "";
-    char                        *nonWhite;
-    int                         newLinePos;                /* position of newline to strip */
-    int                         len;
-    char                        tagEnd;
-    char                        *valueString;
-    char                        *endValueString;
-
-    char  eline [(LINELEN + 2) * (MAX_EXTEND_LINES + 1)];
-    char* elineptr;
-    char* elinenext;
-    int   extend_ct = 0;
+    const Index::TagMap         *tags;
+    const Index::Error          *err;
+    unsigned int                start = 0;
+    unsigned int                end = UINT_MAX;
 
     // For exceptions.
     lineNo = 0;
@@ -217,165 +435,58 @@ IniFile::Find(const char *_tag, const char *_section, int _num, int *lineno)
     if(!CheckIfOpen())
         return(NULL);
 
-    /* start from beginning */
-    rewind(fp);
-
-    /* check for section first-- if it's non-NULL, then position file at
-       line after [section] */
+    tags = &index->tags;
     if(section != NULL){
-        sprintf(bracketSection, "[%s]", section);
-
-        /* find [section], and position fp just after it */
-        while (!feof(fp)) {
-
-            if (NULL == fgets(line, LINELEN + 1, fp)) {
-                /* got to end of file without finding it */
-                ThrowException(ERR_SECTION_NOT_FOUND);
-                return(NULL);
-            }
-
-            if(check_line_endings(line)) {
-                ThrowException(ERR_CONVERSION);
+        Index::SectionMap::const_iterator it = index->sections.find(section);
+        if(it == index->sections.end()){
+            /* got to end of file without finding it */
+            if((err = index->FindError(0, UINT_MAX, true)) != NULL){
+                lineNo = err->lineNo;
+                ThrowException(err->errCode);
                 return(NULL);
             }
-
-            /* got a line */
-            lineNo++;
-
-            /* strip off newline */
-            newLinePos = strlen(line) - 1;        /* newline is on back from 0 */
-            if (newLinePos < 0) {
-                newLinePos = 0;
-            }
-            if (line[newLinePos] == '\n') {
-                line[newLinePos] = 0;        /* make the newline 0 */
-            }
-
-            if (NULL == (nonWhite = SkipWhite(line))) {
-                /* blank line-- skip */
-                continue;
-            }
-
-            /* not a blank line, and nonwhite is first char */
-            if (strncmp(bracketSection, nonWhite, strlen(bracketSection)) != 0){
-                /* not on this line */
-                continue;
-            }
-
-            /* it matches-- fp is now set up for search on tag */
-            break;
-        }
-    }
-
-    while (!feof(fp)) {
-        /* check for end of file */
-        if (NULL == fgets(line, LINELEN + 1, (FILE *) fp)) {
-            /* got to end of file without finding it */
-            ThrowException(ERR_TAG_NOT_FOUND);
+            lineNo = index->lineCount;
+            ThrowException(ERR_SECTION_NOT_FOUND);
             return(NULL);
         }
-
-        if(check_line_endings(line)) {
-            ThrowException(ERR_CONVERSION);
+        start = it->second.lineNo;
+        end = it->second.endLineNo;
+        if((err = index->FindError(0, start, true)) != NULL){
+            lineNo = err->lineNo;
+            ThrowException(err->errCode);
             return(NULL);
         }
+        tags = &it->second.tags;
+    }
 
-        /* got a line */
-        lineNo++;
-
-        /* strip off newline */
-        newLinePos = strlen(line) - 1;        /* newline is on back from 0 */
-        if (newLinePos < 0) {
-            newLinePos = 0;
-        }
-        if (line[newLinePos] == '\n') {
-            line[newLinePos] = 0;        /* make the newline 0 */
-        }
-        // honor backslash (\) as line-end escape
-        if (newLinePos > 0 && line[newLinePos-1] == '\\') {
-           newLinePos = newLinePos-1;
-           line[newLinePos] = 0;
-           if (!extend_ct) {
-               elineptr = (char*)eline; //first time
-               strncpy(elineptr,line,newLinePos);
-               elinenext = elineptr + newLinePos;
-           } else {
-               strncpy(elinenext,line,newLinePos);
-               elinenext = elinenext + newLinePos;
-           }
-           *elinenext = 0;
-           extend_ct++;
-           if (extend_ct > MAX_EXTEND_LINES) {
-              fprintf(stderr,
-                 "INIFILE lineno=%d:Too many backslash line extends (limit=%d)\n",
-                 lineNo, MAX_EXTEND_LINES);
-              ThrowException(ERR_OVER_EXTENDED);
-              return(NULL);
-           }
-           continue; // get next line to extend
-        } else {
-            if (extend_ct) {
-               strncpy(elinenext,line,newLinePos);
-               elinenext = elinenext + newLinePos;
-               *elinenext = 0;
-            }
-        }
-        if (!extend_ct) {
-           elineptr = (char*)line;
-        }
-        extend_ct = 0;
-
-        /* skip leading whitespace */
-        if (NULL == (nonWhite = SkipWhite(elineptr))) {
-            /* blank line-- skip */
-            continue;
-        }
-
-        /* check for '[' char-- if so, it's a section tag, and we're out
-           of our section */
-        if (NULL != section && nonWhite[0] == '[') {
-            ThrowException(ERR_TAG_NOT_FOUND);
-            return(NULL);
-        }
+    /* the Nth entry for the tag, or the end of the section if there
+       are fewer than N */
+    const Index::Entry *entry = NULL;
+    Index::TagMap::const_iterator it = tags->find(tag);
+    if(it != tags->end()){
+        size_t n = (num > 1) ? num - 1 : 0;
+        if(n < it->second.size())
+            entry = &index->entries[it->second[n]];
+    }
 
-        len = strlen(tag);
-        if (strncmp(tag, nonWhite, len) != 0) {
-            /* not on this line */
-            continue;
-        }
+    if((err = index->FindError(start, entry ? entry->lineNo : end, false))
+       != NULL){
+        lineNo = err->lineNo;
+        ThrowException(err->errCode);
+        return(NULL);
+    }
 
-        /* it matches the first part of the string-- if whitespace or = is
-           next char then call it a match */
-        tagEnd = nonWhite[len];
-        if (tagEnd == ' ' || tagEnd == '\r' || tagEnd == '\t'
-            || tagEnd == '\n' || tagEnd == '=') {
-            /* it matches-- return string after =, or NULL */
-            if (--_num > 0) {
-                /* Not looking for this one, so skip it... */
-                continue;
-            }
-            nonWhite += len;
-            valueString = AfterEqual(nonWhite);
-            /* Eliminate white space at the end of a line also. */
-            if (NULL == valueString) {
-                ThrowException(ERR_TAG_NOT_FOUND);
-                return(NULL);
-            }
-            endValueString = valueString + strlen(valueString) - 1;
-            while (*endValueString == ' ' || *endValueString == '\t'
-                   || *endValueString == '\r') {
-                *endValueString = 0;
-                endValueString--;
-            }
-	    if (lineno)
-		*lineno = lineNo;
-            return(valueString);
-        }
-        /* else continue */
+    if(entry == NULL || !entry->hasValue){
+        lineNo = entry ? entry->lineNo
+                       : (end == UINT_MAX ? index->lineCount : end);
+        ThrowException(ERR_TAG_NOT_FOUND);
+        return(NULL);
     }
 
-    ThrowException(ERR_TAG_NOT_FOUND);
-    return(NULL);
+    lineNo = entry->lineNo;
+    if (lineno)
+        *lineno = lineNo;
+    return(entry->value.c_str());
 }
 
 const char *
@@ -613,8 +724,16 @@ extern "C" const char *
 iniFind(FILE *fp, const char *tag, const char *section)
 {
     IniFile                     f(false, fp);
+    const char                  *value;
+    static std::string          result;
 
-    return(f.Find(tag, section));
+    /* The index 'f' found the value in may go away with 'f', as it does
+       for a pipe or a file changed since it was last indexed, so hand
+       out a copy that lasts until the next call, as before. */
+    if((value = f.Find(tag, section)) == NULL)
+        return(NULL);
+    result = value;
+    return(result.c_str());
 }
 
 extern "C" const int
@@ -18,6 +18,7 @@
 
 #include <inifile.h>
 #include <string>
+#include <memory>
 #include <boost/lexical_cast.hpp>
 
 #ifndef __cplusplus
@@ -144,9 +145,12 @@ protected:
 
 
 private:
+    struct Index;
+
     FILE                        *fp;
     struct flock                lock;
     bool                        owned;
+    std::shared_ptr<Index>      index;
 
     Exception                   exception;
     int                         errMask;
@@ -159,8 +163,9 @@ private:
     bool                        CheckIfOpen(void);
     bool                        LockFile(void);
     void                        ThrowException(ErrorCode);
-    char                        *AfterEqual(const char *string);
-    char                        *SkipWhite(const char *string);
+    static std::shared_ptr<Index> IndexFile(FILE *fp);
+    static char                 *AfterEqual(const char *string);
+    static char                 *SkipWhite(const char *string);
 };
 #endif
 
@@ -635,7 +635,8 @@ static int rtapi_trap_handler(int vec, int signo, struct pt_regs *regs,
 }
 
 int rtapi_task_new(void (*taskcode) (void *), void *arg,
-    int prio, int owner, unsigned long int stacksize, int uses_fp)
+    int prio, int owner, unsigned long int stacksize, int uses_fp,
+    int cpu_id)
 {
     int n;
     long task_id;
@@ -671,6 +672,13 @@ int rtapi_task_new(void (*taskcode) (void *), void *arg,
 	rtapi_mutex_give(&(rtapi_data->mutex));
 	return -EINVAL;
     }
+    /* check requested CPU */
+    if (cpu_id == RTAPI_DEFAULT_CPU) {
+	cpu_id = rtapi_data->rt_cpu;
+    } else if (cpu_id < 0 || cpu_id >= NR_CPUS || !cpu_online(cpu_id)) {
+	rtapi_mutex_give(&(rtapi_data->mutex));
+	return -EINVAL;
+    }
     /* get space for the OS's task data - this is around 900 bytes, */
     /* so we don't want to statically allocate it for unused tasks. */
     ostask_array[task_id] = kmalloc(sizeof(RT_TASK), GFP_USER);
@@ -680,9 +688,9 @@ int rtapi_task_new(void (*taskcode) (void *), void *arg,
     }
     task->taskcode = taskcode;
     task->arg = arg;
-    /* call OS to initialize the task - use predetermined CPU */
+    /* call OS to initialize the task on the chosen CPU */
     retval = rt_task_init_cpuid(ostask_array[task_id], wrapper, task_id,
-	 stacksize, prio, uses_fp, 0 /* signal */, rtapi_data->rt_cpu );
+	 stacksize, prio, uses_fp, 0 /* signal */, cpu_id );
     if (retval != 0) {
 	/* couldn't create task, free task data memory */
 	kfree(ostask_array[task_id]);
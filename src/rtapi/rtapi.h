@@ -355,14 +355,21 @@ RTAPI_BEGIN_DECLS
     registers when needed causes the dreaded "NAN bug", so most
     tasks should set 'uses_fp' to RTAPI_USES_FP.  If a task
     definitely does not use floating point, setting 'uses_fp' to
-    RTAPI_NO_FP saves a few microseconds per task switch.  Call
-    only from within init/cleanup code, not from realtime tasks.
+    RTAPI_NO_FP saves a few microseconds per task switch.
+    'cpu_id' is the CPU the task is to run on, or RTAPI_DEFAULT_CPU
+    to let RTAPI pick one, normally the highest numbered CPU available
+    to realtime.  Asking for a CPU that is not available fails with
+    -EINVAL.  Call only from within init/cleanup code, not from
+    realtime tasks.
 */
 #define RTAPI_NO_FP   0
 #define RTAPI_USES_FP 1
 
+#define RTAPI_DEFAULT_CPU (-1)
+
     extern int rtapi_task_new(void (*taskcode) (void *), void *arg,
-	int prio, int owner, unsigned long int stacksize, int uses_fp);
+	int prio, int owner, unsigned long int stacksize, int uses_fp,
+	int cpu_id);
 
 /** 'rtapi_task_delete()' deletes a task.  'task_id' is a task ID
     from a previous call to rtapi_task_new().  It frees memory
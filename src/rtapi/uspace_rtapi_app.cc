@@ -581,7 +581,7 @@ struct rtapi_module {
 #define MODULE_OFFSET 32768
 
 rtapi_task::rtapi_task()
-    : magic{}, id{}, owner{}, stacksize{}, prio{},
+    : magic{}, id{}, owner{}, stacksize{}, prio{}, cpu_id{RTAPI_DEFAULT_CPU},
       period{}, nextstart{},
       ratio{}, arg{}, taskcode{}
 {}
@@ -859,13 +859,21 @@ int RtapiApp::allocate_task_id()
 }
 
 int RtapiApp::task_new(void (*taskcode) (void*), void *arg,
-        int prio, int owner, unsigned long int stacksize, int uses_fp) {
+        int prio, int owner, unsigned long int stacksize, int uses_fp,
+        int cpu_id) {
   /* check requested priority */
   if ((prio > rtapi_prio_highest()) || (prio < rtapi_prio_lowest()))
   {
     return -EINVAL;
   }
 
+  /* check requested CPU */
+  if (cpu_id < RTAPI_DEFAULT_CPU || cpu_id >= sysconf(_SC_NPROCESSORS_CONF))
+  {
+    rtapi_print_msg(RTAPI_MSG_ERR, "rtapi_task_new: no CPU %d\n", cpu_id);
+    return -EINVAL;
+  }
+
   /* label as a valid task structure */
   int n = allocate_task_id();
   if(n < 0) return n;
@@ -880,6 +888,7 @@ int RtapiApp::task_new(void (*taskcode) (void*), void *arg,
   task->stacksize = stacksize;
   task->taskcode = taskcode;
   task->prio = prio;
+  task->cpu_id = cpu_id;
   task->magic = TASK_MAGIC;
   task_array[n] = task;
 
@@ -1004,14 +1013,18 @@ int Posix::task_start(int task_id, unsigned long int period_nsec)
       return -errno;
   if(nprocs > 1) {
       const static int rt_cpu_number = find_rt_cpu_number();
-      if(rt_cpu_number != -1) {
+      int cpu = task->cpu_id;
+      if(cpu == RTAPI_DEFAULT_CPU) cpu = rt_cpu_number;
+      if(cpu != -1) {
 #ifdef __FreeBSD__
           cpuset_t cpuset;
 #else
           cpu_set_t cpuset;
 #endif
+          rtapi_print_msg(RTAPI_MSG_INFO, "task %d runs on CPU %d\n",
+                  task->id, cpu);
           CPU_ZERO(&cpuset);
-          CPU_SET(rt_cpu_number, &cpuset);
+          CPU_SET(cpu, &cpuset);
           if(pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset) < 0)
                return -errno;
       }
@@ -1166,8 +1179,10 @@ long RtapiApp::clock_set_period(long nsecs)
 
 
 int rtapi_task_new(void (*taskcode) (void*), void *arg,
-        int prio, int owner, unsigned long int stacksize, int uses_fp) {
-    return App().task_new(taskcode, arg, prio, owner, stacksize, uses_fp);
+        int prio, int owner, unsigned long int stacksize, int uses_fp,
+        int cpu_id) {
+    return App().task_new(taskcode, arg, prio, owner, stacksize, uses_fp,
+            cpu_id);
 }
 
 int rtapi_task_delete(int id) {
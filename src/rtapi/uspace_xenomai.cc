@@ -53,7 +53,10 @@ struct XenomaiApp : RtapiApp {
         cpu_set_t cpuset;
         CPU_ZERO(&cpuset);
         int nprocs = sysconf( _SC_NPROCESSORS_ONLN );
-        CPU_SET(nprocs-1, &cpuset); // assumes processor numbers are contiguous
+        if(task->cpu_id != RTAPI_DEFAULT_CPU)
+            CPU_SET(task->cpu_id, &cpuset);
+        else
+            CPU_SET(nprocs-1, &cpuset); // assumes processor numbers are contiguous
 
         pthread_attr_t attr;
         if(pthread_attr_init(&attr) < 0)
@@ -0,0 +1,4 @@
+#!/bin/sh
+# write a record file of known samples and print it back
+test_scope_record > record || exit 1
+halscope-record record
@@ -0,0 +1,20 @@
+#!/bin/bash
+# run hm2_eth against the software board at 1, 2 and 4 kHz, first as it
+# is by default and then with packet-coalesce and busy_poll, and print how
+# long its functs took
+
+hm2_eth_emu $EMU_ARGS &
+EMU=$!
+trap "kill $EMU" EXIT
+sleep 1
+
+export BENCH_SECONDS=${SECONDS_PER_RATE:-5}
+for MODE in "0 0" "1 50"; do
+    set -- $MODE
+    export COALESCE=$1 BUSY_POLL=$2
+    for PERIOD in 1000000 500000 250000; do
+        export PERIOD
+        echo "rate $((1000000000 / PERIOD)) Hz coalesce $COALESCE busy_poll $BUSY_POLL"
+        halrun -s -f bench.hal || exit 1
+    done
+done
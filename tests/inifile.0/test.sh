@@ -0,0 +1,21 @@
+#!/bin/sh
+find() {
+    echo "$*:"
+    inivar -ini test.ini "$@" 2>&1
+}
+find -var TOP
+find -var TOP -sec EMC
+find -var MACHINE -sec EMC
+find -var MACHINE -num 2
+find -var DEBUG -sec EMC
+find -var EMPTY -sec EMC
+find -var ALONE -sec EMC
+find -var HALFILE -sec HAL
+find -var HALFILE -sec HAL -num 2
+find -var HALFILE -sec HAL -num 3
+find -var HALFILE -sec HAL -num 4
+find -var TWOPASS -sec HAL
+find -var TYPE -sec JOINT_0
+find -var TYPE -sec JOINT_1
+find -var ONLY_HERE -sec EMC
+find -var ONLY_HERE
@@ -0,0 +1,4 @@
+#!/bin/bash
+rs274 -i test.ini -g test.ngc 2>&1
+# this is expected to fail on the division by zero
+exit 0
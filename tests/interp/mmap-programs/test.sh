@@ -0,0 +1,3 @@
+#!/bin/bash
+rs274 -n 0 -i test.ini -g test.ngc
+exit $?
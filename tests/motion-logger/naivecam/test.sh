@@ -0,0 +1,5 @@
+#!/bin/bash -e
+
+rm -f out.motion-logger result.moves
+
+linuxcnc -r naivecam.ini
@@ -0,0 +1,22 @@
+#!/bin/bash
+# capture a known sequence with halsampler -b and -m, replay each capture
+# with halstreamer -b and -m, and check that nothing changed on the way
+rm -f captured.b captured.m replayed recaptured
+
+halrun -f capture.hal || exit 1
+cmp captured.b captured.m && echo "-b and -m captures are the same"
+
+for MODE in -b -m; do
+    case $MODE in
+    -b) export CAPTURED=captured.b ;;
+    -m) export CAPTURED=captured.m ;;
+    esac
+    export MODE
+    rm -f replayed recaptured
+    halrun -f replay.hal || exit 1
+    diff -u input replayed && echo "halstreamer $MODE replayed the input"
+    cmp captured.b recaptured && echo "halstreamer $MODE capture recaptured unchanged"
+done
+
+# a file of fsub records must not be streamed to fsbu pins
+halrun -f mismatch.hal
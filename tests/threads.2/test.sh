@@ -0,0 +1,15 @@
+#!/bin/bash
+# The thread runs on the last CPU the test may use and gets a worker on
+# each of up to three of the others, so no two of them share a CPU
+CPUS=($(awk -F'[ \t,]+' '/^Cpus_allowed_list:/ {
+    for (i = 2; i <= NF; i++) {
+        n = split($i, r, "-")
+        for (c = r[1]; c <= r[n]; c++) print c
+    }
+}' /proc/self/status))
+export THREAD_CPU=${CPUS[${#CPUS[@]} - 1]}
+unset "CPUS[${#CPUS[@]} - 1]"
+WORKERS=${CPUS[*]:0:3}
+export WORKERS=${WORKERS// /,}
+
+halrun -f threads.hal
@@ -0,0 +1,69 @@
+#!/usr/bin/env python
+
+import linuxcnc
+
+import time
+import sys
+
+
+def wait_for_linuxcnc_startup(status, timeout=10.0):
+
+    """Poll the Status buffer waiting for it to look initialized,
+    rather than just allocated (all-zero).  Returns on success, throws
+    RuntimeError on failure."""
+
+    start_time = time.time()
+    while time.time() - start_time < timeout:
+        status.poll()
+        if (status.angular_units == 0.0) \
+            or (status.axes == 0) \
+            or (status.cycle_time == 0.0) \
+            or (status.exec_state != linuxcnc.EXEC_DONE) \
+            or (status.interp_state != linuxcnc.INTERP_IDLE) \
+            or (status.linear_units == 0.0) \
+            or (status.state != linuxcnc.STATE_ESTOP) \
+            or (status.task_state != linuxcnc.STATE_ESTOP):
+            time.sleep(0.1)
+        else:
+            # looks good
+            return
+
+    # timeout, throw an exception
+    raise RuntimeError
+
+
+# Task writes its status at least once a second, so a wait_complete()
+# that only notices the end of a command on that write takes about
+# that long.
+MAX_WAIT = 0.5
+
+c = linuxcnc.command()
+s = linuxcnc.stat()
+
+wait_for_linuxcnc_startup(s)
+
+c.state(linuxcnc.STATE_ESTOP_RESET)
+c.state(linuxcnc.STATE_ON)
+c.home(-1)
+c.wait_complete()
+
+c.mode(linuxcnc.MODE_MDI)
+c.wait_complete()
+
+retval = 0
+slowest = 0.0
+for i in range(20):
+    start = time.time()
+    c.mdi('G90')
+    r = c.wait_complete()
+    elapsed = time.time() - start
+    slowest = max(slowest, elapsed)
+    if r != linuxcnc.RCS_DONE:
+        print "wait_complete() returned %s on MDI %d" % (r, i)
+        retval = 1
+    if elapsed > MAX_WAIT:
+        print "MDI %d took %.3f seconds to complete" % (i, elapsed)
+        retval = 1
+
+print "slowest MDI took %.3f seconds" % slowest
+sys.exit(retval)
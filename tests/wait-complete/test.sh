@@ -0,0 +1,4 @@
+#!/bin/bash
+
+rm -f sim.var
+linuxcnc -r test.ini
@@ -0,0 +1,217 @@
+/********************************************************************
+* Description: genhexkins_benchmark.c
+*   Forward kinematics of genhexkins the way the servo thread runs
+*   them: the strut lengths of a hexapod trajectory sampled once per
+*   servo period, each solved starting from the pose found for the
+*   period before.  Reports iterations, time per call and the largest
+*   position and rotation error for plain Newton-Raphson and for the
+*   quasi-Newton solver, and for the quasi-Newton solver started cold
+*   from the first pose of the trajectory on every call.  Fails if any
+*   pose is not found.
+*
+*   The trajectory is read from a file with one pose "x y z a b c" per
+*   servo period, or, without one, is a tilted circle at 4 kHz.
+*
+*   Usage: genhexkins_benchmark [-n periods] [trajectory-file]
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+#include <getopt.h>
+
+#include "hal.h"
+#include "emcpos.h"
+#include "kinematics.h"
+
+/* just enough HAL for genhexkins' rtapi_app_main */
+static hal_bit_t *quasi_newton;
+static hal_u32_t *last_iter;
+
+int hal_init(const char *name) { return 1; }
+int hal_exit(int comp_id) { return 0; }
+int hal_ready(int comp_id) { return 0; }
+void *hal_malloc(long int size) { return calloc(1, size); }
+
+int hal_pin_float_newf(hal_pin_dir_t dir, hal_float_t **data_ptr_addr,
+                       int comp_id, const char *fmt, ...)
+{
+    *data_ptr_addr = calloc(1, sizeof(hal_float_t));
+    return 0;
+}
+
+int hal_pin_u32_newf(hal_pin_dir_t dir, hal_u32_t **data_ptr_addr,
+                     int comp_id, const char *fmt, ...)
+{
+    *data_ptr_addr = calloc(1, sizeof(hal_u32_t));
+    if (!strcmp(fmt, "genhexkins.last-iterations"))
+        last_iter = *data_ptr_addr;
+    return 0;
+}
+
+int hal_param_bit_newf(hal_param_dir_t dir, hal_bit_t *data_addr,
+                       int comp_id, const char *fmt, ...)
+{
+    if (!strcmp(fmt, "genhexkins.quasi-newton"))
+        quasi_newton = data_addr;
+    return 0;
+}
+
+int hal_param_float_newf(hal_param_dir_t dir, hal_float_t *data_addr,
+                         int comp_id, const char *fmt, ...)
+{
+    return 0;
+}
+
+int hal_param_u32_newf(hal_param_dir_t dir, hal_u32_t *data_addr,
+                       int comp_id, const char *fmt, ...)
+{
+    return 0;
+}
+
+extern int rtapi_app_main(void);
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static long read_trajectory(const char *name, EmcPose **poses)
+{
+    FILE *f = fopen(name, "r");
+    long n = 0, size = 0;
+    EmcPose p;
+
+    if (!f) {
+        perror(name);
+        exit(1);
+    }
+    memset(&p, 0, sizeof(p));
+    while (fscanf(f, "%lf %lf %lf %lf %lf %lf", &p.tran.x, &p.tran.y,
+                  &p.tran.z, &p.a, &p.b, &p.c) == 6) {
+        if (n == size) {
+            size = size ? 2 * size : 4096;
+            *poses = realloc(*poses, size * sizeof(EmcPose));
+        }
+        (*poses)[n++] = p;
+    }
+    fclose(f);
+    return n;
+}
+
+/* circles of radius 2 at 4 units/s, the platform tilting +-10 degrees */
+static long make_trajectory(long n, EmcPose **poses)
+{
+    double period = 250e-6, radius = 2.0, speed = 4.0;
+
+    *poses = calloc(n, sizeof(EmcPose));
+    for (long i = 0; i < n; i++) {
+        double t = i * period, w = speed / radius;
+        (*poses)[i].tran.x = radius * cos(w * t);
+        (*poses)[i].tran.y = radius * sin(w * t);
+        (*poses)[i].tran.z = 20.0 + 0.5 * sin(w * t / 3);
+        (*poses)[i].a = 10.0 * sin(w * t);
+        (*poses)[i].b = 10.0 * cos(w * t);
+        (*poses)[i].c = 5.0 * sin(w * t / 2);
+    }
+    return n;
+}
+
+/* the largest error allowed in a pose found, in length units and degrees */
+#define MAX_ERROR 1e-6
+
+/* Solves the strut lengths of each period, starting from the pose found
+   for the period before or, for a cold start, from the first pose of the
+   trajectory.  Returns 0 if every pose was found to within MAX_ERROR. */
+static int run(const char *name, int qn, int cold, const EmcPose *poses,
+               double (*joints)[6], long n)
+{
+    KINEMATICS_FORWARD_FLAGS fflags = 0;
+    KINEMATICS_INVERSE_FLAGS iflags = 0;
+    EmcPose pose = poses[0];
+    long iterations = 0;
+    unsigned max_iterations = 0;
+    double err = 0, rot_err = 0;
+
+    *quasi_newton = qn;
+    double start = now();
+    for (long i = 0; i < n; i++) {
+        if (cold)
+            pose = poses[0];
+        if (kinematicsForward(joints[i], &pose, &fflags, &iflags)) {
+            fprintf(stderr, "%s: no solution for period %ld\n", name, i);
+            return 1;
+        }
+        iterations += *last_iter;
+        if (*last_iter > max_iterations)
+            max_iterations = *last_iter;
+        err = fmax(err, fabs(pose.tran.x - poses[i].tran.x));
+        err = fmax(err, fabs(pose.tran.y - poses[i].tran.y));
+        err = fmax(err, fabs(pose.tran.z - poses[i].tran.z));
+        rot_err = fmax(rot_err, fabs(pose.a - poses[i].a));
+        rot_err = fmax(rot_err, fabs(pose.b - poses[i].b));
+        rot_err = fmax(rot_err, fabs(pose.c - poses[i].c));
+    }
+    double t = now() - start;
+    printf("%-18s %8.1f ns per call %6.2f iterations (max %u) "
+           "error %.1e, %.1e deg\n", name, t / n * 1e9,
+           (double) iterations / n, max_iterations, err, rot_err);
+    if (err > MAX_ERROR || rot_err > MAX_ERROR) {
+        fprintf(stderr, "%s: wrong pose found\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    long n = 400000;
+    EmcPose *poses = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n': n = atol(optarg); break;
+        default:
+            fprintf(stderr, "Usage: %s [-n periods] [trajectory-file]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (optind < argc)
+        n = read_trajectory(argv[optind], &poses);
+    else
+        n = make_trajectory(n, &poses);
+    if (n < 1) {
+        fprintf(stderr, "%s: empty trajectory\n", argv[0]);
+        return 1;
+    }
+
+    if (rtapi_app_main() != 0) {
+        fprintf(stderr, "%s: genhexkins failed to start\n", argv[0]);
+        return 1;
+    }
+
+    KINEMATICS_FORWARD_FLAGS fflags = 0;
+    KINEMATICS_INVERSE_FLAGS iflags = 0;
+    double (*joints)[6] = calloc(n, sizeof(*joints));
+    for (long i = 0; i < n; i++) {
+        kinematicsInverse(&poses[i], joints[i], &iflags, &fflags);
+    }
+
+    printf("%ld servo periods\n", n);
+    int failed = run("Newton", 0, 0, poses, joints, n);
+    failed |= run("quasi-Newton", 1, 0, poses, joints, n);
+    failed |= run("quasi-Newton cold", 1, 1, poses, joints, n);
+    return failed;
+}
@@ -0,0 +1,335 @@
+/********************************************************************
+* Description: tcp_srv_loadtest.cc
+*   Many remote NML readers against one CMS TCP server, the way a row
+*   of shop-floor status displays attach to a controller.  Each client
+*   either reads the buffer at a fixed rate and times the reply, or
+*   subscribes to it and counts the updates the server pushes.  The
+*   clients all run from one thread so the load generator itself stays
+*   cheap; with -P the CPU time of the server process is reported too.
+*
+*   Usage: tcp_srv_loadtest [-c clients] [-t seconds] [-r reads/s]
+*                           [-s poll-ms] [-P server-pid]
+*                           [host:]port buffer-number
+*
+*   e.g. against a running emcsvr, emcStatus is buffer 2 on port 5005:
+*       tcp_srv_loadtest -c 300 -P $(pidof emcsvr) 5005 2
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <vector>
+
+// from rem_msg.hh and cms.hh
+enum {
+    READ_REQUEST = 1,
+    SET_SUBSCRIPTION_REQUEST = 9,
+    PEEK_ACCESS = 3,
+    VARIABLE_SUBSCRIPTION = 3,
+};
+
+struct Client {
+    int fd;
+    uint32_t serial;
+    double next_read;		// when the next read request is due
+    double sent;		// when the outstanding one went out, or 0
+    char header[20];
+    int have;			// bytes of the current reply received
+    int want;			// bytes of the current reply expected
+    bool subscribed;
+    long updates;
+};
+
+static std::vector<char> sink;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void putbe32(char *addr, uint32_t val)
+{
+    val = htonl(val);
+    memcpy(addr, &val, sizeof(val));
+}
+
+static uint32_t getbe32(const char *addr)
+{
+    uint32_t val;
+    memcpy(&val, addr, sizeof(val));
+    return ntohl(val);
+}
+
+// user+system seconds of a process, from /proc/<pid>/stat
+static double process_cpu(int pid)
+{
+    char name[64], line[1024];
+    unsigned long utime, stime;
+
+    snprintf(name, sizeof(name), "/proc/%d/stat", pid);
+    FILE *f = fopen(name, "r");
+    if (!f)
+	return -1;
+    char *p = fgets(line, sizeof(line), f) ? strrchr(line, ')') : NULL;
+    fclose(f);
+    if (!p || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u "
+		     "%lu %lu", &utime, &stime) != 2)
+	return -1;
+    return (double) (utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+static double own_cpu()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 +
+	ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+}
+
+static int send_request(Client *c, uint32_t type, uint32_t buffer_number,
+			uint32_t arg1, uint32_t arg2)
+{
+    char req[20];
+    putbe32(req, c->serial);
+    putbe32(req + 4, type);
+    putbe32(req + 8, buffer_number);
+    putbe32(req + 12, arg1);
+    putbe32(req + 16, arg2);
+    return send(c->fd, req, sizeof(req), MSG_NOSIGNAL) == sizeof(req) ?
+	0 : -1;
+}
+
+// Consume what is readable on a client.  Returns the number of complete
+// replies or pushed updates, or -1 when the server closed the connection.
+static int receive(Client *c)
+{
+    int done = 0;
+
+    while (1) {
+	int n;
+	if (c->have < 20) {
+	    n = recv(c->fd, c->header + c->have, c->want - c->have,
+		     MSG_DONTWAIT);
+	} else {
+	    n = recv(c->fd, sink.data(),
+		     std::min<size_t>(c->want - c->have, sink.size()),
+		     MSG_DONTWAIT);
+	}
+	if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR))
+	    return -1;
+	if (n < 0)
+	    return done;
+	c->have += n;
+	if (c->have < c->want)
+	    continue;
+	if (c->want == 8) {
+	    // the reply to the subscription request
+	    if (!getbe32(c->header + 4)) {
+		fprintf(stderr, "subscription refused\n");
+		exit(1);
+	    }
+	    c->subscribed = true;
+	    c->serial = getbe32(c->header);
+	    c->have = 0;
+	    c->want = 20;
+	    continue;
+	} else if (c->want == 20) {
+	    int size = getbe32(c->header + 8);
+	    if (size > 0) {
+		c->want += size;
+		continue;
+	    }
+	}
+	c->serial = getbe32(c->header);
+	c->have = 0;
+	c->want = 20;
+	done++;
+    }
+}
+
+static int connect_client(const struct sockaddr_in *addr)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+
+    if (fd < 0 || connect(fd, (const struct sockaddr *) addr,
+			  sizeof(*addr)) < 0) {
+	perror("connect");
+	exit(1);
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+int main(int argc, char *argv[])
+{
+    int nclients = 200, seconds = 10, server_pid = 0, poll_ms = 0;
+    double rate = 20.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:t:r:s:P:")) != -1) {
+	switch (opt) {
+	case 'c': nclients = atoi(optarg); break;
+	case 't': seconds = atoi(optarg); break;
+	case 'r': rate = atof(optarg); break;
+	case 's': poll_ms = atoi(optarg); break;
+	case 'P': server_pid = atoi(optarg); break;
+	default:
+	    optind = argc;
+	}
+    }
+    if (argc - optind != 2 || nclients < 1 || rate <= 0) {
+	fprintf(stderr, "Usage: %s [-c clients] [-t seconds] [-r reads/s] "
+		"[-s poll-ms] [-P server-pid] [host:]port buffer-number\n",
+		argv[0]);
+	return 1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    const char *port = argv[optind];
+    const char *colon = strrchr(port, ':');
+    if (colon) {
+	char host[256];
+	snprintf(host, sizeof(host), "%.*s", (int) (colon - port), port);
+	struct hostent *he = gethostbyname(host);
+	if (!he) {
+	    fprintf(stderr, "%s: unknown host\n", host);
+	    return 1;
+	}
+	memcpy(&addr.sin_addr, he->h_addr_list[0], sizeof(addr.sin_addr));
+	port = colon + 1;
+    }
+    addr.sin_port = htons(atoi(port));
+    uint32_t buffer_number = atoi(argv[optind + 1]);
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    std::vector<Client> clients(nclients);
+    sink.resize(1 << 20);
+    double start = now();
+    for (int i = 0; i < nclients; i++) {
+	Client *c = &clients[i];
+	memset(c, 0, sizeof(*c));
+	c->fd = connect_client(&addr);
+	c->want = 20;
+	// spread the reads of the clients over one period
+	c->next_read = start + (double) i / nclients / rate;
+	if (poll_ms > 0) {
+	    c->want = 8;
+	    send_request(c, SET_SUBSCRIPTION_REQUEST, buffer_number,
+			 VARIABLE_SUBSCRIPTION, poll_ms);
+	}
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.ptr = c;
+	epoll_ctl(epfd, EPOLL_CTL_ADD, c->fd, &ev);
+    }
+    printf("%d clients connected in %.1f ms\n", nclients,
+	   (now() - start) * 1e3);
+
+    std::vector<double> latency;
+    std::vector<struct epoll_event> events(nclients);
+    double cpu0 = server_pid ? process_cpu(server_pid) : 0;
+    double own0 = own_cpu();
+    start = now();
+    double end = start + seconds;
+    long updates = 0;
+
+    while (1) {
+	double t = now();
+	if (t >= end)
+	    break;
+	double next = end;
+	if (poll_ms <= 0) {
+	    for (int i = 0; i < nclients; i++) {
+		Client *c = &clients[i];
+		if (c->sent == 0 && c->next_read <= t) {
+		    if (send_request(c, READ_REQUEST, buffer_number,
+				     PEEK_ACCESS, 0) < 0) {
+			fprintf(stderr, "send failed: %s\n", strerror(errno));
+			return 1;
+		    }
+		    c->sent = t;
+		    c->next_read += 1.0 / rate;
+		    if (c->next_read < t)
+			c->next_read = t;
+		}
+		if (c->sent == 0 && c->next_read < next)
+		    next = c->next_read;
+	    }
+	}
+	int timeout = (int) ceil((next - now()) * 1e3);
+	int n = epoll_wait(epfd, events.data(), nclients,
+			   timeout > 0 ? timeout : 0);
+	t = now();
+	for (int i = 0; i < n; i++) {
+	    Client *c = (Client *) events[i].data.ptr;
+	    int done = receive(c);
+	    if (done < 0) {
+		fprintf(stderr, "server closed a connection\n");
+		return 1;
+	    }
+	    if (done > 0 && c->sent != 0) {
+		latency.push_back(t - c->sent);
+		c->sent = 0;
+	    }
+	    if (c->subscribed) {
+		c->updates += done;
+		updates += done;
+	    }
+	}
+    }
+
+    double elapsed = now() - start;
+    if (poll_ms <= 0) {
+	if (latency.empty()) {
+	    fprintf(stderr, "no replies\n");
+	    return 1;
+	}
+	std::sort(latency.begin(), latency.end());
+	size_t count = latency.size();
+	printf("%zu reads, %.0f per second\n", count, count / elapsed);
+	printf("latency: median %.0f us, 99%% %.0f us, max %.0f us\n",
+	       latency[count / 2] * 1e6, latency[count * 99 / 100] * 1e6,
+	       latency[count - 1] * 1e6);
+    } else {
+	long fewest = clients[0].updates, most = clients[0].updates;
+	for (int i = 1; i < nclients; i++) {
+	    fewest = std::min(fewest, clients[i].updates);
+	    most = std::max(most, clients[i].updates);
+	}
+	printf("%ld updates pushed, %.1f per client per second "
+	       "(fewest %ld, most %ld per client)\n", updates,
+	       updates / elapsed / nclients, fewest, most);
+    }
+    if (server_pid) {
+	printf("server cpu: %.1f%%\n",
+	       (process_cpu(server_pid) - cpu0) / elapsed * 100);
+    }
+    printf("loadtest cpu: %.1f%%\n", (own_cpu() - own0) / elapsed * 100);
+    return 0;
+}
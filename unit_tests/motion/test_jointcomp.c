@@ -0,0 +1,252 @@
+#include "greatest.h"
+#include "jointcomp.h"
+#include "motion.h"
+#include <float.h>
+#include <math.h>
+
+/* Expand to all the definitions that need to be in
+   the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+#define TABLE_SIZE 4096
+
+static double nominal[TABLE_SIZE + 2];
+static emcmot_comp_entry_t entry[TABLE_SIZE + 2];
+
+/* A table of 'entries' unevenly spaced points, set up the way motion
+   sets it up, with -DBL_MAX and +DBL_MAX at the ends */
+static void make_table(emcmot_comp_t *comp, int entries)
+{
+    int n;
+
+    comp->entries = entries;
+    comp->max_entries = TABLE_SIZE;
+    comp->index = 0;
+    comp->nominal = nominal;
+    comp->entry = entry;
+    nominal[0] = -DBL_MAX;
+    for (n = 1; n <= entries; n++) {
+        nominal[n] = n + 0.001 * n * n - 50.0;
+    }
+    for (; n < TABLE_SIZE + 2; n++) {
+        nominal[n] = DBL_MAX;
+    }
+}
+
+/* the last entry whose nominal position is at or below pos */
+static int reference_entry(const emcmot_comp_t *comp, double pos)
+{
+    int n = 0;
+
+    while (n < comp->entries && nominal[n + 1] <= pos) {
+        n++;
+    }
+    return n;
+}
+
+/* positions on, just either side of, and between each point, and
+   beyond both ends */
+static int test_positions(const emcmot_comp_t *comp, double *pos)
+{
+    int count = 0, n;
+
+    pos[count++] = -1e9;
+    for (n = 1; n <= comp->entries; n++) {
+        pos[count++] = nominal[n];
+        pos[count++] = nominal[n] - 1e-9;
+        pos[count++] = nominal[n] + 1e-9;
+        if (n < comp->entries) {
+            pos[count++] = 0.5 * (nominal[n] + nominal[n + 1]);
+        }
+    }
+    pos[count++] = 1e9;
+    return count;
+}
+
+/* From every entry of small tables to every test position */
+TEST find_comp_entry_every_start() {
+    static double pos[4 * 300 + 2];
+    emcmot_comp_t comp;
+    int entries, start, count, i;
+
+    for (entries = 1; entries <= 300; entries += entries < 8 ? 1 : 73) {
+        make_table(&comp, entries);
+        count = test_positions(&comp, pos);
+        for (start = 0; start <= entries; start++) {
+            for (i = 0; i < count; i++) {
+                comp.index = start;
+                ASSERT_EQ_FMT(reference_entry(&comp, pos[i]),
+                              find_comp_entry(&comp, pos[i]), "%d");
+            }
+        }
+    }
+    PASS();
+}
+
+/* Jumps across a full table, in both directions, as after a rapid */
+TEST find_comp_entry_long_jumps() {
+    static double pos[4 * TABLE_SIZE + 2];
+    static const int starts[] = { 0, 1, 2, 3, TABLE_SIZE / 2,
+                                  TABLE_SIZE - 2, TABLE_SIZE - 1, TABLE_SIZE };
+    emcmot_comp_t comp;
+    int count, s, i;
+
+    make_table(&comp, TABLE_SIZE);
+    count = test_positions(&comp, pos);
+    for (s = 0; s < (int) (sizeof(starts) / sizeof(starts[0])); s++) {
+        for (i = 0; i < count; i++) {
+            comp.index = starts[s];
+            ASSERT_EQ_FMT(reference_entry(&comp, pos[i]),
+                          find_comp_entry(&comp, pos[i]), "%d");
+        }
+    }
+    PASS();
+}
+
+/* Following a position that moves back and forth along the table, each
+   call starting from the entry the one before found */
+TEST find_comp_entry_tracking() {
+    emcmot_comp_t comp;
+    double pos;
+    int step;
+
+    make_table(&comp, TABLE_SIZE);
+    for (step = 0; step < 200000; step++) {
+        pos = 10400.0 + 10500.0 * sin(step * 0.0005) + 3.0 * sin(step * 0.37);
+        comp.index = find_comp_entry(&comp, pos);
+        ASSERT_EQ_FMT(reference_entry(&comp, pos), comp.index, "%d");
+    }
+    PASS();
+}
+
+static float grid_value[64];
+
+/* ASSERT_IN_RANGE lets a NaN through */
+#define ASSERT_GRID_VALUE(EXP, GRID, JOINTS, TOL) do {         \
+        double got_ = comp_grid_value(GRID, JOINTS);            \
+        ASSERT_FALSE(isnan(got_));                              \
+        ASSERT_IN_RANGE(EXP, got_, TOL);                        \
+    } while (0)
+
+static void make_grid(emcmot_comp_grid_t *grid, int axes, const int *size,
+                      const double *start, const double *step)
+{
+    int n;
+
+    grid->axes = axes;
+    grid->points = 1;
+    for (n = 0; n < axes; n++) {
+        grid->joint[n] = n;
+        grid->size[n] = size[n];
+        grid->start[n] = start[n];
+        grid->inv_step[n] = 1.0 / step[n];
+        grid->points *= size[n];
+    }
+    grid->loaded = grid->points;
+    grid->max_points = 64;
+    grid->value = grid_value;
+    /* anything read from beyond the grid spoils the result */
+    for (n = grid->points; n < 64; n++) {
+        grid_value[n] = NAN;
+    }
+}
+
+/* The 3 x 2 grid from the COMP_GRID_FILE example in ini-config.txt */
+TEST comp_grid_value_2d() {
+    static const int size[] = { 3, 2 };
+    static const double start[] = { 0, 0 };
+    static const double step[] = { 100, 200 };
+    static const float values[] = { 0.000, 0.004, 0.006,
+                                    0.002, 0.005, 0.009 };
+    static const struct {
+        double x, y, value;
+    } cases[] = {
+        /* the points themselves */
+        { 0, 0, 0.000 }, { 100, 0, 0.004 }, { 200, 0, 0.006 },
+        { 0, 200, 0.002 }, { 100, 200, 0.005 }, { 200, 200, 0.009 },
+        /* along the cell edges */
+        { 50, 0, 0.002 }, { 150, 0, 0.005 }, { 0, 100, 0.001 },
+        { 100, 100, 0.0045 }, { 200, 100, 0.0075 }, { 150, 200, 0.007 },
+        /* inside the cells */
+        { 50, 100, 0.00275 }, { 150, 50, 0.0055 },
+        /* outside, the nearest edge */
+        { -50, 0, 0.000 }, { 250, 200, 0.009 }, { 50, -100, 0.002 },
+        { 150, 300, 0.007 }, { -1e6, 1e6, 0.002 }, { 1e6, -1e6, 0.006 },
+    };
+    emcmot_comp_grid_t grid;
+    emcmot_joint_t joints[2];
+    int i;
+
+    make_grid(&grid, 2, size, start, step);
+    for (i = 0; i < 6; i++) {
+        grid_value[i] = values[i];
+    }
+    for (i = 0; i < (int) (sizeof(cases) / sizeof(cases[0])); i++) {
+        joints[0].pos_cmd = cases[i].x;
+        joints[1].pos_cmd = cases[i].y;
+        ASSERT_GRID_VALUE(cases[i].value, &grid, joints, 1e-9);
+    }
+    PASS();
+}
+
+/* Interpolation between the points reproduces a plane exactly, so a
+   3 x 4 x 2 grid of one is checked all over, across cell edges */
+static double plane(double x, double y, double z)
+{
+    return 0.25 + 0.01 * x - 0.002 * y + 0.03 * z;
+}
+
+TEST comp_grid_value_3d() {
+    static const int size[] = { 3, 4, 2 };
+    static const double start[] = { -10, 5, 0 };
+    static const double step[] = { 10, 2.5, 4 };
+    emcmot_comp_grid_t grid;
+    emcmot_joint_t joints[3];
+    double x, y, z;
+    int i, j, k;
+
+    make_grid(&grid, 3, size, start, step);
+    for (k = 0; k < size[2]; k++) {
+        for (j = 0; j < size[1]; j++) {
+            for (i = 0; i < size[0]; i++) {
+                grid_value[i + size[0] * (j + size[1] * k)] =
+                    plane(start[0] + i * step[0], start[1] + j * step[1],
+                          start[2] + k * step[2]);
+            }
+        }
+    }
+    for (x = -10; x <= 10; x += 2.5) {
+        for (y = 5; y <= 12.5; y += 0.625) {
+            for (z = 0; z <= 4; z += 0.5) {
+                joints[0].pos_cmd = x;
+                joints[1].pos_cmd = y;
+                joints[2].pos_cmd = z;
+                ASSERT_GRID_VALUE(plane(x, y, z), &grid, joints, 1e-6);
+            }
+        }
+    }
+    /* beyond every face, the value on it */
+    joints[0].pos_cmd = -20;
+    joints[1].pos_cmd = 20;
+    joints[2].pos_cmd = -3;
+    ASSERT_GRID_VALUE(plane(-10, 12.5, 0), &grid, joints, 1e-6);
+    joints[0].pos_cmd = 30;
+    joints[1].pos_cmd = 0;
+    joints[2].pos_cmd = 2;
+    ASSERT_GRID_VALUE(plane(10, 5, 2), &grid, joints, 1e-6);
+    PASS();
+}
+
+SUITE(jointcomp) {
+    RUN_TEST(find_comp_entry_every_start);
+    RUN_TEST(find_comp_entry_long_jumps);
+    RUN_TEST(find_comp_entry_tracking);
+    RUN_TEST(comp_grid_value_2d);
+    RUN_TEST(comp_grid_value_3d);
+}
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN();      /* command-line arguments, initialization. */
+    RUN_SUITE(jointcomp);
+    GREATEST_MAIN_END();        /* display results */
+}
@@ -0,0 +1,148 @@
+/********************************************************************
+* Description: interpl_benchmark.cc
+*   Enqueue/dequeue throughput of NML_INTERP_LIST, the queue between
+*   the interpreter and task, against the LinkedList it used to be
+*   built on.  The list is filled to the readahead depth and then run
+*   the way task runs it: one command in for every command out.
+*
+*   Usage: interpl_benchmark [-n commands] [-d depth] [-s size]
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "nmlmsg.hh"
+#include "emc.hh"
+#include "emccfg.h"
+#include "emcglb.h"
+#include "interpl.hh"
+#include "linklist.hh"
+#include "rcs_print.hh"
+
+// the parts of liblinuxcnc and libnml interpl.cc needs
+int emc_debug = 0;
+const char *emc_symbol_lookup(uint32_t type) { return "?"; }
+int rcs_print(const char *fmt, ...) { return 0; }
+int set_print_rcs_error_info(const char *file, int line) { return 0; }
+int print_rcs_error_new(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    return 0;
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// what NML_INTERP_LIST::append() and get() did with a LinkedList
+struct OldList {
+    LinkedList list;
+    NML_INTERP_LIST_NODE temp_node;
+
+    void append(NMLmsg *m, int line) {
+        temp_node.line_number = line;
+        memcpy(temp_node.command.commandbuf, m, m->size);
+        list.store_at_tail(&temp_node,
+                           m->size + sizeof(temp_node.line_number) +
+                           sizeof(temp_node.dummy) + 32 + (32 - m->size % 32), 1);
+    }
+    NMLmsg *get() {
+        NML_INTERP_LIST_NODE *node = (NML_INTERP_LIST_NODE *) list.retrieve_head();
+        return node ? (NMLmsg *) node->command.commandbuf : NULL;
+    }
+};
+
+template <class List>
+static double run(List &list, NMLmsg *msg, long n, int depth)
+{
+    long sum = 0;
+    int line = 0;
+
+    for (int i = 0; i < depth; i++) {
+        list.append(msg, line++);
+    }
+    double start = now();
+    for (long i = 0; i < n; i++) {
+        sum += list.get()->size;
+        list.append(msg, line++);
+    }
+    double t = now() - start;
+    while (NMLmsg *m = list.get()) {
+        sum += m->size;
+    }
+    if (sum != (n + depth) * msg->size) {
+        fprintf(stderr, "lost commands\n");
+        exit(1);
+    }
+    return t;
+}
+
+struct NewList {
+    NML_INTERP_LIST list;
+
+    void append(NMLmsg *m, int line) {
+        list.set_line_number(line);
+        list.append(m);
+    }
+    NMLmsg *get() { return list.get(); }
+};
+
+int main(int argc, char *argv[])
+{
+    long n = 10000000;
+    int depth = DEFAULT_EMC_TASK_INTERP_MAX_LEN;
+    int size = 128;		// sizeof(EMC_TRAJ_LINEAR_MOVE)
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:d:s:")) != -1) {
+        switch (opt) {
+        case 'n': n = atol(optarg); break;
+        case 'd': depth = atoi(optarg); break;
+        case 's': size = atoi(optarg); break;
+        default:
+            fprintf(stderr, "Usage: %s [-n commands] [-d depth] [-s size]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (n < 1 || depth < 0 || size < (int) sizeof(NMLmsg) ||
+        size > MAX_NML_COMMAND_SIZE - 64) {
+        fprintf(stderr, "%s: bad arguments\n", argv[0]);
+        return 1;
+    }
+
+    NML_INTERP_LIST_NODE buf;
+    memset(&buf, 0, sizeof(buf));
+    NMLmsg *msg = (NMLmsg *) buf.command.commandbuf;
+    msg->type = EMC_TRAJ_LINEAR_MOVE_TYPE;
+    msg->size = size;
+
+    printf("%ld commands of %d bytes, %d queued\n", n, size, depth);
+
+    OldList old_list;
+    double t = run(old_list, msg, n, depth);
+    printf("%-18s %8.1f ns per command %8.2f M commands/s\n",
+           "LinkedList", t / n * 1e9, n / t * 1e-6);
+
+    NewList new_list;
+    new_list.list.reserve(depth);
+    t = run(new_list, msg, n, depth);
+    printf("%-18s %8.1f ns per command %8.2f M commands/s\n",
+           "NML_INTERP_LIST", t / n * 1e9, n / t * 1e-6);
+    return 0;
+}
@@ -63,10 +63,90 @@ TEST pmCartCartAntiParallel_numerical() {
     PASS();
 }
 
+TEST findSCurveMaxStartVel_consistent() {
+
+    const double a_max = 100.0;
+    const double j_max = 2000.0;
+    const double v_max = 1e6;
+
+    // Short moves (no constant accel phase) and long ones, with and
+    // without a final velocity
+    double dists[] = {1e-4, 0.01, 1.0, 50.0};
+    double v_finals[] = {0.0, 1.0, 20.0};
+    int i, k;
+    for (i = 0; i < 4; ++i) {
+        for (k = 0; k < 3; ++k) {
+            double a_s = 0.0;
+            double v_s = findSCurveMaxStartVel(v_finals[k], 0.0, dists[i], a_max, j_max, v_max, &a_s);
+            ASSERT(v_s > v_finals[k]);
+            ASSERT(a_s < 0.0 && a_s >= -a_max);
+            // Jerk limiting can only make things slower
+            ASSERT(v_s <= pmSqrt(pmSq(v_finals[k]) + 2.0 * a_max * dists[i]));
+            // We can follow the braking curve from its start state
+            double d = findSCurveStopDistance(v_s, a_s, v_finals[k], 0.0, a_max, j_max);
+            ASSERT(d <= dists[i] * (1.0 + 1e-9));
+        }
+    }
+
+    // Extending the curve over two pieces is the same as doing it in one go
+    double a_mid = 0.0, a_2 = 0.0, a_1 = 0.0;
+    double v_mid = findSCurveMaxStartVel(0.0, 0.0, 0.3, a_max, j_max, v_max, &a_mid);
+    double v_2 = findSCurveMaxStartVel(v_mid, a_mid, 0.7, a_max, j_max, v_max, &a_2);
+    double v_1 = findSCurveMaxStartVel(0.0, 0.0, 1.0, a_max, j_max, v_max, &a_1);
+    ASSERT_IN_RANGE(v_1, v_2, 1e-9);
+    ASSERT_IN_RANGE(a_1, a_2, 1e-9);
+
+    // The curve rounds off into cruise at the velocity limit, and every point
+    // on the way is reachable from cruise
+    const double v_cruise = 30.0;
+    double v_top = findSCurveMaxStartVel(0.0, 0.0, 50.0, a_max, j_max, v_cruise, &a_1);
+    ASSERT_IN_RANGE(v_cruise, v_top, 1e-9);
+    ASSERT_IN_RANGE(0.0, a_1, 1e-6);
+    for (i = 0; i < 4; ++i) {
+        double v_s = findSCurveMaxStartVel(0.0, 0.0, dists[i], a_max, j_max, v_cruise, &a_1);
+        ASSERT(v_s <= v_cruise + 1e-9);
+        ASSERT(v_s + pmSq(a_1) / (2.0 * j_max) <= v_cruise + 1e-9);
+    }
+
+    // No jerk limit is the trapezoidal profile
+    ASSERT_IN_RANGE(pmSqrt(2.0 * a_max), findSCurveMaxStartVel(0.0, 0.0, 1.0, a_max, 0.0, v_max, &a_1), 1e-12);
+
+    PASS();
+}
+
+TEST findSCurveStopDistance_accel() {
+
+    const double a_max = 100.0;
+    const double j_max = 2000.0;
+
+    // Already accelerating means we need further to stop
+    double d0 = findSCurveStopDistance(10.0, 0.0, 0.0, 0.0, a_max, j_max);
+    double d_acc = findSCurveStopDistance(10.0, 50.0, 0.0, 0.0, a_max, j_max);
+    double d_dec = findSCurveStopDistance(10.0, -50.0, 0.0, 0.0, a_max, j_max);
+    ASSERT(d_acc > d0);
+    ASSERT(d_dec < d0);
+
+    // Cruising at the stop velocity takes exactly the distance to stop, with
+    // and without a constant deceleration phase
+    double dists[] = {1e-3, 0.1, 10.0};
+    int i;
+    for (i = 0; i < 3; ++i) {
+        double v_stop = findSCurveStopVel(dists[i], a_max, j_max);
+        ASSERT_IN_RANGE(dists[i], findSCurveStopDistance(v_stop, 0.0, 0.0, 0.0, a_max, j_max), 1e-9);
+    }
+    ASSERT_IN_RANGE(findVPeak(a_max, 2.0), findSCurveStopVel(1.0, a_max, 0.0), 1e-12);
+
+    // Nothing to do if we're already at the final velocity
+    ASSERT_EQ(0.0, findSCurveStopDistance(10.0, 0.0, 10.0, 0.0, a_max, j_max));
+
+    PASS();
+}
 
  SUITE(blendmath) {
      RUN_TEST(pmCartCartParallel_numerical);
      RUN_TEST(pmCartCartAntiParallel_numerical);
+     RUN_TEST(findSCurveMaxStartVel_consistent);
+     RUN_TEST(findSCurveStopDistance_accel);
 
  }
 
@@ -0,0 +1,163 @@
+#include "tp_debug.h"
+#include "greatest.h"
+#include "tp.h"
+#include "tp_types.h"
+#include "tcq.h"
+#include "motion.h"
+#include "motion_debug.h"
+#include "motion_types.h"
+#include "mot_priv.h"
+#include "emcmotcfg.h"
+#include "emcpose.h"
+#include "math.h"
+#include "rtapi.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Expand to all the definitions that need to be in
+   the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+// Motion globals normally provided by the motion module
+static emcmot_status_t test_status;
+static emcmot_config_t test_config;
+static emcmot_debug_t test_debug;
+emcmot_status_t *emcmotStatus = &test_status;
+emcmot_config_t *emcmotConfig = &test_config;
+emcmot_debug_t *emcmotDebug = &test_debug;
+
+static TC_STRUCT test_tc_space[DEFAULT_TC_QUEUE_SIZE + 10];
+
+// KLUDGE fix link error the ugly way
+void rtapi_print_msg(msg_level_t level, const char *fmt, ...)
+{
+}
+
+void emcmotDioWrite(int index, char value) {}
+void emcmotAioWrite(int index, double value) {}
+void emcmotSetRotaryUnlock(int axis, int unlock) {}
+int emcmotGetRotaryIsUnlocked(int axis) { return 0; }
+
+#define TEST_CYCLE_TIME 0.001
+#define TEST_VEL 40.0
+#define TEST_ACC 100.0
+#define TEST_SEGMENT_LENGTH 0.05
+#define TEST_NUM_SEGMENTS 100000
+
+static void setupMotionGlobals(int depth)
+{
+    memset(&test_status, 0, sizeof(test_status));
+    memset(&test_config, 0, sizeof(test_config));
+    memset(&test_debug, 0, sizeof(test_debug));
+
+    int i;
+    for (i = 0; i < 3; ++i) {
+        test_debug.axes[i].vel_limit = 2.0 * TEST_VEL;
+        test_debug.axes[i].acc_limit = 2.0 * TEST_ACC;
+    }
+    test_status.net_feed_scale = 1.0;
+    test_config.maxFeedScale = 1.0;
+    test_config.numSpindles = 1;
+    test_config.arcBlendEnable = 1;
+    test_config.arcBlendFallbackEnable = 0;
+    test_config.arcBlendOptDepth = depth;
+    test_config.arcBlendGapCycles = 4;
+    test_config.arcBlendRampFreq = 100.0;
+    test_config.arcBlendTangentKinkRatio = 0.1;
+}
+
+/**
+ * Point along a gently curving synthetic spline, parameterized by (roughly)
+ * path length.
+ */
+static EmcPose splinePoint(double s)
+{
+    EmcPose p = {{0}};
+    p.tran.x = s;
+    p.tran.y = 20.0 * sin(s / 100.0);
+    p.tran.z = 5.0 * sin(s / 37.0);
+    return p;
+}
+
+/**
+ * Feed a dense polyline through the planner (keeping the queue topped up the
+ * way motion does) and return the average velocity achieved over the path.
+ */
+static double runSpline(int depth)
+{
+    static TP_STRUCT tp;
+    // TP debug output goes to stdout in unit tests, and there is a lot of it
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+
+    setupMotionGlobals(depth);
+
+    tpCreate(&tp, DEFAULT_TC_QUEUE_SIZE, test_tc_space);
+    tpSetCycleTime(&tp, TEST_CYCLE_TIME);
+    tpSetVmax(&tp, TEST_VEL, TEST_VEL);
+    tpSetVlimit(&tp, 2.0 * TEST_VEL);
+    tpSetAmax(&tp, TEST_ACC);
+    tpSetTermCond(&tp, TC_TERM_COND_TANGENT, TEST_SEGMENT_LENGTH);
+
+    EmcPose start = splinePoint(0.0);
+    tpSetPos(&tp, &start);
+
+    double length = 0.0;
+    EmcPose last = start;
+    long cycles = 0;
+    int n = 1;
+    while (n <= TEST_NUM_SEGMENTS || !tpIsDone(&tp)) {
+        // Keep a margin like motion does to leave room for blend arcs
+        while (n <= TEST_NUM_SEGMENTS
+                && tcqLen(&tp.queue) < DEFAULT_TC_QUEUE_SIZE - 2) {
+            EmcPose end = splinePoint(n * TEST_SEGMENT_LENGTH);
+            if (n == TEST_NUM_SEGMENTS) {
+                tpSetTermCond(&tp, TC_TERM_COND_STOP, 0.0);
+            }
+            tpAddLine(&tp, end, EMC_MOTION_TYPE_FEED, TEST_VEL, TEST_VEL,
+                    TEST_ACC, 0, 0, -1);
+            double d;
+            EmcPose disp;
+            emcPoseSub(&end, &last, &disp);
+            emcPoseMagnitude(&disp, &d);
+            length += d;
+            last = end;
+            ++n;
+        }
+        tpRunCycle(&tp, TEST_CYCLE_TIME * 1e9);
+        ++cycles;
+    }
+
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    close(null_fd);
+
+    return length / (cycles * TEST_CYCLE_TIME);
+}
+
+TEST tpRunOptimization_deepLookahead() {
+    double v_shallow = runSpline(50);
+    double v_deep = runSpline(DEFAULT_TC_QUEUE_SIZE);
+    printf("average velocity: depth 50 = %f, depth %d = %f (requested %f)\n",
+            v_shallow, DEFAULT_TC_QUEUE_SIZE, v_deep, TEST_VEL);
+
+    // Stopping distance is 8 units, or 160 segments, so the default
+    // depth can't reach the requested feed but a deep lookahead can.
+    ASSERT(v_deep > v_shallow);
+    ASSERT(v_deep > 0.9 * TEST_VEL);
+    ASSERT(v_deep <= TEST_VEL * (1.0 + 1e-6));
+    PASS();
+}
+
+SUITE(tp_lookahead) {
+    RUN_TEST(tpRunOptimization_deepLookahead);
+}
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN();      /* command-line arguments, initialization. */
+    RUN_SUITE(tp_lookahead);
+    GREATEST_MAIN_END();        /* display results */
+}
@@ -0,0 +1,515 @@
+/********************************************************************
+* Description: tp_benchmark.cc
+*   Offline trajectory planner simulation. Runs a G-code program through
+*   the interpreter and the standalone canon (SAI), feeds the resulting
+*   moves to the trajectory planner, and steps tpRunCycle at a fixed servo
+*   period without motion, HAL or realtime.
+*
+*   Reports the simulated program time, the CPU time spent per servo
+*   cycle and per enqueued move, how segments ended (blend arcs, tangent,
+*   parabolic, exact stop), and what limited the velocity over the run.
+*
+*   Usage: tp_benchmark [options] program.ngc
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+
+#include <rs274ngc_interp.hh>
+#include <interp_return.hh>
+#include <python_plugin.hh>
+#include <saicanon.hh>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include <algorithm>
+#include <vector>
+
+#include "posemath.h"
+#include "motion.h"
+extern "C" {
+#include "emcpose.h"
+#include "tp.h"
+#include "tcq.h"
+#include "tp_types.h"
+#include "tc_types.h"
+#include "motion_types.h"
+#include "motion_debug.h"
+#include "mot_priv.h"
+}
+
+int _task = 0; // control preview behaviour when remapping
+InterpBase *pinterp;
+
+// KLUDGE fix missing symbol the ugly way
+struct _inittab builtin_modules[] = {
+    { nullptr, nullptr }
+};
+
+// Motion globals normally provided by the motion module
+static emcmot_status_t bench_status;
+static emcmot_config_t bench_config;
+static emcmot_debug_t bench_debug;
+emcmot_status_t *emcmotStatus = &bench_status;
+emcmot_config_t *emcmotConfig = &bench_config;
+emcmot_debug_t *emcmotDebug = &bench_debug;
+
+static TC_STRUCT bench_tc_space[DEFAULT_TC_QUEUE_SIZE + 10];
+
+// KLUDGE fix link errors the ugly way
+extern "C" void rtapi_print_msg(msg_level_t level, const char *fmt, ...) {}
+extern "C" void emcmotDioWrite(int index, char value) {}
+extern "C" void emcmotAioWrite(int index, double value) {}
+extern "C" void emcmotSetRotaryUnlock(int axis, int unlock) {}
+extern "C" int emcmotGetRotaryIsUnlocked(int axis) { return 0; }
+
+/* Machine settings, all lengths in mm */
+struct BenchConfig {
+    double cycle_time = 0.001;
+    double vel = 100.0;
+    double acc = 1000.0;
+    double jerk = 0.0;
+    int depth = 50;
+    int blend_enable = 1;
+};
+
+/* Why the active segment was not moving faster during a cycle */
+enum VelLimit {
+    VEL_LIMIT_FEED,         // at the programmed feed (or traverse) rate
+    VEL_LIMIT_SEGMENT,      // capped by the segment (curvature, axis limits)
+    VEL_LIMIT_LOOKAHEAD,    // slowing down for what comes next
+    VEL_LIMIT_ACCEL,        // still accelerating
+    VEL_LIMIT_IDLE,         // nothing to do (dwell, queue starved)
+    VEL_LIMIT_COUNT
+};
+
+static const char *vel_limit_names[VEL_LIMIT_COUNT] = {
+    "programmed feed",
+    "segment max velocity",
+    "lookahead / final velocity",
+    "acceleration",
+    "idle",
+};
+
+static double elapsed_ns(struct timespec const &start, struct timespec const &end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+class TpBenchmark : public SaiMotionListener
+{
+public:
+    explicit TpBenchmark(BenchConfig const &config) : config_(config)
+    {
+        memset(&bench_status, 0, sizeof(bench_status));
+        memset(&bench_config, 0, sizeof(bench_config));
+        memset(&bench_debug, 0, sizeof(bench_debug));
+
+        for (int i = 0; i < EMCMOT_MAX_AXIS; ++i) {
+            bench_debug.axes[i].vel_limit = config.vel;
+            bench_debug.axes[i].acc_limit = config.acc;
+        }
+        bench_status.net_feed_scale = 1.0;
+        bench_config.maxFeedScale = 1.0;
+        bench_config.numSpindles = 1;
+        bench_config.arcBlendEnable = config.blend_enable;
+        bench_config.arcBlendFallbackEnable = 0;
+        bench_config.arcBlendOptDepth = config.depth;
+        bench_config.arcBlendGapCycles = 4;
+        bench_config.arcBlendRampFreq = 100.0;
+        bench_config.arcBlendTangentKinkRatio = 0.1;
+        bench_config.plannerType = config.jerk > 0.0 ?
+            TP_PLANNER_SCURVE : TP_PLANNER_TRAPEZOIDAL;
+        bench_config.maxJerk = config.jerk;
+
+        tpCreate(&tp_, DEFAULT_TC_QUEUE_SIZE, bench_tc_space);
+        tpSetCycleTime(&tp_, config.cycle_time);
+        tpSetVmax(&tp_, config.vel, config.vel);
+        tpSetVlimit(&tp_, config.vel);
+        tpSetAmax(&tp_, config.acc);
+        EmcPose zero = {{0}};
+        tpSetPos(&tp_, &zero);
+    }
+
+    virtual void straight_traverse(int line_number)
+    {
+        addLine(EMC_MOTION_TYPE_TRAVERSE, config_.vel);
+    }
+
+    virtual void straight_feed(int line_number)
+    {
+        addLine(EMC_MOTION_TYPE_FEED, feedRate());
+    }
+
+    virtual void arc_feed(int line_number, double first_axis,
+            double second_axis, int rotation)
+    {
+        EmcPose end = programEnd();
+        double u = _sai._length_unit_factor;
+
+        // Same plane convention as emccanon: build the arc in the XY plane
+        // and rotate the axes for G18 / G19
+        PmCartesian center, normal;
+        switch (_sai._active_plane) {
+            case CANON_PLANE_YZ:
+                center.x = end.tran.x;
+                center.y = (first_axis + _sai._g5x_y + _sai._g92_y) * u;
+                center.z = (second_axis + _sai._g5x_z + _sai._g92_z) * u;
+                normal.x = 1.0;
+                normal.y = normal.z = 0.0;
+                break;
+            case CANON_PLANE_XZ:
+                center.x = (second_axis + _sai._g5x_x + _sai._g92_x) * u;
+                center.y = end.tran.y;
+                center.z = (first_axis + _sai._g5x_z + _sai._g92_z) * u;
+                normal.y = 1.0;
+                normal.x = normal.z = 0.0;
+                break;
+            default:
+                center.x = (first_axis + _sai._g5x_x + _sai._g92_x) * u;
+                center.y = (second_axis + _sai._g5x_y + _sai._g92_y) * u;
+                center.z = end.tran.z;
+                normal.z = 1.0;
+                normal.x = normal.y = 0.0;
+                break;
+        }
+        int turn = rotation > 0 ? rotation - 1 : rotation;
+
+        waitForQueue();
+        setTermCond();
+        double vel = feedRate();
+        timeEnqueue([&]() {
+            return tpAddCircle(&tp_, end, center, normal, turn,
+                    EMC_MOTION_TYPE_ARC, vel, config_.vel, config_.acc, 0, 0);
+        });
+    }
+
+    virtual void dwell(double seconds)
+    {
+        drain();
+        long cycles = (long)ceil(seconds / config_.cycle_time);
+        for (long i = 0; i < cycles; ++i) {
+            runCycle();
+        }
+    }
+
+    /* Run the planner until everything queued so far has been executed */
+    void drain()
+    {
+        while (!tpIsDone(&tp_)) {
+            runCycle();
+        }
+    }
+
+    void report(FILE *out, char const *program)
+    {
+        fprintf(out, "program: %s\n", program);
+        fprintf(out, "planner: %s, cycle %g s, vel %g mm/s, acc %g mm/s^2",
+                config_.jerk > 0.0 ? "scurve" : "trapezoidal",
+                config_.cycle_time, config_.vel, config_.acc);
+        if (config_.jerk > 0.0) {
+            fprintf(out, ", jerk %g mm/s^3", config_.jerk);
+        }
+        fprintf(out, ", lookahead depth %d\n", config_.depth);
+
+        fprintf(out, "program time: %.4f s (%ld cycles)\n",
+                cycles_ * config_.cycle_time, cycles_);
+        fprintf(out, "path length: %.4f mm\n", path_length_);
+
+        fprintf(out, "moves queued: %ld (%ld rejected)\n",
+                enqueued_, rejected_);
+        fprintf(out, "segments executed: %ld\n", segments_);
+        fprintf(out, "  lines %ld, arcs %ld, blend arcs %ld\n",
+                by_type_[TC_LINEAR], by_type_[TC_CIRCULAR],
+                by_type_[TC_SPHERICAL]);
+        fprintf(out, "  ending in: stop %ld, exact %ld, parabolic %ld, tangent %ld\n",
+                by_term_[TC_TERM_COND_STOP], by_term_[TC_TERM_COND_EXACT],
+                by_term_[TC_TERM_COND_PARABOLIC], by_term_[TC_TERM_COND_TANGENT]);
+
+        reportTimes(out, "tpRunCycle", cycle_ns_);
+        reportTimes(out, "tpAddLine / tpAddCircle", enqueue_ns_);
+
+        fprintf(out, "velocity limited by (fraction of cycles):\n");
+        for (int i = 0; i < VEL_LIMIT_COUNT; ++i) {
+            fprintf(out, "  %-28s %6.2f%%\n", vel_limit_names[i],
+                    cycles_ ? 100.0 * vel_limits_[i] / cycles_ : 0.0);
+        }
+    }
+
+private:
+    /* Current program end point in machine coordinates, mm */
+    EmcPose programEnd() const
+    {
+        double u = _sai._length_unit_factor;
+        EmcPose end = {{0}};
+        end.tran.x = (_sai._program_position_x + _sai._g5x_x + _sai._g92_x) * u;
+        end.tran.y = (_sai._program_position_y + _sai._g5x_y + _sai._g92_y) * u;
+        end.tran.z = (_sai._program_position_z + _sai._g5x_z + _sai._g92_z) * u;
+        end.a = _sai._program_position_a + _sai._g5x_a + _sai._g92_a;
+        end.b = _sai._program_position_b + _sai._g5x_b + _sai._g92_b;
+        end.c = _sai._program_position_c + _sai._g5x_c + _sai._g92_c;
+        return end;
+    }
+
+    /* Programmed feed in mm/s */
+    double feedRate() const
+    {
+        return fmin(_sai._feed_rate * _sai._length_unit_factor / 60.0,
+                config_.vel);
+    }
+
+    void setTermCond()
+    {
+        switch (_sai._motion_mode) {
+            case CANON_EXACT_STOP:
+                tpSetTermCond(&tp_, TC_TERM_COND_STOP, 0.0);
+                break;
+            case CANON_EXACT_PATH:
+                tpSetTermCond(&tp_, TC_TERM_COND_EXACT, 0.0);
+                break;
+            case CANON_CONTINUOUS:
+            default:
+                tpSetTermCond(&tp_, TC_TERM_COND_PARABOLIC,
+                        _sai.motion_tolerance * _sai._length_unit_factor);
+                break;
+        }
+    }
+
+    /* Motion accepts moves until the queue reports full, then task waits */
+    void waitForQueue()
+    {
+        while (tcqFull(&tp_.queue)) {
+            runCycle();
+        }
+    }
+
+    void addLine(int canon_motion_type, double vel)
+    {
+        EmcPose end = programEnd();
+        waitForQueue();
+        setTermCond();
+        timeEnqueue([&]() {
+            return tpAddLine(&tp_, end, canon_motion_type, vel, config_.vel,
+                    config_.acc, 0, 0, -1);
+        });
+    }
+
+    template <typename F>
+    void timeEnqueue(F add)
+    {
+        struct timespec start, end;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+        int res = add();
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+        enqueue_ns_.push_back(elapsed_ns(start, end));
+        if (res == 0) {
+            ++enqueued_;
+        } else {
+            ++rejected_;
+        }
+    }
+
+    void runCycle()
+    {
+        // Remember what is at the front of the queue so that segments
+        // finished during this cycle can be tallied afterwards
+        static const int max_removed = 4;
+        int snap_type[max_removed], snap_term[max_removed];
+        int len_before = tcqLen(&tp_.queue);
+        for (int i = 0; i < len_before && i < max_removed; ++i) {
+            TC_STRUCT const *tc = tcqItem(&tp_.queue, i);
+            snap_type[i] = tc->motion_type;
+            snap_term[i] = tc->term_cond;
+        }
+        EmcPose pos_before;
+        tpGetPos(&tp_, &pos_before);
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+        tpRunCycle(&tp_, (long)(config_.cycle_time * 1e9));
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+        cycle_ns_.push_back(elapsed_ns(start, end));
+        ++cycles_;
+
+        int removed = len_before - tcqLen(&tp_.queue);
+        for (int i = 0; i < removed && i < max_removed; ++i) {
+            ++segments_;
+            if (snap_type[i] >= 0 && snap_type[i] <= TC_SPHERICAL) {
+                ++by_type_[snap_type[i]];
+            }
+            if (snap_term[i] >= 0 && snap_term[i] <= TC_TERM_COND_TANGENT) {
+                ++by_term_[snap_term[i]];
+            }
+        }
+
+        EmcPose pos_after, disp;
+        tpGetPos(&tp_, &pos_after);
+        emcPoseSub(&pos_after, &pos_before, &disp);
+        double d;
+        emcPoseMagnitude(&disp, &d);
+        path_length_ += d;
+
+        ++vel_limits_[classifyVelocity()];
+    }
+
+    VelLimit classifyVelocity()
+    {
+        TC_STRUCT const *tc = tcqItem(&tp_.queue, 0);
+        if (!tc || tc->currentvel <= 0.0) {
+            return VEL_LIMIT_IDLE;
+        }
+        static const double rel_tol = 1e-3;
+        double v = tc->currentvel;
+        double cap = fmin(fmin(tc->target_vel, tc->maxvel), tp_.vLimit);
+        if (v >= tc->reqvel * (1.0 - rel_tol)) {
+            return VEL_LIMIT_FEED;
+        }
+        if (v >= cap * (1.0 - rel_tol)) {
+            return VEL_LIMIT_SEGMENT;
+        }
+        if (tc->currentacc < 0.0 || tc->on_final_decel) {
+            return VEL_LIMIT_LOOKAHEAD;
+        }
+        return VEL_LIMIT_ACCEL;
+    }
+
+    static void reportTimes(FILE *out, char const *name,
+            std::vector<double> &samples)
+    {
+        if (samples.empty()) {
+            return;
+        }
+        std::sort(samples.begin(), samples.end());
+        double sum = 0.0;
+        for (double s : samples) {
+            sum += s;
+        }
+        auto pct = [&](double p) {
+            size_t i = (size_t)(p * (samples.size() - 1));
+            return samples[i] / 1e3;
+        };
+        fprintf(out, "%s CPU time (us, %zu calls): mean %.3f, p50 %.3f, "
+                "p90 %.3f, p99 %.3f, p99.9 %.3f, max %.3f\n",
+                name, samples.size(), sum / samples.size() / 1e3,
+                pct(0.5), pct(0.9), pct(0.99), pct(0.999),
+                samples.back() / 1e3);
+    }
+
+    BenchConfig config_;
+    TP_STRUCT tp_;
+
+    long cycles_ = 0;
+    long enqueued_ = 0;
+    long rejected_ = 0;
+    long segments_ = 0;
+    long by_type_[TC_SPHERICAL + 1] = {0};
+    long by_term_[TC_TERM_COND_TANGENT + 1] = {0};
+    long vel_limits_[VEL_LIMIT_COUNT] = {0};
+    double path_length_ = 0.0;
+    std::vector<double> cycle_ns_;
+    std::vector<double> enqueue_ns_;
+};
+
+static void usage(char const *name)
+{
+    fprintf(stderr,
+            "Usage: %s [options] program.ngc\n"
+            "    -c <s>: servo cycle time (default 0.001)\n"
+            "    -v <mm/s>: maximum velocity (default 100)\n"
+            "    -a <mm/s^2>: maximum acceleration (default 1000)\n"
+            "    -j <mm/s^3>: maximum jerk, enables the S-curve planner\n"
+            "    -d <n>: lookahead depth (default 50)\n"
+            "    -n: disable arc blends\n"
+            "    -o <file>: write the canon calls to <file> (default none)\n",
+            name);
+}
+
+int main(int argc, char *argv[])
+{
+    BenchConfig config;
+    char const *canon_log = "/dev/null";
+    int opt;
+    while ((opt = getopt(argc, argv, "c:v:a:j:d:no:h")) != -1) {
+        switch (opt) {
+            case 'c': config.cycle_time = atof(optarg); break;
+            case 'v': config.vel = atof(optarg); break;
+            case 'a': config.acc = atof(optarg); break;
+            case 'j': config.jerk = atof(optarg); break;
+            case 'd': config.depth = atoi(optarg); break;
+            case 'n': config.blend_enable = 0; break;
+            case 'o': canon_log = optarg; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || config.cycle_time <= 0.0
+            || config.vel <= 0.0 || config.acc <= 0.0) {
+        usage(argv[0]);
+        return 1;
+    }
+    char const *program = argv[optind];
+
+    _outfile = fopen(canon_log, "w");
+    if (!_outfile) {
+        fprintf(stderr, "could not open output file %s\n", canon_log);
+        return 1;
+    }
+    PythonPlugin::instantiate(builtin_modules);
+
+    TpBenchmark bench(config);
+    _sai_motion_listener = &bench;
+
+    pinterp = makeInterp();
+    reset_internals();
+    // Every tool exists with zero offsets, so tool changes and G43 work
+    for (int pocket = 1; pocket < CANON_POCKETS_MAX; ++pocket) {
+        _sai._tools[pocket].toolno = pocket;
+    }
+    int status = pinterp->init();
+    if (status != INTERP_OK) {
+        fprintf(stderr, "interpreter init failed (%d)\n", status);
+        return 1;
+    }
+    status = pinterp->open(program);
+    if (status != INTERP_OK) {
+        fprintf(stderr, "could not open %s (%d)\n", program, status);
+        return 1;
+    }
+
+    for (;;) {
+        status = pinterp->read();
+        if (status == INTERP_ENDFILE) {
+            break;
+        }
+        if (status != INTERP_OK && status != INTERP_EXECUTE_FINISH) {
+            char msg[LINELEN];
+            pinterp->error_text(status, msg, sizeof(msg));
+            fprintf(stderr, "%s: line %d: %s\n", program,
+                    pinterp->line(), msg);
+            return 1;
+        }
+        status = pinterp->execute();
+        if (status == INTERP_EXIT) {
+            break;
+        }
+        if (status != INTERP_OK && status != INTERP_EXECUTE_FINISH) {
+            char msg[LINELEN];
+            pinterp->error_text(status, msg, sizeof(msg));
+            fprintf(stderr, "%s: line %d: %s\n", program,
+                    pinterp->line(), msg);
+            return 1;
+        }
+    }
+    pinterp->close();
+    bench.drain();
+    _sai_motion_listener = nullptr;
+
+    bench.report(stdout, program);
+    return 0;
+}